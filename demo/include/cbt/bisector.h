@@ -7,6 +7,7 @@
 #define INVALID_POINTER UINT32_MAX
 
 // Possible culling state
+#define HORIZON_CULLED -4
 #define BACK_FACE_CULLED -3
 #define FRUSTUM_CULLED -2
 #define TOO_SMALL -1
@@ -14,6 +15,41 @@
 #define BISECT_ELEMENT 1
 #define SIMPLIFY_ELEMENT 2
 #define MERGED_ELEMENT 3
+// Split only requested by the predicted view
+#define PREDICTED_BISECT_ELEMENT 4
+
+// Uncomment to store the bisector data as a structure of arrays
+// #define BISECTOR_DATA_SOA 1
+
+// Uncomment to store the three neighbors of a bisector as 21 bit indices packed in a uint64 (8 bytes per element instead of 12),
+// the meshes with more elements than the packed indices can address keep the unpacked layout
+// #define PACKED_NEIGHBORS 1
+
+// Offsets of the bisector data fields (in the structure of arrays layout, each field is an array of totalNumElements uints)
+#define BISECTOR_DATA_SUBDIVISION_PATTERN 0
+#define BISECTOR_DATA_INDICES 1
+#define BISECTOR_DATA_PROBLEMATIC_NEIGHBOR 4
+#define BISECTOR_DATA_STATE 5
+#define BISECTOR_DATA_FLAGS 6
+#define BISECTOR_DATA_PROPAGATION_ID 7
+#define BISECTOR_DATA_NUM_FIELDS 8
+
+// Packed neighbors layout, three 21 bit indices in a 64 bit word, the all ones field encodes INVALID_POINTER
+#define PACKED_NEIGHBOR_BITS 21
+#define PACKED_NEIGHBOR_MASK 0x1FFFFFull
+
+// Number of slots of the heapID table per element (used to derive the adjacency from the heapIDs)
+#define HEAP_ID_HASH_LOAD_RATIO 2
+
+// The neighbors are updated in place: each bisection records the new neighbors of its (up to four) bisectors in a side buffer
+// sized for the maximal number of new bisectors of an update (see resize_neighbors_update_buffer), which bounds the number of bisections
+#define NEIGHBORS_UPDATE_RECORDS 4
+
+// Bisectors are clustered under their ancestor CLUSTER_SUBTREE_DEPTH levels up (or their base patch), a uniformly subdivided area gives full clusters
+#define CLUSTER_SUBTREE_DEPTH 7
+#define CLUSTER_MAX_ELEMENTS (1 << CLUSTER_SUBTREE_DEPTH)
+// Number of slots of the cluster table per element
+#define CLUSTER_HASH_LOAD_RATIO 2
 
 struct BisectorData
 {
@@ -35,3 +71,36 @@ struct BisectorData
     // ID used for the propagation
     uint32_t propagationID;
 };
+
+// Index (in uints) of a field of a given bisector in the bisector data buffer
+inline uint32_t bisector_data_index(uint32_t bisectorID, uint32_t field, uint32_t totalNumElements)
+{
+#if defined(BISECTOR_DATA_SOA)
+    return field * totalNumElements + bisectorID;
+#else
+    // The fields of a bisector are contiguous, the size of the buffer doesn't matter
+    (void)totalNumElements;
+    return bisectorID * BISECTOR_DATA_NUM_FIELDS + field;
+#endif
+}
+
+inline uint64_t pack_neighbor(uint32_t neighborID)
+{
+    return neighborID == INVALID_POINTER ? PACKED_NEIGHBOR_MASK : (uint64_t)neighborID;
+}
+
+inline uint32_t unpack_neighbor(uint64_t packedNeighbors, uint32_t slot)
+{
+    uint32_t neighborID = (uint32_t)((packedNeighbors >> (slot * PACKED_NEIGHBOR_BITS)) & PACKED_NEIGHBOR_MASK);
+    return neighborID == (uint32_t)PACKED_NEIGHBOR_MASK ? INVALID_POINTER : neighborID;
+}
+
+inline uint64_t pack_neighbors(const uint3& neighbors)
+{
+    return pack_neighbor(neighbors.x) | (pack_neighbor(neighbors.y) << PACKED_NEIGHBOR_BITS) | (pack_neighbor(neighbors.z) << (2 * PACKED_NEIGHBOR_BITS));
+}
+
+inline uint3 unpack_neighbors(uint64_t packedNeighbors)
+{
+    return { unpack_neighbor(packedNeighbors, 0), unpack_neighbor(packedNeighbors, 1), unpack_neighbor(packedNeighbors, 2) };
+}
@@ -67,10 +67,11 @@ struct GPU_CBT
     // Number of Graphics buffers used to represent the CBT
     uint32_t bufferCount = 0;
 
-    // Graphics buffer used to store CBT
+    // Graphics buffer used to store CBT and their sizes
     GraphicsBuffer bufferArray[2];
+    uint32_t bufferSizeArray[2] = { 0, 0 };
 };
 
-// Create the device version of the cbt
-void initialize_gpu_cbt(const CBT& cbt, GraphicsDevice device, CommandQueue queue, CommandBuffer buffer, GPU_CBT& gpuCBT);
+// Create the device version of the cbt, the content of its buffers can be overriden (raw buffers of a snapshot of the same layout)
+void initialize_gpu_cbt(const CBT& cbt, GraphicsDevice device, CommandQueue queue, CommandBuffer buffer, GPU_CBT& gpuCBT, const char* const* bufferData = nullptr);
 void release_gpu_cbt(GPU_CBT& gpuCBT);
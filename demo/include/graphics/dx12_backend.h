@@ -131,6 +131,7 @@ namespace d3d12
 #pragma endregion
 
 #pragma region UAV barrier
+        void uav_barrier(CommandBuffer commandBuffer);
         void uav_barrier_buffer(CommandBuffer commandBuffer, GraphicsBuffer targetBuffer);
         void uav_barrier_texture(CommandBuffer commandBuffer, Texture texture);
         void uav_barrier_render_texture(CommandBuffer commandBuffer, RenderTexture renderTexture);
@@ -193,6 +194,7 @@ namespace d3d12
         void draw_indexed(CommandBuffer commandBuffer, GraphicsPipeline graphicsPipeline, GraphicsBuffer vertexBuffer, GraphicsBuffer indexBuffer, uint32_t numTriangles, uint32_t numInstances, DrawPrimitive primitive = DrawPrimitive::Triangle);
         void draw_procedural(CommandBuffer commandBuffer, GraphicsPipeline graphicsPipeline, uint32_t numTriangles, uint32_t numInstances, DrawPrimitive primitive = DrawPrimitive::Triangle);
         void draw_procedural_indirect(CommandBuffer commandBuffer, GraphicsPipeline graphicsPipeline, GraphicsBuffer indirectBuffer, uint32_t buffeOffset = 0);
+        void draw_indexed_indirect(CommandBuffer commandBuffer, GraphicsPipeline graphicsPipeline, GraphicsBuffer indexBuffer, GraphicsBuffer indirectBuffer, uint32_t bufferOffset = 0);
 #pragma endregion
 
 #pragma region Ray Tracing
@@ -267,8 +267,9 @@ namespace d3d12
 		// Stencil ref
 		uint8_t stencilRef = 0;
 
-		// Command signature for indirect dispatch
+		// Command signatures for indirect draws
 		ID3D12CommandSignature* commandSignature = nullptr;
+		ID3D12CommandSignature* indexedCommandSignature = nullptr;
 
 		// Barriers to enqueue
 		std::vector<D3D12_RESOURCE_BARRIER> barriersData;
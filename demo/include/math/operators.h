@@ -32,7 +32,10 @@
 #pragma endregion
 
 #pragma region double3
+	double3 normalize(const double3& v);
 	double length(const double3& v);
+	double3 cross(const double3& v0, const double3& v1);
+	double dot(const double3& v0, const double3& v1);
 	double3 lerp(const double3& v0, const double3& v1, double f);
 	double3 operator+(const double3& v0, const double3& v1);
 	double3 operator-(const double3& v0, const double3& v1);
@@ -0,0 +1,136 @@
+#pragma once
+
+// Project includes
+#include "math/types.h"
+
+// System includes
+#include <stdint.h>
+#include <vector>
+
+// Number of bisectors in a leaf at build time (consecutive along the bisection curve)
+#define BVH_LEAF_SIZE 8
+// Maximal number of bisectors in a leaf, the remaining slots receive the bisectors inserted by the refits
+#define BVH_LEAF_CAPACITY 16
+// Number of bins per axis evaluated by the SAH
+#define BVH_SAH_BINS 16
+// Minimal number of leaves of a sub-tree for it to be built on its own thread
+#define BVH_PARALLEL_LEAVES 4096
+// Maximal depth of the traversal stack
+#define BVH_STACK_SIZE 64
+// Fraction of the bisectors that can be inserted by the refits before the tree needs to be rebuilt
+#define BVH_REBUILD_INSERTION_RATIO 0.25
+// Number of bisectors that can be tested outside of the tree (their leaf was full) before it needs to be rebuilt
+#define BVH_REBUILD_OVERFLOW 64
+
+// Invalid element or leaf
+#define BVH_INVALID_INDEX 0xFFFFFFFF
+
+struct BVHRay
+{
+    // Origin in the space of the planet (usually double precision world space)
+    double3 origin;
+    // Direction (doesn't need to be normalized, the distances are expressed in its unit)
+    float3 direction;
+    // Maximal distance of the hit
+    float tMax;
+};
+
+struct BVHHit
+{
+    // Distance along the ray
+    float t = 0.0f;
+    // Element that was hit (BVH_INVALID_INDEX if none)
+    uint32_t element = BVH_INVALID_INDEX;
+    // Barycentric coordinates of the hit in the triangle of the element
+    float u = 0.0f;
+    float v = 0.0f;
+};
+
+// Bounding volume hierarchy over the triangles of the allocated bisectors
+class BisectorBVH
+{
+public:
+    // Build the tree over the allocated bisectors (non zero heapID), the vertices are laid out like the current vertex buffer
+    // (three per element) and are relative to the origin
+    void build(const std::vector<uint64_t>& heapIDArray, const std::vector<float3>& vertices, const double3& origin);
+
+    // Refit the tree after the vertices of the listed elements changed (same content as the modified indexed bisector buffer).
+    // The listed elements whose heapID changed are moved to the leaf their triangle fits best, the ones whose heapID changed
+    // without being listed are ignored until they are
+    void refit(const std::vector<uint64_t>& heapIDArray, const std::vector<float3>& vertices, const double3& origin,
+        const uint32_t* modifiedElements, uint32_t numModifiedElements);
+
+    // Too many elements were inserted since the build (the quality of the tree degrades)
+    bool needs_rebuild() const;
+
+    // Closest hit along a ray, returns false if nothing is hit before tMax
+    bool intersect(const BVHRay& ray, BVHHit& hit) const;
+
+    // Returns true if anything is hit before tMax
+    bool occluded(const BVHRay& ray) const;
+
+    // Closest hits of a packet of four rays (traversed together, more efficient when they are coherent)
+    void intersect_packet(const BVHRay rays[4], BVHHit hits[4]) const;
+
+    // Number of nodes of the tree
+    uint32_t num_nodes() const { return (uint32_t)m_Nodes.size(); }
+
+private:
+    struct Node
+    {
+        float3 boundsMin;
+        // Index of the second child (the first one follows the node, the tree is stored depth first)
+        uint32_t child;
+        float3 boundsMax;
+        // Leaf index (BVH_INVALID_INDEX for an inner node)
+        uint32_t leaf;
+    };
+
+    struct Leaf
+    {
+        uint32_t firstElement;
+        uint32_t numElements;
+    };
+
+    // Build the sub-tree of a range of leaves
+    void build_node(uint32_t nodeIdx, uint32_t begin, uint32_t end, uint32_t depth, uint32_t threadBudget);
+
+    // Recompute the bounds of a leaf and of its ancestors
+    void refit_leaf(uint32_t leafIdx);
+
+    // Remove an element from its leaf or from the overflow
+    void remove_element(uint32_t elementID);
+
+    // Insert an element in the leaf with spare room that grows the tree the least, returns the leaf (BVH_INVALID_INDEX if none)
+    uint32_t insert_element(uint32_t elementID);
+
+    // Position relative to the tree origin
+    float3 to_local(const double3& position) const;
+
+private:
+    // Origin of the local space of the triangles
+    double3 m_Origin = { 0.0, 0.0, 0.0 };
+
+    // Triangles of the elements (three vertices per element) and heapID they were evaluated for (0 if not valid)
+    std::vector<float3> m_Triangles;
+    std::vector<uint64_t> m_HeapIDs;
+
+    // Leaf of every element (BVH_INVALID_INDEX if outside of the tree)
+    std::vector<uint32_t> m_ElementLeaves;
+
+    // Leaves, their elements, their bounds (min, max) and their node
+    std::vector<Leaf> m_Leaves;
+    std::vector<uint32_t> m_LeafElements;
+    std::vector<float3> m_LeafBounds;
+    std::vector<uint32_t> m_LeafOrder;
+    std::vector<uint32_t> m_LeafNodes;
+
+    // Tree
+    std::vector<Node> m_Nodes;
+    std::vector<uint32_t> m_NodeParents;
+
+    // Elements that didn't fit in their leaf
+    std::vector<uint32_t> m_Overflow;
+    uint32_t m_NumIndexed = 0;
+    uint32_t m_NumInserted = 0;
+};
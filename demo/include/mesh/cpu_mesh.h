@@ -12,16 +12,61 @@ struct CPUMesh
     // Total number of elements
     uint32_t totalNumElements = 0;
 
+    // Hash of the content of the mesh file (keys the cache and the snapshots)
+    uint64_t contentHash = 0;
+
     // Minimal depth of the mesh
     uint32_t minimalDepth = 0;
 
-    // Bisector
+    // Bisectors, only the base ones are stored. They start at firstBaseElement, the elements before them are unallocated (zero heapID
+    // and neighbors) and are never materialized on the CPU
+    uint32_t firstBaseElement = 0;
     std::vector<uint64_t> heapIDArray;
     std::vector<uint3> neighborsArray;
 
     // Base positions
     std::vector<float3> basePoints;
+
+    // Neighbor patches of each base patch (used to derive the adjacency from the heapIDs)
+    std::vector<uint3> baseNeighborsArray;
+
+    // Bounding cone of each base patch on the unit sphere (axis, cosine of the half angle)
+    std::vector<float4> patchBounds;
+};
+
+// Group of bisectors that share their ancestor CLUSTER_SUBTREE_DEPTH levels up (or their base patch)
+struct BisectorCluster
+{
+    // HeapID of the common ancestor
+    uint64_t rootHeapID;
+
+    // Range of the cluster in the cluster element array
+    uint32_t firstElement;
+    uint32_t numElements;
+
+    // Bounding sphere (center, radius) and normal cone (axis, cosine of the half angle) on the unit sphere
+    float4 boundingSphere;
+    float4 normalCone;
 };
 
 // Load the CPU mesh
-void load_cpu_mesh(const char* meshPath, uint32_t cbtNumElements, CPUMesh& outputMesh);
\ No newline at end of file
+void load_cpu_mesh(const char* meshPath, uint32_t cbtNumElements, CPUMesh& outputMesh);
+
+// Reference derivation of the neighbors of a set of bisectors from their heapIDs and the base patch adjacency
+void derive_neighbors(const CPUMesh& mesh, const std::vector<uint64_t>& heapIDArray, std::vector<uint3>& neighborsArray);
+
+// Reference evaluation of the positions of a bisector on the unit sphere (its three vertices and the fourth vertex of its parent)
+void decode_bisector_positions(const CPUMesh& mesh, uint64_t heapID, double3 positions[4]);
+// Incremental evaluation of the positions of a bisector from the cached ones of its parent, grandparent or child, returns false if they can't be used
+bool derive_bisector_positions(const CPUMesh& mesh, uint64_t heapID, uint64_t cachedHeapID, const double3 cachedPositions[4], double3 positions[4]);
+// Maximal distance between the incremental and the reference positions along random sequences of bisections and merges
+double incremental_positions_drift(const CPUMesh& mesh, uint32_t numSequences, uint32_t numSteps);
+
+// Root of the cluster of a bisector
+uint64_t cluster_root_heap_id(const CPUMesh& mesh, uint64_t heapID);
+// Bounds of a cluster on the unit sphere, every descendant of the root is projected inside the spherical triangle of its corners
+void evaluate_cluster_bounds(const CPUMesh& mesh, uint64_t rootHeapID, float4& boundingSphere, float4& normalCone);
+// Groups a set of bisectors (0 if unallocated) into clusters ordered along the bisection curve, the cluster elements are indices in the set
+void build_bisector_clusters(const CPUMesh& mesh, const std::vector<uint64_t>& heapIDArray, std::vector<BisectorCluster>& clusters, std::vector<uint32_t>& clusterElements);
+// Checks that every allocated bisector belongs to exactly one cluster that bounds its positions
+bool validate_bisector_clusters(const CPUMesh& mesh, const std::vector<uint64_t>& heapIDArray, const std::vector<BisectorCluster>& clusters, const std::vector<uint32_t>& clusterElements);
@@ -0,0 +1,50 @@
+#pragma once
+
+// Project includes
+#include "cbt/bisector.h"
+#include "mesh/cpu_mesh.h"
+
+// System includes
+#include <stdint.h>
+#include <vector>
+
+// Refined state of a CPU mesh, the elements are laid out like the GPU buffers (unallocated elements have a zero heapID)
+struct CPUMeshState
+{
+    std::vector<uint64_t> heapIDArray;
+    std::vector<uint3> neighborsArray;
+    std::vector<BisectorData> bisectorDataArray;
+};
+
+// Budgets of an update (UINT32_MAX doesn't limit them)
+struct CPUUpdateBudgets
+{
+    // Split requests, and requests that only come from the predicted view (processed after the other ones, within what they leave of the split budget)
+    uint32_t splitBudget = UINT32_MAX;
+    uint32_t predictiveSplitBudget = UINT32_MAX;
+    uint32_t simplifyBudget = UINT32_MAX;
+
+    // Maximal number of bisectors an update can create
+    uint32_t maxNewBisectors = UINT32_MAX;
+};
+
+// What an update did
+struct CPUUpdateStats
+{
+    // Registered requests
+    uint32_t numSplitRequests = 0;
+    uint32_t numPredictedSplitRequests = 0;
+    uint32_t numSimplifyRequests = 0;
+
+    // Bisected elements, created bisectors and merged pairs
+    uint32_t numBisectedElements = 0;
+    uint32_t numNewBisectors = 0;
+    uint32_t numMerges = 0;
+};
+
+// Copy the base bisectors of a CPU mesh in a state
+void init_cpu_mesh_state(const CPUMesh& mesh, CPUMeshState& state);
+
+// CPU reference of the topology update of UpdateMesh.compute, its passes run sequentially on the classification of every element
+// (in the convention of ClassifyBisector, ignored for the unallocated elements). The hysteresis of the GPU update isn't modeled.
+void update_cpu_mesh_state(const CPUMesh& mesh, const std::vector<int32_t>& validityArray, const CPUUpdateBudgets& budgets, CPUMeshState& state, CPUUpdateStats& stats);
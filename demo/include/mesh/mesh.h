@@ -7,6 +7,32 @@
 #include "cbt/bisector.h"
 #include "cbt/cbt.h"
 #include "mesh/cpu_mesh.h"
+#include "mesh/mesh_snapshot.h"
+
+// Enable to share the corners of the bisectors between their neighbors and draw them through an index buffer
+// #define WELDED_VERTICES 1
+
+// The corners of a closed mesh take about half a vertex per bisector, the fourth vertices one
+#define WELDED_VERTEX_RATIO 2
+
+// Size of the welded draw arguments (indexed draw, vertex counter)
+#define WELDED_ARGS_SIZE 6
+
+// Enable to group the bisectors into clusters that are culled as a whole before the visibility pass
+// #define BISECTOR_CLUSTERS 1
+
+#if defined(WELDED_VERTICES) && defined(BISECTOR_CLUSTERS)
+#error "The welded index buffer is not clustered, the bisector clusters require the procedural draw"
+#endif
+
+// Size of the cluster arguments (cluster counter, element offset, visible cluster counter, padding, procedural draw)
+#define CLUSTER_ARGS_SIZE 8
+#define CLUSTER_DRAW_ARGS_OFFSET 4
+
+// Offsets (in uints) of the welded vertex and cluster dispatches in the indirect dispatch buffer
+#define WELDED_DISPATCH_OFFSET 9
+#define CLUSTER_DISPATCH_OFFSET 12
+#define INDIRECT_DISPATCH_BUFFER_SIZE 15
 
 struct BaseMesh
 {
@@ -32,10 +58,22 @@ struct CBTMesh
     // Base heap depth
     uint32_t baseDepth;
 
+    // Content hash of the base mesh (see CPUMesh::contentHash)
+    uint64_t baseMeshHash;
+
+    // First base bisector, the elements before it must be cleared before the first update unless the mesh started from a snapshot
+    uint32_t firstBaseElement;
+    bool clearUnallocatedElements;
+
+    // Layout of the neighbors buffer (see packed_neighbors)
+    bool packedNeighbors;
+
     // Bisector buffers
     GraphicsBuffer heapIDBuffer;
-    uint32_t currentNeighborsBufferIdx;
-    GraphicsBuffer neighborsBuffers[2];
+    GraphicsBuffer neighborsBuffer;
+    // New neighbors recorded by the bisections of an update (bisector, neighbors), sized for the maximal number of bisectors an update can create
+    GraphicsBuffer neighborsUpdateBuffer;
+    uint32_t maxNewBisectors;
 
     // Intermediate buffers
     GraphicsBuffer updateBuffer;
@@ -51,19 +89,115 @@ struct CBTMesh
     GraphicsBuffer visibleIndexedBisectorBuffer;
     GraphicsBuffer modifiedIndexedBisectorBuffer;
 
+    // Compaction buffers
+    GraphicsBuffer compactionRemapBuffer;
+    GraphicsBuffer compactionHeapIDBuffer;
+
+    // Incremental classification
+    GraphicsBuffer classificationCacheBuffer;
+
+    // Split/merge hysteresis (birth of the bisectors, compaction scratch and churn counters)
+    GraphicsBuffer bisectorAgeBuffer;
+
+    // Base patch culling
+    GraphicsBuffer patchBoundsBuffer;
+    GraphicsBuffer patchVisibilityBuffer;
+    GraphicsBuffer patchCullingBuffer;
+
+    // Derived adjacency (neighbor patches of the base patches and heapID table)
+    GraphicsBuffer baseNeighborsBuffer;
+    GraphicsBuffer heapIDHashBuffer;
+
     // Geometry buffers
     GraphicsBuffer lebVertexBuffer;
+    // HeapID that the LEB positions of each element were evaluated for (0 if none)
+    GraphicsBuffer lebPositionHeapIDBuffer;
     GraphicsBuffer currentVertexBuffer;
     GraphicsBuffer currentDisplacementBuffer;
 
+#if defined(WELDED_VERTICES)
+    // Welded vertex of the corners and fourth vertex of every element (laid out like the LEB positions)
+    GraphicsBuffer vertexIndexBuffer;
+    // LEB position that each welded vertex is evaluated from
+    GraphicsBuffer weldedVertexBuffer;
+    // Index buffer of the indexed bisectors and its draw arguments
+    GraphicsBuffer weldedIndexBuffer;
+    GraphicsBuffer weldedArgsBuffer;
+#endif
+
+#if defined(BISECTOR_CLUSTERS)
+    // Cluster table (leader of each cluster), cluster root, cluster of the leaders and cluster slot (cluster, local index) of the indexed bisectors
+    GraphicsBuffer clusterHashBuffer;
+    GraphicsBuffer clusterRootBuffer;
+    GraphicsBuffer clusterIDBuffer;
+    GraphicsBuffer clusterSlotBuffer;
+    // Clusters (leader, first element, element count, first drawn triangle) and their bounds (camera relative bounding sphere, normal cone)
+    GraphicsBuffer clusterBuffer;
+    GraphicsBuffer clusterBoundsBuffer;
+    // Bisectors grouped by cluster and bisectors of the visible clusters
+    GraphicsBuffer clusterElementBuffer;
+    GraphicsBuffer clusterDrawBuffer;
+    GraphicsBuffer clusterArgsBuffer;
+    // HeapIDs of the topology exposed by the last asynchronous update, the update keeps rewriting the live ones (allocated on demand)
+    GraphicsBuffer clusterHeapIDBuffer;
+#endif
+
+    // Back buffers of the asynchronous update (allocated on demand)
+    GraphicsBuffer asyncIndirectDrawBuffer;
+    GraphicsBuffer asyncIndirectDispatchBuffer;
+    GraphicsBuffer asyncIndexedBisectorBuffer;
+    GraphicsBuffer asyncVisibleIndexedBisectorBuffer;
+    GraphicsBuffer asyncModifiedIndexedBisectorBuffer;
+    GraphicsBuffer asyncLebVertexBuffer;
+    GraphicsBuffer asyncLebPositionHeapIDBuffer;
+    GraphicsBuffer asyncVertexBuffer;
+#if defined(WELDED_VERTICES)
+    GraphicsBuffer asyncVertexIndexBuffer;
+    GraphicsBuffer asyncWeldedVertexBuffer;
+    GraphicsBuffer asyncWeldedIndexBuffer;
+    GraphicsBuffer asyncWeldedArgsBuffer;
+#endif
+#if defined(BISECTOR_CLUSTERS)
+    GraphicsBuffer asyncClusterHeapIDBuffer;
+#endif
+
     // Device version of the CBT
     GPU_CBT gpuCBT;
 };
 
-// Function to initialize a cbt mesh
-void initialize_cbt_mesh(const CPUMesh& cpuMesh, const CBT& cbt, GraphicsDevice device, CommandQueue queue, CommandBuffer buffer, CBTMesh& cbtMesh);
+// Returns true if the neighbors of a mesh with this number of elements are packed (PACKED_NEIGHBORS is enabled and the indices fit in the packed fields)
+bool packed_neighbors(uint32_t totalNumElements);
+// Size of an element of the neighbor buffer of a mesh with this number of elements
+uint32_t neighbors_element_size(uint32_t totalNumElements);
+
+// Function to initialize a cbt mesh, a snapshot of the same layout starts it in its refined state
+void initialize_cbt_mesh(const CPUMesh& cpuMesh, const CBT& cbt, GraphicsDevice device, CommandQueue queue, CommandBuffer buffer, uint32_t maxNewBisectors, CBTMesh& cbtMesh, const CBTMeshSnapshot* snapshot = nullptr);
 void release_cbt_mesh(CBTMesh& cbtMesh);
 
+// Recreates the neighbors update buffer for a new maximal number of bisectors per update (the device must be done with the mesh)
+void resize_neighbors_update_buffer(GraphicsDevice device, CBTMesh& cbtMesh, uint32_t maxNewBisectors);
+
+// Functions to capture the refined state of a cbt mesh (the device must be idle) and check that a snapshot can initialize a mesh
+void capture_cbt_mesh_snapshot(const CBTMesh& cbtMesh, GraphicsDevice device, CommandQueue queue, CommandBuffer buffer, CBTMeshSnapshot& snapshot);
+bool cbt_mesh_snapshot_matches(const CBTMeshSnapshot& snapshot, const CPUMesh& cpuMesh, const CBT& cbt);
+
+// Reads back the heapIDs and neighbors of every element (the device must be idle) and optionally the displacement of their corners (three per element)
+void readback_cbt_mesh_bisectors(const CBTMesh& cbtMesh, GraphicsDevice device, CommandQueue queue, CommandBuffer buffer,
+    std::vector<uint64_t>& heapIDArray, std::vector<uint3>& neighborsArray, std::vector<float3>* displacementArray);
+
+// Functions to double buffer the topology consumed by the rendering while an asynchronous update is running
+void initialize_async_update_buffers(GraphicsDevice device, CBTMesh& cbtMesh);
+void release_async_update_buffers(CBTMesh& cbtMesh);
+// Copies the front indexation and vertices into the back buffers, must be recorded on the direct queue
+void prepare_async_update(CommandBuffer cmdB, const CBTMesh& cbtMesh);
+// Returns a version of the mesh that reads and writes the back buffers
+CBTMesh async_update_mesh(const CBTMesh& cbtMesh);
+// Exposes the topology written by the last asynchronous update to the rendering
+void swap_async_update_buffers(CBTMesh& cbtMesh);
+
+// Number of vertices the current vertex buffer can hold
+uint32_t current_vertex_capacity(const CBTMesh& cbtMesh);
+
 // Function to initialize a base mesh
 void initialize_base_mesh(const CPUMesh& cpuMesh, GraphicsDevice device, CommandQueue queue, CommandBuffer buffer, BaseMesh& baseMesh);
 void release_base_mesh(BaseMesh& baseMesh);
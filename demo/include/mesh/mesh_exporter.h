@@ -0,0 +1,40 @@
+#pragma once
+
+// Project includes
+#include "math/types.h"
+#include "mesh/cpu_mesh.h"
+
+// System includes
+#include <stdint.h>
+#include <vector>
+
+// Number of consecutive elements that are welded, decoded and written together
+#define MESH_EXPORT_BLOCK_SIZE 4096
+// Number of blocks decoded while the previous ones are being written
+#define MESH_EXPORT_BLOCKS_PER_CHUNK 16
+// Maximal number of bisectors around a vertex that the welding walks through (like the welded vertices on the GPU)
+#define MESH_EXPORT_MAX_VALENCE 32
+
+enum class MeshExportFormat
+{
+    OBJ = 0,
+    Binary,
+    Count
+};
+
+// Result of an export
+struct MeshExportStats
+{
+    uint32_t numTriangles = 0;
+    uint32_t numVertices = 0;
+    uint64_t fileSize = 0;
+    // Duration of the export in milliseconds
+    double duration = 0.0;
+};
+
+// Write the triangles of the allocated bisectors (non zero heapID) in planet space. The corners shared through the neighbor links are welded
+// and the displacements (three per element like the current displacement buffer) are optional. The output is written in blocks from a
+// bounded buffer while the next blocks are decoded. The binary format is a header (magic, version, vertex, triangle and block counts) followed
+// by the blocks, each one a (vertex count, triangle count) pair, its double precision vertices and the global indices of its triangles
+bool export_bisector_mesh(const CPUMesh& mesh, const std::vector<uint64_t>& heapIDArray, const std::vector<uint3>& neighborsArray, const float3* displacementArray,
+    double planetRadius, MeshExportFormat format, const char* exportPath, MeshExportStats& stats);
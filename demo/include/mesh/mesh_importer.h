@@ -0,0 +1,19 @@
+#pragma once
+
+// Project includes
+#include "math/types.h"
+
+// System includes
+#include <stdint.h>
+#include <vector>
+
+// Returns true if the file is an indexed polygon mesh supported by the importer (.obj or .ply)
+bool is_polygon_mesh_file(const char* meshPath);
+
+// Load an indexed polygon mesh (OBJ, ASCII or binary PLY) and convert it to halfedges. The halfedges of a face are consecutive, each one
+// starts at its vertex and its neighbors are (prev, next, twin) with INVALID_POINTER on the boundary, like the base neighbors of the CPU mesh
+bool import_polygon_mesh(const char* meshPath, std::vector<float3>& vertices, std::vector<uint32_t>& halfedgeVertices, std::vector<uint3>& halfedgeNeighbors);
+
+// Build the halfedges of a set of faces (ranges of the face vertex array), the twins are paired in parallel through an edge hash table.
+// Edges shared by more than two faces or by two faces of inconsistent orientations are left on the boundary
+void build_halfedges(const std::vector<uint32_t>& faceOffsets, const std::vector<uint32_t>& faceVertices, std::vector<uint32_t>& halfedgeVertices, std::vector<uint3>& halfedgeNeighbors);
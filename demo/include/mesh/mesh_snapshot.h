@@ -0,0 +1,49 @@
+#pragma once
+
+// System includes
+#include <stdint.h>
+#include <vector>
+
+// Refined state of a CBT mesh (CBT buffers, heapIDs and neighbors of the allocated bisectors), only the allocated bisectors are stored
+struct CBTMeshSnapshot
+{
+    // Layout of the mesh the snapshot was taken from
+    uint32_t totalNumElements = 0;
+    uint32_t baseDepth = 0;
+    uint32_t neighborsElementSize = 0;
+    // Content hash of the base mesh the bisectors subdivide
+    uint64_t baseMeshHash = 0;
+
+    // Raw content of the CBT buffers
+    uint32_t cbtBufferCount = 0;
+    std::vector<char> cbtBuffers[2];
+
+    // Allocated elements (one bit per element), their heapIDs and their neighbors (in the layout of the neighbor buffer) in element order
+    std::vector<uint64_t> allocationMask;
+    std::vector<uint64_t> heapIDArray;
+    std::vector<char> neighborsArray;
+};
+
+// Durations (in milliseconds) of the stages of the snapshot loading for a number of elements
+struct SnapshotBenchmark
+{
+    uint32_t numElements;
+    uint32_t fileSize;
+    double compactDuration;
+    double saveDuration;
+    double loadDuration;
+    double expandDuration;
+};
+
+// Gather the allocated elements (non zero heapID) of the full heapID and neighbor arrays, the layout fields must be set
+void compact_cbt_mesh_snapshot(const uint64_t* heapIDArray, const char* neighborsArray, CBTMeshSnapshot& snapshot);
+
+// Scatter the allocated elements into full heapID and neighbor arrays (the unallocated elements are cleared)
+void expand_cbt_mesh_snapshot(const CBTMeshSnapshot& snapshot, uint64_t* heapIDArray, char* neighborsArray);
+
+// Write and read a snapshot file (returns false if it can't be written, or doesn't exist or isn't valid)
+bool save_cbt_mesh_snapshot(const CBTMeshSnapshot& snapshot, const char* snapshotPath);
+bool load_cbt_mesh_snapshot(const char* snapshotPath, CBTMeshSnapshot& snapshot);
+
+// Times the compaction, save, load and expansion of synthetic snapshots of growing sizes (the scratch file is removed)
+void benchmark_cbt_mesh_snapshots(const char* scratchPath, std::vector<SnapshotBenchmark>& results);
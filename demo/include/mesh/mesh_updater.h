@@ -5,9 +5,20 @@
 
 // Project includes
 #include "mesh/mesh.h"
+#include "tools/readback_ring.h"
 
 // System includes
 #include <string>
+#include <vector>
+
+// Mesh of a batched update and the constant buffers that describe it
+struct MeshUpdateTarget
+{
+    const CBTMesh* mesh = nullptr;
+    ConstantBuffer geometryCB = 0;
+    ConstantBuffer updateCB = 0;
+    bool compact = false;
+};
 
 class MeshUpdater
 {
@@ -20,48 +31,108 @@ public:
     void initialize(GraphicsDevice graphicsDevice, CommandQueue cmdQ);
     void release();
 
-    // Reload shaders
-    void reload_shaders(const std::string& shaderLibrary, CBTType cbtType, const char* updateShader = "UpdateMesh.compute");
+    // Reload shaders (for the neighbor layout of the meshes that will be updated, see packed_neighbors)
+    void reload_shaders(const std::string& shaderLibrary, CBTType cbtType, bool packedNeighbors, const char* updateShader = "UpdateMesh.compute");
 
-    // Update a given mesh
-    void update(CommandBuffer cmd, CBTMesh& mesh, ConstantBuffer globalCB, ConstantBuffer geometryCB, ConstantBuffer updateCB);
+    // Update a given mesh (and compact its bisectors if requested and fragmented enough)
+    void update(CommandBuffer cmd, CBTMesh& mesh, ConstantBuffer globalCB, ConstantBuffer geometryCB, ConstantBuffer updateCB, bool compact = false);
+
+    // Update several meshes with a single barrier per pass (every pass is recorded for all the meshes before the next one)
+    void update(CommandBuffer cmd, const std::vector<MeshUpdateTarget>& targets, ConstantBuffer globalCB);
 
     // Make sure the mesh's topology is valid
     void validate(CommandBuffer cmd, const CBTMesh& mesh, ConstantBuffer geometryCB);
 
+    // Experimental: derive the neighbors from the heapIDs and count the bisectors for which they differ from the stored ones (needs to be recorded before validate)
+    void derive_adjacency(CommandBuffer cmd, const CBTMesh& mesh, ConstantBuffer geometryCB);
+
     // Reset the buffers
-    void reset_buffers(CommandBuffer cmd, const CBTMesh& mesh);
+    void reset_buffers(CommandBuffer cmd, const CBTMesh& mesh, ConstantBuffer geometryCB);
+
+    // Clear the elements before the base bisectors of a freshly created mesh (nothing to do afterwards or if it started from a snapshot)
+    void clear_unallocated_elements(CommandBuffer cmd, CBTMesh& mesh, ConstantBuffer geometryCB);
 
     // Prepare the mesh for indirect dispatches
     void prepare_indirection(CommandBuffer cmd, const CBTMesh& mesh, ConstantBuffer geometryCB);
 
-    // Control if the validation pass should run
+    // Result of the latest completed validation pass
     bool check_if_valid();
 
+    // Number of derived adjacency mismatches accumulated up to the latest completed validation pass
+    uint32_t get_derived_adjacency_mismatches() const { return m_DerivedAdjacencyMismatches; }
+
     // Query occupancy
     void query_occupancy(CommandBuffer cmdB, const CBTMesh& mesh);
 
-    // Get the occupancy
-    uint32_t get_occupancy();
+    // Get the latest completed occupancy (returns false if none completed since the last call)
+    bool get_occupancy(uint32_t& occupancy);
+
+    // Query the number of split and simplification requests of the last update
+    void query_convergence(CommandBuffer cmdB, const CBTMesh& mesh);
+
+    // Get the number of split and simplification requests (the mesh converged when they fit in the budgets)
+    // and the screen area (in pixels) covered by the bisectors that the update camera wants to split
+    bool get_convergence(uint32_t& splitRequests, uint32_t& simplifyRequests, uint32_t& underRefinedArea);
+
+    // Query the churn counters (accumulated since the creation of the mesh)
+    void query_churn(CommandBuffer cmdB, const CBTMesh& mesh);
+
+    // Get the number of bisectors that were merged shortly after a split and split shortly after a merge
+    bool get_churn(uint32_t& splitMergeCount, uint32_t& mergeSplitCount);
+
+    // Signal the readbacks recorded in the last executed command buffer (they are read a few frames later without stalling)
+    void submit_readbacks(CommandQueue cmdQ);
+
+private:
+    // Make sure every mesh of a batch has its own scratch buffers
+    void reserve_batch_buffers(uint32_t numTargets);
+
+    // Record the reset of a mesh without any barrier
+    void reset_buffers(CommandBuffer cmd, const CBTMesh& mesh, ConstantBuffer geometryCB, GraphicsBuffer memoryBuffer);
+
+    // Update the tree of the CBTs
+    void reduce(CommandBuffer cmd, const std::vector<MeshUpdateTarget>& targets);
+
+    // Prepare the meshes of a batch for indirect dispatches
+    void prepare_indirection(CommandBuffer cmd, const std::vector<MeshUpdateTarget>& targets);
+
+    // Renumber the allocated bisectors in spatial order
+    void compact(CommandBuffer cmd, const CBTMesh& mesh, ConstantBuffer geometryCB, ConstantBuffer updateCB);
 
 private:
     // Graphics Device
     GraphicsDevice m_Device = 0;
 
-    // Buffer that can be shared between the updates
-    GraphicsBuffer indirectBuffer = 0;
-    GraphicsBuffer memoryBuffer = 0;
+    // Neighbor layout the shaders were compiled for
+    bool m_PackedNeighbors = false;
+
+    // Buffer that can be shared between the updates (the dispatch arguments and memory counters are per mesh of a batch)
+    std::vector<GraphicsBuffer> indirectBuffers;
+    std::vector<GraphicsBuffer> memoryBuffers;
     GraphicsBuffer validationBuffer = 0;
-    GraphicsBuffer validationBufferRB = 0;
-    GraphicsBuffer occupancyBufferRB = 0;
+    GraphicsBuffer compactionBuffer = 0;
+
+    // Readbacks
+    ReadbackRing m_ValidationReadback = ReadbackRing();
+    ReadbackRing m_OccupancyReadback = ReadbackRing();
+    ReadbackRing m_ConvergenceReadback = ReadbackRing();
+    ReadbackRing m_ChurnReadback = ReadbackRing();
+    bool m_LastValidation = true;
+    uint32_t m_DerivedAdjacencyMismatches = 0;
 
     // Main update
     ComputeShader m_ResetCS = 0;
+    ComputeShader m_ClearUnallocatedElementsCS = 0;
+    ComputeShader m_PatchCullingCS = 0;
+    ComputeShader m_PatchCullingIndexationCS = 0;
     ComputeShader m_ClassifyCS = 0;
     ComputeShader m_SplitCS = 0;
+    ComputeShader m_SplitPredictedCS = 0;
     ComputeShader m_PrepareIndirectCS = 0;
+    ComputeShader m_PrepareClassificationIndirectCS = 0;
     ComputeShader m_AllocateCS = 0;
     ComputeShader m_BisectCS = 0;
+    ComputeShader m_ScatterNeighborsCS = 0;
     ComputeShader m_PropagateBisectCS = 0;
     ComputeShader m_PrepareSimplifyCS = 0;
     ComputeShader m_SimplifyCS = 0;
@@ -76,6 +147,27 @@ private:
     ComputeShader m_BisectorIndexationCS = 0;
     ComputeShader m_PrepareBisectorIndirectCS = 0;
 
+    // Welded vertices
+#if defined(WELDED_VERTICES)
+    ComputeShader m_WeldVerticesCS = 0;
+    ComputeShader m_ResolveWeldedVerticesCS = 0;
+    ComputeShader m_PrepareWeldedIndirectCS = 0;
+#endif
+
     // Debug
     ComputeShader m_ValidateCS = 0;
+
+    // Derived adjacency
+    ComputeShader m_ClearHeapIDHashCS = 0;
+    ComputeShader m_BuildHeapIDHashCS = 0;
+    ComputeShader m_DeriveAdjacencyCS = 0;
+
+    // Compaction
+    ComputeShader m_CompactionClearCS = 0;
+    ComputeShader m_CompactionCountCS = 0;
+    ComputeShader m_PrepareCompactionCS = 0;
+    ComputeShader m_CompactionScanCS = 0;
+    ComputeShader m_CompactionRemapCS = 0;
+    ComputeShader m_CompactionScatterCS = 0;
+    ComputeShader m_CompactionResolveCS = 0;
 };
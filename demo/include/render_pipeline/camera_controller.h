@@ -68,6 +68,9 @@ public:
     const Camera& get_camera() const { return m_Camera; }
     Camera& get_camera() { return m_Camera; }
 
+    // Get the velocity of the camera over the last update (in meters per second)
+    const double3& get_velocity() const { return m_Velocity; }
+
     // Update the camera matrices
     void evaluate_camera_matrices();
     void evaluate_distances();
@@ -117,4 +120,7 @@ protected:
 
     // Distance to the planet center
     double2 m_DistanceToPlanetCenter = { 0.0, 0.0 };
+
+    // Velocity of the camera
+    double3 m_Velocity = { 0.0, 0.0, 0.0 };
 };
\ No newline at end of file
@@ -11,12 +11,14 @@ const float g_EarthRadius = 6371000.0;
 const double3 g_EarthCenter = { 0.0, 0.0, 0.0 };
 const float g_EarthImpostorToggle = g_EarthRadius * 1.1f;
 const float g_EarthTriangleSize = 60.0f;
+const float g_EarthMaxDisplacement = 100.0f;
 
 // Moon data
 const float g_MoonRadius = 1737400.0;
 const double3 g_MoonCenter = double3({ 30000000.0, 12000000.0, 0.0 });
 const float g_MoonImpostorToggle = g_MoonRadius * 2.0f;
 const float g_MoonTriangleSize = 60.0f;
+const float g_MoonMaxDisplacement = 11000.0f;
 
 // Convert kmh to mpsec
 const float g_KMPerHourToMPerSec = 1.0f / 3.6f;
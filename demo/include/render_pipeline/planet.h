@@ -20,8 +20,8 @@ public:
 
     // Init and release
     void initialize(GraphicsDevice device, CommandQueue cmdQ, CommandBuffer cmdB,
-                    float planetRadius, const double3& planetCenter, float toggleDistance, float triangleSize, uint32_t materialID,
-                    const CPUMesh& mesh, const CBT& cbt);
+                    float planetRadius, const double3& planetCenter, float toggleDistance, float triangleSize, float maxDisplacement, uint32_t materialID,
+                    const CPUMesh& mesh, const CBT& cbt, const CBTMeshSnapshot* snapshot = nullptr);
     void release();
 
     // Reload shaders
@@ -30,15 +30,35 @@ public:
     // Pre-render loop call
     void upload_static_constant_buffers(CommandBuffer cmd);
 
-    // Update the constant buffers
-    void update_constant_buffers(CommandBuffer cmd, const UpdateProperties& updateProperties);
+    // Update the constant buffers (the additional views are classified on top of the update camera)
+    void update_constant_buffers(CommandBuffer cmd, const UpdateProperties& updateProperties, const std::vector<UpdateProperties>& additionalViews, const UpdateProperties* predictedView);
+    // Must be called once a synchronous update is recorded (the ages of the bisectors are counted in updates)
+    void complete_update();
 
     // Render planet
     void evaluate_leb(CommandBuffer cmdB, const Camera& camera, ConstantBuffer globalCB, GraphicsBuffer lebMatrixCache, bool clear, bool complete = false);
 
+#if defined(BISECTOR_CLUSTERS)
+    // Group the indexed bisectors into clusters and gather the bisectors of the visible ones for the visibility pass
+    void build_clusters(CommandBuffer cmdB, ConstantBuffer globalCB);
+#endif
+
+    // Asynchronous update (the preparation is recorded on the direct queue and the update on the compute queue)
+    void prepare_async_update(CommandBuffer cmdB);
+    void async_update(CommandBuffer cmdB, MeshUpdater& meshUpdater, ConstantBuffer globalCB, GraphicsBuffer lebMatrixCache, bool compact);
+    void complete_async_update();
+
+    // Recreate the neighbors update buffer when the bisections ratio changed (the device must be done with the mesh)
+    bool neighbors_update_buffer_outdated() const { return get_max_new_bisectors() != m_CBTMesh.maxNewBisectors; }
+    void resize_neighbors_update_buffer();
+
     // UI
     void render_ui(const char* planetName);
 
+    // Adapt the triangle size to keep the occupancy of the CBT and the update duration (in microseconds) under their limits
+    void adapt_triangle_size(uint32_t occupancy, uint64_t updateDuration);
+    bool adaptive_triangle_size() const { return m_AdaptiveTriangleSize; }
+
     // Is the panet close to the camera
     void planet_visibility(const Camera& camera, double& distance, bool& visible, bool& updatable) const;
     const CBTMesh& get_cbt_mesh() const { return m_CBTMesh; }
@@ -48,6 +68,20 @@ public:
     ConstantBuffer get_geometry_cb() const { return m_GeometryCB; }
     ConstantBuffer get_planet_cb() const { return m_PlanetCB; }
     ConstantBuffer get_update_cb() const { return m_UpdateCB; }
+    uint32_t get_split_budget() const { return m_SplitBudget > 0 ? (uint32_t)m_SplitBudget : UINT32_MAX; }
+    uint32_t get_simplify_budget() const { return m_SimplifyBudget > 0 ? (uint32_t)m_SimplifyBudget : UINT32_MAX; }
+    uint32_t get_max_new_bisectors() const { return m_CBTMesh.totalNumElements / (m_BisectionsRatio > 1 ? (uint32_t)m_BisectionsRatio : 1); }
+    float get_triangle_size() const;
+
+private:
+    // Upload the geometry constant buffer (it only changes with the neighbors update buffer)
+    void upload_geometry_cb(CommandBuffer cmd);
+
+    // Start a new incremental classification epoch if needed
+    void update_classification_epoch(const UpdateProperties& updateProperties);
+
+    // Evaluate the LEB positions of a version of the mesh
+    void evaluate_mesh_leb(CommandBuffer cmdB, const CBTMesh& mesh, ConstantBuffer globalCB, ConstantBuffer updateCB, GraphicsBuffer lebMatrixCache, bool complete);
 
 private:
     // General
@@ -56,21 +90,68 @@ private:
     // Static properties
     float m_PlanetRadius = 0.0;
     float m_ToggleDistance = 0.0;
+    float m_MaxDisplacement = 0.0;
     double3 m_PlanetCenter = { 0.0, 0.0, 0.0 };
     uint32_t m_MaterialID = UINT32_MAX;
 
     // Modifiable properties
     int32_t m_MaxSubdivisionDepth = 0;
     float m_TriangleSize = 0.0;
+    float m_CompactionThreshold = 0.0;
+    bool m_IncrementalClassification = false;
+    bool m_IncrementalLEB = false;
+    bool m_HorizonCulling = false;
+    bool m_PatchCulling = false;
+    int32_t m_SplitBudget = 0;
+    int32_t m_SimplifyBudget = 0;
+    int32_t m_PredictiveSplitBudget = 0;
+    int32_t m_BisectionsRatio = 0;
+    bool m_AdaptiveTriangleSize = false;
+    float m_TargetOccupancy = 0.0f;
+    float m_MaxUpdateDuration = 0.0f;
+    float m_SimplifyHysteresis = 0.0f;
+    int32_t m_MinBisectorAge = 0;
+    int32_t m_ChurnWindow = 0;
+
+    // Incremental classification state
+    uint32_t m_ClassificationEpoch = 0;
+    float m_ClassificationTravel = 0.0f;
+    double3 m_PrevCameraPosition = { 0.0, 0.0, 0.0 };
+    float3 m_EpochCameraForward = { 0.0, 0.0, 0.0 };
+    float m_EpochFOV = 0.0f;
+    float m_EpochTriangleSize = 0.0f;
+    int32_t m_EpochMaxSubdivisionDepth = 0;
+
+    // Split/merge hysteresis state
+    uint32_t m_UpdateIndex = 0;
+
+    // Adaptive triangle size state
+    float m_AdaptedTriangleSize = 0.0f;
+    uint32_t m_AdaptationUpdateIndex = 0;
 
     // Runtime resources
     CBTMesh m_CBTMesh = CBTMesh();
     BaseMesh m_BaseMesh = BaseMesh();
     ConstantBuffer m_GeometryCB = 0;
+    bool m_GeometryCBOutdated = false;
     ConstantBuffer m_PlanetCB = 0;
     ConstantBuffer m_UpdateCB = 0;
 
+    // Asynchronous update resources
+    UpdateCB m_UpdateCBData = UpdateCB();
+    ConstantBuffer m_AsyncUpdateCB = 0;
+    // Is the drawn topology produced by the asynchronous updates (their heapIDs are snapshot for the clusters)
+    bool m_AsyncTopology = false;
+
     // Compute shader
     ComputeShader m_LebEvalCS = 0;
     ComputeShader m_ClearCS = 0;
+#if defined(BISECTOR_CLUSTERS)
+    ComputeShader m_ClearClustersCS = 0;
+    ComputeShader m_InsertClustersCS = 0;
+    ComputeShader m_CountClustersCS = 0;
+    ComputeShader m_PrepareClusterIndirectCS = 0;
+    ComputeShader m_PlaceClustersCS = 0;
+    ComputeShader m_ScatterClustersCS = 0;
+#endif
 };
\ No newline at end of file
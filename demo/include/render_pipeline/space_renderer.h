@@ -4,6 +4,7 @@
 #include "rendering/frustum.h"
 #include "cbt/leb_matrix_cache.h"
 #include "cbt/cbt_utility.h"
+#include "mesh/mesh_exporter.h"
 #include "mesh/mesh_updater.h"
 #include "moon/moon_deformer.h"
 #include "render_pipeline/cubemap.h"
@@ -41,7 +42,15 @@ private:
     void reload_shaders();
     void initialize_geometry();
     void release_geometry();
+    void create_acceleration_structures();
+    void release_acceleration_structures();
+#if defined(WELDED_VERTICES)
+    BottomLevelAS select_blas(const CBTMesh& mesh, BottomLevelAS* blasArray, GraphicsBuffer* indexBufferArray);
+#endif
     void reset_cbt_type();
+    std::string snapshot_path(const char* planetName) const;
+    void save_snapshots();
+    void export_meshes(MeshExportFormat format);
 
     // Rendering
     void prepare_rendering(CommandBuffer cmd);
@@ -53,6 +62,10 @@ private:
     void ray_tracing_render_pipeline(CommandBuffer cmd, bool earthIsVisible, bool moonIsVisible, double earthDistance, double moonDistance);
     void render_pipeline(CommandBuffer cmd);
 
+    // Asynchronous update
+    void async_update(bool earthIsUpdatable, bool moonIsUpdatable, bool compact);
+    void complete_async_update(bool wait);
+
     // Update
     void update(double deltaTime);
     void evaluate_sun_direction();
@@ -73,6 +86,7 @@ private:
     std::string m_ProjectDir = "";
 
     // Global Rendering Resources
+    GlobalCB m_GlobalCBData = GlobalCB();
     ConstantBuffer m_GlobalCB = 0;
     RenderTexture m_DepthBuffer = 0;
     RenderTexture m_VisibilityBuffer = 0;
@@ -88,6 +102,9 @@ private:
     // POV management
     bool m_MirrorPOV = true;
     UpdateProperties m_UpdateProperties = UpdateProperties();
+    std::vector<UpdateProperties> m_AdditionalUpdateProperties;
+    bool m_PredictiveRefinement = false;
+    float m_LookaheadTime = 0.0f;
 
     // Sun parameters
     float m_SunElevation = 0.0f;
@@ -103,10 +120,37 @@ private:
     bool m_ActiveUpdate = false;
     bool m_ActiveWireFrame = false;
     bool m_EnableValidation = false;
+    bool m_DeriveAdjacency = false;
     bool m_EnableOccupancy = false;
+    int32_t m_CompactionInterval = 0;
+    uint32_t m_UpdateCounter = 0;
     float3 m_WireframeColor = { 0.6, 0.6, 0.6 };
     float m_WireframeSize = 0.5;
     uint32_t m_Occupancy = 0;
+    bool m_EnableConvergence = false;
+    uint32_t m_SplitRequests = 0;
+    uint32_t m_SimplifyRequests = 0;
+    uint32_t m_ConvergenceFrames = 0;
+    uint32_t m_SplitMergeChurn = 0;
+    uint32_t m_MergeSplitChurn = 0;
+    float m_UnderRefinedFraction = 0.0f;
+    bool m_AsyncUpdate = false;
+    bool m_BatchedUpdate = false;
+    bool m_WarmStart = false;
+    bool m_SaveSnapshots = false;
+    std::vector<SnapshotBenchmark> m_SnapshotBenchmarks;
+    bool m_ExportDisplacement = false;
+    MeshExportFormat m_ExportFormat = MeshExportFormat::Count;
+    MeshExportStats m_ExportStats = MeshExportStats();
+
+    // Asynchronous update
+    CommandBuffer m_AsyncCmdBuffer = 0;
+    ConstantBuffer m_AsyncGlobalCB = 0;
+    Fence m_AsyncFence = 0;
+    uint64_t m_AsyncFenceValue = 0;
+    bool m_AsyncUpdateInFlight = false;
+    bool m_AsyncEarthUpdated = false;
+    bool m_AsyncMoonUpdated = false;
 
     // Profiling data
     ProfilingHelper m_ProfilingHelper = ProfilingHelper();
@@ -116,6 +160,8 @@ private:
     LebMatrixCache m_LebMatrixCache = LebMatrixCache();
     CBTType m_CBTType = CBTType::Count;
     CBTType m_NewCBTType = CBTType::Count;
+    // Base mesh of the planets, used to decode the exported bisectors
+    CPUMesh m_PlanetCPUMesh = CPUMesh();
 
     // Water simulation
     WaterSimulation m_WaterSim = WaterSimulation();
@@ -144,5 +190,12 @@ private:
     TopLevelAS m_TLAS = 0;
     BottomLevelAS m_EarthBLAS = 0;
     BottomLevelAS m_MoonBLAS = 0;
+#if defined(WELDED_VERTICES)
+    // The asynchronous updates swap the vertex indices, each planet has a bottom level structure per index buffer
+    BottomLevelAS m_EarthBLASArray[2] = { 0, 0 };
+    BottomLevelAS m_MoonBLASArray[2] = { 0, 0 };
+    GraphicsBuffer m_EarthBLASIndexBuffer[2] = { 0, 0 };
+    GraphicsBuffer m_MoonBLASIndexBuffer[2] = { 0, 0 };
+#endif
     ComputeShader m_VisibilityRT = 0;
 };
\ No newline at end of file
@@ -8,6 +8,9 @@
 #include "render_pipeline/constant_buffers.h"
 #include "render_pipeline/camera.h"
 
+// System includes
+#include <vector>
+
 struct UpdateProperties
 {
     float4x4 viewProj = {};
@@ -17,10 +20,21 @@ struct UpdateProperties
     float farPlane = 0.0;
     float fov = 0.0;
     Frustum frustum = Frustum();
+    // Only used by the additional views, the update camera uses the screen size
+    float2 screenSize = {};
 };
 
 // Mirror the update properties from the camera
 void mirror_update_properties(const Camera& camera, UpdateProperties& updateProperties);
 
 // Apply the properties to the constant buffer
-void set_update_properties(const UpdateProperties& updateProps, UpdateCB& updateCB);
\ No newline at end of file
+void set_update_properties(const UpdateProperties& updateProps, UpdateCB& updateCB);
+
+// Apply the additional views to the constant buffer (relative to the update camera)
+void set_additional_update_views(const UpdateProperties& updateProps, const std::vector<UpdateProperties>& additionalViews, UpdateCB& updateCB);
+
+// Extrapolate the update properties along the camera velocity
+void predict_update_properties(const UpdateProperties& updateProps, const double3& velocity, float lookahead, UpdateProperties& predictedProps);
+
+// Apply the predicted view to the constant buffer (nullptr disables the predictive refinement)
+void set_predicted_update_view(const UpdateProperties& updateProps, const UpdateProperties* predictedView, UpdateCB& updateCB);
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+
+// Project includes
+#include "math/types.h"
+
+// Is a sphere fully hidden by the occluder sphere of the planet (everything is relative to the camera), mirrors HorizonSphereCulled
+bool horizon_sphere_culled(const float3& planetCenter, float occluderRadius, const float3& sphereCenter, float sphereRadius);
+
+// Is a bisector hidden behind the horizon of the planet (everything is relative to the camera), mirrors HorizonBisectorCulled
+bool horizon_bisector_culled(const float3& p0, const float3& p1, const float3& p2, const float3& planetCenter, float planetRadius, float maxDisplacement);
@@ -0,0 +1,24 @@
+#pragma once
+
+// System includes
+#include <stdint.h>
+
+// Read only view of a file mapped in memory
+struct MappedFile
+{
+	const char* data = nullptr;
+	uint64_t size = 0;
+
+	// OS handles
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+};
+
+// Map a whole file in memory (returns false if it doesn't exist or is empty)
+bool map_file(const char* filePath, MappedFile& file);
+
+// Release the view and the handles of a mapped file
+void unmap_file(MappedFile& file);
+
+// 64 bit hash of a memory range (FNV-1a over 8 byte words)
+uint64_t hash_memory(const char* data, uint64_t size);
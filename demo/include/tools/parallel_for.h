@@ -0,0 +1,9 @@
+#pragma once
+
+// System includes
+#include <functional>
+#include <stdint.h>
+
+// Runs a function over consecutive ranges [begin, end) of [0, count) on the available cores, every range except the last
+// one holds at least minRange indices (a single range runs on the calling thread)
+void parallel_for(uint32_t count, uint32_t minRange, const std::function<void(uint32_t, uint32_t)>& function);
@@ -0,0 +1,49 @@
+#pragma once
+
+// Project includes
+#include "graphics/types.h"
+
+// System includes
+#include <vector>
+
+// Default number of readbacks that can be in flight
+#define READBACK_RING_DEFAULT_DEPTH 3
+
+// Ring of readback buffers that allows to read GPU values a few frames late without waiting on the queue
+class ReadbackRing
+{
+public:
+	// Cst & Dst
+	ReadbackRing();
+	~ReadbackRing();
+
+	// Initialization and release
+	void initialize(GraphicsDevice device, uint32_t size, uint32_t depth = READBACK_RING_DEFAULT_DEPTH);
+	void release();
+
+	// Record the copy of a section of a buffer in the next free slot (returns false if every slot is in flight)
+	bool enqueue(CommandBuffer cmd, GraphicsBuffer buffer, uint32_t offset = 0);
+
+	// Signal the fence of the recorded copies, needs to be called after the command buffer is executed
+	void submit(CommandQueue cmdQ, CommandBufferType type = CommandBufferType::Default);
+
+	// Copy the most recent completed readback (returns false if none completed since the last call)
+	bool read(void* output);
+
+	// Number of readbacks that are recorded or in flight
+	uint32_t num_pending() const { return m_NumPending; }
+
+private:
+	// Resources
+	std::vector<GraphicsBuffer> m_Buffers;
+	std::vector<uint64_t> m_SlotFenceValues;
+	Fence m_Fence = 0;
+	uint64_t m_FenceValue = 0;
+
+	// Ring state
+	uint32_t m_Size = 0;
+	uint32_t m_Depth = 0;
+	uint32_t m_ReadIdx = 0;
+	uint32_t m_NumPending = 0;
+	uint32_t m_NumRecorded = 0;
+};
\ No newline at end of file
@@ -2,7 +2,7 @@
 #include "cbt/cbt.h"
 #include "graphics/dx12_backend.h"
 
-void initialize_gpu_cbt(const CBT& cbt, GraphicsDevice device, CommandQueue queue, CommandBuffer buffer, GPU_CBT& gpuCBT)
+void initialize_gpu_cbt(const CBT& cbt, GraphicsDevice device, CommandQueue queue, CommandBuffer buffer, GPU_CBT& gpuCBT, const char* const* bufferData)
 {
     // CBT upload buffers
     GraphicsBuffer cbtUploadBuffer[2] = { 0, 0 };
@@ -18,9 +18,10 @@ void initialize_gpu_cbt(const CBT& cbt, GraphicsDevice device, CommandQueue queu
         uint32_t bufferSize = cbt.buffer_size(bufferIdx);
         uint32_t elementSize = cbt.element_size(bufferIdx);
         gpuCBT.bufferArray[bufferIdx] = d3d12::graphics_resources::create_graphics_buffer(device, bufferSize, elementSize, GraphicsBufferType::Default);
+        gpuCBT.bufferSizeArray[bufferIdx] = bufferSize;
         {
             cbtUploadBuffer[bufferIdx] = d3d12::graphics_resources::create_graphics_buffer(device, bufferSize, elementSize, GraphicsBufferType::Upload);
-            d3d12::graphics_resources::set_buffer_data(cbtUploadBuffer[bufferIdx], cbt.raw_buffer(bufferIdx), bufferSize);
+            d3d12::graphics_resources::set_buffer_data(cbtUploadBuffer[bufferIdx], bufferData != nullptr ? bufferData[bufferIdx] : cbt.raw_buffer(bufferIdx), bufferSize);
             d3d12::command_buffer::copy_graphics_buffer(buffer, cbtUploadBuffer[bufferIdx], gpuCBT.bufferArray[bufferIdx]);
         }
     }
@@ -218,6 +218,19 @@ namespace d3d12
 			resourceState = targetState;
 		}
 
+		void uav_barrier(CommandBuffer commandBuffer)
+		{
+			// Get the internal command buffer structure
+			DX12CommandBuffer* dx12_commandBuffer = (DX12CommandBuffer*)commandBuffer;
+
+			// A UAV barrier without resource covers all the pending unordered accesses
+			D3D12_RESOURCE_BARRIER barrier = {};
+			barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+			barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+			barrier.UAV.pResource = nullptr;
+			dx12_commandBuffer->cmdList()->ResourceBarrier(1, &barrier);
+		}
+
 		void uav_barrier_buffer(CommandBuffer commandBuffer, GraphicsBuffer targetBuffer)
 		{
 			// Get the internal command buffer structure
@@ -1680,6 +1693,73 @@ namespace d3d12
 			dx12_gp->nextUsableHeap++;
 		}
 
+		void draw_indexed_indirect(CommandBuffer commandBuffer, GraphicsPipeline graphicsPipeline, GraphicsBuffer indexBuffer, GraphicsBuffer indirectBuffer, uint32_t bufferOffset)
+		{
+			// Convert the opaque types
+			DX12CommandBuffer* cmdI = (DX12CommandBuffer*)commandBuffer;
+			DX12GraphicsPipeline* dx12_gp = (DX12GraphicsPipeline*)graphicsPipeline;
+			DX12GraphicsBuffer* dx12_indexBuffer = (DX12GraphicsBuffer*)indexBuffer;
+			DX12GraphicsBuffer* dx12_indirectBuffer = (DX12GraphicsBuffer*)indirectBuffer;
+
+			// Make sure the buffer has at least the minimal required size
+			assert(dx12_indirectBuffer->bufferSize >= bufferOffset + sizeof(uint32_t) * 5);
+
+			// Make sure the resources are in the right state
+			async_change_resource_state(dx12_gp->barriersData, dx12_indexBuffer->resource, dx12_indexBuffer->state, D3D12_RESOURCE_STATE_INDEX_BUFFER);
+			async_change_resource_state(dx12_gp->barriersData, dx12_indirectBuffer->resource, dx12_indirectBuffer->state, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+
+			// Process all the barriers that have been registered (at once)
+			if (dx12_gp->barriersData.size() > 0)
+				cmdI->cmdList()->ResourceBarrier((uint32_t)dx12_gp->barriersData.size(), dx12_gp->barriersData.data());
+			dx12_gp->barriersData.clear();
+
+			// First we need to validate that the right heap will be used
+			validate_graphics_pipeline_heap(dx12_gp, cmdI->frameIdx);
+
+			// Set the pipeline state
+			cmdI->cmdList()->SetPipelineState(dx12_gp->pipelineStateObject);
+
+			// Set the root signature
+			cmdI->cmdList()->SetGraphicsRootSignature(dx12_gp->rootSignature->rootSignature);
+
+			// Set the descriptor heap
+			DX12DescriptorHeap& currentHeap_cbv_srv_uav = dx12_gp->CSUHeaps[dx12_gp->nextUsableHeap];
+			DX12DescriptorHeap& currentHeap_sampler = dx12_gp->samplerHeaps[dx12_gp->nextUsableHeap];
+			ID3D12DescriptorHeap* ppHeaps[] = { currentHeap_cbv_srv_uav.descriptorHeap, currentHeap_sampler.descriptorHeap };
+			cmdI->cmdList()->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+
+			// Set the tables
+			if (dx12_gp->rootSignature->srvIndex != UINT32_MAX)
+				cmdI->cmdList()->SetGraphicsRootDescriptorTable(dx12_gp->rootSignature->srvIndex, currentHeap_cbv_srv_uav.srvGPU);
+			if (dx12_gp->rootSignature->uavIndex != UINT32_MAX)
+				cmdI->cmdList()->SetGraphicsRootDescriptorTable(dx12_gp->rootSignature->uavIndex, currentHeap_cbv_srv_uav.uavGPU);
+			if (dx12_gp->rootSignature->cbvIndex != UINT32_MAX)
+				cmdI->cmdList()->SetGraphicsRootDescriptorTable(dx12_gp->rootSignature->cbvIndex, currentHeap_cbv_srv_uav.cbvGPU);
+			if (dx12_gp->rootSignature->samplerIndex != UINT32_MAX)
+				cmdI->cmdList()->SetGraphicsRootDescriptorTable(dx12_gp->rootSignature->samplerIndex, currentHeap_sampler.samplerGPU);
+
+			// Set the right stencil
+			cmdI->cmdList()->OMSetStencilRef(dx12_gp->stencilRef);
+
+			// Set the right primitive
+			cmdI->cmdList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+			// Bind the index buffer
+			{
+				D3D12_INDEX_BUFFER_VIEW indexBufferView;
+				indexBufferView.BufferLocation = dx12_indexBuffer->resource->GetGPUVirtualAddress();
+				indexBufferView.Format = DXGI_FORMAT_R32_UINT;
+				indexBufferView.SizeInBytes = (uint32_t)dx12_indexBuffer->bufferSize;
+				cmdI->cmdList()->IASetIndexBuffer(&indexBufferView);
+			}
+
+			// Execute the command
+			cmdI->cmdList()->ExecuteIndirect(dx12_gp->indexedCommandSignature, 1, dx12_indirectBuffer->resource, bufferOffset, nullptr, 0);
+
+			// This heap has been used for the current command buffer batch, we need to move to the next one
+			dx12_gp->nextUsableHeap++;
+		}
+
 		void build_blas(CommandBuffer cmdB, BottomLevelAS blas)
 		{
 			DX12CommandBuffer* dx12_cmdB = (DX12CommandBuffer*)cmdB;
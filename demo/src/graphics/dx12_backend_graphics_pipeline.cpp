@@ -297,6 +297,14 @@ namespace d3d12
             commandSignatureDesc.ByteStride = sizeof(D3D12_DRAW_ARGUMENTS);
             assert(deviceI->device->CreateCommandSignature(&commandSignatureDesc, nullptr, IID_PPV_ARGS(&dx12_graphicsPipeline->commandSignature)) == S_OK);
 
+            // Create the command signature of the indexed draws
+            D3D12_INDIRECT_ARGUMENT_DESC indexedArgumentDescs[1];
+            indexedArgumentDescs[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+            commandSignatureDesc.pArgumentDescs = indexedArgumentDescs;
+            commandSignatureDesc.ByteStride = sizeof(D3D12_DRAW_INDEXED_ARGUMENTS);
+            hr = deviceI->device->CreateCommandSignature(&commandSignatureDesc, nullptr, IID_PPV_ARGS(&dx12_graphicsPipeline->indexedCommandSignature));
+            assert_msg(hr == S_OK, "Failed to create the indexed command signature.");
+
             // Create the descriptor heap for this compute shader
             dx12_graphicsPipeline->CSUHeaps.push_back(create_descriptor_heap_suc(deviceI, gpd.srvCount, gpd.uavCount, gpd.cbvCount));
             dx12_graphicsPipeline->samplerHeaps.push_back(create_descriptor_heap_sampler(deviceI, max(1, gpd.samplerCount)));
@@ -398,6 +406,7 @@ namespace d3d12
 
             // Destroy the dx12 objects
             dx12_gp->commandSignature->Release();
+            dx12_gp->indexedCommandSignature->Release();
             dx12_gp->pipelineStateObject->Release();
             destroy_root_signature(dx12_gp->rootSignature);
 
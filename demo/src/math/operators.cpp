@@ -123,11 +123,27 @@
 #pragma endregion
 
 #pragma region double3
+    double3 normalize(const double3& v)
+    {
+        double l = sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+        return double3({ v.x / l, v.y / l , v.z / l });
+    }
+
     double length(const double3& v)
     {
         return sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
     }
 
+    double3 cross(const double3& v0, const double3& v1)
+    {
+        return double3({ v0.y * v1.z - v0.z * v1.y, v0.z * v1.x - v0.x * v1.z, v0.x * v1.y - v0.y * v1.x });
+    }
+
+    double dot(const double3& v0, const double3& v1)
+    {
+        return v0.x * v1.x + v0.y * v1.y + v0.z * v1.z;
+    }
+
     double3 lerp(const double3& v0, const double3& v1, double f)
     {
         double v_c = 1.0 - f;
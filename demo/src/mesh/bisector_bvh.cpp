@@ -0,0 +1,670 @@
+// Project includes
+#include "math/operators.h"
+#include "mesh/bisector_bvh.h"
+
+// System includes
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <thread>
+#include <xmmintrin.h>
+
+// Leaf of the elements that are tested outside of the tree
+#define BVH_OVERFLOW_LEAF 0xFFFFFFFE
+
+namespace
+{
+    void grow_bounds(float3& boundsMin, float3& boundsMax, const float3& p)
+    {
+        boundsMin = { std::min(boundsMin.x, p.x), std::min(boundsMin.y, p.y), std::min(boundsMin.z, p.z) };
+        boundsMax = { std::max(boundsMax.x, p.x), std::max(boundsMax.y, p.y), std::max(boundsMax.z, p.z) };
+    }
+
+    float half_area(const float3& boundsMin, const float3& boundsMax)
+    {
+        float3 e = boundsMax - boundsMin;
+        return e.x * e.y + e.y * e.z + e.z * e.x;
+    }
+
+    float axis_value(const float3& v, uint32_t axis)
+    {
+        return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+    }
+
+    // Möller-Trumbore intersection (both faces), returns true and updates the hit if closer than tMax
+    bool intersect_triangle(const float3& origin, const float3& direction, const float3* tri, float tMax, float& t, float& u, float& v)
+    {
+        float3 e0 = tri[1] - tri[0];
+        float3 e1 = tri[2] - tri[0];
+        float3 p = cross(direction, e1);
+        float det = dot(e0, p);
+        if (fabsf(det) < FLT_MIN)
+            return false;
+        float invDet = 1.0f / det;
+        float3 s = origin - tri[0];
+        float bu = dot(s, p) * invDet;
+        if (bu < 0.0f || bu > 1.0f)
+            return false;
+        float3 q = cross(s, e0);
+        float bv = dot(direction, q) * invDet;
+        if (bv < 0.0f || bu + bv > 1.0f)
+            return false;
+        float bt = dot(e1, q) * invDet;
+        if (bt < 0.0f || bt >= tMax)
+            return false;
+        t = bt;
+        u = bu;
+        v = bv;
+        return true;
+    }
+
+    // Slab test of a ray against a box
+    bool intersect_box(const float3& origin, const float3& invDirection, const float3& boundsMin, const float3& boundsMax, float tMax, float& tEntry)
+    {
+        float tx0 = (boundsMin.x - origin.x) * invDirection.x, tx1 = (boundsMax.x - origin.x) * invDirection.x;
+        float ty0 = (boundsMin.y - origin.y) * invDirection.y, ty1 = (boundsMax.y - origin.y) * invDirection.y;
+        float tz0 = (boundsMin.z - origin.z) * invDirection.z, tz1 = (boundsMax.z - origin.z) * invDirection.z;
+        float tNear = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0f));
+        float tFar = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::min(std::max(tz0, tz1), tMax));
+        tEntry = tNear;
+        return tNear <= tFar;
+    }
+
+    float3 inverse_direction(const float3& d)
+    {
+        // Zero components are replaced by a large value to keep the slabs finite
+        return { d.x != 0.0f ? 1.0f / d.x : FLT_MAX, d.y != 0.0f ? 1.0f / d.y : FLT_MAX, d.z != 0.0f ? 1.0f / d.z : FLT_MAX };
+    }
+}
+
+float3 BisectorBVH::to_local(const double3& position) const
+{
+    double3 local = position - m_Origin;
+    return { (float)local.x, (float)local.y, (float)local.z };
+}
+
+void BisectorBVH::build(const std::vector<uint64_t>& heapIDArray, const std::vector<float3>& vertices, const double3& origin)
+{
+    const uint32_t totalNumElements = (uint32_t)heapIDArray.size();
+    m_Origin = origin;
+    m_Triangles = vertices;
+    m_Triangles.resize(3 * totalNumElements);
+    m_HeapIDs = heapIDArray;
+    m_ElementLeaves.assign(totalNumElements, BVH_INVALID_INDEX);
+    m_Overflow.clear();
+    m_NumInserted = 0;
+
+    // Order the allocated bisectors along the bisection curve, consecutive ones are neighbors on the surface
+    std::vector<std::pair<uint64_t, uint32_t>> keys;
+    keys.reserve(totalNumElements);
+    for (uint32_t elementID = 0; elementID < totalNumElements; ++elementID)
+    {
+        uint64_t heapID = heapIDArray[elementID];
+        if (heapID != 0)
+            keys.push_back({ heapID << (64 - find_msb_64(heapID)), elementID });
+    }
+    std::sort(keys.begin(), keys.end());
+    m_NumIndexed = (uint32_t)keys.size();
+
+    // Group them into leaves
+    const uint32_t numLeaves = (m_NumIndexed + BVH_LEAF_SIZE - 1) / BVH_LEAF_SIZE;
+    m_Leaves.resize(numLeaves);
+    m_LeafElements.resize(numLeaves * BVH_LEAF_CAPACITY);
+    m_LeafBounds.resize(2 * numLeaves);
+    m_LeafOrder.resize(numLeaves);
+    m_LeafNodes.resize(numLeaves);
+    for (uint32_t leafIdx = 0; leafIdx < numLeaves; ++leafIdx)
+    {
+        Leaf& leaf = m_Leaves[leafIdx];
+        leaf.firstElement = leafIdx * BVH_LEAF_CAPACITY;
+        leaf.numElements = std::min(m_NumIndexed - leafIdx * BVH_LEAF_SIZE, (uint32_t)BVH_LEAF_SIZE);
+
+        float3 boundsMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float3 boundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (uint32_t eIdx = 0; eIdx < leaf.numElements; ++eIdx)
+        {
+            uint32_t elementID = keys[leafIdx * BVH_LEAF_SIZE + eIdx].second;
+            m_LeafElements[leaf.firstElement + eIdx] = elementID;
+            m_ElementLeaves[elementID] = leafIdx;
+            for (uint32_t vIdx = 0; vIdx < 3; ++vIdx)
+                grow_bounds(boundsMin, boundsMax, m_Triangles[3 * elementID + vIdx]);
+        }
+        m_LeafBounds[2 * leafIdx] = boundsMin;
+        m_LeafBounds[2 * leafIdx + 1] = boundsMax;
+        m_LeafOrder[leafIdx] = leafIdx;
+    }
+
+    // A binary tree over the leaves, the sub-trees large enough are built in parallel
+    m_Nodes.resize(numLeaves > 0 ? 2 * numLeaves - 1 : 0);
+    m_NodeParents.resize(m_Nodes.size());
+    if (numLeaves > 0)
+    {
+        m_NodeParents[0] = BVH_INVALID_INDEX;
+        build_node(0, 0, numLeaves, 0, std::max(std::thread::hardware_concurrency(), 1u));
+    }
+}
+
+void BisectorBVH::build_node(uint32_t nodeIdx, uint32_t begin, uint32_t end, uint32_t depth, uint32_t threadBudget)
+{
+    Node& node = m_Nodes[nodeIdx];
+    const uint32_t numLeaves = end - begin;
+    if (numLeaves == 1)
+    {
+        uint32_t leafIdx = m_LeafOrder[begin];
+        node.boundsMin = m_LeafBounds[2 * leafIdx];
+        node.boundsMax = m_LeafBounds[2 * leafIdx + 1];
+        node.child = BVH_INVALID_INDEX;
+        node.leaf = leafIdx;
+        m_LeafNodes[leafIdx] = nodeIdx;
+        return;
+    }
+
+    // Bounds of the leaf centroids
+    float3 centroidMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float3 centroidMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (uint32_t idx = begin; idx < end; ++idx)
+    {
+        uint32_t leafIdx = m_LeafOrder[idx];
+        grow_bounds(centroidMin, centroidMax, (m_LeafBounds[2 * leafIdx] + m_LeafBounds[2 * leafIdx + 1]) * 0.5f);
+    }
+
+    // Evaluate the binned SAH on every axis
+    float bestCost = FLT_MAX;
+    uint32_t bestAxis = 0, bestBin = 0;
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        float cMin = axis_value(centroidMin, axis);
+        float extent = axis_value(centroidMax, axis) - cMin;
+        if (extent <= 0.0f)
+            continue;
+        float scale = BVH_SAH_BINS / extent;
+
+        uint32_t binCounts[BVH_SAH_BINS] = {};
+        float3 binMin[BVH_SAH_BINS], binMax[BVH_SAH_BINS];
+        for (uint32_t binIdx = 0; binIdx < BVH_SAH_BINS; ++binIdx)
+        {
+            binMin[binIdx] = { FLT_MAX, FLT_MAX, FLT_MAX };
+            binMax[binIdx] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        }
+        for (uint32_t idx = begin; idx < end; ++idx)
+        {
+            uint32_t leafIdx = m_LeafOrder[idx];
+            const float3& lMin = m_LeafBounds[2 * leafIdx];
+            const float3& lMax = m_LeafBounds[2 * leafIdx + 1];
+            float c = (axis_value(lMin, axis) + axis_value(lMax, axis)) * 0.5f;
+            uint32_t binIdx = std::min((uint32_t)((c - cMin) * scale), (uint32_t)BVH_SAH_BINS - 1);
+            binCounts[binIdx]++;
+            grow_bounds(binMin[binIdx], binMax[binIdx], lMin);
+            grow_bounds(binMin[binIdx], binMax[binIdx], lMax);
+        }
+
+        // Sweep from the right to accumulate the costs of the right sides
+        float rightCost[BVH_SAH_BINS];
+        float3 accMin = { FLT_MAX, FLT_MAX, FLT_MAX }, accMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        uint32_t accCount = 0;
+        for (uint32_t binIdx = BVH_SAH_BINS - 1; binIdx > 0; --binIdx)
+        {
+            accCount += binCounts[binIdx];
+            if (binCounts[binIdx] > 0)
+            {
+                grow_bounds(accMin, accMax, binMin[binIdx]);
+                grow_bounds(accMin, accMax, binMax[binIdx]);
+            }
+            rightCost[binIdx] = accCount > 0 ? half_area(accMin, accMax) * accCount : FLT_MAX;
+        }
+
+        // Sweep from the left and keep the best split
+        accMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+        accMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        accCount = 0;
+        for (uint32_t binIdx = 0; binIdx < BVH_SAH_BINS - 1; ++binIdx)
+        {
+            accCount += binCounts[binIdx];
+            if (binCounts[binIdx] > 0)
+            {
+                grow_bounds(accMin, accMax, binMin[binIdx]);
+                grow_bounds(accMin, accMax, binMax[binIdx]);
+            }
+            if (accCount == 0 || accCount == numLeaves)
+                continue;
+            float cost = half_area(accMin, accMax) * accCount + rightCost[binIdx + 1];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = binIdx;
+            }
+        }
+    }
+
+    // Partition the leaves (in the middle of the curve order if all the centroids are in the same bin or if the
+    // tree gets too deep, a median split keeps the remaining depth logarithmic and the traversal stack bounded)
+    uint32_t middle = begin + numLeaves / 2;
+    if (bestCost < FLT_MAX && depth < BVH_STACK_SIZE / 2)
+    {
+        float cMin = axis_value(centroidMin, bestAxis);
+        float scale = BVH_SAH_BINS / (axis_value(centroidMax, bestAxis) - cMin);
+        uint32_t* split = std::partition(m_LeafOrder.data() + begin, m_LeafOrder.data() + end, [&](uint32_t leafIdx)
+        {
+            float c = (axis_value(m_LeafBounds[2 * leafIdx], bestAxis) + axis_value(m_LeafBounds[2 * leafIdx + 1], bestAxis)) * 0.5f;
+            return std::min((uint32_t)((c - cMin) * scale), (uint32_t)BVH_SAH_BINS - 1) <= bestBin;
+        });
+        middle = (uint32_t)(split - m_LeafOrder.data());
+    }
+
+    // The first child follows the node, the second one follows the sub-tree of the first one
+    uint32_t leftIdx = nodeIdx + 1;
+    uint32_t rightIdx = nodeIdx + 2 * (middle - begin);
+    m_NodeParents[leftIdx] = nodeIdx;
+    m_NodeParents[rightIdx] = nodeIdx;
+    if (threadBudget > 1 && numLeaves >= BVH_PARALLEL_LEAVES)
+    {
+        std::thread leftThread(&BisectorBVH::build_node, this, leftIdx, begin, middle, depth + 1, threadBudget / 2);
+        build_node(rightIdx, middle, end, depth + 1, threadBudget - threadBudget / 2);
+        leftThread.join();
+    }
+    else
+    {
+        build_node(leftIdx, begin, middle, depth + 1, 1);
+        build_node(rightIdx, middle, end, depth + 1, 1);
+    }
+
+    // The sub-trees write disjoint ranges of the node array
+    node.boundsMin = m_Nodes[leftIdx].boundsMin;
+    node.boundsMax = m_Nodes[leftIdx].boundsMax;
+    grow_bounds(node.boundsMin, node.boundsMax, m_Nodes[rightIdx].boundsMin);
+    grow_bounds(node.boundsMin, node.boundsMax, m_Nodes[rightIdx].boundsMax);
+    node.child = rightIdx;
+    node.leaf = BVH_INVALID_INDEX;
+}
+
+void BisectorBVH::refit_leaf(uint32_t leafIdx)
+{
+    const Leaf& leaf = m_Leaves[leafIdx];
+    float3 boundsMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float3 boundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (uint32_t eIdx = 0; eIdx < leaf.numElements; ++eIdx)
+    {
+        uint32_t elementID = m_LeafElements[leaf.firstElement + eIdx];
+        if (m_HeapIDs[elementID] == 0)
+            continue;
+        for (uint32_t vIdx = 0; vIdx < 3; ++vIdx)
+            grow_bounds(boundsMin, boundsMax, m_Triangles[3 * elementID + vIdx]);
+    }
+    m_LeafBounds[2 * leafIdx] = boundsMin;
+    m_LeafBounds[2 * leafIdx + 1] = boundsMax;
+
+    // Walk up until the bounds don't change anymore
+    uint32_t nodeIdx = m_LeafNodes[leafIdx];
+    m_Nodes[nodeIdx].boundsMin = boundsMin;
+    m_Nodes[nodeIdx].boundsMax = boundsMax;
+    for (nodeIdx = m_NodeParents[nodeIdx]; nodeIdx != BVH_INVALID_INDEX; nodeIdx = m_NodeParents[nodeIdx])
+    {
+        Node& node = m_Nodes[nodeIdx];
+        const Node& left = m_Nodes[nodeIdx + 1];
+        const Node& right = m_Nodes[node.child];
+        float3 newMin = left.boundsMin, newMax = left.boundsMax;
+        grow_bounds(newMin, newMax, right.boundsMin);
+        grow_bounds(newMin, newMax, right.boundsMax);
+        if (memcmp(&newMin, &node.boundsMin, sizeof(float3)) == 0 && memcmp(&newMax, &node.boundsMax, sizeof(float3)) == 0)
+            break;
+        node.boundsMin = newMin;
+        node.boundsMax = newMax;
+    }
+}
+
+void BisectorBVH::remove_element(uint32_t elementID)
+{
+    uint32_t leafIdx = m_ElementLeaves[elementID];
+    m_ElementLeaves[elementID] = BVH_INVALID_INDEX;
+    if (leafIdx == BVH_OVERFLOW_LEAF)
+    {
+        m_Overflow.erase(std::find(m_Overflow.begin(), m_Overflow.end(), elementID));
+        return;
+    }
+
+    // The bounds of the leaf stay conservative until its next refit
+    Leaf& leaf = m_Leaves[leafIdx];
+    uint32_t* elements = &m_LeafElements[leaf.firstElement];
+    uint32_t eIdx = (uint32_t)(std::find(elements, elements + leaf.numElements, elementID) - elements);
+    elements[eIdx] = elements[--leaf.numElements];
+}
+
+uint32_t BisectorBVH::insert_element(uint32_t elementID)
+{
+    float3 triMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float3 triMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (uint32_t vIdx = 0; vIdx < 3; ++vIdx)
+        grow_bounds(triMin, triMax, m_Triangles[3 * elementID + vIdx]);
+
+    // Branch and bound search of the leaf with spare room whose insertion grows the surface of the tree the least. The cost of
+    // a node is the growth of its ancestors (induced) plus its own, it bounds the cost of every leaf of its sub-tree
+    uint32_t bestLeaf = BVH_INVALID_INDEX;
+    float bestCost = FLT_MAX;
+    std::vector<std::pair<float, uint32_t>> queue;
+    queue.push_back({ 0.0f, 0 });
+    auto closest = [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) { return a.first > b.first; };
+    while (!queue.empty())
+    {
+        std::pop_heap(queue.begin(), queue.end(), closest);
+        std::pair<float, uint32_t> entry = queue.back();
+        queue.pop_back();
+        if (entry.first >= bestCost)
+            break;
+
+        const Node& node = m_Nodes[entry.second];
+        float3 grownMin = node.boundsMin, grownMax = node.boundsMax;
+        grow_bounds(grownMin, grownMax, triMin);
+        grow_bounds(grownMin, grownMax, triMax);
+        float cost = entry.first + half_area(grownMin, grownMax) - half_area(node.boundsMin, node.boundsMax);
+        if (cost >= bestCost)
+            continue;
+
+        if (node.leaf != BVH_INVALID_INDEX)
+        {
+            // Full leaves are skipped
+            if (m_Leaves[node.leaf].numElements < BVH_LEAF_CAPACITY)
+            {
+                bestCost = cost;
+                bestLeaf = node.leaf;
+            }
+            continue;
+        }
+        queue.push_back({ cost, entry.second + 1 });
+        std::push_heap(queue.begin(), queue.end(), closest);
+        queue.push_back({ cost, node.child });
+        std::push_heap(queue.begin(), queue.end(), closest);
+    }
+
+    // If every leaf is full the element is tested outside of the tree
+    if (bestLeaf == BVH_INVALID_INDEX)
+    {
+        m_ElementLeaves[elementID] = BVH_OVERFLOW_LEAF;
+        m_Overflow.push_back(elementID);
+        return BVH_INVALID_INDEX;
+    }
+    Leaf& leaf = m_Leaves[bestLeaf];
+    m_LeafElements[leaf.firstElement + leaf.numElements++] = elementID;
+    m_ElementLeaves[elementID] = bestLeaf;
+    m_NumInserted++;
+    return bestLeaf;
+}
+
+void BisectorBVH::refit(const std::vector<uint64_t>& heapIDArray, const std::vector<float3>& vertices, const double3& origin,
+    const uint32_t* modifiedElements, uint32_t numModifiedElements)
+{
+    // The elements whose heapID changed don't have valid vertices anymore, the slots are reused anywhere on the surface
+    // so they leave their leaf (its bounds stay conservative)
+    const uint32_t totalNumElements = (uint32_t)m_HeapIDs.size();
+    for (uint32_t elementID = 0; elementID < totalNumElements; ++elementID)
+    {
+        if (m_HeapIDs[elementID] == heapIDArray[elementID])
+            continue;
+        m_HeapIDs[elementID] = 0;
+        if (m_ElementLeaves[elementID] != BVH_INVALID_INDEX)
+            remove_element(elementID);
+    }
+
+    // Copy the new vertices in the local space of the tree
+    double3 offset = origin - m_Origin;
+    std::vector<uint32_t> dirtyLeaves;
+    for (uint32_t mIdx = 0; mIdx < numModifiedElements; ++mIdx)
+    {
+        uint32_t elementID = modifiedElements[mIdx];
+        m_HeapIDs[elementID] = heapIDArray[elementID];
+        for (uint32_t vIdx = 0; vIdx < 3; ++vIdx)
+        {
+            const float3& v = vertices[3 * elementID + vIdx];
+            m_Triangles[3 * elementID + vIdx] = { (float)(v.x + offset.x), (float)(v.y + offset.y), (float)(v.z + offset.z) };
+        }
+
+        // The elements that left their leaf are inserted where they fit best
+        uint32_t leafIdx = m_ElementLeaves[elementID];
+        if (leafIdx == BVH_INVALID_INDEX && !m_Nodes.empty())
+            leafIdx = insert_element(elementID);
+        if (leafIdx != BVH_INVALID_INDEX && leafIdx != BVH_OVERFLOW_LEAF)
+            dirtyLeaves.push_back(leafIdx);
+    }
+
+    // Refit the modified leaves and their ancestors
+    std::sort(dirtyLeaves.begin(), dirtyLeaves.end());
+    dirtyLeaves.erase(std::unique(dirtyLeaves.begin(), dirtyLeaves.end()), dirtyLeaves.end());
+    for (uint32_t leafIdx : dirtyLeaves)
+        refit_leaf(leafIdx);
+}
+
+bool BisectorBVH::needs_rebuild() const
+{
+    return m_NumInserted > BVH_REBUILD_INSERTION_RATIO * m_NumIndexed || m_Overflow.size() > BVH_REBUILD_OVERFLOW;
+}
+
+bool BisectorBVH::intersect(const BVHRay& ray, BVHHit& hit) const
+{
+    float3 origin = to_local(ray.origin);
+    float3 invDirection = inverse_direction(ray.direction);
+    hit = BVHHit();
+    float tMax = ray.tMax;
+
+    // Traverse the tree, the closest child first
+    uint32_t stack[BVH_STACK_SIZE];
+    uint32_t stackSize = 0;
+    float tEntry;
+    if (!m_Nodes.empty() && intersect_box(origin, invDirection, m_Nodes[0].boundsMin, m_Nodes[0].boundsMax, tMax, tEntry))
+        stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        uint32_t nodeIdx = stack[--stackSize];
+        const Node& node = m_Nodes[nodeIdx];
+        if (node.leaf != BVH_INVALID_INDEX)
+        {
+            const Leaf& leaf = m_Leaves[node.leaf];
+            for (uint32_t eIdx = 0; eIdx < leaf.numElements; ++eIdx)
+            {
+                uint32_t elementID = m_LeafElements[leaf.firstElement + eIdx];
+                if (m_HeapIDs[elementID] != 0 && intersect_triangle(origin, ray.direction, &m_Triangles[3 * elementID], tMax, hit.t, hit.u, hit.v))
+                {
+                    tMax = hit.t;
+                    hit.element = elementID;
+                }
+            }
+            continue;
+        }
+
+        uint32_t leftIdx = nodeIdx + 1;
+        float tLeft, tRight;
+        bool hitLeft = intersect_box(origin, invDirection, m_Nodes[leftIdx].boundsMin, m_Nodes[leftIdx].boundsMax, tMax, tLeft);
+        bool hitRight = intersect_box(origin, invDirection, m_Nodes[node.child].boundsMin, m_Nodes[node.child].boundsMax, tMax, tRight);
+        if (hitLeft && hitRight)
+        {
+            stack[stackSize++] = tLeft < tRight ? node.child : leftIdx;
+            stack[stackSize++] = tLeft < tRight ? leftIdx : node.child;
+        }
+        else if (hitLeft)
+            stack[stackSize++] = leftIdx;
+        else if (hitRight)
+            stack[stackSize++] = node.child;
+    }
+
+    // Elements allocated since the build
+    for (uint32_t elementID : m_Overflow)
+    {
+        if (m_HeapIDs[elementID] != 0 && intersect_triangle(origin, ray.direction, &m_Triangles[3 * elementID], tMax, hit.t, hit.u, hit.v))
+        {
+            tMax = hit.t;
+            hit.element = elementID;
+        }
+    }
+    return hit.element != BVH_INVALID_INDEX;
+}
+
+bool BisectorBVH::occluded(const BVHRay& ray) const
+{
+    float3 origin = to_local(ray.origin);
+    float3 invDirection = inverse_direction(ray.direction);
+    float t, u, v;
+
+    // Any hit terminates the traversal
+    uint32_t stack[BVH_STACK_SIZE];
+    uint32_t stackSize = m_Nodes.empty() ? 0 : 1;
+    stack[0] = 0;
+    while (stackSize > 0)
+    {
+        uint32_t nodeIdx = stack[--stackSize];
+        const Node& node = m_Nodes[nodeIdx];
+        if (!intersect_box(origin, invDirection, node.boundsMin, node.boundsMax, ray.tMax, t))
+            continue;
+        if (node.leaf != BVH_INVALID_INDEX)
+        {
+            const Leaf& leaf = m_Leaves[node.leaf];
+            for (uint32_t eIdx = 0; eIdx < leaf.numElements; ++eIdx)
+            {
+                uint32_t elementID = m_LeafElements[leaf.firstElement + eIdx];
+                if (m_HeapIDs[elementID] != 0 && intersect_triangle(origin, ray.direction, &m_Triangles[3 * elementID], ray.tMax, t, u, v))
+                    return true;
+            }
+            continue;
+        }
+        stack[stackSize++] = node.child;
+        stack[stackSize++] = nodeIdx + 1;
+    }
+
+    for (uint32_t elementID : m_Overflow)
+    {
+        if (m_HeapIDs[elementID] != 0 && intersect_triangle(origin, ray.direction, &m_Triangles[3 * elementID], ray.tMax, t, u, v))
+            return true;
+    }
+    return false;
+}
+
+void BisectorBVH::intersect_packet(const BVHRay rays[4], BVHHit hits[4]) const
+{
+    // Rays in structure of arrays
+    alignas(16) float ox[4], oy[4], oz[4], dx[4], dy[4], dz[4], idx[4], idy[4], idz[4], tMax[4];
+    for (uint32_t rIdx = 0; rIdx < 4; ++rIdx)
+    {
+        float3 origin = to_local(rays[rIdx].origin);
+        float3 invDirection = inverse_direction(rays[rIdx].direction);
+        ox[rIdx] = origin.x; oy[rIdx] = origin.y; oz[rIdx] = origin.z;
+        dx[rIdx] = rays[rIdx].direction.x; dy[rIdx] = rays[rIdx].direction.y; dz[rIdx] = rays[rIdx].direction.z;
+        idx[rIdx] = invDirection.x; idy[rIdx] = invDirection.y; idz[rIdx] = invDirection.z;
+        tMax[rIdx] = rays[rIdx].tMax;
+        hits[rIdx] = BVHHit();
+    }
+    const __m128 rOx = _mm_load_ps(ox), rOy = _mm_load_ps(oy), rOz = _mm_load_ps(oz);
+    const __m128 rDx = _mm_load_ps(dx), rDy = _mm_load_ps(dy), rDz = _mm_load_ps(dz);
+    const __m128 rIdx = _mm_load_ps(idx), rIdy = _mm_load_ps(idy), rIdz = _mm_load_ps(idz);
+    __m128 rTMax = _mm_load_ps(tMax);
+    __m128 rU = _mm_setzero_ps(), rV = _mm_setzero_ps();
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+
+    // Intersection of the packet with a triangle, updates the closest hits
+    auto packet_triangle = [&](uint32_t elementID)
+    {
+        const float3* tri = &m_Triangles[3 * elementID];
+        float3 e0 = tri[1] - tri[0];
+        float3 e1 = tri[2] - tri[0];
+        __m128 e0x = _mm_set1_ps(e0.x), e0y = _mm_set1_ps(e0.y), e0z = _mm_set1_ps(e0.z);
+        __m128 e1x = _mm_set1_ps(e1.x), e1y = _mm_set1_ps(e1.y), e1z = _mm_set1_ps(e1.z);
+
+        // p = d x e1, det = e0.p
+        __m128 px = _mm_sub_ps(_mm_mul_ps(rDy, e1z), _mm_mul_ps(rDz, e1y));
+        __m128 py = _mm_sub_ps(_mm_mul_ps(rDz, e1x), _mm_mul_ps(rDx, e1z));
+        __m128 pz = _mm_sub_ps(_mm_mul_ps(rDx, e1y), _mm_mul_ps(rDy, e1x));
+        __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e0x, px), _mm_mul_ps(e0y, py)), _mm_mul_ps(e0z, pz));
+        __m128 invDet = _mm_div_ps(one, det);
+
+        // s = o - v0, u = s.p / det
+        __m128 sx = _mm_sub_ps(rOx, _mm_set1_ps(tri[0].x));
+        __m128 sy = _mm_sub_ps(rOy, _mm_set1_ps(tri[0].y));
+        __m128 sz = _mm_sub_ps(rOz, _mm_set1_ps(tri[0].z));
+        __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), invDet);
+
+        // q = s x e0, v = d.q / det, t = e1.q / det
+        __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e0z), _mm_mul_ps(sz, e0y));
+        __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e0x), _mm_mul_ps(sx, e0z));
+        __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e0y), _mm_mul_ps(sy, e0x));
+        __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rDx, qx), _mm_mul_ps(rDy, qy)), _mm_mul_ps(rDz, qz)), invDet);
+        __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, qx), _mm_mul_ps(e1y, qy)), _mm_mul_ps(e1z, qz)), invDet);
+
+        // Degenerate determinants produce infinities or NaNs that fail the comparisons
+        __m128 mask = _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+        mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmplt_ps(t, rTMax)));
+        int hitMask = _mm_movemask_ps(mask);
+        if (hitMask == 0)
+            return;
+        rTMax = _mm_or_ps(_mm_and_ps(mask, t), _mm_andnot_ps(mask, rTMax));
+        rU = _mm_or_ps(_mm_and_ps(mask, u), _mm_andnot_ps(mask, rU));
+        rV = _mm_or_ps(_mm_and_ps(mask, v), _mm_andnot_ps(mask, rV));
+        for (uint32_t rayIdx = 0; rayIdx < 4; ++rayIdx)
+        {
+            if (hitMask & (1 << rayIdx))
+                hits[rayIdx].element = elementID;
+        }
+    };
+
+    // The packet descends in a node as long as one of its rays overlaps it
+    uint32_t stack[BVH_STACK_SIZE];
+    uint32_t stackSize = m_Nodes.empty() ? 0 : 1;
+    stack[0] = 0;
+    while (stackSize > 0)
+    {
+        uint32_t nodeIdx = stack[--stackSize];
+        const Node& node = m_Nodes[nodeIdx];
+        __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin.x), rOx), rIdx);
+        __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax.x), rOx), rIdx);
+        __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin.y), rOy), rIdy);
+        __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax.y), rOy), rIdy);
+        __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin.z), rOz), rIdz);
+        __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax.z), rOz), rIdz);
+        __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), _mm_max_ps(_mm_min_ps(tz0, tz1), zero));
+        __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), _mm_min_ps(_mm_max_ps(tz0, tz1), rTMax));
+        if (_mm_movemask_ps(_mm_cmple_ps(tNear, tFar)) == 0)
+            continue;
+
+        if (node.leaf != BVH_INVALID_INDEX)
+        {
+            const Leaf& leaf = m_Leaves[node.leaf];
+            for (uint32_t eIdx = 0; eIdx < leaf.numElements; ++eIdx)
+            {
+                uint32_t elementID = m_LeafElements[leaf.firstElement + eIdx];
+                if (m_HeapIDs[elementID] != 0)
+                    packet_triangle(elementID);
+            }
+            continue;
+        }
+
+        // Visit first the child on the side the first ray comes from (along the axis that separates the children the most)
+        const Node& left = m_Nodes[nodeIdx + 1];
+        const Node& right = m_Nodes[node.child];
+        float3 separation = (right.boundsMin + right.boundsMax) - (left.boundsMin + left.boundsMax);
+        float ax = fabsf(separation.x), ay = fabsf(separation.y), az = fabsf(separation.z);
+        float axisSeparation = ax > ay ? (ax > az ? separation.x : separation.z) : (ay > az ? separation.y : separation.z);
+        float axisDirection = ax > ay ? (ax > az ? dx[0] : dz[0]) : (ay > az ? dy[0] : dz[0]);
+        bool leftFirst = (axisSeparation > 0.0f) == (axisDirection > 0.0f);
+        stack[stackSize++] = leftFirst ? node.child : nodeIdx + 1;
+        stack[stackSize++] = leftFirst ? nodeIdx + 1 : node.child;
+    }
+
+    // Elements allocated since the build
+    for (uint32_t elementID : m_Overflow)
+    {
+        if (m_HeapIDs[elementID] != 0)
+            packet_triangle(elementID);
+    }
+
+    // Write back the distances and coordinates of the hits
+    _mm_store_ps(tMax, rTMax);
+    alignas(16) float u[4], v[4];
+    _mm_store_ps(u, rU);
+    _mm_store_ps(v, rV);
+    for (uint32_t rayIdx = 0; rayIdx < 4; ++rayIdx)
+    {
+        if (hits[rayIdx].element == BVH_INVALID_INDEX)
+            continue;
+        hits[rayIdx].t = tMax[rayIdx];
+        hits[rayIdx].u = u[rayIdx];
+        hits[rayIdx].v = v[rayIdx];
+    }
+}
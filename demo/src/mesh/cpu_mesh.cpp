@@ -2,84 +2,588 @@
 #include "cbt/bisector.h"
 #include "math/operators.h"
 #include "mesh/cpu_mesh.h"
+#include "mesh/mesh_importer.h"
+#include "tools/mapped_file.h"
+#include "tools/parallel_for.h"
 #include "tools/security.h"
 
 // External includes
 #define CC_IMPLEMENTATION
 #include "ccmesh.h"
 
-void fill_bisectors(cc_Mesh* targetMesh, uint32_t cbtNumElements,
-    std::vector<uint64_t>& heapIDArray, std::vector<uint3>& neighborsArray,
-    std::vector<float3>& basePoints, uint32_t& totalNumElements, uint32_t& minimalDepth)
+// System includes
+#include <algorithm>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+
+// Minimal number of halfedges processed by a thread while loading the mesh
+#define CPU_MESH_PARALLEL_MIN_RANGE 4096
+
+// Base mesh cache written next to the mesh file ("CCMC")
+#define CPU_MESH_CACHE_EXTENSION ".cache"
+#define CPU_MESH_CACHE_MAGIC 0x434D4343
+#define CPU_MESH_CACHE_VERSION 1
+
+void extract_halfedges(const cc_Mesh* targetMesh, std::vector<float3>& vertices, std::vector<uint32_t>& halfedgeVertices, std::vector<uint3>& halfedgeNeighbors)
 {
-    // Total number of elements of the mesh
-    totalNumElements = targetMesh->halfedgeCount + cbtNumElements;
+    vertices.resize(targetMesh->vertexCount);
+    for (uint32_t vertexIdx = 0; vertexIdx < (uint32_t)targetMesh->vertexCount; ++vertexIdx)
+    {
+        const cc_VertexPoint& vp = targetMesh->vertexPoints[vertexIdx];
+        vertices[vertexIdx] = float3({ vp.x, vp.y, vp.z });
+    }
+
+    halfedgeVertices.resize(targetMesh->halfedgeCount);
+    halfedgeNeighbors.resize(targetMesh->halfedgeCount);
+    for (uint32_t halfEdgeIdx = 0; halfEdgeIdx < (uint32_t)targetMesh->halfedgeCount; ++halfEdgeIdx)
+    {
+        const cc_Halfedge& halfEdge = targetMesh->halfedges[halfEdgeIdx];
+        halfedgeVertices[halfEdgeIdx] = halfEdge.vertexID;
+        halfedgeNeighbors[halfEdgeIdx] = uint3({ (uint32_t)halfEdge.prevID, (uint32_t)halfEdge.nextID, (uint32_t)halfEdge.twinID });
+    }
+}
 
-    // Allocate and initialize the memory
-    heapIDArray.resize(totalNumElements);
-    neighborsArray.resize(totalNumElements);
-    memset(heapIDArray.data(), 0, totalNumElements * sizeof(uint64_t));
-    memset(neighborsArray.data(), 0, totalNumElements * sizeof(uint3));
+void fill_base_patches(const std::vector<float3>& vertices, const std::vector<uint32_t>& halfedgeVertices, CPUMesh& mesh)
+{
+    // The base neighbors (prev, next, twin) of each halfedge are already set
+    const uint32_t halfedgeCount = (uint32_t)halfedgeVertices.size();
+    const std::vector<uint3>& baseNeighborsArray = mesh.baseNeighborsArray;
 
     // Find the base HeapID
-    minimalDepth = std::min(find_msb_64(targetMesh->halfedgeCount), 63u) + 1;
-    const uint64_t baseHeapID = 1ull << (minimalDepth - 1);
+    mesh.minimalDepth = std::min(find_msb_64(halfedgeCount), 63u) + 1;
 
     // Set of points for each face
-    basePoints.resize(targetMesh->halfedgeCount * 3);
+    std::vector<float3>& basePoints = mesh.basePoints;
+    basePoints.resize(halfedgeCount * 3);
 
-    // Load the bisector data
-    uint3 neighbors;
-    for (uint32_t halfEdgeIdx = 0; halfEdgeIdx < (uint32_t)targetMesh->halfedgeCount; ++halfEdgeIdx)
+    // The halfedges are independent, each thread processes a range of them
+    parallel_for(halfedgeCount, CPU_MESH_PARALLEL_MIN_RANGE, [&](uint32_t firstHalfEdge, uint32_t lastHalfEdge)
     {
-        // ID of this element
-        uint32_t elementID = cbtNumElements + halfEdgeIdx;
-
-        // Set the heap ID
-        heapIDArray[elementID] = baseHeapID + halfEdgeIdx;
-
-        // Fill and export the neighbors
-        cc_Halfedge& halfEdge = targetMesh->halfedges[halfEdgeIdx];
-        neighbors.x = halfEdge.prevID != -1 ? cbtNumElements + halfEdge.prevID : UINT32_MAX;
-        neighbors.y = halfEdge.nextID != -1 ? cbtNumElements + halfEdge.nextID : UINT32_MAX;
-        neighbors.z = halfEdge.twinID != -1 ? cbtNumElements + halfEdge.twinID : UINT32_MAX;
-        neighborsArray[elementID] = neighbors;
-
-        // First vertex
-        cc_VertexPoint p2 = targetMesh->vertexPoints[halfEdge.vertexID];
-        basePoints[3 * halfEdgeIdx + 2] = float3({ p2.x, p2.y, p2.z });
-
-        // Second vertex
-        cc_Halfedge& nextHalfEdge = targetMesh->halfedges[halfEdge.nextID];
-        cc_VertexPoint p0 = targetMesh->vertexPoints[nextHalfEdge.vertexID];
-        basePoints[3 * halfEdgeIdx + 0] = float3({ p0.x, p0.y, p0.z });
-
-        // Let's compute the third vertex
-        float3 thirdVertex = basePoints[3 * halfEdgeIdx + 2];
-        float sumWeight = 1.0f;
-        uint32_t currentIdx = halfEdge.nextID;
-        while (currentIdx != halfEdgeIdx)
+        for (uint32_t halfEdgeIdx = firstHalfEdge; halfEdgeIdx < lastHalfEdge; ++halfEdgeIdx)
         {
-            cc_Halfedge currentHalfEdge = targetMesh->halfedges[currentIdx];
-            cc_VertexPoint vp = targetMesh->vertexPoints[currentHalfEdge.vertexID];
-            thirdVertex.x += vp.x;
-            thirdVertex.y += vp.y;
-            thirdVertex.z += vp.z;
-            sumWeight += 1.0f;
-            currentIdx = currentHalfEdge.nextID;
+            // First vertex
+            basePoints[3 * halfEdgeIdx + 2] = vertices[halfedgeVertices[halfEdgeIdx]];
+
+            // Second vertex
+            const uint32_t nextID = baseNeighborsArray[halfEdgeIdx].y;
+            basePoints[3 * halfEdgeIdx + 0] = vertices[halfedgeVertices[nextID]];
+
+            // Let's compute the third vertex
+            float3 thirdVertex = basePoints[3 * halfEdgeIdx + 2];
+            float sumWeight = 1.0f;
+            uint32_t currentIdx = nextID;
+            while (currentIdx != halfEdgeIdx)
+            {
+                const float3& vp = vertices[halfedgeVertices[currentIdx]];
+                thirdVertex.x += vp.x;
+                thirdVertex.y += vp.y;
+                thirdVertex.z += vp.z;
+                sumWeight += 1.0f;
+                currentIdx = baseNeighborsArray[currentIdx].y;
+            }
+            basePoints[3 * halfEdgeIdx + 1] = float3({ thirdVertex.x / sumWeight, thirdVertex.y / sumWeight, thirdVertex.z / sumWeight });
         }
-        basePoints[3 * halfEdgeIdx + 1] = float3({ thirdVertex.x / sumWeight, thirdVertex.y / sumWeight, thirdVertex.z / sumWeight });
+    });
+}
+
+void fill_bisectors(uint32_t cbtNumElements, CPUMesh& mesh)
+{
+    // Total number of elements of the mesh
+    const uint32_t numPatches = (uint32_t)mesh.baseNeighborsArray.size();
+    mesh.totalNumElements = numPatches + cbtNumElements;
+
+    // The base bisectors follow the CBT elements, which are all unallocated at load time and aren't stored
+    mesh.firstBaseElement = cbtNumElements;
+    mesh.heapIDArray.resize(numPatches);
+    mesh.neighborsArray.resize(numPatches);
+    const uint64_t baseHeapID = 1ull << (mesh.minimalDepth - 1);
+    parallel_for(numPatches, CPU_MESH_PARALLEL_MIN_RANGE, [&](uint32_t firstPatch, uint32_t lastPatch)
+    {
+        for (uint32_t patchIdx = firstPatch; patchIdx < lastPatch; ++patchIdx)
+        {
+            mesh.heapIDArray[patchIdx] = baseHeapID + patchIdx;
+            const uint3& baseNeighbors = mesh.baseNeighborsArray[patchIdx];
+            mesh.neighborsArray[patchIdx].x = baseNeighbors.x != INVALID_POINTER ? cbtNumElements + baseNeighbors.x : UINT32_MAX;
+            mesh.neighborsArray[patchIdx].y = baseNeighbors.y != INVALID_POINTER ? cbtNumElements + baseNeighbors.y : UINT32_MAX;
+            mesh.neighborsArray[patchIdx].z = baseNeighbors.z != INVALID_POINTER ? cbtNumElements + baseNeighbors.z : UINT32_MAX;
+        }
+    });
+}
+
+void evaluate_patch_bounds(const std::vector<float3>& basePoints, std::vector<float4>& patchBounds)
+{
+    // Every bisector of a patch is projected inside the spherical triangle of its base points
+    uint32_t numPatches = (uint32_t)basePoints.size() / 3;
+    patchBounds.resize(numPatches);
+    for (uint32_t patchIdx = 0; patchIdx < numPatches; ++patchIdx)
+    {
+        // Project the base points on the unit sphere
+        float3 p0 = normalize(basePoints[3 * patchIdx]);
+        float3 p1 = normalize(basePoints[3 * patchIdx + 1]);
+        float3 p2 = normalize(basePoints[3 * patchIdx + 2]);
+
+        // The spherical triangle is inside the cap that contains its three corners
+        float3 axis = normalize(p0 + p1 + p2);
+        float cosHalfAngle = std::min(std::min(dot(axis, p0), dot(axis, p1)), dot(axis, p2));
+
+        // Small margin for the float precision
+        patchBounds[patchIdx] = float4({ axis.x, axis.y, axis.z, cosHalfAngle - 1e-5f });
+    }
+}
+
+// Header of the base mesh cache, followed by the base neighbors, the base points and the patch bounds
+struct CPUMeshCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t contentHash;
+    uint32_t numPatches;
+    uint32_t minimalDepth;
+};
+
+uint64_t cpu_mesh_cache_size(uint32_t numPatches)
+{
+    return sizeof(CPUMeshCacheHeader) + numPatches * (sizeof(uint3) + 3 * sizeof(float3) + sizeof(float4));
+}
+
+bool load_cpu_mesh_cache(const char* cachePath, uint64_t contentHash, CPUMesh& mesh)
+{
+    MappedFile cacheFile;
+    if (!map_file(cachePath, cacheFile))
+        return false;
+
+    // The cache must match the current mesh file and format
+    CPUMeshCacheHeader header;
+    bool valid = cacheFile.size >= sizeof(CPUMeshCacheHeader);
+    if (valid)
+    {
+        memcpy(&header, cacheFile.data, sizeof(CPUMeshCacheHeader));
+        valid = header.magic == CPU_MESH_CACHE_MAGIC && header.version == CPU_MESH_CACHE_VERSION && header.contentHash == contentHash
+            && cacheFile.size == cpu_mesh_cache_size(header.numPatches);
     }
+
+    // Copy the arrays straight from the mapping
+    if (valid)
+    {
+        const char* data = cacheFile.data + sizeof(CPUMeshCacheHeader);
+        mesh.minimalDepth = header.minimalDepth;
+        mesh.baseNeighborsArray.resize(header.numPatches);
+        memcpy(mesh.baseNeighborsArray.data(), data, header.numPatches * sizeof(uint3));
+        data += header.numPatches * sizeof(uint3);
+        mesh.basePoints.resize(3 * header.numPatches);
+        memcpy(mesh.basePoints.data(), data, 3 * header.numPatches * sizeof(float3));
+        data += 3 * header.numPatches * sizeof(float3);
+        mesh.patchBounds.resize(header.numPatches);
+        memcpy(mesh.patchBounds.data(), data, header.numPatches * sizeof(float4));
+    }
+    unmap_file(cacheFile);
+    return valid;
+}
+
+void write_cpu_mesh_cache(const char* cachePath, uint64_t contentHash, const CPUMesh& mesh)
+{
+    // Not being able to write the cache only means that the next load parses the mesh again
+    FILE* cacheFile = fopen(cachePath, "wb");
+    if (cacheFile == nullptr)
+        return;
+    CPUMeshCacheHeader header = { CPU_MESH_CACHE_MAGIC, CPU_MESH_CACHE_VERSION, contentHash, (uint32_t)mesh.baseNeighborsArray.size(), mesh.minimalDepth };
+    bool written = fwrite(&header, sizeof(CPUMeshCacheHeader), 1, cacheFile) == 1;
+    written = written && fwrite(mesh.baseNeighborsArray.data(), sizeof(uint3), header.numPatches, cacheFile) == header.numPatches;
+    written = written && fwrite(mesh.basePoints.data(), sizeof(float3), 3 * header.numPatches, cacheFile) == 3 * header.numPatches;
+    written = written && fwrite(mesh.patchBounds.data(), sizeof(float4), header.numPatches, cacheFile) == header.numPatches;
+    fclose(cacheFile);
+
+    // Don't leave a truncated cache behind
+    if (!written)
+        remove(cachePath);
 }
 
 void load_cpu_mesh(const char* meshPath, uint32_t cbtNumElements, CPUMesh& outputMesh)
 {
-    // Load the CCMesh
-    cc_Mesh* targetMesh = ccm_Load(meshPath);
+    // The cache is keyed by the content of the mesh file
+    MappedFile meshFile;
+    assert_msg(map_file(meshPath, meshFile), "Failed to open the mesh file.");
+    uint64_t contentHash = hash_memory(meshFile.data, meshFile.size);
+    unmap_file(meshFile);
+
+    // Parse the mesh only if the cache doesn't match
+    std::string cachePath = std::string(meshPath) + CPU_MESH_CACHE_EXTENSION;
+    bool cacheHit = load_cpu_mesh_cache(cachePath.c_str(), contentHash, outputMesh);
+    if (!cacheHit)
+    {
+        // Halfedges of the mesh, from an indexed polygon mesh or a CCMesh
+        std::vector<float3> vertices;
+        std::vector<uint32_t> halfedgeVertices;
+        if (is_polygon_mesh_file(meshPath))
+        {
+            assert_msg(import_polygon_mesh(meshPath, vertices, halfedgeVertices, outputMesh.baseNeighborsArray), "Failed to import the mesh file.");
+        }
+        else
+        {
+            cc_Mesh* targetMesh = ccm_Load(meshPath);
+            assert_msg(targetMesh != nullptr, "Failed to parse the mesh file.");
+            extract_halfedges(targetMesh, vertices, halfedgeVertices, outputMesh.baseNeighborsArray);
+            ccm_Release(targetMesh);
+        }
+
+        // Extract the base patches
+        fill_base_patches(vertices, halfedgeVertices, outputMesh);
+
+        // Evaluate the bounds of the base patches
+        evaluate_patch_bounds(outputMesh.basePoints, outputMesh.patchBounds);
+    }
+
+    // Initialize the bisectors
+    outputMesh.contentHash = contentHash;
+    fill_bisectors(cbtNumElements, outputMesh);
+
+    // Write the cache of a freshly parsed mesh
+    if (!cacheHit)
+        write_cpu_mesh_cache(cachePath.c_str(), contentHash, outputMesh);
+}
+
+// Same depth neighbors (0 if none) of a heapID, obtained by replaying its bisections from the base patch adjacency
+void same_depth_neighbors(const CPUMesh& mesh, uint64_t heapID, uint64_t neighbors[3])
+{
+    const uint64_t baseHeapID = 1ull << (mesh.minimalDepth - 1);
+    const uint32_t depth = find_msb_64(heapID);
+    uint64_t current = heapID >> (depth - mesh.minimalDepth);
+    const uint3& baseNeighbors = mesh.baseNeighborsArray[current - baseHeapID];
+    neighbors[0] = baseNeighbors.x != INVALID_POINTER ? baseHeapID + baseNeighbors.x : 0;
+    neighbors[1] = baseNeighbors.y != INVALID_POINTER ? baseHeapID + baseNeighbors.y : 0;
+    neighbors[2] = baseNeighbors.z != INVALID_POINTER ? baseHeapID + baseNeighbors.z : 0;
+
+    // The first child's twin is the parent's first neighbor, the second child's twin is the parent's second neighbor
+    for (int32_t bitID = depth - mesh.minimalDepth - 1; bitID >= 0; --bitID)
+    {
+        uint64_t n0 = neighbors[0], n1 = neighbors[1], n2 = neighbors[2];
+        if (((heapID >> bitID) & 1) == 0)
+        {
+            neighbors[0] = 2 * current + 1;
+            neighbors[1] = n2 != 0 ? 2 * n2 + 1 : 0;
+            neighbors[2] = n0 != 0 ? 2 * n0 + 1 : 0;
+            current = 2 * current;
+        }
+        else
+        {
+            neighbors[0] = n2 != 0 ? 2 * n2 : 0;
+            neighbors[1] = 2 * current;
+            neighbors[2] = n1 != 0 ? 2 * n1 : 0;
+            current = 2 * current + 1;
+        }
+    }
+}
+
+void derive_neighbors(const CPUMesh& mesh, const std::vector<uint64_t>& heapIDArray, std::vector<uint3>& neighborsArray)
+{
+    // Map every allocated heapID to its element
+    std::unordered_map<uint64_t, uint32_t> heapIDMap;
+    uint32_t numElements = (uint32_t)heapIDArray.size();
+    for (uint32_t elementID = 0; elementID < numElements; ++elementID)
+    {
+        if (heapIDArray[elementID] != 0)
+            heapIDMap[heapIDArray[elementID]] = elementID;
+    }
+
+    auto lookup = [&heapIDMap](uint64_t heapID) -> uint32_t
+    {
+        auto it = heapIDMap.find(heapID);
+        return it != heapIDMap.end() ? it->second : INVALID_POINTER;
+    };
+
+    neighborsArray.resize(numElements);
+    for (uint32_t elementID = 0; elementID < numElements; ++elementID)
+    {
+        uint32_t resolved[3] = { INVALID_POINTER, INVALID_POINTER, INVALID_POINTER };
+        uint64_t heapID = heapIDArray[elementID];
+        if (heapID != 0)
+        {
+            uint64_t neighbors[3];
+            same_depth_neighbors(mesh, heapID, neighbors);
+            for (uint32_t slot = 0; slot < 3; ++slot)
+            {
+                uint64_t neighborHeapID = neighbors[slot];
+                if (neighborHeapID == 0)
+                    continue;
+
+                // Same depth neighbor, otherwise the twin can only be coarser and the other two only finer
+                resolved[slot] = lookup(neighborHeapID);
+                if (resolved[slot] != INVALID_POINTER)
+                    continue;
+                if (slot == 2)
+                    resolved[slot] = find_msb_64(neighborHeapID) > mesh.minimalDepth ? lookup(neighborHeapID >> 1) : INVALID_POINTER;
+                else
+                    resolved[slot] = lookup(2 * neighborHeapID + (slot == 0 ? 1 : 0));
+            }
+        }
+        neighborsArray[elementID] = uint3({ resolved[0], resolved[1], resolved[2] });
+    }
+}
+
+// Plane of the base patch of a heapID, the bisections are linear in it
+void base_patch_plane(const CPUMesh& mesh, uint64_t heapID, double3& planeNormal, double& planeOffset)
+{
+    const uint64_t baseHeapID = 1ull << (mesh.minimalDepth - 1);
+    const uint32_t primitiveID = (uint32_t)((heapID >> (find_msb_64(heapID) - mesh.minimalDepth)) - baseHeapID);
+    const float3& b0 = mesh.basePoints[3 * primitiveID];
+    const float3& b1 = mesh.basePoints[3 * primitiveID + 1];
+    const float3& b2 = mesh.basePoints[3 * primitiveID + 2];
+    double3 p0 = double3({ b0.x, b0.y, b0.z });
+    planeNormal = cross(double3({ b1.x, b1.y, b1.z }) - p0, double3({ b2.x, b2.y, b2.z }) - p0);
+    planeOffset = dot(planeNormal, p0);
+}
+
+// Intersection of the ray from the planet center through a position with the plane of the base patch
+double3 to_plane_coordinate(const double3& position, const double3& planeNormal, double planeOffset)
+{
+    return position * (planeOffset / dot(planeNormal, position));
+}
+
+void decode_bisector_positions(const CPUMesh& mesh, uint64_t heapID, double3 positions[4])
+{
+    // Barycentric coordinates of the bisector and its parent in the base patch, bisected like the decoding matrices
+    double3 child[3] = { double3({ 1.0, 0.0, 0.0 }), double3({ 0.0, 1.0, 0.0 }), double3({ 0.0, 0.0, 1.0 }) };
+    double3 parent[3] = { child[0], child[1], child[2] };
+    const int32_t subTreeDepth = (int32_t)(find_msb_64(heapID) - mesh.minimalDepth);
+    for (int32_t bitID = subTreeDepth - 1; bitID >= 0; --bitID)
+    {
+        std::copy(child, child + 3, parent);
+        bool bit = ((heapID >> bitID) & 1) != 0;
+        child[0] = bit ? parent[1] : parent[2];
+        child[1] = (parent[0] + parent[2]) * 0.5;
+        child[2] = bit ? parent[0] : parent[1];
+    }
+
+    // Evaluate the positions in the plane of the base patch and project them on the sphere
+    const uint64_t baseHeapID = 1ull << (mesh.minimalDepth - 1);
+    const uint32_t primitiveID = (uint32_t)((heapID >> subTreeDepth) - baseHeapID);
+    const float3* base = &mesh.basePoints[3 * primitiveID];
+    auto evaluate = [base](const double3& w) -> double3
+    {
+        return normalize(double3({ base[0].x * w.x + base[1].x * w.y + base[2].x * w.z,
+                                   base[0].y * w.x + base[1].y * w.y + base[2].y * w.z,
+                                   base[0].z * w.x + base[1].z * w.y + base[2].z * w.z }));
+    };
+    positions[0] = evaluate(child[0]);
+    positions[1] = evaluate(child[1]);
+    positions[2] = evaluate(child[2]);
+    positions[3] = subTreeDepth > 0 ? evaluate(heapID % 2 == 0 ? parent[0] : parent[2]) : double3({ 0.0, 0.0, 0.0 });
+}
+
+bool derive_bisector_positions(const CPUMesh& mesh, uint64_t heapID, uint64_t cachedHeapID, const double3 cachedPositions[4], double3 positions[4])
+{
+    // Nothing changed
+    if (cachedHeapID == heapID)
+    {
+        std::copy(cachedPositions, cachedPositions + 4, positions);
+        return true;
+    }
+
+    // Only the parent, grandparent or a child can be used
+    const uint32_t depth = find_msb_64(heapID);
+    const uint32_t cachedDepth = find_msb_64(cachedHeapID);
+    bool ancestor = cachedHeapID != 0 && cachedDepth < depth && (depth - cachedDepth) <= 2 && (heapID >> (depth - cachedDepth)) == cachedHeapID;
+    bool child = (cachedHeapID >> 1) == heapID;
+    if (!ancestor && !child)
+        return false;
+
+    // Only the new vertices go through the plane of the base patch, the shared ones are copied
+    double3 planeNormal;
+    double planeOffset;
+    base_patch_plane(mesh, heapID, planeNormal, planeOffset);
+
+    std::copy(cachedPositions, cachedPositions + 4, positions);
+    if (ancestor)
+    {
+        // Bisect the cached triangle, every bisection adds the midpoint of the longest edge
+        for (int32_t bitID = (int32_t)(depth - cachedDepth) - 1; bitID >= 0; --bitID)
+        {
+            double3 parent[3] = { positions[0], positions[1], positions[2] };
+            double3 midPoint = (to_plane_coordinate(parent[0], planeNormal, planeOffset) + to_plane_coordinate(parent[2], planeNormal, planeOffset)) * 0.5;
+            bool bit = ((heapID >> bitID) & 1) != 0;
+            positions[0] = bit ? parent[1] : parent[2];
+            positions[1] = normalize(midPoint);
+            positions[2] = bit ? parent[0] : parent[1];
+            positions[3] = bit ? parent[2] : parent[0];
+        }
+    }
+    else
+    {
+        // The parent is made of the cached child and its fourth vertex
+        bool evenChild = (cachedHeapID % 2) == 0;
+        positions[0] = evenChild ? cachedPositions[3] : cachedPositions[2];
+        positions[1] = evenChild ? cachedPositions[2] : cachedPositions[0];
+        positions[2] = evenChild ? cachedPositions[0] : cachedPositions[3];
+
+        // The second vertex is the midpoint of the longest edge of the grandparent, which gives back its missing vertex
+        positions[3] = double3({ 0.0, 0.0, 0.0 });
+        if (depth > mesh.minimalDepth)
+        {
+            double3 midPoint = to_plane_coordinate(positions[1], planeNormal, planeOffset);
+            double3 endPoint = to_plane_coordinate(heapID % 2 == 0 ? positions[0] : positions[2], planeNormal, planeOffset);
+            positions[3] = normalize(midPoint * 2.0 - endPoint);
+        }
+    }
+    return true;
+}
+
+double incremental_positions_drift(const CPUMesh& mesh, uint32_t numSequences, uint32_t numSteps)
+{
+    std::mt19937 generator(0);
+    const uint64_t baseHeapID = 1ull << (mesh.minimalDepth - 1);
+    const uint32_t numPatches = (uint32_t)(mesh.basePoints.size() / 3);
+
+    double maxDrift = 0.0;
+    for (uint32_t sequenceIdx = 0; sequenceIdx < numSequences; ++sequenceIdx)
+    {
+        // Start from the full decoding of a base patch
+        uint64_t heapID = baseHeapID + (uint64_t)sequenceIdx * numPatches / numSequences;
+        double3 positions[4];
+        decode_bisector_positions(mesh, heapID, positions);
+
+        for (uint32_t stepIdx = 0; stepIdx < numSteps; ++stepIdx)
+        {
+            // Bisect once or twice like an update, or merge (sequences tend to go down to the maximal depth)
+            uint32_t depth = find_msb_64(heapID);
+            uint32_t operation = generator() % 3;
+            uint64_t nextHeapID = heapID >> 1;
+            if (operation < 2 && depth + operation + 1 <= 63)
+                nextHeapID = (heapID << (operation + 1)) | (generator() & ((2ull << operation) - 1));
+            else if (depth == mesh.minimalDepth)
+                continue;
+
+            // Chain the incremental evaluations and compare them to the full decoding
+            double3 nextPositions[4], reference[4];
+            bool derived = derive_bisector_positions(mesh, nextHeapID, heapID, positions, nextPositions);
+            assert_msg(derived, "Positions of a parent or child can always be derived.");
+            decode_bisector_positions(mesh, nextHeapID, reference);
+            for (uint32_t vertexIdx = 0; vertexIdx < 4; ++vertexIdx)
+                maxDrift = std::max(maxDrift, length(nextPositions[vertexIdx] - reference[vertexIdx]));
+
+            heapID = nextHeapID;
+            std::copy(nextPositions, nextPositions + 4, positions);
+        }
+    }
+    return maxDrift;
+}
+
+uint64_t cluster_root_heap_id(const CPUMesh& mesh, uint64_t heapID)
+{
+    const uint32_t subTreeDepth = find_msb_64(heapID) - mesh.minimalDepth;
+    return heapID >> std::min(subTreeDepth, (uint32_t)CLUSTER_SUBTREE_DEPTH);
+}
+
+void evaluate_cluster_bounds(const CPUMesh& mesh, uint64_t rootHeapID, float4& boundingSphere, float4& normalCone)
+{
+    double3 positions[4];
+    decode_bisector_positions(mesh, rootHeapID, positions);
+
+    // The spherical triangle of the root is inside the cap that contains its three corners
+    double3 axis = normalize(positions[0] + positions[1] + positions[2]);
+    double cosHalfAngle = std::min(std::min(dot(axis, positions[0]), dot(axis, positions[1])), dot(axis, positions[2]));
+
+    // The cap is inside the sphere centered on its base disk, a cap wider than a hemisphere is bounded by the unit sphere
+    double3 center = axis * cosHalfAngle;
+    double radius = sqrt(1.0 - cosHalfAngle * cosHalfAngle);
+    if (cosHalfAngle < 0.0)
+    {
+        center = double3({ 0.0, 0.0, 0.0 });
+        radius = 1.0;
+    }
 
-    // Initialize the mesh
-    fill_bisectors(targetMesh, cbtNumElements, outputMesh.heapIDArray, outputMesh.neighborsArray, outputMesh.basePoints, outputMesh.totalNumElements, outputMesh.minimalDepth);
+    // Small margin for the float precision
+    boundingSphere = float4({ (float)center.x, (float)center.y, (float)center.z, (float)radius + 1e-5f });
+    normalCone = float4({ (float)axis.x, (float)axis.y, (float)axis.z, (float)cosHalfAngle - 1e-5f });
+}
 
-    // Release the mesh
-    ccm_Release(targetMesh);
-}
\ No newline at end of file
+// HeapID shifted to the maximal depth, the descendants of a bisector cover a contiguous range that starts at its own
+uint64_t aligned_heap_id(uint64_t heapID)
+{
+    return heapID << (64 - find_msb_64(heapID));
+}
+
+void build_bisector_clusters(const CPUMesh& mesh, const std::vector<uint64_t>& heapIDArray, std::vector<BisectorCluster>& clusters, std::vector<uint32_t>& clusterElements)
+{
+    // Order the allocated bisectors by cluster, the clusters and their elements follow the bisection curve
+    struct ClusterKey
+    {
+        uint64_t alignedRoot;
+        uint32_t rootDepth;
+        uint64_t alignedHeapID;
+        uint32_t elementID;
+    };
+    std::vector<ClusterKey> keys;
+    keys.reserve(heapIDArray.size());
+    for (uint32_t elementID = 0; elementID < (uint32_t)heapIDArray.size(); ++elementID)
+    {
+        uint64_t heapID = heapIDArray[elementID];
+        if (heapID == 0)
+            continue;
+        uint64_t rootHeapID = cluster_root_heap_id(mesh, heapID);
+        keys.push_back({ aligned_heap_id(rootHeapID), find_msb_64(rootHeapID), aligned_heap_id(heapID), elementID });
+    }
+    std::sort(keys.begin(), keys.end(), [](const ClusterKey& a, const ClusterKey& b)
+    {
+        if (a.alignedRoot != b.alignedRoot)
+            return a.alignedRoot < b.alignedRoot;
+        if (a.rootDepth != b.rootDepth)
+            return a.rootDepth < b.rootDepth;
+        return a.alignedHeapID < b.alignedHeapID;
+    });
+
+    // The elements of a cluster are contiguous
+    clusters.clear();
+    clusterElements.resize(keys.size());
+    for (uint32_t keyIdx = 0; keyIdx < (uint32_t)keys.size(); ++keyIdx)
+    {
+        uint32_t elementID = keys[keyIdx].elementID;
+        uint64_t rootHeapID = cluster_root_heap_id(mesh, heapIDArray[elementID]);
+        if (clusters.empty() || clusters.back().rootHeapID != rootHeapID)
+        {
+            BisectorCluster cluster;
+            cluster.rootHeapID = rootHeapID;
+            cluster.firstElement = keyIdx;
+            cluster.numElements = 0;
+            evaluate_cluster_bounds(mesh, rootHeapID, cluster.boundingSphere, cluster.normalCone);
+            clusters.push_back(cluster);
+        }
+        clusters.back().numElements++;
+        clusterElements[keyIdx] = elementID;
+    }
+}
+
+bool validate_bisector_clusters(const CPUMesh& mesh, const std::vector<uint64_t>& heapIDArray, const std::vector<BisectorCluster>& clusters, const std::vector<uint32_t>& clusterElements)
+{
+    std::vector<bool> clustered(heapIDArray.size(), false);
+    uint32_t numClustered = 0;
+    for (const BisectorCluster& cluster : clusters)
+    {
+        if (cluster.numElements == 0 || cluster.numElements > CLUSTER_MAX_ELEMENTS || cluster.firstElement + cluster.numElements > clusterElements.size())
+            return false;
+
+        double3 center = double3({ cluster.boundingSphere.x, cluster.boundingSphere.y, cluster.boundingSphere.z });
+        double3 axis = double3({ cluster.normalCone.x, cluster.normalCone.y, cluster.normalCone.z });
+        for (uint32_t elementIdx = cluster.firstElement; elementIdx < cluster.firstElement + cluster.numElements; ++elementIdx)
+        {
+            // Every allocated bisector is in a single cluster, the one of its root
+            uint32_t elementID = clusterElements[elementIdx];
+            if (elementID >= heapIDArray.size() || clustered[elementID] || heapIDArray[elementID] == 0 || cluster_root_heap_id(mesh, heapIDArray[elementID]) != cluster.rootHeapID)
+                return false;
+            clustered[elementID] = true;
+            numClustered++;
+
+            // Its positions are inside the bounding sphere and the normal cone
+            double3 positions[4];
+            decode_bisector_positions(mesh, heapIDArray[elementID], positions);
+            for (uint32_t vertexIdx = 0; vertexIdx < 3; ++vertexIdx)
+            {
+                if (length(positions[vertexIdx] - center) > cluster.boundingSphere.w || dot(positions[vertexIdx], axis) < cluster.normalCone.w)
+                    return false;
+            }
+        }
+    }
+    return numClustered == (uint32_t)std::count_if(heapIDArray.begin(), heapIDArray.end(), [](uint64_t heapID) { return heapID != 0; });
+}
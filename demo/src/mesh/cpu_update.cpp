@@ -0,0 +1,516 @@
+// Project includes
+#include "mesh/cpu_update.h"
+#include "math/operators.h"
+#include "tools/security.h"
+
+// System includes
+#include <algorithm>
+#include <utility>
+
+// Subdivision patterns of a bisector (see update_utilities.hlsl)
+#define NO_SPLIT 0x00
+#define CENTER_SPLIT 0x01
+#define RIGHT_SPLIT 0x02
+#define LEFT_SPLIT 0x04
+#define RIGHT_DOUBLE_SPLIT (CENTER_SPLIT | RIGHT_SPLIT)
+#define LEFT_DOUBLE_SPLIT (CENTER_SPLIT | LEFT_SPLIT)
+#define TRIPLE_SPLIT (CENTER_SPLIT | RIGHT_SPLIT | LEFT_SPLIT)
+
+// Content of the counters and lists of an update, the lists are filled in the order the GPU threads would increment their counters
+struct CPUUpdateContext
+{
+    CPUMeshState& state;
+    uint32_t baseDepth;
+
+    // Classification lists
+    std::vector<uint32_t> splitList;
+    std::vector<uint32_t> simplifyList;
+    std::vector<uint32_t> predictedSplitList;
+
+    // Allocated slots and bisectors that can still be created (_MemoryBuffer)
+    uint32_t numAllocatedSlots = 0;
+    int32_t remainingMemory = 0;
+    std::vector<uint32_t> freeElements;
+
+    // Bisected elements, their neighbors records and the bisectors of the propagation passes
+    std::vector<uint32_t> allocateList;
+    std::vector<std::pair<uint32_t, uint3>> neighborsRecords;
+    std::vector<uint32_t> propagateBisectList;
+    std::vector<uint32_t> simplificationList;
+    std::vector<uint32_t> propagateSimplifyList;
+};
+
+static uint32_t heap_id_depth(uint64_t heapID)
+{
+    return find_msb_64(heapID);
+}
+
+static uint32_t& component(uint3& vector, uint32_t idx)
+{
+    return idx == 0 ? vector.x : (idx == 1 ? vector.y : vector.z);
+}
+
+void init_cpu_mesh_state(const CPUMesh& mesh, CPUMeshState& state)
+{
+    // The base bisectors are at the end of the buffers
+    state.heapIDArray.assign(mesh.totalNumElements, 0);
+    state.neighborsArray.assign(mesh.totalNumElements, uint3({ INVALID_POINTER, INVALID_POINTER, INVALID_POINTER }));
+    std::copy(mesh.heapIDArray.begin(), mesh.heapIDArray.end(), state.heapIDArray.begin() + mesh.firstBaseElement);
+    std::copy(mesh.neighborsArray.begin(), mesh.neighborsArray.end(), state.neighborsArray.begin() + mesh.firstBaseElement);
+
+    BisectorData emptyData = { NO_SPLIT, { INVALID_POINTER, INVALID_POINTER, INVALID_POINTER }, INVALID_POINTER, UNCHANGED_ELEMENT, 0, INVALID_POINTER };
+    state.bisectorDataArray.assign(mesh.totalNumElements, emptyData);
+}
+
+static void register_classification(CPUUpdateContext& context, uint32_t currentID, int32_t currentValidity, const CPUUpdateBudgets& budgets)
+{
+    BisectorData& cBisectorData = context.state.bisectorDataArray[currentID];
+    uint64_t heapID = context.state.heapIDArray[currentID];
+    uint32_t depth = heap_id_depth(heapID);
+
+    // Reset some values
+    cBisectorData.subdivisionPattern = NO_SPLIT;
+    cBisectorData.bisectorState = UNCHANGED_ELEMENT;
+    cBisectorData.problematicNeighbor = INVALID_POINTER;
+
+    // The splits that only the predicted view requests have their own list, their state stays unchanged
+    if (currentValidity == PREDICTED_BISECT_ELEMENT)
+        context.predictedSplitList.push_back(currentID);
+    else if (currentValidity > UNCHANGED_ELEMENT)
+    {
+        // Requests past the budget are deferred
+        cBisectorData.bisectorState = context.splitList.size() < budgets.splitBudget ? BISECT_ELEMENT : UNCHANGED_ELEMENT;
+        context.splitList.push_back(currentID);
+    }
+
+    // Only the even heapIDs of the pairs that require a simplification are registered
+    if (context.baseDepth != depth && currentValidity < UNCHANGED_ELEMENT)
+    {
+        cBisectorData.bisectorState = SIMPLIFY_ELEMENT;
+        if (heapID % 2 == 0)
+        {
+            if (context.simplifyList.size() >= budgets.simplifyBudget)
+                cBisectorData.bisectorState = UNCHANGED_ELEMENT;
+            context.simplifyList.push_back(currentID);
+        }
+    }
+}
+
+static void split_element(CPUUpdateContext& context, uint32_t currentID)
+{
+    CPUMeshState& state = context.state;
+
+    // Skip the elements that are on the path of a neighbor that gets split
+    uint3 cNeighbors = state.neighborsArray[currentID];
+    if (cNeighbors.x != INVALID_POINTER && state.neighborsArray[cNeighbors.x].z == currentID && state.bisectorDataArray[cNeighbors.x].bisectorState != UNCHANGED_ELEMENT)
+        return;
+    if (cNeighbors.y != INVALID_POINTER && state.neighborsArray[cNeighbors.y].z == currentID && state.bisectorDataArray[cNeighbors.y].bisectorState != UNCHANGED_ELEMENT)
+        return;
+
+    // Compute the maximal required memory for this subdivision
+    uint32_t currentDepth = heap_id_depth(state.heapIDArray[currentID]);
+    int32_t maxRequiredMemory = 2 * (int32_t)(currentDepth - context.baseDepth) - 1;
+    uint32_t twinID = cNeighbors.z;
+    if (twinID == INVALID_POINTER)
+        maxRequiredMemory = 1;
+    else if (state.neighborsArray[twinID].z == currentID)
+        maxRequiredMemory = 2;
+
+    // Try to reserve
+    if (context.remainingMemory < maxRequiredMemory)
+        return;
+    context.remainingMemory -= maxRequiredMemory;
+
+    // An other neighbor already raised this element
+    if (state.bisectorDataArray[currentID].subdivisionPattern != NO_SPLIT)
+    {
+        context.remainingMemory += maxRequiredMemory;
+        return;
+    }
+    state.bisectorDataArray[currentID].subdivisionPattern = CENTER_SPLIT;
+    context.allocateList.push_back(currentID);
+    int32_t usedMemory = 1;
+
+    // Propagate the split up the twin path
+    while (twinID != INVALID_POINTER)
+    {
+        uint32_t nDepth = heap_id_depth(state.heapIDArray[twinID]);
+        uint3 nNeighbors = state.neighborsArray[twinID];
+        uint32_t& nPattern = state.bisectorDataArray[twinID].subdivisionPattern;
+        uint32_t prevPattern = nPattern;
+        if (nDepth == currentDepth)
+        {
+            nPattern |= CENTER_SPLIT;
+            if (prevPattern == NO_SPLIT)
+            {
+                context.allocateList.push_back(twinID);
+                usedMemory++;
+            }
+            break;
+        }
+
+        nPattern |= nNeighbors.x == currentID ? RIGHT_DOUBLE_SPLIT : LEFT_DOUBLE_SPLIT;
+        if (prevPattern != NO_SPLIT)
+        {
+            usedMemory++;
+            break;
+        }
+        context.allocateList.push_back(twinID);
+        usedMemory += 2;
+
+        // The new bisector that needs to be propagated
+        currentID = twinID;
+        currentDepth = nDepth;
+        twinID = state.neighborsArray[currentID].z;
+    }
+
+    // Add back the unused memory
+    context.remainingMemory += std::max(maxRequiredMemory - usedMemory, 0);
+}
+
+static void allocate_element(CPUUpdateContext& context, uint32_t currentID)
+{
+    BisectorData& cBisectorData = context.state.bisectorDataArray[currentID];
+    uint32_t numSlots = countbits(cBisectorData.subdivisionPattern);
+    assert_msg(context.numAllocatedSlots + numSlots <= context.freeElements.size(), "The memory reservation exceeds the free elements.");
+    for (uint32_t bitID = 0; bitID < numSlots; ++bitID)
+        component(cBisectorData.indices, bitID) = context.freeElements[context.numAllocatedSlots + bitID];
+    context.numAllocatedSlots += numSlots;
+}
+
+static void evaluate_neighbors(const CPUMeshState& state, uint32_t currentID, uint32_t bisectorID, uint32_t& resX, uint32_t& resY)
+{
+    const BisectorData& nBisectorData = state.bisectorDataArray[bisectorID];
+    const uint3& nNeighbors = state.neighborsArray[bisectorID];
+    const uint3& nIndices = nBisectorData.indices;
+    if (nBisectorData.subdivisionPattern == CENTER_SPLIT)
+    {
+        resX = nIndices.x;
+        resY = bisectorID;
+    }
+    else if (nBisectorData.subdivisionPattern == RIGHT_DOUBLE_SPLIT)
+    {
+        resX = nNeighbors.x == currentID ? nIndices.y : nIndices.x;
+        resY = nNeighbors.x == currentID ? bisectorID : nIndices.y;
+    }
+    else if (nBisectorData.subdivisionPattern == LEFT_DOUBLE_SPLIT)
+    {
+        resX = nNeighbors.y == currentID ? nIndices.y : nIndices.x;
+        resY = nNeighbors.y == currentID ? nIndices.x : bisectorID;
+    }
+    else if (nNeighbors.x == currentID)
+    {
+        resX = nIndices.y;
+        resY = bisectorID;
+    }
+    else if (nNeighbors.y == currentID)
+    {
+        resX = nIndices.z;
+        resY = nIndices.x;
+    }
+    else
+    {
+        resX = nIndices.x;
+        resY = nIndices.y;
+    }
+}
+
+static void bisect_element(CPUUpdateContext& context, uint32_t currentID)
+{
+    CPUMeshState& state = context.state;
+    const BisectorData cBisectorData = state.bisectorDataArray[currentID];
+    uint64_t baseHeapID = state.heapIDArray[currentID];
+    if (baseHeapID == 0 || cBisectorData.subdivisionPattern == NO_SPLIT)
+        return;
+
+    // Neighbors of the parent and new bisectors
+    uint3 cNeighbors = state.neighborsArray[currentID];
+    uint32_t p_n0 = cNeighbors.x, p_n1 = cNeighbors.y, p_n2 = cNeighbors.z;
+    uint32_t siblingID0 = cBisectorData.indices.x, siblingID1 = cBisectorData.indices.y, siblingID2 = cBisectorData.indices.z;
+
+    // The new bisectors of the propagations keep the neighbor of the parent they need to patch
+    BisectorData modifiedBisector = cBisectorData;
+    modifiedBisector.propagationID = currentID;
+    modifiedBisector.problematicNeighbor = INVALID_POINTER;
+    auto store_bisector = [&](uint32_t bisectorID, uint32_t problematicNeighbor)
+    {
+        state.bisectorDataArray[bisectorID] = modifiedBisector;
+        state.bisectorDataArray[bisectorID].problematicNeighbor = problematicNeighbor;
+    };
+
+    // The neighbors are recorded and only written once every bisection is done
+    switch (cBisectorData.subdivisionPattern)
+    {
+        case CENTER_SPLIT:
+        {
+            uint32_t resX = INVALID_POINTER, resY = INVALID_POINTER;
+            if (p_n2 != INVALID_POINTER)
+                evaluate_neighbors(state, currentID, p_n2, resX, resY);
+
+            state.heapIDArray[currentID] = 2 * baseHeapID;
+            state.heapIDArray[siblingID0] = 2 * baseHeapID + 1;
+            context.neighborsRecords.push_back({ currentID, uint3({ siblingID0, resX, p_n0 }) });
+            context.neighborsRecords.push_back({ siblingID0, uint3({ resY, currentID, p_n1 }) });
+
+            store_bisector(currentID, INVALID_POINTER);
+            store_bisector(siblingID0, p_n1);
+            context.propagateBisectList.push_back(siblingID0);
+        }
+        break;
+        case RIGHT_DOUBLE_SPLIT:
+        {
+            uint32_t res0X = INVALID_POINTER, res0Y = INVALID_POINTER;
+            evaluate_neighbors(state, currentID, p_n0, res0X, res0Y);
+            uint32_t res1X = INVALID_POINTER, res1Y = INVALID_POINTER;
+            if (p_n2 != INVALID_POINTER)
+                evaluate_neighbors(state, currentID, p_n2, res1X, res1Y);
+
+            state.heapIDArray[currentID] = 4 * baseHeapID;
+            state.heapIDArray[siblingID0] = 2 * baseHeapID + 1;
+            state.heapIDArray[siblingID1] = 4 * baseHeapID + 1;
+            context.neighborsRecords.push_back({ currentID, uint3({ siblingID1, res0X, siblingID0 }) });
+            context.neighborsRecords.push_back({ siblingID0, uint3({ res1Y, currentID, p_n1 }) });
+            context.neighborsRecords.push_back({ siblingID1, uint3({ res0Y, currentID, res1X }) });
+
+            store_bisector(currentID, INVALID_POINTER);
+            store_bisector(siblingID0, p_n1);
+            store_bisector(siblingID1, INVALID_POINTER);
+            context.propagateBisectList.push_back(siblingID0);
+        }
+        break;
+        case LEFT_DOUBLE_SPLIT:
+        {
+            uint32_t res0X = INVALID_POINTER, res0Y = INVALID_POINTER;
+            evaluate_neighbors(state, currentID, p_n1, res0X, res0Y);
+            uint32_t res1X = INVALID_POINTER, res1Y = INVALID_POINTER;
+            if (p_n2 != INVALID_POINTER)
+                evaluate_neighbors(state, currentID, p_n2, res1X, res1Y);
+
+            state.heapIDArray[currentID] = 2 * baseHeapID;
+            state.heapIDArray[siblingID0] = 4 * baseHeapID + 2;
+            state.heapIDArray[siblingID1] = 4 * baseHeapID + 3;
+            context.neighborsRecords.push_back({ currentID, uint3({ siblingID1, res1X, p_n0 }) });
+            context.neighborsRecords.push_back({ siblingID0, uint3({ siblingID1, res0X, res1Y }) });
+            context.neighborsRecords.push_back({ siblingID1, uint3({ res0Y, siblingID0, currentID }) });
+
+            store_bisector(currentID, INVALID_POINTER);
+            store_bisector(siblingID0, INVALID_POINTER);
+            store_bisector(siblingID1, INVALID_POINTER);
+        }
+        break;
+        case TRIPLE_SPLIT:
+        {
+            uint32_t res0X = INVALID_POINTER, res0Y = INVALID_POINTER;
+            evaluate_neighbors(state, currentID, p_n0, res0X, res0Y);
+            uint32_t res1X = INVALID_POINTER, res1Y = INVALID_POINTER;
+            evaluate_neighbors(state, currentID, p_n1, res1X, res1Y);
+            uint32_t res2X = INVALID_POINTER, res2Y = INVALID_POINTER;
+            if (p_n2 != INVALID_POINTER)
+                evaluate_neighbors(state, currentID, p_n2, res2X, res2Y);
+
+            state.heapIDArray[currentID] = 4 * baseHeapID;
+            state.heapIDArray[siblingID0] = 4 * baseHeapID + 2;
+            state.heapIDArray[siblingID1] = 4 * baseHeapID + 1;
+            state.heapIDArray[siblingID2] = 4 * baseHeapID + 3;
+            context.neighborsRecords.push_back({ currentID, uint3({ siblingID1, res0X, siblingID2 }) });
+            context.neighborsRecords.push_back({ siblingID0, uint3({ siblingID2, res1X, res2Y }) });
+            context.neighborsRecords.push_back({ siblingID1, uint3({ res0Y, currentID, res2X }) });
+            context.neighborsRecords.push_back({ siblingID2, uint3({ res1Y, siblingID0, currentID }) });
+
+            store_bisector(currentID, INVALID_POINTER);
+            store_bisector(siblingID0, INVALID_POINTER);
+            store_bisector(siblingID1, INVALID_POINTER);
+            store_bisector(siblingID2, INVALID_POINTER);
+        }
+        break;
+    }
+}
+
+static void set_neighbor(CPUMeshState& state, uint32_t bisectorID, uint32_t slot, uint32_t neighborID)
+{
+    component(state.neighborsArray[bisectorID], slot) = neighborID;
+}
+
+static uint32_t get_neighbor(CPUMeshState& state, uint32_t bisectorID, uint32_t slot)
+{
+    return component(state.neighborsArray[bisectorID], slot);
+}
+
+static void propagate_bisect_element(CPUMeshState& state, uint32_t currentID)
+{
+    BisectorData& cBisectorData = state.bisectorDataArray[currentID];
+    uint32_t parentID = cBisectorData.propagationID;
+    uint32_t targetID = cBisectorData.problematicNeighbor;
+
+    // Read the neighbor that may have changed
+    const BisectorData tBisectorData = state.bisectorDataArray[targetID];
+    uint3 tNeighbors = state.neighborsArray[targetID];
+    if (tBisectorData.subdivisionPattern == NO_SPLIT)
+    {
+        for (uint32_t slot = 0; slot < 3; ++slot)
+        {
+            if (component(tNeighbors, slot) == parentID)
+                set_neighbor(state, targetID, slot, currentID);
+        }
+    }
+    else if (tBisectorData.subdivisionPattern == CENTER_SPLIT)
+    {
+        if (get_neighbor(state, targetID, 2) == parentID)
+            set_neighbor(state, targetID, 2, currentID);
+        if (get_neighbor(state, tBisectorData.propagationID, 2) == parentID)
+            set_neighbor(state, tBisectorData.propagationID, 2, currentID);
+    }
+    else if (tBisectorData.subdivisionPattern == RIGHT_DOUBLE_SPLIT)
+        set_neighbor(state, tBisectorData.indices.y, 2, currentID);
+    else if (tBisectorData.subdivisionPattern == LEFT_DOUBLE_SPLIT)
+        set_neighbor(state, targetID, 2, currentID);
+
+    // Reset the problematic neighbor and the bisection state
+    cBisectorData.problematicNeighbor = INVALID_POINTER;
+    cBisectorData.bisectorState = UNCHANGED_ELEMENT;
+}
+
+static void prepare_simplify_element(CPUUpdateContext& context, uint32_t currentID)
+{
+    const CPUMeshState& state = context.state;
+    uint64_t cHeapID = state.heapIDArray[currentID];
+    uint3 cNeighbors = state.neighborsArray[currentID];
+    uint32_t currentDepth = heap_id_depth(cHeapID);
+
+    // The pair needs to be at the same depth and flagged for simplification
+    uint32_t pairID = cNeighbors.x;
+    uint3 pNeighbors = state.neighborsArray[pairID];
+    if (heap_id_depth(state.heapIDArray[pairID]) != currentDepth || state.bisectorDataArray[pairID].bisectorState != SIMPLIFY_ELEMENT)
+        return;
+
+    // So does the twin pair, the smallest heapID of the diamond does the simplification
+    uint32_t twinLowID = pNeighbors.x;
+    uint32_t twinHighID = cNeighbors.y;
+    if (twinLowID != INVALID_POINTER)
+    {
+        uint64_t twinLowHeapID = state.heapIDArray[twinLowID];
+        uint64_t twinHighHeapID = state.heapIDArray[twinHighID];
+        if (cHeapID > twinLowHeapID)
+            return;
+        if (heap_id_depth(twinLowHeapID) != currentDepth || heap_id_depth(twinHighHeapID) != currentDepth)
+            return;
+        if (state.bisectorDataArray[twinLowID].bisectorState != SIMPLIFY_ELEMENT || state.bisectorDataArray[twinHighID].bisectorState != SIMPLIFY_ELEMENT)
+            return;
+    }
+    context.simplificationList.push_back(currentID);
+}
+
+static uint32_t simplify_element(CPUUpdateContext& context, uint32_t currentID)
+{
+    CPUMeshState& state = context.state;
+    uint3 cNeighbors = state.neighborsArray[currentID];
+    uint32_t pairID = cNeighbors.x;
+    uint3 pNeighbors = state.neighborsArray[pairID];
+    uint32_t twinLowID = pNeighbors.x;
+    uint32_t twinHighID = cNeighbors.y;
+
+    // Merge the pair into the current element
+    state.heapIDArray[currentID] /= 2;
+    state.heapIDArray[pairID] = 0;
+    state.neighborsArray[currentID] = uint3({ cNeighbors.z, pNeighbors.z, twinLowID });
+    BisectorData& cBisectorData = state.bisectorDataArray[currentID];
+    cBisectorData.propagationID = pairID;
+    cBisectorData.problematicNeighbor = pNeighbors.z;
+    cBisectorData.bisectorState = MERGED_ELEMENT;
+    if (pNeighbors.z != INVALID_POINTER)
+        context.propagateSimplifyList.push_back(currentID);
+    state.bisectorDataArray[pairID].bisectorState = MERGED_ELEMENT;
+
+    // If there was a facing pair, simplify it aswell
+    if (twinLowID == INVALID_POINTER)
+        return 1;
+    uint3 lfNeighbors = state.neighborsArray[twinLowID];
+    uint3 hfNeighbors = state.neighborsArray[twinHighID];
+    state.heapIDArray[twinLowID] /= 2;
+    state.heapIDArray[twinHighID] = 0;
+    state.neighborsArray[twinLowID] = uint3({ lfNeighbors.z, hfNeighbors.z, currentID });
+    BisectorData& lBisectorData = state.bisectorDataArray[twinLowID];
+    lBisectorData.propagationID = twinHighID;
+    lBisectorData.problematicNeighbor = hfNeighbors.z;
+    lBisectorData.bisectorState = MERGED_ELEMENT;
+    if (hfNeighbors.z != INVALID_POINTER)
+        context.propagateSimplifyList.push_back(twinLowID);
+    state.bisectorDataArray[twinHighID].bisectorState = MERGED_ELEMENT;
+    return 2;
+}
+
+static void propagate_simplify_element(CPUMeshState& state, uint32_t currentID)
+{
+    BisectorData& cBisectorData = state.bisectorDataArray[currentID];
+    uint32_t deletedPair = cBisectorData.propagationID;
+    uint32_t neighborID = cBisectorData.problematicNeighbor;
+
+    // A neighbor that was merged away is replaced by its pair
+    if (state.bisectorDataArray[neighborID].bisectorState == MERGED_ELEMENT && state.heapIDArray[neighborID] == 0)
+        neighborID = state.neighborsArray[neighborID].y;
+    for (uint32_t slot = 0; slot < 3; ++slot)
+    {
+        if (get_neighbor(state, neighborID, slot) == deletedPair)
+            set_neighbor(state, neighborID, slot, currentID);
+    }
+    cBisectorData.problematicNeighbor = INVALID_POINTER;
+}
+
+void update_cpu_mesh_state(const CPUMesh& mesh, const std::vector<int32_t>& validityArray, const CPUUpdateBudgets& budgets, CPUMeshState& state, CPUUpdateStats& stats)
+{
+    assert_msg(validityArray.size() == state.heapIDArray.size(), "One validity is required per element.");
+    CPUUpdateContext context = { state, mesh.minimalDepth };
+    const uint32_t totalNumElements = (uint32_t)state.heapIDArray.size();
+
+    // The number of new bisectors is bounded by the free elements
+    for (uint32_t elementID = 0; elementID < totalNumElements; ++elementID)
+    {
+        if (state.heapIDArray[elementID] == 0)
+            context.freeElements.push_back(elementID);
+    }
+    context.remainingMemory = (int32_t)std::min((uint32_t)context.freeElements.size(), budgets.maxNewBisectors);
+
+    // Classification
+    for (uint32_t elementID = 0; elementID < totalNumElements; ++elementID)
+    {
+        if (state.heapIDArray[elementID] != 0)
+            register_classification(context, elementID, validityArray[elementID], budgets);
+    }
+
+    // Split, allocation and bisection of the requests within the budget
+    uint32_t numSplits = std::min((uint32_t)context.splitList.size(), budgets.splitBudget);
+    for (uint32_t requestIdx = 0; requestIdx < numSplits; ++requestIdx)
+        split_element(context, context.splitList[requestIdx]);
+    uint32_t numPredictedSplits = std::min((uint32_t)context.predictedSplitList.size(), std::min(budgets.predictiveSplitBudget, budgets.splitBudget - numSplits));
+    for (uint32_t requestIdx = 0; requestIdx < numPredictedSplits; ++requestIdx)
+        split_element(context, context.predictedSplitList[requestIdx]);
+    for (uint32_t currentID : context.allocateList)
+        allocate_element(context, currentID);
+    for (uint32_t currentID : context.allocateList)
+        bisect_element(context, currentID);
+    for (const std::pair<uint32_t, uint3>& record : context.neighborsRecords)
+    {
+        if (record.first != INVALID_POINTER)
+            state.neighborsArray[record.first] = record.second;
+    }
+    for (uint32_t currentID : context.propagateBisectList)
+        propagate_bisect_element(state, currentID);
+
+    // Simplification of the pairs within the budget
+    uint32_t numSimplifications = std::min((uint32_t)context.simplifyList.size(), budgets.simplifyBudget);
+    for (uint32_t requestIdx = 0; requestIdx < numSimplifications; ++requestIdx)
+        prepare_simplify_element(context, context.simplifyList[requestIdx]);
+    uint32_t numMerges = 0;
+    for (uint32_t currentID : context.simplificationList)
+        numMerges += simplify_element(context, currentID);
+    for (uint32_t currentID : context.propagateSimplifyList)
+        propagate_simplify_element(state, currentID);
+
+    // Report the update
+    stats.numSplitRequests = (uint32_t)context.splitList.size();
+    stats.numPredictedSplitRequests = (uint32_t)context.predictedSplitList.size();
+    stats.numSimplifyRequests = (uint32_t)context.simplifyList.size();
+    stats.numBisectedElements = (uint32_t)context.allocateList.size();
+    stats.numNewBisectors = context.numAllocatedSlots;
+    stats.numMerges = numMerges;
+}
@@ -3,15 +3,50 @@
 
 // Project includes
 #include "mesh/mesh.h"
+#include "tools/security.h"
 
-void initialize_cbt_mesh(const CPUMesh& cpuMesh, const CBT& cbt, GraphicsDevice device, CommandQueue queue, CommandBuffer cmdB, CBTMesh& cbtMesh)
+// System includes
+#include <algorithm>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+bool packed_neighbors(uint32_t totalNumElements)
+{
+#if defined(PACKED_NEIGHBORS)
+    // The all ones field encodes INVALID_POINTER
+    return totalNumElements < PACKED_NEIGHBOR_MASK;
+#else
+    return false;
+#endif
+}
+
+uint32_t neighbors_element_size(uint32_t totalNumElements)
+{
+    return packed_neighbors(totalNumElements) ? sizeof(uint64_t) : sizeof(uint3);
+}
+
+void initialize_cbt_mesh(const CPUMesh& cpuMesh, const CBT& cbt, GraphicsDevice device, CommandQueue queue, CommandBuffer cmdB, uint32_t maxNewBisectors, CBTMesh& cbtMesh, const CBTMeshSnapshot* snapshot)
 {
+    const uint32_t neighborsElementSize = neighbors_element_size(cpuMesh.totalNumElements);
+
+    // A snapshot replaces the content of the CBT and bisector buffers, it must have been captured from the same layout
+    const char* cbtBufferData[2] = { nullptr, nullptr };
+    if (snapshot != nullptr)
+    {
+        assert_msg(cbt_mesh_snapshot_matches(*snapshot, cpuMesh, cbt), "The snapshot doesn't match the layout of the mesh.");
+        for (uint32_t bufferIdx = 0; bufferIdx < snapshot->cbtBufferCount; ++bufferIdx)
+            cbtBufferData[bufferIdx] = snapshot->cbtBuffers[bufferIdx].data();
+    }
+
     // Initialize the device cbt
-    initialize_gpu_cbt(cbt, device, queue, cmdB, cbtMesh.gpuCBT);
+    initialize_gpu_cbt(cbt, device, queue, cmdB, cbtMesh.gpuCBT, snapshot != nullptr ? cbtBufferData : nullptr);
 
     // Create the graphics buffer to upload, process and readback the bitfield buffer
     GraphicsBuffer heapIDUploadBuffer = 0;
     GraphicsBuffer neighborsUploadBuffer = 0;
+    GraphicsBuffer patchBoundsUploadBuffer = 0;
+    GraphicsBuffer baseNeighborsUploadBuffer = 0;
 
     // We reset the command buffer
     d3d12::command_buffer::reset(cmdB);
@@ -20,45 +55,147 @@ void initialize_cbt_mesh(const CPUMesh& cpuMesh, const CBT& cbt, GraphicsDevice
     cbtMesh.totalNumElements = cpuMesh.totalNumElements;
     cbtMesh.numBaseVertices = (uint32_t)cpuMesh.basePoints.size();
     cbtMesh.baseDepth = cpuMesh.minimalDepth;
+    cbtMesh.baseMeshHash = cpuMesh.contentHash;
+    cbtMesh.firstBaseElement = cpuMesh.firstBaseElement;
+    cbtMesh.clearUnallocatedElements = snapshot == nullptr;
+    cbtMesh.packedNeighbors = packed_neighbors(cpuMesh.totalNumElements);
 
     // Bisector buffers
     cbtMesh.heapIDBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint64_t) * cpuMesh.totalNumElements, sizeof(uint64_t), GraphicsBufferType::Default);
+    cbtMesh.neighborsBuffer = d3d12::graphics_resources::create_graphics_buffer(device, neighborsElementSize * cpuMesh.totalNumElements, neighborsElementSize, GraphicsBufferType::Default);
+    if (snapshot != nullptr)
     {
+        // The allocated bisectors of the snapshot are expanded straight into the upload buffers
         heapIDUploadBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint64_t) * cpuMesh.totalNumElements, sizeof(uint64_t), GraphicsBufferType::Upload);
-        d3d12::graphics_resources::set_buffer_data(heapIDUploadBuffer, (const char*)cpuMesh.heapIDArray.data(), sizeof(uint64_t) * cpuMesh.totalNumElements);
+        neighborsUploadBuffer = d3d12::graphics_resources::create_graphics_buffer(device, neighborsElementSize * cpuMesh.totalNumElements, neighborsElementSize, GraphicsBufferType::Upload);
+        char* heapIDData = d3d12::graphics_resources::allocate_cpu_buffer(heapIDUploadBuffer);
+        char* neighborsData = d3d12::graphics_resources::allocate_cpu_buffer(neighborsUploadBuffer);
+        expand_cbt_mesh_snapshot(*snapshot, (uint64_t*)heapIDData, neighborsData);
+        d3d12::graphics_resources::release_cpu_buffer(heapIDUploadBuffer);
+        d3d12::graphics_resources::release_cpu_buffer(neighborsUploadBuffer);
         d3d12::command_buffer::copy_graphics_buffer(cmdB, heapIDUploadBuffer, cbtMesh.heapIDBuffer);
+        d3d12::command_buffer::copy_graphics_buffer(cmdB, neighborsUploadBuffer, cbtMesh.neighborsBuffer);
     }
-
-    cbtMesh.currentNeighborsBufferIdx = 0;
-    cbtMesh.neighborsBuffers[0] = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint3) * cpuMesh.totalNumElements, sizeof(uint3), GraphicsBufferType::Default);
+    else
     {
-        neighborsUploadBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint3) * cpuMesh.totalNumElements, sizeof(uint3), GraphicsBufferType::Upload);
-        d3d12::graphics_resources::set_buffer_data(neighborsUploadBuffer, (const char*)cpuMesh.neighborsArray.data(), sizeof(uint3) * cpuMesh.totalNumElements);
-        d3d12::command_buffer::copy_graphics_buffer(cmdB, neighborsUploadBuffer, cbtMesh.neighborsBuffers[0]);
+        // Only the base bisectors are uploaded, the elements before them are cleared by the mesh updater (see clear_unallocated_elements)
+        const uint32_t numBaseElements = (uint32_t)cpuMesh.heapIDArray.size();
+        heapIDUploadBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint64_t) * numBaseElements, sizeof(uint64_t), GraphicsBufferType::Upload);
+        d3d12::graphics_resources::set_buffer_data(heapIDUploadBuffer, (const char*)cpuMesh.heapIDArray.data(), sizeof(uint64_t) * numBaseElements);
+        d3d12::command_buffer::copy_graphics_buffer(cmdB, heapIDUploadBuffer, 0, cbtMesh.heapIDBuffer, sizeof(uint64_t) * cpuMesh.firstBaseElement, sizeof(uint64_t) * numBaseElements);
+
+        std::vector<uint64_t> packedNeighborsArray;
+        const char* neighborsData = (const char*)cpuMesh.neighborsArray.data();
+        if (cbtMesh.packedNeighbors)
+        {
+            packedNeighborsArray.resize(numBaseElements);
+            for (uint32_t baseElementIdx = 0; baseElementIdx < numBaseElements; ++baseElementIdx)
+                packedNeighborsArray[baseElementIdx] = pack_neighbors(cpuMesh.neighborsArray[baseElementIdx]);
+            neighborsData = (const char*)packedNeighborsArray.data();
+        }
+        neighborsUploadBuffer = d3d12::graphics_resources::create_graphics_buffer(device, neighborsElementSize * numBaseElements, neighborsElementSize, GraphicsBufferType::Upload);
+        d3d12::graphics_resources::set_buffer_data(neighborsUploadBuffer, neighborsData, neighborsElementSize * numBaseElements);
+        d3d12::command_buffer::copy_graphics_buffer(cmdB, neighborsUploadBuffer, 0, cbtMesh.neighborsBuffer, neighborsElementSize * cpuMesh.firstBaseElement, neighborsElementSize * numBaseElements);
     }
-    cbtMesh.neighborsBuffers[1] = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint3) * cpuMesh.totalNumElements, sizeof(uint3), GraphicsBufferType::Default);
+    cbtMesh.neighborsUpdateBuffer = 0;
+    resize_neighbors_update_buffer(device, cbtMesh, maxNewBisectors);
 
     // Intermediate buffers
+#if defined(BISECTOR_DATA_SOA)
+    cbtMesh.updateBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * BISECTOR_DATA_NUM_FIELDS * cpuMesh.totalNumElements, sizeof(uint32_t), GraphicsBufferType::Default);
+#else
     cbtMesh.updateBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(BisectorData) * cpuMesh.totalNumElements, sizeof(BisectorData), GraphicsBufferType::Default);
-    cbtMesh.classificationBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * (2 + cpuMesh.totalNumElements * 2), sizeof(uint32_t), GraphicsBufferType::Default);
+#endif
+    cbtMesh.classificationBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * (4 + cpuMesh.totalNumElements * 2), sizeof(uint32_t), GraphicsBufferType::Default);
     cbtMesh.simplificationBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * (1 + cpuMesh.totalNumElements), sizeof(uint32_t), GraphicsBufferType::Default);
     cbtMesh.allocateBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * (1 + cpuMesh.totalNumElements), sizeof(uint32_t), GraphicsBufferType::Default);
     cbtMesh.propagateBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * (2 + cpuMesh.totalNumElements), sizeof(uint32_t), GraphicsBufferType::Default);
     
     // Active bisector indexation
     cbtMesh.indirectDrawBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * (4 * 2 + 2), sizeof(uint32_t), GraphicsBufferType::Default);
-    cbtMesh.indirectDispatchBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * 3 * 3, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.indirectDispatchBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * INDIRECT_DISPATCH_BUFFER_SIZE, sizeof(uint32_t), GraphicsBufferType::Default);
     cbtMesh.indexedBisectorBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cpuMesh.totalNumElements, sizeof(uint32_t), GraphicsBufferType::Default);
     cbtMesh.visibleIndexedBisectorBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cpuMesh.totalNumElements, sizeof(uint32_t), GraphicsBufferType::Default);
     cbtMesh.modifiedIndexedBisectorBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cpuMesh.totalNumElements, sizeof(uint32_t), GraphicsBufferType::Default);
 
+    // Compaction buffers
+    cbtMesh.compactionRemapBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cpuMesh.totalNumElements, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.compactionHeapIDBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint64_t) * cpuMesh.totalNumElements, sizeof(uint64_t), GraphicsBufferType::Default);
+
+    // Incremental classification
+    cbtMesh.classificationCacheBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(float4) * cpuMesh.totalNumElements, sizeof(float4), GraphicsBufferType::Default);
+
+    // Split/merge hysteresis
+    cbtMesh.bisectorAgeBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * (2 * cpuMesh.totalNumElements + 2), sizeof(uint32_t), GraphicsBufferType::Default);
+
+    // Base patch culling
+    uint32_t numPatches = (uint32_t)cpuMesh.patchBounds.size();
+    cbtMesh.patchBoundsBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(float4) * numPatches, sizeof(float4), GraphicsBufferType::Default);
+    {
+        patchBoundsUploadBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(float4) * numPatches, sizeof(float4), GraphicsBufferType::Upload);
+        d3d12::graphics_resources::set_buffer_data(patchBoundsUploadBuffer, (const char*)cpuMesh.patchBounds.data(), sizeof(float4) * numPatches);
+        d3d12::command_buffer::copy_graphics_buffer(cmdB, patchBoundsUploadBuffer, cbtMesh.patchBoundsBuffer);
+    }
+    cbtMesh.patchVisibilityBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * numPatches, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.patchCullingBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * (1 + cpuMesh.totalNumElements), sizeof(uint32_t), GraphicsBufferType::Default);
+
+    // Derived adjacency
+    cbtMesh.baseNeighborsBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint3) * numPatches, sizeof(uint3), GraphicsBufferType::Default);
+    {
+        baseNeighborsUploadBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint3) * numPatches, sizeof(uint3), GraphicsBufferType::Upload);
+        d3d12::graphics_resources::set_buffer_data(baseNeighborsUploadBuffer, (const char*)cpuMesh.baseNeighborsArray.data(), sizeof(uint3) * numPatches);
+        d3d12::command_buffer::copy_graphics_buffer(cmdB, baseNeighborsUploadBuffer, cbtMesh.baseNeighborsBuffer);
+    }
+    cbtMesh.heapIDHashBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * HEAP_ID_HASH_LOAD_RATIO * cpuMesh.totalNumElements, sizeof(uint32_t), GraphicsBufferType::Default);
+
     // Allocate the current vertex buffer
     if (d3d12::graphics_device::double_ops_support(device))
         cbtMesh.lebVertexBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(double3) * cbtMesh.totalNumElements * 4, sizeof(double3), GraphicsBufferType::Default);
     else
         cbtMesh.lebVertexBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(float3) * cbtMesh.totalNumElements * 4, sizeof(float3), GraphicsBufferType::Default);
-    cbtMesh.currentVertexBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(float3) * cbtMesh.totalNumElements * 4, sizeof(float3), GraphicsBufferType::Default);
+    // Committed resources are zero initialized, so no position is considered cached at first
+    cbtMesh.lebPositionHeapIDBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint64_t) * cbtMesh.totalNumElements, sizeof(uint64_t), GraphicsBufferType::Default);
+    cbtMesh.currentVertexBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(float3) * current_vertex_capacity(cbtMesh), sizeof(float3), GraphicsBufferType::Default);
+#if defined(WELDED_VERTICES)
+    cbtMesh.currentDisplacementBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(float3) * current_vertex_capacity(cbtMesh), sizeof(float3), GraphicsBufferType::Default);
+
+    // Welded vertices
+    cbtMesh.vertexIndexBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cbtMesh.totalNumElements * 4, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.weldedVertexBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * current_vertex_capacity(cbtMesh), sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.weldedIndexBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cbtMesh.totalNumElements * 3, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.weldedArgsBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * WELDED_ARGS_SIZE, sizeof(uint32_t), GraphicsBufferType::Default);
+#else
     cbtMesh.currentDisplacementBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(float3) * cbtMesh.totalNumElements * 3, sizeof(float3), GraphicsBufferType::Default);
+#endif
+
+#if defined(BISECTOR_CLUSTERS)
+    // Bisector clusters, every indexed bisector can be alone in its cluster
+    cbtMesh.clusterHashBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * CLUSTER_HASH_LOAD_RATIO * cbtMesh.totalNumElements, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.clusterRootBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint64_t) * cbtMesh.totalNumElements, sizeof(uint64_t), GraphicsBufferType::Default);
+    cbtMesh.clusterIDBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cbtMesh.totalNumElements, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.clusterSlotBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cbtMesh.totalNumElements * 2, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.clusterBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cbtMesh.totalNumElements * 4, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.clusterBoundsBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(float4) * cbtMesh.totalNumElements * 2, sizeof(float4), GraphicsBufferType::Default);
+    cbtMesh.clusterElementBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cbtMesh.totalNumElements, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.clusterDrawBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cbtMesh.totalNumElements, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.clusterArgsBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * CLUSTER_ARGS_SIZE, sizeof(uint32_t), GraphicsBufferType::Default);
+#endif
+
+    // The asynchronous update buffers are only allocated if the mode is used
+    cbtMesh.asyncIndirectDrawBuffer = 0;
+    cbtMesh.asyncIndirectDispatchBuffer = 0;
+    cbtMesh.asyncIndexedBisectorBuffer = 0;
+    cbtMesh.asyncVisibleIndexedBisectorBuffer = 0;
+    cbtMesh.asyncModifiedIndexedBisectorBuffer = 0;
+    cbtMesh.asyncLebVertexBuffer = 0;
+    cbtMesh.asyncLebPositionHeapIDBuffer = 0;
+    cbtMesh.asyncVertexBuffer = 0;
+#if defined(WELDED_VERTICES)
+    cbtMesh.asyncVertexIndexBuffer = 0;
+    cbtMesh.asyncWeldedVertexBuffer = 0;
+    cbtMesh.asyncWeldedIndexBuffer = 0;
+    cbtMesh.asyncWeldedArgsBuffer = 0;
+#endif
 
     // Execute and flush the queue
     d3d12::command_buffer::close(cmdB);
@@ -68,14 +205,58 @@ void initialize_cbt_mesh(const CPUMesh& cpuMesh, const CBT& cbt, GraphicsDevice
     // Make sure to free the temporary graphics buffers
     d3d12::graphics_resources::destroy_graphics_buffer(heapIDUploadBuffer);
     d3d12::graphics_resources::destroy_graphics_buffer(neighborsUploadBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(patchBoundsUploadBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(baseNeighborsUploadBuffer);
 }
 
 void release_cbt_mesh(CBTMesh& cbtMesh)
 {
+    // Asynchronous update buffers
+    release_async_update_buffers(cbtMesh);
+
+#if defined(BISECTOR_CLUSTERS)
+    // Bisector clusters
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.clusterArgsBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.clusterDrawBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.clusterElementBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.clusterBoundsBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.clusterBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.clusterSlotBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.clusterIDBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.clusterRootBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.clusterHashBuffer);
+#endif
+
     // Geometry buffers
+#if defined(WELDED_VERTICES)
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.weldedArgsBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.weldedIndexBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.weldedVertexBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.vertexIndexBuffer);
+#endif
     d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.currentDisplacementBuffer);
     d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.currentVertexBuffer);
     d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.lebVertexBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.lebPositionHeapIDBuffer);
+
+    // Derived adjacency
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.heapIDHashBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.baseNeighborsBuffer);
+
+    // Base patch culling
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.patchCullingBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.patchVisibilityBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.patchBoundsBuffer);
+
+    // Split/merge hysteresis
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.bisectorAgeBuffer);
+
+    // Incremental classification
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.classificationCacheBuffer);
+
+    // Compaction buffers
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.compactionHeapIDBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.compactionRemapBuffer);
 
     // Indexation buffers
     d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.modifiedIndexedBisectorBuffer);
@@ -93,13 +274,305 @@ void release_cbt_mesh(CBTMesh& cbtMesh)
 
     // Bisector buffers
     d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.heapIDBuffer);
-    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.neighborsBuffers[0]);
-    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.neighborsBuffers[1]);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.neighborsBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.neighborsUpdateBuffer);
 
     // Release the cbt
     release_gpu_cbt(cbtMesh.gpuCBT);
 }
 
+void resize_neighbors_update_buffer(GraphicsDevice device, CBTMesh& cbtMesh, uint32_t maxNewBisectors)
+{
+    // An update can't create more bisectors than the mesh has elements
+    maxNewBisectors = std::min(std::max(maxNewBisectors, 1u), cbtMesh.totalNumElements);
+    if (cbtMesh.neighborsUpdateBuffer != 0)
+    {
+        if (maxNewBisectors == cbtMesh.maxNewBisectors)
+            return;
+        d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.neighborsUpdateBuffer);
+    }
+
+    // Every bisection creates at least one bisector, so the records of each possible bisection fit
+    cbtMesh.maxNewBisectors = maxNewBisectors;
+    cbtMesh.neighborsUpdateBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint4) * NEIGHBORS_UPDATE_RECORDS * maxNewBisectors, sizeof(uint4), GraphicsBufferType::Default);
+}
+
+bool cbt_mesh_snapshot_matches(const CBTMeshSnapshot& snapshot, const CPUMesh& cpuMesh, const CBT& cbt)
+{
+    // The bisectors only make sense on the base mesh they were refined from
+    bool matches = snapshot.totalNumElements == cpuMesh.totalNumElements && snapshot.baseDepth == cpuMesh.minimalDepth && snapshot.baseMeshHash == cpuMesh.contentHash
+        && snapshot.neighborsElementSize == neighbors_element_size(cpuMesh.totalNumElements) && snapshot.cbtBufferCount == cbt.num_internal_buffers();
+    for (uint32_t bufferIdx = 0; matches && bufferIdx < snapshot.cbtBufferCount; ++bufferIdx)
+        matches = snapshot.cbtBuffers[bufferIdx].size() == cbt.buffer_size(bufferIdx);
+    return matches;
+}
+
+void capture_cbt_mesh_snapshot(const CBTMesh& cbtMesh, GraphicsDevice device, CommandQueue queue, CommandBuffer cmdB, CBTMeshSnapshot& snapshot)
+{
+    // Layout of the mesh
+    snapshot.totalNumElements = cbtMesh.totalNumElements;
+    snapshot.baseDepth = cbtMesh.baseDepth;
+    snapshot.baseMeshHash = cbtMesh.baseMeshHash;
+    snapshot.neighborsElementSize = neighbors_element_size(cbtMesh.totalNumElements);
+    snapshot.cbtBufferCount = cbtMesh.gpuCBT.bufferCount;
+
+    // Copy the CBT and bisector buffers into readback buffers
+    GraphicsBuffer cbtReadbackBuffer[2] = { 0, 0 };
+    d3d12::command_buffer::reset(cmdB);
+    for (uint32_t bufferIdx = 0; bufferIdx < snapshot.cbtBufferCount; ++bufferIdx)
+    {
+        cbtReadbackBuffer[bufferIdx] = d3d12::graphics_resources::create_graphics_buffer(device, cbtMesh.gpuCBT.bufferSizeArray[bufferIdx], sizeof(uint32_t), GraphicsBufferType::Readback);
+        d3d12::command_buffer::copy_graphics_buffer(cmdB, cbtMesh.gpuCBT.bufferArray[bufferIdx], cbtReadbackBuffer[bufferIdx]);
+    }
+    GraphicsBuffer heapIDReadbackBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint64_t) * cbtMesh.totalNumElements, sizeof(uint64_t), GraphicsBufferType::Readback);
+    d3d12::command_buffer::copy_graphics_buffer(cmdB, cbtMesh.heapIDBuffer, heapIDReadbackBuffer);
+    GraphicsBuffer neighborsReadbackBuffer = d3d12::graphics_resources::create_graphics_buffer(device, snapshot.neighborsElementSize * cbtMesh.totalNumElements, snapshot.neighborsElementSize, GraphicsBufferType::Readback);
+    d3d12::command_buffer::copy_graphics_buffer(cmdB, cbtMesh.neighborsBuffer, neighborsReadbackBuffer);
+
+    // Execute and flush the queue
+    d3d12::command_buffer::close(cmdB);
+    d3d12::command_queue::execute_command_buffer(queue, cmdB);
+    d3d12::command_queue::flush(queue);
+
+    // Keep the CBT as is and only the allocated bisectors
+    for (uint32_t bufferIdx = 0; bufferIdx < snapshot.cbtBufferCount; ++bufferIdx)
+    {
+        const char* cbtData = d3d12::graphics_resources::allocate_cpu_buffer(cbtReadbackBuffer[bufferIdx]);
+        snapshot.cbtBuffers[bufferIdx].assign(cbtData, cbtData + cbtMesh.gpuCBT.bufferSizeArray[bufferIdx]);
+        d3d12::graphics_resources::release_cpu_buffer(cbtReadbackBuffer[bufferIdx]);
+        d3d12::graphics_resources::destroy_graphics_buffer(cbtReadbackBuffer[bufferIdx]);
+    }
+    const char* heapIDData = d3d12::graphics_resources::allocate_cpu_buffer(heapIDReadbackBuffer);
+    const char* neighborsData = d3d12::graphics_resources::allocate_cpu_buffer(neighborsReadbackBuffer);
+    compact_cbt_mesh_snapshot((const uint64_t*)heapIDData, neighborsData, snapshot);
+    d3d12::graphics_resources::release_cpu_buffer(heapIDReadbackBuffer);
+    d3d12::graphics_resources::release_cpu_buffer(neighborsReadbackBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(heapIDReadbackBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(neighborsReadbackBuffer);
+}
+
+void readback_cbt_mesh_bisectors(const CBTMesh& cbtMesh, GraphicsDevice device, CommandQueue queue, CommandBuffer cmdB,
+    std::vector<uint64_t>& heapIDArray, std::vector<uint3>& neighborsArray, std::vector<float3>* displacementArray)
+{
+    const uint32_t numElements = cbtMesh.totalNumElements;
+    const uint32_t neighborsElementSize = neighbors_element_size(numElements);
+
+    // Copy the bisector buffers (and the displacements) into readback buffers
+    d3d12::command_buffer::reset(cmdB);
+    GraphicsBuffer heapIDReadbackBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint64_t) * numElements, sizeof(uint64_t), GraphicsBufferType::Readback);
+    d3d12::command_buffer::copy_graphics_buffer(cmdB, cbtMesh.heapIDBuffer, heapIDReadbackBuffer);
+    GraphicsBuffer neighborsReadbackBuffer = d3d12::graphics_resources::create_graphics_buffer(device, neighborsElementSize * numElements, neighborsElementSize, GraphicsBufferType::Readback);
+    d3d12::command_buffer::copy_graphics_buffer(cmdB, cbtMesh.neighborsBuffer, neighborsReadbackBuffer);
+    GraphicsBuffer displacementReadbackBuffer = 0;
+#if defined(WELDED_VERTICES)
+    // The displacements are stored per welded vertex
+    const uint32_t numDisplacements = current_vertex_capacity(cbtMesh);
+    GraphicsBuffer vertexIndexReadbackBuffer = 0;
+#else
+    const uint32_t numDisplacements = 3 * numElements;
+#endif
+    if (displacementArray != nullptr)
+    {
+        displacementReadbackBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(float3) * numDisplacements, sizeof(float3), GraphicsBufferType::Readback);
+        d3d12::command_buffer::copy_graphics_buffer(cmdB, cbtMesh.currentDisplacementBuffer, displacementReadbackBuffer);
+#if defined(WELDED_VERTICES)
+        vertexIndexReadbackBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * numElements * 4, sizeof(uint32_t), GraphicsBufferType::Readback);
+        d3d12::command_buffer::copy_graphics_buffer(cmdB, cbtMesh.vertexIndexBuffer, vertexIndexReadbackBuffer);
+#endif
+    }
+
+    // Execute and flush the queue
+    d3d12::command_buffer::close(cmdB);
+    d3d12::command_queue::execute_command_buffer(queue, cmdB);
+    d3d12::command_queue::flush(queue);
+
+    // Bisectors
+    heapIDArray.resize(numElements);
+    const char* heapIDData = d3d12::graphics_resources::allocate_cpu_buffer(heapIDReadbackBuffer);
+    memcpy(heapIDArray.data(), heapIDData, sizeof(uint64_t) * numElements);
+    d3d12::graphics_resources::release_cpu_buffer(heapIDReadbackBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(heapIDReadbackBuffer);
+    neighborsArray.resize(numElements);
+    const char* neighborsData = d3d12::graphics_resources::allocate_cpu_buffer(neighborsReadbackBuffer);
+    if (cbtMesh.packedNeighbors)
+    {
+        const uint64_t* packedNeighborsData = (const uint64_t*)neighborsData;
+        for (uint32_t elementID = 0; elementID < numElements; ++elementID)
+            neighborsArray[elementID] = unpack_neighbors(packedNeighborsData[elementID]);
+    }
+    else
+        memcpy(neighborsArray.data(), neighborsData, sizeof(uint3) * numElements);
+    d3d12::graphics_resources::release_cpu_buffer(neighborsReadbackBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(neighborsReadbackBuffer);
+
+    // Displacement of the corners
+    if (displacementArray != nullptr)
+    {
+        displacementArray->resize(3 * (size_t)numElements);
+        const float3* displacementData = (const float3*)d3d12::graphics_resources::allocate_cpu_buffer(displacementReadbackBuffer);
+#if defined(WELDED_VERTICES)
+        const uint32_t* vertexIndexData = (const uint32_t*)d3d12::graphics_resources::allocate_cpu_buffer(vertexIndexReadbackBuffer);
+        for (uint32_t cornerIdx = 0; cornerIdx < 3 * numElements; ++cornerIdx)
+        {
+            uint32_t vertexIndex = vertexIndexData[cornerIdx];
+            (*displacementArray)[cornerIdx] = vertexIndex < numDisplacements ? displacementData[vertexIndex] : float3({ 0.0f, 0.0f, 0.0f });
+        }
+        d3d12::graphics_resources::release_cpu_buffer(vertexIndexReadbackBuffer);
+        d3d12::graphics_resources::destroy_graphics_buffer(vertexIndexReadbackBuffer);
+#else
+        memcpy(displacementArray->data(), displacementData, sizeof(float3) * numDisplacements);
+#endif
+        d3d12::graphics_resources::release_cpu_buffer(displacementReadbackBuffer);
+        d3d12::graphics_resources::destroy_graphics_buffer(displacementReadbackBuffer);
+    }
+}
+
+void initialize_async_update_buffers(GraphicsDevice device, CBTMesh& cbtMesh)
+{
+    // Already allocated
+    if (cbtMesh.asyncIndexedBisectorBuffer != 0)
+        return;
+
+    // Indexation buffers
+    cbtMesh.asyncIndirectDrawBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * (4 * 2 + 2), sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.asyncIndirectDispatchBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * INDIRECT_DISPATCH_BUFFER_SIZE, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.asyncIndexedBisectorBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cbtMesh.totalNumElements, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.asyncVisibleIndexedBisectorBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cbtMesh.totalNumElements, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.asyncModifiedIndexedBisectorBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cbtMesh.totalNumElements, sizeof(uint32_t), GraphicsBufferType::Default);
+
+    // Geometry buffers
+    if (d3d12::graphics_device::double_ops_support(device))
+        cbtMesh.asyncLebVertexBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(double3) * cbtMesh.totalNumElements * 4, sizeof(double3), GraphicsBufferType::Default);
+    else
+        cbtMesh.asyncLebVertexBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(float3) * cbtMesh.totalNumElements * 4, sizeof(float3), GraphicsBufferType::Default);
+    cbtMesh.asyncLebPositionHeapIDBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint64_t) * cbtMesh.totalNumElements, sizeof(uint64_t), GraphicsBufferType::Default);
+    cbtMesh.asyncVertexBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(float3) * current_vertex_capacity(cbtMesh), sizeof(float3), GraphicsBufferType::Default);
+#if defined(WELDED_VERTICES)
+    cbtMesh.asyncVertexIndexBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cbtMesh.totalNumElements * 4, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.asyncWeldedVertexBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * current_vertex_capacity(cbtMesh), sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.asyncWeldedIndexBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * cbtMesh.totalNumElements * 3, sizeof(uint32_t), GraphicsBufferType::Default);
+    cbtMesh.asyncWeldedArgsBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint32_t) * WELDED_ARGS_SIZE, sizeof(uint32_t), GraphicsBufferType::Default);
+#endif
+#if defined(BISECTOR_CLUSTERS)
+    cbtMesh.clusterHeapIDBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint64_t) * cbtMesh.totalNumElements, sizeof(uint64_t), GraphicsBufferType::Default);
+    cbtMesh.asyncClusterHeapIDBuffer = d3d12::graphics_resources::create_graphics_buffer(device, sizeof(uint64_t) * cbtMesh.totalNumElements, sizeof(uint64_t), GraphicsBufferType::Default);
+#endif
+}
+
+void release_async_update_buffers(CBTMesh& cbtMesh)
+{
+    // Never allocated
+    if (cbtMesh.asyncIndexedBisectorBuffer == 0)
+        return;
+
+#if defined(BISECTOR_CLUSTERS)
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.asyncClusterHeapIDBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.clusterHeapIDBuffer);
+    cbtMesh.asyncClusterHeapIDBuffer = 0;
+    cbtMesh.clusterHeapIDBuffer = 0;
+#endif
+
+#if defined(WELDED_VERTICES)
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.asyncWeldedArgsBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.asyncWeldedIndexBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.asyncWeldedVertexBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.asyncVertexIndexBuffer);
+    cbtMesh.asyncWeldedArgsBuffer = 0;
+    cbtMesh.asyncWeldedIndexBuffer = 0;
+    cbtMesh.asyncWeldedVertexBuffer = 0;
+    cbtMesh.asyncVertexIndexBuffer = 0;
+#endif
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.asyncVertexBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.asyncLebVertexBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.asyncLebPositionHeapIDBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.asyncModifiedIndexedBisectorBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.asyncVisibleIndexedBisectorBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.asyncIndexedBisectorBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.asyncIndirectDispatchBuffer);
+    d3d12::graphics_resources::destroy_graphics_buffer(cbtMesh.asyncIndirectDrawBuffer);
+
+    cbtMesh.asyncVertexBuffer = 0;
+    cbtMesh.asyncLebVertexBuffer = 0;
+    cbtMesh.asyncLebPositionHeapIDBuffer = 0;
+    cbtMesh.asyncModifiedIndexedBisectorBuffer = 0;
+    cbtMesh.asyncVisibleIndexedBisectorBuffer = 0;
+    cbtMesh.asyncIndexedBisectorBuffer = 0;
+    cbtMesh.asyncIndirectDispatchBuffer = 0;
+    cbtMesh.asyncIndirectDrawBuffer = 0;
+}
+
+void prepare_async_update(CommandBuffer cmdB, const CBTMesh& cbtMesh)
+{
+    d3d12::command_buffer::start_section(cmdB, "Prepare Async Update");
+    {
+        // The patch culling and classification of the update read the previous indexation
+        d3d12::command_buffer::copy_graphics_buffer(cmdB, cbtMesh.indirectDrawBuffer, cbtMesh.asyncIndirectDrawBuffer);
+        d3d12::command_buffer::copy_graphics_buffer(cmdB, cbtMesh.indirectDispatchBuffer, cbtMesh.asyncIndirectDispatchBuffer);
+        d3d12::command_buffer::copy_graphics_buffer(cmdB, cbtMesh.indexedBisectorBuffer, cbtMesh.asyncIndexedBisectorBuffer);
+
+        // The classification reads the deformed vertices, the rendering keeps writing the front ones
+        d3d12::command_buffer::copy_graphics_buffer(cmdB, cbtMesh.currentVertexBuffer, cbtMesh.asyncVertexBuffer);
+#if defined(WELDED_VERTICES)
+        d3d12::command_buffer::copy_graphics_buffer(cmdB, cbtMesh.vertexIndexBuffer, cbtMesh.asyncVertexIndexBuffer);
+#endif
+    }
+    d3d12::command_buffer::end_section(cmdB);
+}
+
+CBTMesh async_update_mesh(const CBTMesh& cbtMesh)
+{
+    // The bisector data and the CBT are only touched by the update, the rest is double buffered
+    CBTMesh asyncMesh = cbtMesh;
+    asyncMesh.indirectDrawBuffer = cbtMesh.asyncIndirectDrawBuffer;
+    asyncMesh.indirectDispatchBuffer = cbtMesh.asyncIndirectDispatchBuffer;
+    asyncMesh.indexedBisectorBuffer = cbtMesh.asyncIndexedBisectorBuffer;
+    asyncMesh.visibleIndexedBisectorBuffer = cbtMesh.asyncVisibleIndexedBisectorBuffer;
+    asyncMesh.modifiedIndexedBisectorBuffer = cbtMesh.asyncModifiedIndexedBisectorBuffer;
+    asyncMesh.lebVertexBuffer = cbtMesh.asyncLebVertexBuffer;
+    asyncMesh.lebPositionHeapIDBuffer = cbtMesh.asyncLebPositionHeapIDBuffer;
+    asyncMesh.currentVertexBuffer = cbtMesh.asyncVertexBuffer;
+#if defined(WELDED_VERTICES)
+    asyncMesh.vertexIndexBuffer = cbtMesh.asyncVertexIndexBuffer;
+    asyncMesh.weldedVertexBuffer = cbtMesh.asyncWeldedVertexBuffer;
+    asyncMesh.weldedIndexBuffer = cbtMesh.asyncWeldedIndexBuffer;
+    asyncMesh.weldedArgsBuffer = cbtMesh.asyncWeldedArgsBuffer;
+#endif
+#if defined(BISECTOR_CLUSTERS)
+    asyncMesh.clusterHeapIDBuffer = cbtMesh.asyncClusterHeapIDBuffer;
+#endif
+    return asyncMesh;
+}
+
+void swap_async_update_buffers(CBTMesh& cbtMesh)
+{
+    std::swap(cbtMesh.indirectDrawBuffer, cbtMesh.asyncIndirectDrawBuffer);
+    std::swap(cbtMesh.indirectDispatchBuffer, cbtMesh.asyncIndirectDispatchBuffer);
+    std::swap(cbtMesh.indexedBisectorBuffer, cbtMesh.asyncIndexedBisectorBuffer);
+    std::swap(cbtMesh.visibleIndexedBisectorBuffer, cbtMesh.asyncVisibleIndexedBisectorBuffer);
+    std::swap(cbtMesh.modifiedIndexedBisectorBuffer, cbtMesh.asyncModifiedIndexedBisectorBuffer);
+    std::swap(cbtMesh.lebVertexBuffer, cbtMesh.asyncLebVertexBuffer);
+    std::swap(cbtMesh.lebPositionHeapIDBuffer, cbtMesh.asyncLebPositionHeapIDBuffer);
+#if defined(WELDED_VERTICES)
+    std::swap(cbtMesh.vertexIndexBuffer, cbtMesh.asyncVertexIndexBuffer);
+    std::swap(cbtMesh.weldedVertexBuffer, cbtMesh.asyncWeldedVertexBuffer);
+    std::swap(cbtMesh.weldedIndexBuffer, cbtMesh.asyncWeldedIndexBuffer);
+    std::swap(cbtMesh.weldedArgsBuffer, cbtMesh.asyncWeldedArgsBuffer);
+#endif
+#if defined(BISECTOR_CLUSTERS)
+    std::swap(cbtMesh.clusterHeapIDBuffer, cbtMesh.asyncClusterHeapIDBuffer);
+#endif
+}
+
+uint32_t current_vertex_capacity(const CBTMesh& cbtMesh)
+{
+#if defined(WELDED_VERTICES)
+    return WELDED_VERTEX_RATIO * cbtMesh.totalNumElements;
+#else
+    // 3 vertices per element + the fourth one
+    return 4 * cbtMesh.totalNumElements;
+#endif
+}
+
 void initialize_base_mesh(const CPUMesh& cpuMesh, GraphicsDevice device, CommandQueue queue, CommandBuffer buffer, BaseMesh& baseMesh)
 {
     GraphicsBuffer vertexUploadBuffer = 0;
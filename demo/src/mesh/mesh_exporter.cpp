@@ -0,0 +1,357 @@
+// Project includes
+#include "cbt/bisector.h"
+#include "math/operators.h"
+#include "mesh/mesh_exporter.h"
+#include "tools/parallel_for.h"
+
+// System includes
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+// Binary export file ("CBME") and its version
+#define MESH_EXPORT_MAGIC 0x454D4243
+#define MESH_EXPORT_VERSION 1
+
+// Flags a corner that points to the corner owning its vertex
+#define MESH_EXPORT_OWNER_FLAG 0x80000000
+
+// Upper bound of the text of an OBJ vertex and triangle
+#define MESH_EXPORT_OBJ_VERTEX_SIZE 80
+#define MESH_EXPORT_OBJ_TRIANGLE_SIZE 40
+
+struct MeshExportHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numVertices;
+    uint32_t numTriangles;
+    uint32_t numBlocks;
+    uint32_t padding;
+};
+
+struct MeshExportContext
+{
+    const CPUMesh* mesh;
+    const std::vector<uint64_t>* heapIDArray;
+    const float3* displacementArray;
+    double planetRadius;
+    MeshExportFormat format;
+
+    // Vertex of every corner (or owner corner flagged), and vertices, triangles and first vertex of every block
+    std::vector<uint32_t> cornerVertexArray;
+    std::vector<uint32_t> blockVertices;
+    std::vector<uint32_t> blockTriangles;
+    std::vector<uint32_t> blockFirstVertex;
+};
+
+uint32_t neighbor_slot(const uint3& neighbors, uint32_t slot)
+{
+    return slot == 0 ? neighbors.x : (slot == 1 ? neighbors.y : neighbors.z);
+}
+
+// Slot of the edge that leaves each corner (v0 -> v1 is the next edge, v1 -> v2 the previous one and v2 -> v0 the twin)
+uint32_t outgoing_edge_slot(uint32_t corner)
+{
+    return corner == 0 ? 1 : (corner == 1 ? 0 : 2);
+}
+
+uint32_t weld_owner_key(const std::vector<uint3>& neighborsArray, uint32_t bisectorID, uint32_t corner)
+{
+    // Turn around the vertex through the outgoing edges, the neighbors share them in the reverse direction
+    const uint32_t numElements = (uint32_t)neighborsArray.size();
+    uint32_t ownerKey = 3 * bisectorID + corner;
+    uint32_t currentBisector = bisectorID;
+    uint32_t currentCorner = corner;
+    for (uint32_t step = 0; step < MESH_EXPORT_MAX_VALENCE; ++step)
+    {
+        uint32_t neighborID = neighbor_slot(neighborsArray[currentBisector], outgoing_edge_slot(currentCorner));
+        if (neighborID >= numElements)
+            break;
+
+        // The edge that reaches the vertex in the neighbor gives its corner
+        const uint3& nNeighbors = neighborsArray[neighborID];
+        uint32_t incomingSlot = nNeighbors.x == currentBisector ? 0 : (nNeighbors.y == currentBisector ? 1 : 2);
+        currentBisector = neighborID;
+        currentCorner = 2 - incomingSlot;
+
+        // The fan is closed, the smallest corner key owns the vertex
+        if (currentBisector == bisectorID)
+            return ownerKey;
+        ownerKey = std::min(ownerKey, 3 * currentBisector + currentCorner);
+    }
+
+    // Open or too large fan, every corner of it keeps its own vertex
+    return 3 * bisectorID + corner;
+}
+
+char* append_uint(char* output, uint64_t value)
+{
+    char digits[20];
+    uint32_t numDigits = 0;
+    do
+    {
+        digits[numDigits++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (numDigits > 0)
+        *output++ = digits[--numDigits];
+    return output;
+}
+
+// Writes a value with three decimals (millimeters for the planet space positions)
+char* append_fixed(char* output, double value)
+{
+    int64_t scaled = llround(value * 1000.0);
+    if (scaled < 0)
+    {
+        *output++ = '-';
+        scaled = -scaled;
+    }
+    output = append_uint(output, (uint64_t)scaled / 1000);
+    uint32_t fraction = (uint32_t)((uint64_t)scaled % 1000);
+    *output++ = '.';
+    *output++ = (char)('0' + fraction / 100);
+    *output++ = (char)('0' + fraction / 10 % 10);
+    *output++ = (char)('0' + fraction % 10);
+    return output;
+}
+
+void format_block(const MeshExportContext& context, uint32_t blockIdx, std::vector<char>& output)
+{
+    const std::vector<uint64_t>& heapIDArray = *context.heapIDArray;
+    const uint32_t firstElement = blockIdx * MESH_EXPORT_BLOCK_SIZE;
+    const uint32_t lastElement = std::min(firstElement + MESH_EXPORT_BLOCK_SIZE, (uint32_t)heapIDArray.size());
+    const uint32_t numVertices = context.blockVertices[blockIdx];
+    const uint32_t numTriangles = context.blockTriangles[blockIdx];
+    const bool obj = context.format == MeshExportFormat::OBJ;
+
+    // Upper bound of the block
+    if (obj)
+        output.resize((size_t)numVertices * MESH_EXPORT_OBJ_VERTEX_SIZE + (size_t)numTriangles * MESH_EXPORT_OBJ_TRIANGLE_SIZE);
+    else
+        output.resize(sizeof(uint32_t) * 2 + sizeof(double3) * numVertices + sizeof(uint3) * numTriangles);
+    char* data = output.data();
+    if (!obj)
+    {
+        memcpy(data, &numVertices, sizeof(uint32_t));
+        memcpy(data + sizeof(uint32_t), &numTriangles, sizeof(uint32_t));
+        data += sizeof(uint32_t) * 2;
+    }
+
+    // Vertices owned by the elements of the block, in the order they were numbered
+    for (uint32_t elementID = firstElement; elementID < lastElement; ++elementID)
+    {
+        uint64_t heapID = heapIDArray[elementID];
+        if (heapID == 0)
+            continue;
+
+        bool decoded = false;
+        double3 positions[4];
+        for (uint32_t corner = 0; corner < 3; ++corner)
+        {
+            uint32_t cornerKey = 3 * elementID + corner;
+            if ((context.cornerVertexArray[cornerKey] & MESH_EXPORT_OWNER_FLAG) != 0)
+                continue;
+
+            // Only decode the elements that own a vertex
+            if (!decoded)
+            {
+                decode_bisector_positions(*context.mesh, heapID, positions);
+                decoded = true;
+            }
+            double3 position = positions[corner] * context.planetRadius;
+            if (context.displacementArray != nullptr)
+            {
+                const float3& displacement = context.displacementArray[cornerKey];
+                position = double3({ position.x + displacement.x, position.y + displacement.y, position.z + displacement.z });
+            }
+
+            if (obj)
+            {
+                *data++ = 'v';
+                *data++ = ' ';
+                data = append_fixed(data, position.x);
+                *data++ = ' ';
+                data = append_fixed(data, position.y);
+                *data++ = ' ';
+                data = append_fixed(data, position.z);
+                *data++ = '\n';
+            }
+            else
+            {
+                memcpy(data, &position, sizeof(double3));
+                data += sizeof(double3);
+            }
+        }
+    }
+
+    // Triangles of the block, the corners are written in the reverse order like the rendering does
+    for (uint32_t elementID = firstElement; elementID < lastElement; ++elementID)
+    {
+        if (heapIDArray[elementID] == 0)
+            continue;
+
+        uint32_t vertices[3];
+        for (uint32_t corner = 0; corner < 3; ++corner)
+        {
+            uint32_t vertexIndex = context.cornerVertexArray[3 * elementID + corner];
+            if ((vertexIndex & MESH_EXPORT_OWNER_FLAG) != 0)
+                vertexIndex = context.cornerVertexArray[vertexIndex & ~MESH_EXPORT_OWNER_FLAG];
+            vertices[2 - corner] = vertexIndex;
+        }
+
+        if (obj)
+        {
+            *data++ = 'f';
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                *data++ = ' ';
+                data = append_uint(data, vertices[corner] + 1);
+            }
+            *data++ = '\n';
+        }
+        else
+        {
+            memcpy(data, vertices, sizeof(uint3));
+            data += sizeof(uint3);
+        }
+    }
+    output.resize(data - output.data());
+}
+
+bool export_bisector_mesh(const CPUMesh& mesh, const std::vector<uint64_t>& heapIDArray, const std::vector<uint3>& neighborsArray, const float3* displacementArray,
+    double planetRadius, MeshExportFormat format, const char* exportPath, MeshExportStats& stats)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    FILE* exportFile = fopen(exportPath, "wb");
+    if (exportFile == nullptr)
+        return false;
+
+    MeshExportContext context;
+    context.mesh = &mesh;
+    context.heapIDArray = &heapIDArray;
+    context.displacementArray = displacementArray;
+    context.planetRadius = planetRadius;
+    context.format = format;
+
+    // Find the owner of every corner (the smallest corner key of its fan, which is never in a later block)
+    const uint32_t numElements = (uint32_t)heapIDArray.size();
+    const uint32_t numBlocks = (numElements + MESH_EXPORT_BLOCK_SIZE - 1) / MESH_EXPORT_BLOCK_SIZE;
+    context.cornerVertexArray.resize(3 * (size_t)numElements);
+    context.blockVertices.resize(numBlocks);
+    context.blockTriangles.resize(numBlocks);
+    context.blockFirstVertex.resize(numBlocks);
+    parallel_for(numBlocks, 1, [&](uint32_t firstBlock, uint32_t lastBlock)
+    {
+        for (uint32_t blockIdx = firstBlock; blockIdx < lastBlock; ++blockIdx)
+        {
+            uint32_t numVertices = 0;
+            uint32_t numTriangles = 0;
+            uint32_t lastElement = std::min((blockIdx + 1) * MESH_EXPORT_BLOCK_SIZE, numElements);
+            for (uint32_t elementID = blockIdx * MESH_EXPORT_BLOCK_SIZE; elementID < lastElement; ++elementID)
+            {
+                if (heapIDArray[elementID] == 0)
+                    continue;
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                {
+                    uint32_t cornerKey = 3 * elementID + corner;
+                    uint32_t ownerKey = weld_owner_key(neighborsArray, elementID, corner);
+                    context.cornerVertexArray[cornerKey] = ownerKey == cornerKey ? 0 : (MESH_EXPORT_OWNER_FLAG | ownerKey);
+                    numVertices += ownerKey == cornerKey ? 1 : 0;
+                }
+                numTriangles++;
+            }
+            context.blockVertices[blockIdx] = numVertices;
+            context.blockTriangles[blockIdx] = numTriangles;
+        }
+    });
+
+    // Number the vertices block after block
+    stats = MeshExportStats();
+    for (uint32_t blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+    {
+        context.blockFirstVertex[blockIdx] = stats.numVertices;
+        stats.numVertices += context.blockVertices[blockIdx];
+        stats.numTriangles += context.blockTriangles[blockIdx];
+    }
+    parallel_for(numBlocks, 1, [&](uint32_t firstBlock, uint32_t lastBlock)
+    {
+        for (uint32_t blockIdx = firstBlock; blockIdx < lastBlock; ++blockIdx)
+        {
+            uint32_t vertexIndex = context.blockFirstVertex[blockIdx];
+            uint32_t lastElement = std::min((blockIdx + 1) * MESH_EXPORT_BLOCK_SIZE, numElements);
+            for (uint32_t elementID = blockIdx * MESH_EXPORT_BLOCK_SIZE; elementID < lastElement; ++elementID)
+            {
+                if (heapIDArray[elementID] == 0)
+                    continue;
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                {
+                    uint32_t& cornerVertex = context.cornerVertexArray[3 * elementID + corner];
+                    if ((cornerVertex & MESH_EXPORT_OWNER_FLAG) == 0)
+                        cornerVertex = vertexIndex++;
+                }
+            }
+        }
+    });
+
+    // Header
+    bool written = true;
+    if (format == MeshExportFormat::Binary)
+    {
+        MeshExportHeader header = { MESH_EXPORT_MAGIC, MESH_EXPORT_VERSION, stats.numVertices, stats.numTriangles, numBlocks, 0 };
+        written = fwrite(&header, sizeof(MeshExportHeader), 1, exportFile) == 1;
+        stats.fileSize += sizeof(MeshExportHeader);
+    }
+    else
+    {
+        char header[128];
+        int headerSize = snprintf(header, sizeof(header), "# %u vertices, %u triangles\n", stats.numVertices, stats.numTriangles);
+        written = fwrite(header, 1, headerSize, exportFile) == (size_t)headerSize;
+        stats.fileSize += headerSize;
+    }
+
+    // Decode the chunks into one set of block buffers while the previous chunk is written from the other one
+    std::vector<std::vector<char>> blockBuffers[2];
+    blockBuffers[0].resize(MESH_EXPORT_BLOCKS_PER_CHUNK);
+    blockBuffers[1].resize(MESH_EXPORT_BLOCKS_PER_CHUNK);
+    std::thread writer;
+    bool chunkWritten = true;
+    const uint32_t numChunks = (numBlocks + MESH_EXPORT_BLOCKS_PER_CHUNK - 1) / MESH_EXPORT_BLOCKS_PER_CHUNK;
+    for (uint32_t chunkIdx = 0; chunkIdx < numChunks && written; ++chunkIdx)
+    {
+        std::vector<std::vector<char>>& buffers = blockBuffers[chunkIdx % 2];
+        uint32_t firstBlock = chunkIdx * MESH_EXPORT_BLOCKS_PER_CHUNK;
+        uint32_t numChunkBlocks = std::min((uint32_t)MESH_EXPORT_BLOCKS_PER_CHUNK, numBlocks - firstBlock);
+        parallel_for(numChunkBlocks, 1, [&](uint32_t first, uint32_t last)
+        {
+            for (uint32_t localBlockIdx = first; localBlockIdx < last; ++localBlockIdx)
+                format_block(context, firstBlock + localBlockIdx, buffers[localBlockIdx]);
+        });
+        for (uint32_t localBlockIdx = 0; localBlockIdx < numChunkBlocks; ++localBlockIdx)
+            stats.fileSize += buffers[localBlockIdx].size();
+
+        // Wait for the previous chunk before writing this one
+        if (writer.joinable())
+            writer.join();
+        written = chunkWritten;
+        writer = std::thread([&buffers, numChunkBlocks, exportFile, &chunkWritten]()
+        {
+            for (uint32_t localBlockIdx = 0; localBlockIdx < numChunkBlocks && chunkWritten; ++localBlockIdx)
+                chunkWritten = fwrite(buffers[localBlockIdx].data(), 1, buffers[localBlockIdx].size(), exportFile) == buffers[localBlockIdx].size();
+        });
+    }
+    if (writer.joinable())
+        writer.join();
+    written = written && chunkWritten;
+    fclose(exportFile);
+
+    // Don't leave a truncated export behind
+    if (!written)
+        remove(exportPath);
+    stats.duration = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return written;
+}
@@ -0,0 +1,535 @@
+// Project includes
+#include "cbt/bisector.h"
+#include "mesh/mesh_importer.h"
+#include "tools/mapped_file.h"
+#include "tools/parallel_for.h"
+#include "tools/security.h"
+
+// System includes
+#include <atomic>
+#include <math.h>
+#include <memory>
+#include <string.h>
+#include <string>
+
+// Minimal number of faces or halfedges processed by a thread while building the halfedges
+#define MESH_IMPORTER_PARALLEL_MIN_RANGE 4096
+
+// Empty slot of the edge table
+#define EDGE_TABLE_EMPTY_KEY UINT64_MAX
+
+// Longer integers could overflow an int64_t
+#define PARSE_INT_MAX_DIGITS 18
+
+// Read only cursor over a mapped file
+struct ParseCursor
+{
+    const char* current;
+    const char* end;
+};
+
+enum class PLYFormat
+{
+    Ascii = 0,
+    BinaryLittleEndian,
+    BinaryBigEndian
+};
+
+enum class PLYType
+{
+    Int8 = 0,
+    UInt8,
+    Int16,
+    UInt16,
+    Int32,
+    UInt32,
+    Float32,
+    Float64,
+    Invalid
+};
+
+struct PLYProperty
+{
+    std::string name;
+    PLYType type;
+    // List properties have a count followed by that many items of type
+    bool list;
+    PLYType countType;
+};
+
+struct PLYElement
+{
+    std::string name;
+    uint32_t count;
+    std::vector<PLYProperty> properties;
+};
+
+// Spaces and tabs (and carriage returns) of the current line
+void skip_blanks(ParseCursor& cursor)
+{
+    while (cursor.current < cursor.end && (*cursor.current == ' ' || *cursor.current == '\t' || *cursor.current == '\r'))
+        cursor.current++;
+}
+
+// Every white space, including the line breaks
+void skip_white_spaces(ParseCursor& cursor)
+{
+    while (cursor.current < cursor.end && (*cursor.current == ' ' || *cursor.current == '\t' || *cursor.current == '\r' || *cursor.current == '\n'))
+        cursor.current++;
+}
+
+bool end_of_line(const ParseCursor& cursor)
+{
+    return cursor.current >= cursor.end || *cursor.current == '\n';
+}
+
+void next_line(ParseCursor& cursor)
+{
+    while (cursor.current < cursor.end && *cursor.current++ != '\n');
+}
+
+// Non blank characters of the current line
+std::string read_token(ParseCursor& cursor)
+{
+    skip_blanks(cursor);
+    const char* begin = cursor.current;
+    while (cursor.current < cursor.end && *cursor.current != ' ' && *cursor.current != '\t' && *cursor.current != '\r' && *cursor.current != '\n')
+        cursor.current++;
+    return std::string(begin, cursor.current);
+}
+
+bool parse_int(ParseCursor& cursor, int64_t& value)
+{
+    const char* current = cursor.current;
+    bool negative = current < cursor.end && *current == '-';
+    if (current < cursor.end && (*current == '-' || *current == '+'))
+        current++;
+    if (current >= cursor.end || *current < '0' || *current > '9')
+        return false;
+    value = 0;
+    const char* firstDigit = current;
+    while (current < cursor.end && *current >= '0' && *current <= '9')
+    {
+        if (current - firstDigit == PARSE_INT_MAX_DIGITS)
+            return false;
+        value = value * 10 + (*current++ - '0');
+    }
+    value = negative ? -value : value;
+    cursor.current = current;
+    return true;
+}
+
+// The files are mapped and not null terminated, the numbers are parsed within the bounds of the cursor
+bool parse_double(ParseCursor& cursor, double& value)
+{
+    const char* current = cursor.current;
+    bool negative = current < cursor.end && *current == '-';
+    if (current < cursor.end && (*current == '-' || *current == '+'))
+        current++;
+
+    // Mantissa
+    double mantissa = 0.0;
+    int32_t exponent = 0;
+    bool digits = false;
+    while (current < cursor.end && *current >= '0' && *current <= '9')
+    {
+        mantissa = mantissa * 10.0 + (*current++ - '0');
+        digits = true;
+    }
+    if (current < cursor.end && *current == '.')
+    {
+        current++;
+        while (current < cursor.end && *current >= '0' && *current <= '9')
+        {
+            mantissa = mantissa * 10.0 + (*current++ - '0');
+            exponent--;
+            digits = true;
+        }
+    }
+    if (!digits)
+        return false;
+
+    // Exponent
+    if (current < cursor.end && (*current == 'e' || *current == 'E'))
+    {
+        ParseCursor exponentCursor = { current + 1, cursor.end };
+        int64_t explicitExponent;
+        if (parse_int(exponentCursor, explicitExponent))
+        {
+            exponent += (int32_t)explicitExponent;
+            current = exponentCursor.current;
+        }
+    }
+
+    value = mantissa * pow(10.0, exponent);
+    value = negative ? -value : value;
+    cursor.current = current;
+    return true;
+}
+
+bool import_obj(const MappedFile& file, std::vector<float3>& vertices, std::vector<uint32_t>& faceOffsets, std::vector<uint32_t>& faceVertices)
+{
+    ParseCursor cursor = { file.data, file.data + file.size };
+    faceOffsets.push_back(0);
+    while (cursor.current < cursor.end)
+    {
+        skip_blanks(cursor);
+        const char* keyword = cursor.current;
+        uint32_t keywordLength = 0;
+        while (keyword + keywordLength < cursor.end && keyword[keywordLength] != ' ' && keyword[keywordLength] != '\t' && keyword[keywordLength] != '\n')
+            keywordLength++;
+
+        if (keywordLength == 1 && keyword[0] == 'v')
+        {
+            // Position (the optional weight or color is ignored)
+            cursor.current += keywordLength;
+            double coordinates[3];
+            for (uint32_t coordIdx = 0; coordIdx < 3; ++coordIdx)
+            {
+                skip_blanks(cursor);
+                if (!parse_double(cursor, coordinates[coordIdx]))
+                    return false;
+            }
+            vertices.push_back(float3({ (float)coordinates[0], (float)coordinates[1], (float)coordinates[2] }));
+        }
+        else if (keywordLength == 1 && keyword[0] == 'f')
+        {
+            // Position indices (one based or relative to the last vertex), the texture and normal indices are ignored
+            cursor.current += keywordLength;
+            uint32_t firstVertex = (uint32_t)faceVertices.size();
+            skip_blanks(cursor);
+            while (!end_of_line(cursor))
+            {
+                int64_t index;
+                if (!parse_int(cursor, index) || index == 0)
+                    return false;
+                faceVertices.push_back((uint32_t)(index > 0 ? index - 1 : (int64_t)vertices.size() + index));
+                while (!end_of_line(cursor) && *cursor.current != ' ' && *cursor.current != '\t' && *cursor.current != '\r')
+                    cursor.current++;
+                skip_blanks(cursor);
+            }
+
+            // Degenerated faces are dropped
+            if (faceVertices.size() - firstVertex < 3)
+                faceVertices.resize(firstVertex);
+            else
+                faceOffsets.push_back((uint32_t)faceVertices.size());
+        }
+        next_line(cursor);
+    }
+    return true;
+}
+
+PLYType ply_type(const std::string& name)
+{
+    if (name == "char" || name == "int8") return PLYType::Int8;
+    if (name == "uchar" || name == "uint8") return PLYType::UInt8;
+    if (name == "short" || name == "int16") return PLYType::Int16;
+    if (name == "ushort" || name == "uint16") return PLYType::UInt16;
+    if (name == "int" || name == "int32") return PLYType::Int32;
+    if (name == "uint" || name == "uint32") return PLYType::UInt32;
+    if (name == "float" || name == "float32") return PLYType::Float32;
+    if (name == "double" || name == "float64") return PLYType::Float64;
+    return PLYType::Invalid;
+}
+
+uint32_t ply_type_size(PLYType type)
+{
+    switch (type)
+    {
+        case PLYType::Int8:
+        case PLYType::UInt8:
+            return 1;
+        case PLYType::Int16:
+        case PLYType::UInt16:
+            return 2;
+        case PLYType::Int32:
+        case PLYType::UInt32:
+        case PLYType::Float32:
+            return 4;
+        case PLYType::Float64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+bool read_ply_value(ParseCursor& cursor, PLYFormat format, PLYType type, double& value)
+{
+    if (format == PLYFormat::Ascii)
+    {
+        skip_white_spaces(cursor);
+        return parse_double(cursor, value);
+    }
+
+    // Copy the bytes in the native (little endian) order
+    uint32_t size = ply_type_size(type);
+    if ((uint64_t)(cursor.end - cursor.current) < size)
+        return false;
+    uint8_t bytes[8];
+    for (uint32_t byteIdx = 0; byteIdx < size; ++byteIdx)
+        bytes[byteIdx] = (uint8_t)cursor.current[format == PLYFormat::BinaryBigEndian ? size - 1 - byteIdx : byteIdx];
+    cursor.current += size;
+
+    switch (type)
+    {
+        case PLYType::Int8: { int8_t v; memcpy(&v, bytes, 1); value = v; } break;
+        case PLYType::UInt8: { uint8_t v; memcpy(&v, bytes, 1); value = v; } break;
+        case PLYType::Int16: { int16_t v; memcpy(&v, bytes, 2); value = v; } break;
+        case PLYType::UInt16: { uint16_t v; memcpy(&v, bytes, 2); value = v; } break;
+        case PLYType::Int32: { int32_t v; memcpy(&v, bytes, 4); value = v; } break;
+        case PLYType::UInt32: { uint32_t v; memcpy(&v, bytes, 4); value = v; } break;
+        case PLYType::Float32: { float v; memcpy(&v, bytes, 4); value = v; } break;
+        case PLYType::Float64: { double v; memcpy(&v, bytes, 8); value = v; } break;
+        default: return false;
+    }
+    return true;
+}
+
+bool ply_uint32(double value)
+{
+    return value >= 0.0 && value <= (double)UINT32_MAX && floor(value) == value;
+}
+
+bool import_ply(const MappedFile& file, std::vector<float3>& vertices, std::vector<uint32_t>& faceOffsets, std::vector<uint32_t>& faceVertices)
+{
+    ParseCursor cursor = { file.data, file.data + file.size };
+    if (read_token(cursor) != "ply")
+        return false;
+    next_line(cursor);
+
+    // Parse the header
+    PLYFormat format = PLYFormat::Ascii;
+    std::vector<PLYElement> elements;
+    while (true)
+    {
+        if (cursor.current >= cursor.end)
+            return false;
+        std::string keyword = read_token(cursor);
+        if (keyword == "end_header")
+        {
+            next_line(cursor);
+            break;
+        }
+        else if (keyword == "format")
+        {
+            std::string formatName = read_token(cursor);
+            if (formatName == "ascii")
+                format = PLYFormat::Ascii;
+            else if (formatName == "binary_little_endian")
+                format = PLYFormat::BinaryLittleEndian;
+            else if (formatName == "binary_big_endian")
+                format = PLYFormat::BinaryBigEndian;
+            else
+                return false;
+        }
+        else if (keyword == "element")
+        {
+            PLYElement element;
+            element.name = read_token(cursor);
+            skip_blanks(cursor);
+            int64_t count;
+            if (!parse_int(cursor, count) || count < 0 || count > UINT32_MAX)
+                return false;
+            element.count = (uint32_t)count;
+            elements.push_back(element);
+        }
+        else if (keyword == "property")
+        {
+            if (elements.empty())
+                return false;
+            PLYProperty property;
+            std::string typeName = read_token(cursor);
+            property.list = typeName == "list";
+            property.countType = property.list ? ply_type(read_token(cursor)) : PLYType::Invalid;
+            property.type = ply_type(property.list ? read_token(cursor) : typeName);
+            property.name = read_token(cursor);
+            if (property.type == PLYType::Invalid || (property.list && property.countType == PLYType::Invalid))
+                return false;
+            elements.back().properties.push_back(property);
+        }
+        next_line(cursor);
+    }
+
+    // Read the elements, only the positions and the face indices are kept
+    faceOffsets.push_back(0);
+    for (const PLYElement& element : elements)
+    {
+        bool vertexElement = element.name == "vertex";
+        bool faceElement = element.name == "face";
+        for (uint32_t itemIdx = 0; itemIdx < element.count; ++itemIdx)
+        {
+            double position[3] = { 0.0, 0.0, 0.0 };
+            uint32_t firstVertex = (uint32_t)faceVertices.size();
+            for (const PLYProperty& property : element.properties)
+            {
+                double value;
+                if (!property.list)
+                {
+                    if (!read_ply_value(cursor, format, property.type, value))
+                        return false;
+                    if (vertexElement && property.name.size() == 1 && property.name[0] >= 'x' && property.name[0] <= 'z')
+                        position[property.name[0] - 'x'] = value;
+                    continue;
+                }
+
+                // The counts and the indices must be integers that fit the face vertices
+                double count;
+                if (!read_ply_value(cursor, format, property.countType, count) || !ply_uint32(count))
+                    return false;
+                bool indices = faceElement && (property.name == "vertex_indices" || property.name == "vertex_index");
+                for (uint32_t valueIdx = 0; valueIdx < (uint32_t)count; ++valueIdx)
+                {
+                    if (!read_ply_value(cursor, format, property.type, value))
+                        return false;
+                    if (indices && !ply_uint32(value))
+                        return false;
+                    if (indices)
+                        faceVertices.push_back((uint32_t)value);
+                }
+            }
+
+            if (vertexElement)
+                vertices.push_back(float3({ (float)position[0], (float)position[1], (float)position[2] }));
+            if (faceElement)
+            {
+                // Degenerated faces are dropped
+                if (faceVertices.size() - firstVertex < 3)
+                    faceVertices.resize(firstVertex);
+                else
+                    faceOffsets.push_back((uint32_t)faceVertices.size());
+            }
+        }
+    }
+    return true;
+}
+
+bool has_extension(const std::string& path, const char* extension)
+{
+    size_t extensionLength = strlen(extension);
+    if (path.size() < extensionLength)
+        return false;
+    for (size_t charIdx = 0; charIdx < extensionLength; ++charIdx)
+    {
+        char c = path[path.size() - extensionLength + charIdx];
+        if ((c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c) != extension[charIdx])
+            return false;
+    }
+    return true;
+}
+
+bool is_polygon_mesh_file(const char* meshPath)
+{
+    return has_extension(meshPath, ".obj") || has_extension(meshPath, ".ply");
+}
+
+bool import_polygon_mesh(const char* meshPath, std::vector<float3>& vertices, std::vector<uint32_t>& halfedgeVertices, std::vector<uint3>& halfedgeNeighbors)
+{
+    MappedFile file;
+    if (!map_file(meshPath, file))
+        return false;
+
+    // Parse the positions and the faces
+    std::vector<uint32_t> faceOffsets, faceVertices;
+    bool parsed = has_extension(meshPath, ".obj") ? import_obj(file, vertices, faceOffsets, faceVertices) : import_ply(file, vertices, faceOffsets, faceVertices);
+    unmap_file(file);
+    if (!parsed || faceVertices.empty())
+        return false;
+
+    // Every face must reference existing vertices
+    for (uint32_t vertexID : faceVertices)
+    {
+        if (vertexID >= vertices.size())
+            return false;
+    }
+
+    // Convert the faces to halfedges
+    build_halfedges(faceOffsets, faceVertices, halfedgeVertices, halfedgeNeighbors);
+    return true;
+}
+
+void build_halfedges(const std::vector<uint32_t>& faceOffsets, const std::vector<uint32_t>& faceVertices, std::vector<uint32_t>& halfedgeVertices, std::vector<uint3>& halfedgeNeighbors)
+{
+    // Each halfedge starts at its face vertex
+    const uint32_t numFaces = (uint32_t)faceOffsets.size() - 1;
+    const uint32_t numHalfedges = (uint32_t)faceVertices.size();
+    halfedgeVertices = faceVertices;
+    halfedgeNeighbors.resize(numHalfedges);
+
+    // Link the halfedges of every face
+    parallel_for(numFaces, MESH_IMPORTER_PARALLEL_MIN_RANGE, [&](uint32_t firstFace, uint32_t lastFace)
+    {
+        for (uint32_t faceIdx = firstFace; faceIdx < lastFace; ++faceIdx)
+        {
+            uint32_t begin = faceOffsets[faceIdx], end = faceOffsets[faceIdx + 1];
+            for (uint32_t halfedgeIdx = begin; halfedgeIdx < end; ++halfedgeIdx)
+            {
+                uint32_t prevID = halfedgeIdx == begin ? end - 1 : halfedgeIdx - 1;
+                uint32_t nextID = halfedgeIdx + 1 == end ? begin : halfedgeIdx + 1;
+                halfedgeNeighbors[halfedgeIdx] = uint3({ prevID, nextID, INVALID_POINTER });
+            }
+        }
+    });
+
+    // Open addressing table of the undirected edges, at most half full
+    uint32_t tableBits = 1;
+    while ((1ull << tableBits) < 2ull * numHalfedges)
+        tableBits++;
+    const uint64_t tableSize = 1ull << tableBits;
+    assert_msg(tableSize <= UINT32_MAX, "Too many halfedges for the edge table.");
+    std::unique_ptr<std::atomic<uint64_t>[]> edgeKeys(new std::atomic<uint64_t>[tableSize]);
+    std::unique_ptr<std::atomic<uint32_t>[]> edgeCounts(new std::atomic<uint32_t>[tableSize]);
+    std::vector<uint32_t> edgeHalfedges(2 * tableSize);
+    parallel_for((uint32_t)tableSize, MESH_IMPORTER_PARALLEL_MIN_RANGE, [&](uint32_t firstSlot, uint32_t lastSlot)
+    {
+        for (uint32_t slotIdx = firstSlot; slotIdx < lastSlot; ++slotIdx)
+        {
+            edgeKeys[slotIdx].store(EDGE_TABLE_EMPTY_KEY, std::memory_order_relaxed);
+            edgeCounts[slotIdx].store(0, std::memory_order_relaxed);
+        }
+    });
+
+    // Slot of the edge of a halfedge (claimed if it doesn't exist yet)
+    auto edge_slot = [&](uint32_t halfedgeIdx) -> uint64_t
+    {
+        uint64_t v0 = halfedgeVertices[halfedgeIdx];
+        uint64_t v1 = halfedgeVertices[halfedgeNeighbors[halfedgeIdx].y];
+        uint64_t key = v0 < v1 ? (v0 << 32) | v1 : (v1 << 32) | v0;
+        uint64_t slotIdx = (key * 0x9E3779B97F4A7C15ull) >> (64 - tableBits);
+        while (true)
+        {
+            uint64_t slotKey = edgeKeys[slotIdx].load(std::memory_order_acquire);
+            if (slotKey == EDGE_TABLE_EMPTY_KEY && edgeKeys[slotIdx].compare_exchange_strong(slotKey, key, std::memory_order_acq_rel))
+                return slotIdx;
+            if (slotKey == key)
+                return slotIdx;
+            slotIdx = (slotIdx + 1) & (tableSize - 1);
+        }
+    };
+
+    // Register every halfedge in its edge (only the first two are kept)
+    parallel_for(numHalfedges, MESH_IMPORTER_PARALLEL_MIN_RANGE, [&](uint32_t firstHalfedge, uint32_t lastHalfedge)
+    {
+        for (uint32_t halfedgeIdx = firstHalfedge; halfedgeIdx < lastHalfedge; ++halfedgeIdx)
+        {
+            uint64_t slotIdx = edge_slot(halfedgeIdx);
+            uint32_t edgeHalfedgeIdx = edgeCounts[slotIdx].fetch_add(1, std::memory_order_relaxed);
+            if (edgeHalfedgeIdx < 2)
+                edgeHalfedges[2 * slotIdx + edgeHalfedgeIdx] = halfedgeIdx;
+        }
+    });
+
+    // Manifold edges of consistently oriented faces pair their two halfedges
+    parallel_for(numHalfedges, MESH_IMPORTER_PARALLEL_MIN_RANGE, [&](uint32_t firstHalfedge, uint32_t lastHalfedge)
+    {
+        for (uint32_t halfedgeIdx = firstHalfedge; halfedgeIdx < lastHalfedge; ++halfedgeIdx)
+        {
+            uint64_t slotIdx = edge_slot(halfedgeIdx);
+            if (edgeCounts[slotIdx].load(std::memory_order_relaxed) != 2)
+                continue;
+            uint32_t twinID = edgeHalfedges[2 * slotIdx] == halfedgeIdx ? edgeHalfedges[2 * slotIdx + 1] : edgeHalfedges[2 * slotIdx];
+            if (halfedgeVertices[twinID] == halfedgeVertices[halfedgeNeighbors[halfedgeIdx].y] && halfedgeVertices[halfedgeNeighbors[twinID].y] == halfedgeVertices[halfedgeIdx])
+                halfedgeNeighbors[halfedgeIdx].z = twinID;
+        }
+    });
+}
@@ -0,0 +1,299 @@
+// Project includes
+#include "math/operators.h"
+#include "mesh/mesh_snapshot.h"
+#include "tools/mapped_file.h"
+#include "tools/parallel_for.h"
+#include "tools/security.h"
+
+// System includes
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+
+// Snapshot file ("CBMS") and its version
+#define CBT_MESH_SNAPSHOT_MAGIC 0x534D4243
+#define CBT_MESH_SNAPSHOT_VERSION 2
+
+// Number of 64 bit allocation words processed together, the chunks are compacted and expanded in parallel
+#define SNAPSHOT_CHUNK_WORDS 1024
+
+// Sizes of the synthetic snapshots of the benchmark and fraction of their allocated elements
+#define SNAPSHOT_BENCHMARK_MIN_ELEMENTS (1u << 17)
+#define SNAPSHOT_BENCHMARK_MAX_ELEMENTS (1u << 22)
+#define SNAPSHOT_BENCHMARK_OCCUPANCY 0.75
+
+// Header of the snapshot file, followed by the CBT buffers, the allocation mask, the heapIDs and the neighbors
+struct CBTMeshSnapshotHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t totalNumElements;
+    uint32_t baseDepth;
+    uint32_t neighborsElementSize;
+    uint32_t cbtBufferCount;
+    uint32_t cbtBufferSizes[2];
+    uint32_t numAllocatedElements;
+    uint32_t padding;
+    uint64_t baseMeshHash;
+};
+
+uint32_t num_allocation_words(uint32_t totalNumElements)
+{
+    return (totalNumElements + 63) / 64;
+}
+
+// First allocated element of every chunk of the allocation mask
+uint32_t chunk_offsets(const std::vector<uint64_t>& allocationMask, std::vector<uint32_t>& offsets)
+{
+    uint32_t numWords = (uint32_t)allocationMask.size();
+    uint32_t numChunks = (numWords + SNAPSHOT_CHUNK_WORDS - 1) / SNAPSHOT_CHUNK_WORDS;
+    offsets.resize(numChunks);
+    parallel_for(numChunks, 1, [&](uint32_t firstChunk, uint32_t lastChunk)
+    {
+        for (uint32_t chunkIdx = firstChunk; chunkIdx < lastChunk; ++chunkIdx)
+        {
+            uint32_t count = 0;
+            uint32_t lastWord = std::min((chunkIdx + 1) * SNAPSHOT_CHUNK_WORDS, numWords);
+            for (uint32_t wordIdx = chunkIdx * SNAPSHOT_CHUNK_WORDS; wordIdx < lastWord; ++wordIdx)
+                count += countbits(allocationMask[wordIdx]);
+            offsets[chunkIdx] = count;
+        }
+    });
+
+    // Exclusive prefix sum of the counts
+    uint32_t numAllocated = 0;
+    for (uint32_t chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+    {
+        uint32_t count = offsets[chunkIdx];
+        offsets[chunkIdx] = numAllocated;
+        numAllocated += count;
+    }
+    return numAllocated;
+}
+
+void compact_cbt_mesh_snapshot(const uint64_t* heapIDArray, const char* neighborsArray, CBTMeshSnapshot& snapshot)
+{
+    const uint32_t totalNumElements = snapshot.totalNumElements;
+    const uint32_t elementSize = snapshot.neighborsElementSize;
+    const uint32_t numWords = num_allocation_words(totalNumElements);
+    const uint32_t numChunks = (numWords + SNAPSHOT_CHUNK_WORDS - 1) / SNAPSHOT_CHUNK_WORDS;
+
+    // Flag the allocated elements
+    snapshot.allocationMask.resize(numWords);
+    parallel_for(numWords, SNAPSHOT_CHUNK_WORDS, [&](uint32_t firstWord, uint32_t lastWord)
+    {
+        for (uint32_t wordIdx = firstWord; wordIdx < lastWord; ++wordIdx)
+        {
+            uint64_t word = 0;
+            uint32_t lastElement = std::min(64 * wordIdx + 64, totalNumElements);
+            for (uint32_t elementID = 64 * wordIdx; elementID < lastElement; ++elementID)
+                word |= (heapIDArray[elementID] != 0 ? 1ull : 0ull) << (elementID & 63);
+            snapshot.allocationMask[wordIdx] = word;
+        }
+    });
+
+    // Gather them, every chunk starts after the allocated elements of the previous ones
+    std::vector<uint32_t> offsets;
+    uint32_t numAllocated = chunk_offsets(snapshot.allocationMask, offsets);
+    snapshot.heapIDArray.resize(numAllocated);
+    snapshot.neighborsArray.resize((size_t)numAllocated * elementSize);
+    parallel_for(numChunks, 1, [&](uint32_t firstChunk, uint32_t lastChunk)
+    {
+        for (uint32_t chunkIdx = firstChunk; chunkIdx < lastChunk; ++chunkIdx)
+        {
+            uint32_t target = offsets[chunkIdx];
+            uint32_t lastWord = std::min((chunkIdx + 1) * SNAPSHOT_CHUNK_WORDS, numWords);
+            for (uint32_t wordIdx = chunkIdx * SNAPSHOT_CHUNK_WORDS; wordIdx < lastWord; ++wordIdx)
+            {
+                for (uint64_t word = snapshot.allocationMask[wordIdx]; word != 0; word &= word - 1)
+                {
+                    uint32_t elementID = 64 * wordIdx + countbits((word & (~word + 1)) - 1);
+                    snapshot.heapIDArray[target] = heapIDArray[elementID];
+                    memcpy(&snapshot.neighborsArray[(size_t)target * elementSize], neighborsArray + (size_t)elementID * elementSize, elementSize);
+                    target++;
+                }
+            }
+        }
+    });
+}
+
+void expand_cbt_mesh_snapshot(const CBTMeshSnapshot& snapshot, uint64_t* heapIDArray, char* neighborsArray)
+{
+    const uint32_t totalNumElements = snapshot.totalNumElements;
+    const uint32_t elementSize = snapshot.neighborsElementSize;
+    const uint32_t numWords = num_allocation_words(totalNumElements);
+    const uint32_t numChunks = (numWords + SNAPSHOT_CHUNK_WORDS - 1) / SNAPSHOT_CHUNK_WORDS;
+
+    // Every chunk reads after the allocated elements of the previous ones
+    std::vector<uint32_t> offsets;
+    chunk_offsets(snapshot.allocationMask, offsets);
+    parallel_for(numChunks, 1, [&](uint32_t firstChunk, uint32_t lastChunk)
+    {
+        for (uint32_t chunkIdx = firstChunk; chunkIdx < lastChunk; ++chunkIdx)
+        {
+            // Clear the elements of the chunk
+            uint32_t firstElement = chunkIdx * SNAPSHOT_CHUNK_WORDS * 64;
+            uint32_t lastElement = std::min(firstElement + SNAPSHOT_CHUNK_WORDS * 64, totalNumElements);
+            memset(heapIDArray + firstElement, 0, sizeof(uint64_t) * (lastElement - firstElement));
+            memset(neighborsArray + (size_t)firstElement * elementSize, 0, (size_t)(lastElement - firstElement) * elementSize);
+
+            // Scatter the allocated ones
+            uint32_t source = offsets[chunkIdx];
+            uint32_t lastWord = std::min((chunkIdx + 1) * SNAPSHOT_CHUNK_WORDS, numWords);
+            for (uint32_t wordIdx = chunkIdx * SNAPSHOT_CHUNK_WORDS; wordIdx < lastWord; ++wordIdx)
+            {
+                for (uint64_t word = snapshot.allocationMask[wordIdx]; word != 0; word &= word - 1)
+                {
+                    uint32_t elementID = 64 * wordIdx + countbits((word & (~word + 1)) - 1);
+                    heapIDArray[elementID] = snapshot.heapIDArray[source];
+                    memcpy(neighborsArray + (size_t)elementID * elementSize, &snapshot.neighborsArray[(size_t)source * elementSize], elementSize);
+                    source++;
+                }
+            }
+        }
+    });
+}
+
+bool save_cbt_mesh_snapshot(const CBTMeshSnapshot& snapshot, const char* snapshotPath)
+{
+    FILE* snapshotFile = fopen(snapshotPath, "wb");
+    if (snapshotFile == nullptr)
+        return false;
+
+    CBTMeshSnapshotHeader header = {};
+    header.magic = CBT_MESH_SNAPSHOT_MAGIC;
+    header.version = CBT_MESH_SNAPSHOT_VERSION;
+    header.totalNumElements = snapshot.totalNumElements;
+    header.baseDepth = snapshot.baseDepth;
+    header.neighborsElementSize = snapshot.neighborsElementSize;
+    header.cbtBufferCount = snapshot.cbtBufferCount;
+    for (uint32_t bufferIdx = 0; bufferIdx < snapshot.cbtBufferCount; ++bufferIdx)
+        header.cbtBufferSizes[bufferIdx] = (uint32_t)snapshot.cbtBuffers[bufferIdx].size();
+    header.numAllocatedElements = (uint32_t)snapshot.heapIDArray.size();
+    header.baseMeshHash = snapshot.baseMeshHash;
+
+    bool written = fwrite(&header, sizeof(CBTMeshSnapshotHeader), 1, snapshotFile) == 1;
+    for (uint32_t bufferIdx = 0; bufferIdx < snapshot.cbtBufferCount; ++bufferIdx)
+        written = written && fwrite(snapshot.cbtBuffers[bufferIdx].data(), 1, header.cbtBufferSizes[bufferIdx], snapshotFile) == header.cbtBufferSizes[bufferIdx];
+    written = written && fwrite(snapshot.allocationMask.data(), sizeof(uint64_t), snapshot.allocationMask.size(), snapshotFile) == snapshot.allocationMask.size();
+    written = written && fwrite(snapshot.heapIDArray.data(), sizeof(uint64_t), snapshot.heapIDArray.size(), snapshotFile) == snapshot.heapIDArray.size();
+    written = written && fwrite(snapshot.neighborsArray.data(), 1, snapshot.neighborsArray.size(), snapshotFile) == snapshot.neighborsArray.size();
+    fclose(snapshotFile);
+
+    // Don't leave a truncated snapshot behind
+    if (!written)
+        remove(snapshotPath);
+    return written;
+}
+
+bool load_cbt_mesh_snapshot(const char* snapshotPath, CBTMeshSnapshot& snapshot)
+{
+    MappedFile snapshotFile;
+    if (!map_file(snapshotPath, snapshotFile))
+        return false;
+
+    // Validate the header and the size of the file
+    CBTMeshSnapshotHeader header;
+    bool valid = snapshotFile.size >= sizeof(CBTMeshSnapshotHeader);
+    if (valid)
+    {
+        memcpy(&header, snapshotFile.data, sizeof(CBTMeshSnapshotHeader));
+        valid = header.magic == CBT_MESH_SNAPSHOT_MAGIC && header.version == CBT_MESH_SNAPSHOT_VERSION && header.cbtBufferCount <= 2
+            && header.numAllocatedElements <= header.totalNumElements;
+    }
+    uint64_t expectedSize = sizeof(CBTMeshSnapshotHeader);
+    if (valid)
+    {
+        for (uint32_t bufferIdx = 0; bufferIdx < header.cbtBufferCount; ++bufferIdx)
+            expectedSize += header.cbtBufferSizes[bufferIdx];
+        expectedSize += sizeof(uint64_t) * num_allocation_words(header.totalNumElements);
+        expectedSize += (uint64_t)header.numAllocatedElements * (sizeof(uint64_t) + header.neighborsElementSize);
+        valid = snapshotFile.size == expectedSize;
+    }
+
+    // Copy the sections
+    if (valid)
+    {
+        const char* data = snapshotFile.data + sizeof(CBTMeshSnapshotHeader);
+        snapshot.totalNumElements = header.totalNumElements;
+        snapshot.baseDepth = header.baseDepth;
+        snapshot.neighborsElementSize = header.neighborsElementSize;
+        snapshot.baseMeshHash = header.baseMeshHash;
+        snapshot.cbtBufferCount = header.cbtBufferCount;
+        for (uint32_t bufferIdx = 0; bufferIdx < header.cbtBufferCount; ++bufferIdx)
+        {
+            snapshot.cbtBuffers[bufferIdx].assign(data, data + header.cbtBufferSizes[bufferIdx]);
+            data += header.cbtBufferSizes[bufferIdx];
+        }
+        snapshot.allocationMask.resize(num_allocation_words(header.totalNumElements));
+        memcpy(snapshot.allocationMask.data(), data, sizeof(uint64_t) * snapshot.allocationMask.size());
+        data += sizeof(uint64_t) * snapshot.allocationMask.size();
+        snapshot.heapIDArray.resize(header.numAllocatedElements);
+        memcpy(snapshot.heapIDArray.data(), data, sizeof(uint64_t) * header.numAllocatedElements);
+        data += sizeof(uint64_t) * header.numAllocatedElements;
+        snapshot.neighborsArray.assign(data, data + (size_t)header.numAllocatedElements * header.neighborsElementSize);
+
+        // The mask must flag as many elements as there are stored
+        std::vector<uint32_t> offsets;
+        valid = chunk_offsets(snapshot.allocationMask, offsets) == header.numAllocatedElements;
+    }
+    unmap_file(snapshotFile);
+    return valid;
+}
+
+void benchmark_cbt_mesh_snapshots(const char* scratchPath, std::vector<SnapshotBenchmark>& results)
+{
+    results.clear();
+    std::mt19937_64 generator(0);
+    for (uint32_t numElements = SNAPSHOT_BENCHMARK_MIN_ELEMENTS; numElements <= SNAPSHOT_BENCHMARK_MAX_ELEMENTS; numElements *= 2)
+    {
+        // Synthetic refined state
+        std::vector<uint64_t> heapIDArray(numElements);
+        std::vector<char> neighborsArray((size_t)numElements * sizeof(uint3));
+        std::bernoulli_distribution allocated(SNAPSHOT_BENCHMARK_OCCUPANCY);
+        for (uint32_t elementID = 0; elementID < numElements; ++elementID)
+            heapIDArray[elementID] = allocated(generator) ? generator() | 1 : 0;
+        for (char& byte : neighborsArray)
+            byte = (char)generator();
+
+        CBTMeshSnapshot snapshot;
+        snapshot.totalNumElements = numElements;
+        snapshot.neighborsElementSize = sizeof(uint3);
+        snapshot.cbtBufferCount = 1;
+        snapshot.cbtBuffers[0].resize(numElements / 8);
+
+        SnapshotBenchmark result;
+        result.numElements = numElements;
+        auto start = std::chrono::high_resolution_clock::now();
+        compact_cbt_mesh_snapshot(heapIDArray.data(), neighborsArray.data(), snapshot);
+        auto compacted = std::chrono::high_resolution_clock::now();
+        save_cbt_mesh_snapshot(snapshot, scratchPath);
+        auto saved = std::chrono::high_resolution_clock::now();
+        CBTMeshSnapshot loadedSnapshot;
+        bool loaded = load_cbt_mesh_snapshot(scratchPath, loadedSnapshot);
+        auto loadedTime = std::chrono::high_resolution_clock::now();
+        std::vector<uint64_t> expandedHeapIDArray(numElements);
+        std::vector<char> expandedNeighborsArray(neighborsArray.size());
+        auto expandStart = std::chrono::high_resolution_clock::now();
+        if (loaded)
+            expand_cbt_mesh_snapshot(loadedSnapshot, expandedHeapIDArray.data(), expandedNeighborsArray.data());
+        auto expanded = std::chrono::high_resolution_clock::now();
+
+        // The allocated elements must survive the round trip
+        bool matches = loaded && expandedHeapIDArray == heapIDArray;
+        for (uint32_t elementID = 0; matches && elementID < numElements; ++elementID)
+            matches = heapIDArray[elementID] == 0 || memcmp(&expandedNeighborsArray[(size_t)elementID * sizeof(uint3)], &neighborsArray[(size_t)elementID * sizeof(uint3)], sizeof(uint3)) == 0;
+        assert_msg(matches, "Snapshot round trip doesn't match the original state.");
+
+        result.fileSize = (uint32_t)(sizeof(CBTMeshSnapshotHeader) + snapshot.cbtBuffers[0].size() + sizeof(uint64_t) * snapshot.allocationMask.size()
+            + snapshot.heapIDArray.size() * sizeof(uint64_t) + snapshot.neighborsArray.size());
+        result.compactDuration = std::chrono::duration<double, std::milli>(compacted - start).count();
+        result.saveDuration = std::chrono::duration<double, std::milli>(saved - compacted).count();
+        result.loadDuration = std::chrono::duration<double, std::milli>(loadedTime - saved).count();
+        result.expandDuration = std::chrono::duration<double, std::milli>(expanded - expandStart).count();
+        results.push_back(result);
+    }
+    remove(scratchPath);
+}
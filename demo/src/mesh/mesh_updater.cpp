@@ -3,15 +3,22 @@
 // Project includes
 #include "graphics/dx12_backend.h"
 #include "mesh/mesh_updater.h"
+#include "tools/security.h"
 #include "tools/shader_utils.h"
 
 // Main Update
 const char* reset_kernel = "Reset";
+const char* clear_unallocated_elements_kernel = "ClearUnallocatedElements";
+const char* patch_culling_kernel = "PatchCulling";
+const char* patch_culling_indexation_kernel = "PatchCullingIndexation";
 const char* classify_kernel = "Classify";
 const char* split_kernel = "Split";
+const char* split_predicted_kernel = "SplitPredicted";
 const char* prepare_indirect_kernel = "PrepareIndirect";
+const char* prepare_classification_indirect_kernel = "PrepareClassificationIndirect";
 const char* allocate_kernel = "Allocate";
 const char* bisect_kernel = "Bisect";
+const char* scatter_neighbors_kernel = "ScatterNeighbors";
 const char* propagate_bisect_kernel = "PropagateBisect";
 const char* prepare_simplify_kernel = "PrepareSimplify";
 const char* simplify_kernel = "Simplify";
@@ -26,12 +33,34 @@ const char* reduce_second_pass_kernel = "ReduceSecondPass";
 const char* bisector_indexation_kernel = "BisectorIndexation";
 const char* prepare_bisector_indirect_kernel = "PrepareBisectorIndirect";
 
+// Welded vertices
+const char* weld_vertices_kernel = "WeldVertices";
+const char* resolve_welded_vertices_kernel = "ResolveWeldedVertices";
+const char* prepare_welded_indirect_kernel = "PrepareWeldedIndirect";
+
 // Debug
 const char* validate_kernel = "Validate";
 
+// Derived adjacency
+const char* clear_heap_id_hash_kernel = "ClearHeapIDHash";
+const char* build_heap_id_hash_kernel = "BuildHeapIDHash";
+const char* derive_adjacency_kernel = "DeriveAdjacency";
+
+// Compaction
+const char* compaction_clear_kernel = "CompactionClear";
+const char* compaction_count_kernel = "CompactionCount";
+const char* prepare_compaction_kernel = "PrepareCompaction";
+const char* compaction_scan_kernel = "CompactionScan";
+const char* compaction_remap_kernel = "CompactionRemap";
+const char* compaction_scatter_kernel = "CompactionScatter";
+const char* compaction_resolve_kernel = "CompactionResolve";
+
 // Workgroup size
 #define WORKGROUP_SIZE 64
 
+// Compaction buckets (+1 for the slot span)
+#define COMPACTION_NUM_BUCKETS 65536
+
 // CBVs
 #define GLOBAL_CB_BINDING_SLOT CBV_SLOT(0)
 #define GEOMETRY_CB_BINDING_SLOT CBV_SLOT(1)
@@ -49,7 +78,7 @@ const char* validate_kernel = "Validate";
 // Bisector buffers
 #define HEAP_ID_BUFFER_BINDING_SLOT UAV_SLOT(2)
 #define NEIGHBORS_BUFFER_BINDING_SLOT UAV_SLOT(3)
-#define NEIGHBORS_OUTPUT_BUFFER_BINDING_SLOT UAV_SLOT(4)
+#define NEIGHBORS_UPDATE_BUFFER_BINDING_SLOT UAV_SLOT(4)
 
 // Intermediate buffers
 #define BISECTOR_DATA_BUFFER_BINDING_SLOT UAV_SLOT(5)
@@ -69,9 +98,39 @@ const char* validate_kernel = "Validate";
 // Debug
 #define VALIDATION_BUFFER_BINDING_SLOT UAV_SLOT(16)
 
+// Compaction buffers
+#define COMPACTION_BUFFER_BINDING_SLOT UAV_SLOT(17)
+#define COMPACTION_REMAP_BUFFER_BINDING_SLOT UAV_SLOT(18)
+#define COMPACTION_HEAP_ID_BUFFER_BINDING_SLOT UAV_SLOT(19)
+
+// Classification cache
+#define CLASSIFICATION_CACHE_BUFFER_BINDING_SLOT UAV_SLOT(20)
+
+// Base patch culling
+#define PATCH_BOUNDS_BUFFER_BINDING_SLOT UAV_SLOT(21)
+#define PATCH_VISIBILITY_BUFFER_BINDING_SLOT UAV_SLOT(22)
+#define PATCH_CULLING_BUFFER_BINDING_SLOT UAV_SLOT(23)
+
+// Split/merge hysteresis
+#define BISECTOR_AGE_BUFFER_BINDING_SLOT UAV_SLOT(24)
+
+// Derived adjacency
+#define BASE_NEIGHBORS_BUFFER_BINDING_SLOT UAV_SLOT(25)
+#define HEAP_ID_HASH_BUFFER_BINDING_SLOT UAV_SLOT(26)
+
+// Cached LEB positions
+#define LEB_POSITION_BUFFER_BINDING_SLOT UAV_SLOT(27)
+#define LEB_POSITION_HEAP_ID_BUFFER_BINDING_SLOT UAV_SLOT(28)
+
+// Welded vertices
+#define VERTEX_INDEX_BUFFER_BINDING_SLOT UAV_SLOT(29)
+#define WELDED_VERTEX_BUFFER_BINDING_SLOT UAV_SLOT(30)
+#define WELDED_INDEX_BUFFER_BINDING_SLOT UAV_SLOT(31)
+#define WELDED_ARGS_BUFFER_BINDING_SLOT UAV_SLOT(32)
+
 #define NUM_SRV_BINDING_SLOTS 2
 #define NUM_CBV_BINDING_SLOTS 3
-#define NUM_UAV_BINDING_SLOTS 17
+#define NUM_UAV_BINDING_SLOTS 33
 
 MeshUpdater::MeshUpdater()
 {
@@ -88,29 +147,63 @@ void MeshUpdater::initialize(GraphicsDevice graphicsDevice, CommandQueue cmdQ)
     m_Device = graphicsDevice;
 
     // Shared buffers
-    indirectBuffer = d3d12::graphics_resources::create_graphics_buffer(m_Device, sizeof(uint32_t) * 9, sizeof(uint32_t), GraphicsBufferType::Default);
-    memoryBuffer = d3d12::graphics_resources::create_graphics_buffer(m_Device, sizeof(int32_t) * 2, sizeof(int32_t), GraphicsBufferType::Default);
+    reserve_batch_buffers(1);
     validationBuffer = d3d12::graphics_resources::create_graphics_buffer(m_Device, sizeof(int32_t) * 2, sizeof(int32_t), GraphicsBufferType::Default);
-    validationBufferRB = d3d12::graphics_resources::create_graphics_buffer(m_Device, sizeof(int32_t) * 2, sizeof(int32_t), GraphicsBufferType::Readback);
-    occupancyBufferRB = d3d12::graphics_resources::create_graphics_buffer(m_Device, sizeof(uint32_t), sizeof(uint32_t), GraphicsBufferType::Readback);
+    compactionBuffer = d3d12::graphics_resources::create_graphics_buffer(m_Device, sizeof(uint32_t) * (1 + COMPACTION_NUM_BUCKETS), sizeof(uint32_t), GraphicsBufferType::Default);
+
+    // Readbacks (read a few frames late)
+    m_ValidationReadback.initialize(m_Device, sizeof(int32_t) * 2);
+    m_OccupancyReadback.initialize(m_Device, sizeof(uint32_t));
+    m_ConvergenceReadback.initialize(m_Device, sizeof(uint32_t) * 4);
+    m_ChurnReadback.initialize(m_Device, sizeof(uint32_t) * 2);
+    m_LastValidation = true;
 }
 
 void MeshUpdater::release()
 {
+    // Destroy the readbacks
+    m_ChurnReadback.release();
+    m_ConvergenceReadback.release();
+    m_OccupancyReadback.release();
+    m_ValidationReadback.release();
+
     // Destroy the buffers
-    d3d12::graphics_resources::destroy_graphics_buffer(occupancyBufferRB);
-    d3d12::graphics_resources::destroy_graphics_buffer(validationBufferRB);
+    d3d12::graphics_resources::destroy_graphics_buffer(compactionBuffer);
     d3d12::graphics_resources::destroy_graphics_buffer(validationBuffer);
-    d3d12::graphics_resources::destroy_graphics_buffer(memoryBuffer);
-    d3d12::graphics_resources::destroy_graphics_buffer(indirectBuffer);
+    for (uint32_t targetIdx = 0; targetIdx < (uint32_t)indirectBuffers.size(); ++targetIdx)
+    {
+        d3d12::graphics_resources::destroy_graphics_buffer(memoryBuffers[targetIdx]);
+        d3d12::graphics_resources::destroy_graphics_buffer(indirectBuffers[targetIdx]);
+    }
+    memoryBuffers.clear();
+    indirectBuffers.clear();
+
+    // Compaction
+    d3d12::compute_shader::destroy_compute_shader(m_CompactionResolveCS);
+    d3d12::compute_shader::destroy_compute_shader(m_CompactionScatterCS);
+    d3d12::compute_shader::destroy_compute_shader(m_CompactionRemapCS);
+    d3d12::compute_shader::destroy_compute_shader(m_CompactionScanCS);
+    d3d12::compute_shader::destroy_compute_shader(m_PrepareCompactionCS);
+    d3d12::compute_shader::destroy_compute_shader(m_CompactionCountCS);
+    d3d12::compute_shader::destroy_compute_shader(m_CompactionClearCS);
 
     // Debug
     d3d12::compute_shader::destroy_compute_shader(m_ValidateCS);
+    d3d12::compute_shader::destroy_compute_shader(m_ClearHeapIDHashCS);
+    d3d12::compute_shader::destroy_compute_shader(m_BuildHeapIDHashCS);
+    d3d12::compute_shader::destroy_compute_shader(m_DeriveAdjacencyCS);
 
     // Indexation
     d3d12::compute_shader::destroy_compute_shader(m_BisectorIndexationCS);
     d3d12::compute_shader::destroy_compute_shader(m_PrepareBisectorIndirectCS);
 
+    // Welded vertices
+#if defined(WELDED_VERTICES)
+    d3d12::compute_shader::destroy_compute_shader(m_PrepareWeldedIndirectCS);
+    d3d12::compute_shader::destroy_compute_shader(m_ResolveWeldedVerticesCS);
+    d3d12::compute_shader::destroy_compute_shader(m_WeldVerticesCS);
+#endif
+
     // Reduce
     d3d12::compute_shader::destroy_compute_shader(m_ReducePrePassCS);
     d3d12::compute_shader::destroy_compute_shader(m_ReduceFirstPassCS);
@@ -122,15 +215,24 @@ void MeshUpdater::release()
     d3d12::compute_shader::destroy_compute_shader(m_PrepareSimplifyCS);
     d3d12::compute_shader::destroy_compute_shader(m_PropagateBisectCS);
     d3d12::compute_shader::destroy_compute_shader(m_BisectCS);
+    d3d12::compute_shader::destroy_compute_shader(m_ScatterNeighborsCS);
     d3d12::compute_shader::destroy_compute_shader(m_AllocateCS);
+    d3d12::compute_shader::destroy_compute_shader(m_PrepareClassificationIndirectCS);
     d3d12::compute_shader::destroy_compute_shader(m_PrepareIndirectCS);
+    d3d12::compute_shader::destroy_compute_shader(m_SplitPredictedCS);
     d3d12::compute_shader::destroy_compute_shader(m_SplitCS);
     d3d12::compute_shader::destroy_compute_shader(m_ClassifyCS);
+    d3d12::compute_shader::destroy_compute_shader(m_PatchCullingIndexationCS);
+    d3d12::compute_shader::destroy_compute_shader(m_PatchCullingCS);
+    d3d12::compute_shader::destroy_compute_shader(m_ClearUnallocatedElementsCS);
     d3d12::compute_shader::destroy_compute_shader(m_ResetCS);
 }
 
-void MeshUpdater::reload_shaders(const std::string& shaderLibrary, CBTType cbtType, const char* updateShader)
+void MeshUpdater::reload_shaders(const std::string& shaderLibrary, CBTType cbtType, bool packedNeighbors, const char* updateShader)
 {
+    // Keep track of the neighbor layout
+    m_PackedNeighbors = packedNeighbors;
+
     // Create the compute shaders
     ComputeShaderDescriptor csd;
     csd.includeDirectories.push_back(shaderLibrary);
@@ -139,11 +241,29 @@ void MeshUpdater::reload_shaders(const std::string& shaderLibrary, CBTType cbtTy
     csd.srvCount = NUM_SRV_BINDING_SLOTS;
     csd.uavCount = NUM_UAV_BINDING_SLOTS;
     csd.defines.push_back(cbt_type_to_string(cbtType));
-
-    // Reset kernel
+#if defined(BISECTOR_DATA_SOA)
+    csd.defines.push_back("BISECTOR_DATA_SOA");
+#endif
+    if (packedNeighbors)
+        csd.defines.push_back("PACKED_NEIGHBORS");
+#if defined(WELDED_VERTICES)
+    csd.defines.push_back("WELDED_VERTICES");
+#endif
+
+    // Reset kernels
     csd.kernelname = reset_kernel;
     compile_and_replace_compute_shader(m_Device, csd, m_ResetCS);
 
+    csd.kernelname = clear_unallocated_elements_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_ClearUnallocatedElementsCS);
+
+    // Patch culling kernels
+    csd.kernelname = patch_culling_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_PatchCullingCS);
+
+    csd.kernelname = patch_culling_indexation_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_PatchCullingIndexationCS);
+
     // Classify kernel
     csd.kernelname = classify_kernel;
     compile_and_replace_compute_shader(m_Device, csd, m_ClassifyCS);
@@ -152,10 +272,16 @@ void MeshUpdater::reload_shaders(const std::string& shaderLibrary, CBTType cbtTy
     csd.kernelname = split_kernel;
     compile_and_replace_compute_shader(m_Device, csd, m_SplitCS);
 
+    csd.kernelname = split_predicted_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_SplitPredictedCS);
+
     // Indirect kernel
     csd.kernelname = prepare_indirect_kernel;
     compile_and_replace_compute_shader(m_Device, csd, m_PrepareIndirectCS);
 
+    csd.kernelname = prepare_classification_indirect_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_PrepareClassificationIndirectCS);
+
     // Allocate kernel
     csd.kernelname = allocate_kernel;
     compile_and_replace_compute_shader(m_Device, csd, m_AllocateCS);
@@ -164,6 +290,9 @@ void MeshUpdater::reload_shaders(const std::string& shaderLibrary, CBTType cbtTy
     csd.kernelname = bisect_kernel;
     compile_and_replace_compute_shader(m_Device, csd, m_BisectCS);
 
+    csd.kernelname = scatter_neighbors_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_ScatterNeighborsCS);
+
     // Propagate split kernel
     csd.kernelname = propagate_bisect_kernel;
     compile_and_replace_compute_shader(m_Device, csd, m_PropagateBisectCS);
@@ -199,108 +328,293 @@ void MeshUpdater::reload_shaders(const std::string& shaderLibrary, CBTType cbtTy
     csd.kernelname = prepare_bisector_indirect_kernel;
     compile_and_replace_compute_shader(m_Device, csd, m_PrepareBisectorIndirectCS);
 
+#if defined(WELDED_VERTICES)
+    // Welded vertices kernels
+    csd.kernelname = weld_vertices_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_WeldVerticesCS);
+
+    csd.kernelname = resolve_welded_vertices_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_ResolveWeldedVerticesCS);
+
+    csd.kernelname = prepare_welded_indirect_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_PrepareWeldedIndirectCS);
+#endif
+
     // Validate kernel
     csd.kernelname = validate_kernel;
     compile_and_replace_compute_shader(m_Device, csd, m_ValidateCS);
+
+    // Derived adjacency kernels
+    csd.kernelname = clear_heap_id_hash_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_ClearHeapIDHashCS);
+
+    csd.kernelname = build_heap_id_hash_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_BuildHeapIDHashCS);
+
+    csd.kernelname = derive_adjacency_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_DeriveAdjacencyCS);
+
+    // Compaction kernels
+    csd.kernelname = compaction_clear_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_CompactionClearCS);
+
+    csd.kernelname = compaction_count_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_CompactionCountCS);
+
+    csd.kernelname = prepare_compaction_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_PrepareCompactionCS);
+
+    csd.kernelname = compaction_scan_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_CompactionScanCS);
+
+    csd.kernelname = compaction_remap_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_CompactionRemapCS);
+
+    csd.kernelname = compaction_scatter_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_CompactionScatterCS);
+
+    csd.kernelname = compaction_resolve_kernel;
+    compile_and_replace_compute_shader(m_Device, csd, m_CompactionResolveCS);
 }
 
-void MeshUpdater::update(CommandBuffer cmd, CBTMesh& mesh, ConstantBuffer globalCB, ConstantBuffer geometryCB, ConstantBuffer updateCB)
+void MeshUpdater::update(CommandBuffer cmd, CBTMesh& mesh, ConstantBuffer globalCB, ConstantBuffer geometryCB, ConstantBuffer updateCB, bool compact)
 {
-    // Num groups that need to be dispatched
-    uint32_t numGroups = (mesh.totalNumElements + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
-
-    // Grab the two bisectors
-    uint32_t nextNeighborsBufferIdx = (mesh.currentNeighborsBufferIdx + 1) % 2;
-    GraphicsBuffer currentNeighborsBuffer = mesh.neighborsBuffers[mesh.currentNeighborsBufferIdx];
-    GraphicsBuffer nextNeighborsBuffer = mesh.neighborsBuffers[nextNeighborsBufferIdx];
+    // A single mesh is a batch of one
+    MeshUpdateTarget target;
+    target.mesh = &mesh;
+    target.geometryCB = geometryCB;
+    target.updateCB = updateCB;
+    target.compact = compact;
+    update(cmd, std::vector<MeshUpdateTarget>(1, target), globalCB);
+}
 
+void MeshUpdater::update(CommandBuffer cmd, const std::vector<MeshUpdateTarget>& targets, ConstantBuffer globalCB)
+{
+    // Every mesh needs its own dispatch arguments and memory counters
+    uint32_t numTargets = (uint32_t)targets.size();
+    reserve_batch_buffers(numTargets);
+    for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
+        assert_msg(targets[targetIdx].mesh->packedNeighbors == m_PackedNeighbors, "The shaders were compiled for an other neighbor layout.");
+
+    // Each pass is recorded for all the meshes before a single barrier, the meshes don't share any resource
+    // so their dispatches can overlap and the number of synchronization points doesn't depend on the batch size
     d3d12::command_buffer::start_section(cmd, "Update Mesh");
     {
         // Reset pass
-        reset_buffers(cmd, mesh);
+        d3d12::command_buffer::start_section(cmd, "Reset Buffers");
+        {
+            for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
+                reset_buffers(cmd, *targets[targetIdx].mesh, targets[targetIdx].geometryCB, memoryBuffers[targetIdx]);
+            d3d12::command_buffer::uav_barrier(cmd);
+        }
+        d3d12::command_buffer::end_section(cmd);
+
+        // Patch Culling Pass
+        d3d12::command_buffer::start_section(cmd, "Patch Culling");
+        {
+            // Evaluate the visibility of the base patches
+            for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
+            {
+                const MeshUpdateTarget& target = targets[targetIdx];
+                const CBTMesh& mesh = *target.mesh;
+
+                // CBVs
+                d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PatchCullingCS, GLOBAL_CB_BINDING_SLOT, globalCB);
+                d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PatchCullingCS, GEOMETRY_CB_BINDING_SLOT, target.geometryCB);
+                d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PatchCullingCS, UPDATE_CB_BINDING_SLOT, target.updateCB);
+
+                // UAVs
+                d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PatchCullingCS, PATCH_BOUNDS_BUFFER_BINDING_SLOT, mesh.patchBoundsBuffer);
+                d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PatchCullingCS, PATCH_VISIBILITY_BUFFER_BINDING_SLOT, mesh.patchVisibilityBuffer);
+                d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PatchCullingCS, PATCH_CULLING_BUFFER_BINDING_SLOT, mesh.patchCullingBuffer);
+
+                // Dispatch
+                uint32_t numPatchGroups = (mesh.numBaseVertices / 3 + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+                d3d12::command_buffer::dispatch(cmd, m_PatchCullingCS, numPatchGroups, 1, 1);
+            }
+            d3d12::command_buffer::uav_barrier(cmd);
+
+            // Cull the bisectors of the hidden patches and gather the others
+            for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
+            {
+                const MeshUpdateTarget& target = targets[targetIdx];
+                const CBTMesh& mesh = *target.mesh;
+
+                // CBVs
+                d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PatchCullingIndexationCS, GLOBAL_CB_BINDING_SLOT, globalCB);
+                d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PatchCullingIndexationCS, GEOMETRY_CB_BINDING_SLOT, target.geometryCB);
+                d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PatchCullingIndexationCS, UPDATE_CB_BINDING_SLOT, target.updateCB);
+
+                // SRVs
+                d3d12::command_buffer::set_compute_shader_buffer_srv(cmd, m_PatchCullingIndexationCS, INDEXED_BISECTOR_BUFFER_BINDING_SLOT, mesh.indexedBisectorBuffer);
+
+                // UAVs
+                d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PatchCullingIndexationCS, INDIRECT_DRAW_BUFFER_BINDING_SLOT, mesh.indirectDrawBuffer);
+                d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PatchCullingIndexationCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
+                d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PatchCullingIndexationCS, BISECTOR_DATA_BUFFER_BINDING_SLOT, mesh.updateBuffer);
+                d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PatchCullingIndexationCS, CLASSIFICATION_BUFFER_BINDING_SLOT, mesh.classificationBuffer);
+                d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PatchCullingIndexationCS, CLASSIFICATION_CACHE_BUFFER_BINDING_SLOT, mesh.classificationCacheBuffer);
+                d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PatchCullingIndexationCS, BISECTOR_AGE_BUFFER_BINDING_SLOT, mesh.bisectorAgeBuffer);
+                d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PatchCullingIndexationCS, PATCH_VISIBILITY_BUFFER_BINDING_SLOT, mesh.patchVisibilityBuffer);
+                d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PatchCullingIndexationCS, PATCH_CULLING_BUFFER_BINDING_SLOT, mesh.patchCullingBuffer);
+
+                // Dispatch
+                d3d12::command_buffer::dispatch_indirect(cmd, m_PatchCullingIndexationCS, mesh.indirectDispatchBuffer);
+            }
+            d3d12::command_buffer::uav_barrier(cmd);
+
+            // Prepare the classification of the surviving bisectors
+            for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
+            {
+                const CBTMesh& mesh = *targets[targetIdx].mesh;
+                GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+
+                d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareIndirectCS, ALLOCATE_BUFFER_BINDING_SLOT, mesh.patchCullingBuffer);
+                d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareIndirectCS, INDIRECT_DISPATCH_BUFFER_BINDING_SLOT, indirectBuffer);
+                d3d12::command_buffer::dispatch(cmd, m_PrepareIndirectCS, 1, 1, 1);
+            }
+            d3d12::command_buffer::uav_barrier(cmd);
+        }
+        d3d12::command_buffer::end_section(cmd);
 
         // Classify Pass
         d3d12::command_buffer::start_section(cmd, "Classify");
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
         {
+            const MeshUpdateTarget& target = targets[targetIdx];
+            const CBTMesh& mesh = *target.mesh;
+            GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+
             // CBVs
             d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_ClassifyCS, GLOBAL_CB_BINDING_SLOT, globalCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_ClassifyCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_ClassifyCS, UPDATE_CB_BINDING_SLOT, updateCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_ClassifyCS, GEOMETRY_CB_BINDING_SLOT, target.geometryCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_ClassifyCS, UPDATE_CB_BINDING_SLOT, target.updateCB);
 
             // SRVs
             d3d12::command_buffer::set_compute_shader_buffer_srv(cmd, m_ClassifyCS, CURRENT_VERTEX_BUFFER_SLOT, mesh.currentVertexBuffer);
-            d3d12::command_buffer::set_compute_shader_buffer_srv(cmd, m_ClassifyCS, INDEXED_BISECTOR_BUFFER_BINDING_SLOT, mesh.indexedBisectorBuffer);
 
             // UAVs
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ClassifyCS, INDIRECT_DRAW_BUFFER_BINDING_SLOT, mesh.indirectDrawBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ClassifyCS, PATCH_CULLING_BUFFER_BINDING_SLOT, mesh.patchCullingBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ClassifyCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ClassifyCS, BISECTOR_DATA_BUFFER_BINDING_SLOT, mesh.updateBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ClassifyCS, CLASSIFICATION_BUFFER_BINDING_SLOT, mesh.classificationBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ClassifyCS, CLASSIFICATION_CACHE_BUFFER_BINDING_SLOT, mesh.classificationCacheBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ClassifyCS, BISECTOR_AGE_BUFFER_BINDING_SLOT, mesh.bisectorAgeBuffer);
+#if defined(WELDED_VERTICES)
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ClassifyCS, VERTEX_INDEX_BUFFER_BINDING_SLOT, mesh.vertexIndexBuffer);
+#endif
 
             // Dispatch
-            d3d12::command_buffer::dispatch_indirect(cmd, m_ClassifyCS, mesh.indirectDispatchBuffer);
-
-            // Barrier
-            d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.updateBuffer);
+            d3d12::command_buffer::dispatch_indirect(cmd, m_ClassifyCS, indirectBuffer);
         }
+        d3d12::command_buffer::uav_barrier(cmd);
         d3d12::command_buffer::end_section(cmd);
 
         // Prepare Indirect Pass
         d3d12::command_buffer::start_section(cmd, "Prepare indirect split");
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
         {
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareIndirectCS, ALLOCATE_BUFFER_BINDING_SLOT, mesh.classificationBuffer);
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareIndirectCS, INDIRECT_DISPATCH_BUFFER_BINDING_SLOT, indirectBuffer);
-            d3d12::command_buffer::dispatch(cmd, m_PrepareIndirectCS, 2, 1, 1);
-            d3d12::command_buffer::uav_barrier_buffer(cmd, indirectBuffer);
+            const MeshUpdateTarget& target = targets[targetIdx];
+            const CBTMesh& mesh = *target.mesh;
+            GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+
+            // The split, simplification and predicted split budgets are applied to the dispatch sizes
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PrepareClassificationIndirectCS, UPDATE_CB_BINDING_SLOT, target.updateCB);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareClassificationIndirectCS, CLASSIFICATION_BUFFER_BINDING_SLOT, mesh.classificationBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareClassificationIndirectCS, INDIRECT_DISPATCH_BUFFER_BINDING_SLOT, indirectBuffer);
+            d3d12::command_buffer::dispatch(cmd, m_PrepareClassificationIndirectCS, 3, 1, 1);
         }
+        d3d12::command_buffer::uav_barrier(cmd);
         d3d12::command_buffer::end_section(cmd);
 
         // Split Pass
         d3d12::command_buffer::start_section(cmd, "Split");
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
         {
+            const MeshUpdateTarget& target = targets[targetIdx];
+            const CBTMesh& mesh = *target.mesh;
+            GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+            GraphicsBuffer memoryBuffer = memoryBuffers[targetIdx];
+
             // CBVs
             d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_SplitCS, GLOBAL_CB_BINDING_SLOT, globalCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_SplitCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_SplitCS, UPDATE_CB_BINDING_SLOT, updateCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_SplitCS, GEOMETRY_CB_BINDING_SLOT, target.geometryCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_SplitCS, UPDATE_CB_BINDING_SLOT, target.updateCB);
 
             // UAVs
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SplitCS, CLASSIFICATION_BUFFER_BINDING_SLOT, mesh.classificationBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SplitCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SplitCS, BISECTOR_DATA_BUFFER_BINDING_SLOT, mesh.updateBuffer);
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SplitCS, NEIGHBORS_BUFFER_BINDING_SLOT, currentNeighborsBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SplitCS, NEIGHBORS_BUFFER_BINDING_SLOT, mesh.neighborsBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SplitCS, MEMORY_BUFFER_BINDING_SLOT, memoryBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SplitCS, ALLOCATE_BUFFER_BINDING_SLOT, mesh.allocateBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SplitCS, BISECTOR_AGE_BUFFER_BINDING_SLOT, mesh.bisectorAgeBuffer);
 
             // Dispatch
             d3d12::command_buffer::dispatch_indirect(cmd, m_SplitCS, indirectBuffer);
+        }
+        d3d12::command_buffer::uav_barrier(cmd);
+        d3d12::command_buffer::end_section(cmd);
 
-            // Barrier
-            d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.updateBuffer);
+        // Predicted Split Pass (after the regular requests, they get the memory that is left)
+        d3d12::command_buffer::start_section(cmd, "Split predicted");
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
+        {
+            const MeshUpdateTarget& target = targets[targetIdx];
+            const CBTMesh& mesh = *target.mesh;
+            GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+            GraphicsBuffer memoryBuffer = memoryBuffers[targetIdx];
+
+            // CBVs
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_SplitPredictedCS, GLOBAL_CB_BINDING_SLOT, globalCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_SplitPredictedCS, GEOMETRY_CB_BINDING_SLOT, target.geometryCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_SplitPredictedCS, UPDATE_CB_BINDING_SLOT, target.updateCB);
+
+            // UAVs
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SplitPredictedCS, CLASSIFICATION_BUFFER_BINDING_SLOT, mesh.classificationBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SplitPredictedCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SplitPredictedCS, BISECTOR_DATA_BUFFER_BINDING_SLOT, mesh.updateBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SplitPredictedCS, NEIGHBORS_BUFFER_BINDING_SLOT, mesh.neighborsBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SplitPredictedCS, MEMORY_BUFFER_BINDING_SLOT, memoryBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SplitPredictedCS, ALLOCATE_BUFFER_BINDING_SLOT, mesh.allocateBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SplitPredictedCS, BISECTOR_AGE_BUFFER_BINDING_SLOT, mesh.bisectorAgeBuffer);
+
+            // Dispatch
+            d3d12::command_buffer::dispatch_indirect(cmd, m_SplitPredictedCS, indirectBuffer, 6 * sizeof(uint32_t));
         }
+        d3d12::command_buffer::uav_barrier(cmd);
         d3d12::command_buffer::end_section(cmd);
 
         // Prepare Indirect Pass
         d3d12::command_buffer::start_section(cmd, "Prepare indirect allocate");
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
         {
+            const CBTMesh& mesh = *targets[targetIdx].mesh;
+            GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+
             // UAVs
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareIndirectCS, ALLOCATE_BUFFER_BINDING_SLOT, mesh.allocateBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareIndirectCS, INDIRECT_DISPATCH_BUFFER_BINDING_SLOT, indirectBuffer);
 
             // Dispatch
             d3d12::command_buffer::dispatch(cmd, m_PrepareIndirectCS, 1, 1, 1);
-
-            // Barrier
-            d3d12::command_buffer::uav_barrier_buffer(cmd, indirectBuffer);
         }
+        d3d12::command_buffer::uav_barrier(cmd);
         d3d12::command_buffer::end_section(cmd);
 
         // Alocate Pass
         d3d12::command_buffer::start_section(cmd, "Allocate");
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
         {
+            const MeshUpdateTarget& target = targets[targetIdx];
+            const CBTMesh& mesh = *target.mesh;
+            GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+            GraphicsBuffer memoryBuffer = memoryBuffers[targetIdx];
+
             // CBVs
             d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_AllocateCS, GLOBAL_CB_BINDING_SLOT, globalCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_AllocateCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_AllocateCS, UPDATE_CB_BINDING_SLOT, updateCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_AllocateCS, GEOMETRY_CB_BINDING_SLOT, target.geometryCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_AllocateCS, UPDATE_CB_BINDING_SLOT, target.updateCB);
 
             // UAVs
             for (uint32_t bufferIdx = 0; bufferIdx < mesh.gpuCBT.bufferCount; ++bufferIdx)
@@ -311,22 +625,22 @@ void MeshUpdater::update(CommandBuffer cmd, CBTMesh& mesh, ConstantBuffer global
 
             // Dispatch
             d3d12::command_buffer::dispatch_indirect(cmd, m_AllocateCS, indirectBuffer);
-
-            // Barrier
-            d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.updateBuffer);
         }
+        d3d12::command_buffer::uav_barrier(cmd);
         d3d12::command_buffer::end_section(cmd);
 
-        // Copy Pass
-        d3d12::command_buffer::copy_graphics_buffer(cmd, currentNeighborsBuffer, nextNeighborsBuffer);
-
         // Bisect Pass
         d3d12::command_buffer::start_section(cmd, "Bisect");
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
         {
+            const MeshUpdateTarget& target = targets[targetIdx];
+            const CBTMesh& mesh = *target.mesh;
+            GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+
             // CBVs
             d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_BisectCS, GLOBAL_CB_BINDING_SLOT, globalCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_BisectCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_BisectCS, UPDATE_CB_BINDING_SLOT, updateCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_BisectCS, GEOMETRY_CB_BINDING_SLOT, target.geometryCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_BisectCS, UPDATE_CB_BINDING_SLOT, target.updateCB);
 
             // UAVs
             for (uint32_t bufferIdx = 0; bufferIdx < mesh.gpuCBT.bufferCount; ++bufferIdx)
@@ -334,187 +648,376 @@ void MeshUpdater::update(CommandBuffer cmd, CBTMesh& mesh, ConstantBuffer global
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectCS, ALLOCATE_BUFFER_BINDING_SLOT, mesh.allocateBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectCS, BISECTOR_DATA_BUFFER_BINDING_SLOT, mesh.updateBuffer);
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectCS, NEIGHBORS_BUFFER_BINDING_SLOT, currentNeighborsBuffer);
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectCS, NEIGHBORS_OUTPUT_BUFFER_BINDING_SLOT, nextNeighborsBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectCS, NEIGHBORS_BUFFER_BINDING_SLOT, mesh.neighborsBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectCS, NEIGHBORS_UPDATE_BUFFER_BINDING_SLOT, mesh.neighborsUpdateBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectCS, PROPAGATE_BUFFER_BINDING_SLOT, mesh.propagateBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectCS, BISECTOR_AGE_BUFFER_BINDING_SLOT, mesh.bisectorAgeBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectCS, LEB_POSITION_BUFFER_BINDING_SLOT, mesh.lebVertexBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectCS, LEB_POSITION_HEAP_ID_BUFFER_BINDING_SLOT, mesh.lebPositionHeapIDBuffer);
 
             // Dispatch
             d3d12::command_buffer::dispatch_indirect(cmd, m_BisectCS, indirectBuffer);
+        }
+        d3d12::command_buffer::uav_barrier(cmd);
+        d3d12::command_buffer::end_section(cmd);
 
-            // Barrier
-            d3d12::command_buffer::uav_barrier_buffer(cmd, nextNeighborsBuffer);
+        // Scatter Neighbors Pass
+        d3d12::command_buffer::start_section(cmd, "Scatter Neighbors");
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
+        {
+            const CBTMesh& mesh = *targets[targetIdx].mesh;
+            GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+
+            // UAVs
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ScatterNeighborsCS, ALLOCATE_BUFFER_BINDING_SLOT, mesh.allocateBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ScatterNeighborsCS, NEIGHBORS_BUFFER_BINDING_SLOT, mesh.neighborsBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ScatterNeighborsCS, NEIGHBORS_UPDATE_BUFFER_BINDING_SLOT, mesh.neighborsUpdateBuffer);
+
+            // Dispatch
+            d3d12::command_buffer::dispatch_indirect(cmd, m_ScatterNeighborsCS, indirectBuffer);
         }
+        d3d12::command_buffer::uav_barrier(cmd);
         d3d12::command_buffer::end_section(cmd);
 
         // Prepare Indirect Pass
         d3d12::command_buffer::start_section(cmd, "Prepare indirect propagate bisect");
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
         {
+            const CBTMesh& mesh = *targets[targetIdx].mesh;
+            GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+
             // UAVs
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareIndirectCS, ALLOCATE_BUFFER_BINDING_SLOT, mesh.propagateBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareIndirectCS, INDIRECT_DISPATCH_BUFFER_BINDING_SLOT, indirectBuffer);
 
             // Dispatch
             d3d12::command_buffer::dispatch(cmd, m_PrepareIndirectCS, 1, 1, 1);
-
-            // Barrier
-            d3d12::command_buffer::uav_barrier_buffer(cmd, indirectBuffer);
         }
+        d3d12::command_buffer::uav_barrier(cmd);
         d3d12::command_buffer::end_section(cmd);
 
         // Propagate Split Pass
         d3d12::command_buffer::start_section(cmd, "Propagate Bisect");
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
         {
+            const MeshUpdateTarget& target = targets[targetIdx];
+            const CBTMesh& mesh = *target.mesh;
+            GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+
             // CBVs
             d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PropagateBisectCS, GLOBAL_CB_BINDING_SLOT, globalCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PropagateBisectCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PropagateBisectCS, UPDATE_CB_BINDING_SLOT, updateCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PropagateBisectCS, GEOMETRY_CB_BINDING_SLOT, target.geometryCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PropagateBisectCS, UPDATE_CB_BINDING_SLOT, target.updateCB);
 
             // UAVs
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PropagateBisectCS, PROPAGATE_BUFFER_BINDING_SLOT, mesh.propagateBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PropagateBisectCS, BISECTOR_DATA_BUFFER_BINDING_SLOT, mesh.updateBuffer);
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PropagateBisectCS, NEIGHBORS_BUFFER_BINDING_SLOT, nextNeighborsBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PropagateBisectCS, NEIGHBORS_BUFFER_BINDING_SLOT, mesh.neighborsBuffer);
 
             // Dispatch
             d3d12::command_buffer::dispatch_indirect(cmd, m_PropagateBisectCS, indirectBuffer);
-
-            // Barrier
-            d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.updateBuffer);
         }
+        d3d12::command_buffer::uav_barrier(cmd);
         d3d12::command_buffer::end_section(cmd);
 
         // Simplify Pass
         d3d12::command_buffer::start_section(cmd, "Prepare Simplify");
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
         {
+            const MeshUpdateTarget& target = targets[targetIdx];
+            const CBTMesh& mesh = *target.mesh;
+            GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+
             // CBVs
             d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PrepareSimplifyCS, GLOBAL_CB_BINDING_SLOT, globalCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PrepareSimplifyCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PrepareSimplifyCS, UPDATE_CB_BINDING_SLOT, updateCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PrepareSimplifyCS, GEOMETRY_CB_BINDING_SLOT, target.geometryCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PrepareSimplifyCS, UPDATE_CB_BINDING_SLOT, target.updateCB);
 
             // UAVs
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareSimplifyCS, CLASSIFICATION_BUFFER_BINDING_SLOT, mesh.classificationBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareSimplifyCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareSimplifyCS, BISECTOR_DATA_BUFFER_BINDING_SLOT, mesh.updateBuffer);
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareSimplifyCS, NEIGHBORS_BUFFER_BINDING_SLOT, nextNeighborsBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareSimplifyCS, NEIGHBORS_BUFFER_BINDING_SLOT, mesh.neighborsBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareSimplifyCS, SIMPLIFICATION_BUFFER_BINDING_SLOT, mesh.simplificationBuffer);
 
             // Dispatch
             d3d12::command_buffer::dispatch_indirect(cmd, m_PrepareSimplifyCS, indirectBuffer, 3 * sizeof(uint32_t));
-
-            // Barrier
-            d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.simplificationBuffer);
         }
+        d3d12::command_buffer::uav_barrier(cmd);
         d3d12::command_buffer::end_section(cmd);
 
         // Prepare Indirect Pass
         d3d12::command_buffer::start_section(cmd, "Prepare Indirect Simplify");
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
         {
+            const CBTMesh& mesh = *targets[targetIdx].mesh;
+            GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+
             // UAVs
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareIndirectCS, ALLOCATE_BUFFER_BINDING_SLOT, mesh.simplificationBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareIndirectCS, INDIRECT_DISPATCH_BUFFER_BINDING_SLOT, indirectBuffer);
 
             // Dispatch
             d3d12::command_buffer::dispatch(cmd, m_PrepareIndirectCS, 1, 1, 1);
-
-            // Barrier
-            d3d12::command_buffer::uav_barrier_buffer(cmd, indirectBuffer);
         }
+        d3d12::command_buffer::uav_barrier(cmd);
         d3d12::command_buffer::end_section(cmd);
 
         // Simplify Pass
         d3d12::command_buffer::start_section(cmd, "Simplify");
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
         {
+            const MeshUpdateTarget& target = targets[targetIdx];
+            const CBTMesh& mesh = *target.mesh;
+            GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+
             // CBVs
             d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_SimplifyCS, GLOBAL_CB_BINDING_SLOT, globalCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_SimplifyCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_SimplifyCS, UPDATE_CB_BINDING_SLOT, updateCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_SimplifyCS, GEOMETRY_CB_BINDING_SLOT, target.geometryCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_SimplifyCS, UPDATE_CB_BINDING_SLOT, target.updateCB);
 
             // UAVs
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SimplifyCS, SIMPLIFICATION_BUFFER_BINDING_SLOT, mesh.simplificationBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SimplifyCS, BISECTOR_DATA_BUFFER_BINDING_SLOT, mesh.updateBuffer);
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SimplifyCS, NEIGHBORS_BUFFER_BINDING_SLOT, nextNeighborsBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SimplifyCS, NEIGHBORS_BUFFER_BINDING_SLOT, mesh.neighborsBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SimplifyCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
             for (uint32_t bufferIdx = 0; bufferIdx < mesh.gpuCBT.bufferCount; ++bufferIdx)
                 d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SimplifyCS, CBT_BUFFER0_BINDING_SLOT + bufferIdx, mesh.gpuCBT.bufferArray[bufferIdx]);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SimplifyCS, PROPAGATE_BUFFER_BINDING_SLOT, mesh.propagateBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_SimplifyCS, BISECTOR_AGE_BUFFER_BINDING_SLOT, mesh.bisectorAgeBuffer);
 
             // Dispatch
             d3d12::command_buffer::dispatch_indirect(cmd, m_SimplifyCS, indirectBuffer);
-
-            // Barrier
-            d3d12::command_buffer::uav_barrier_buffer(cmd, nextNeighborsBuffer);
         }
+        d3d12::command_buffer::uav_barrier(cmd);
         d3d12::command_buffer::end_section(cmd);
 
         // Prepare Indirect Pass
         d3d12::command_buffer::start_section(cmd, "Prepare indirect propagate simplify");
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
         {
+            const CBTMesh& mesh = *targets[targetIdx].mesh;
+            GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+
             // UAVs
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareIndirectCS, ALLOCATE_BUFFER_BINDING_SLOT, mesh.propagateBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareIndirectCS, INDIRECT_DISPATCH_BUFFER_BINDING_SLOT, indirectBuffer);
 
             // Dispatch
             d3d12::command_buffer::dispatch(cmd, m_PrepareIndirectCS, 2, 1, 1);
-
-            // Barrier
-            d3d12::command_buffer::uav_barrier_buffer(cmd, indirectBuffer);
         }
+        d3d12::command_buffer::uav_barrier(cmd);
         d3d12::command_buffer::end_section(cmd);
 
         // Propagate Simplify Pass
         d3d12::command_buffer::start_section(cmd, "PropagateSimplify");
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
         {
+            const MeshUpdateTarget& target = targets[targetIdx];
+            const CBTMesh& mesh = *target.mesh;
+            GraphicsBuffer indirectBuffer = indirectBuffers[targetIdx];
+
             // CBVs
             d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PropagateSimplifyCS, GLOBAL_CB_BINDING_SLOT, globalCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PropagateSimplifyCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
-            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PropagateSimplifyCS, UPDATE_CB_BINDING_SLOT, updateCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PropagateSimplifyCS, GEOMETRY_CB_BINDING_SLOT, target.geometryCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PropagateSimplifyCS, UPDATE_CB_BINDING_SLOT, target.updateCB);
 
             // UAVs
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PropagateSimplifyCS, PROPAGATE_BUFFER_BINDING_SLOT, mesh.propagateBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PropagateSimplifyCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
             d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PropagateSimplifyCS, BISECTOR_DATA_BUFFER_BINDING_SLOT, mesh.updateBuffer);
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PropagateSimplifyCS, NEIGHBORS_BUFFER_BINDING_SLOT, nextNeighborsBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PropagateSimplifyCS, NEIGHBORS_BUFFER_BINDING_SLOT, mesh.neighborsBuffer);
 
             // Dispatch
             d3d12::command_buffer::dispatch_indirect(cmd, m_PropagateSimplifyCS, indirectBuffer, 3 * sizeof(uint32_t));
-
-            // Barrier
-            d3d12::command_buffer::uav_barrier_buffer(cmd, nextNeighborsBuffer);
         }
+        d3d12::command_buffer::uav_barrier(cmd);
         d3d12::command_buffer::end_section(cmd);
 
         // Update Tree
-        d3d12::command_buffer::start_section(cmd, "Reduce");
+        reduce(cmd, targets);
+
+        // Renumber the bisectors if requested (the compaction buffer is shared, so the meshes are compacted one after the other)
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
         {
-            // The unique CBT Buffer
-            GraphicsBuffer cbtBuffer0 = mesh.gpuCBT.bufferArray[0];
-            GraphicsBuffer cbtBuffer1 = mesh.gpuCBT.bufferArray[1];
+            const MeshUpdateTarget& target = targets[targetIdx];
+            if (target.compact)
+                this->compact(cmd, *target.mesh, target.geometryCB, target.updateCB);
+        }
 
-            // First Pass
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ReducePrePassCS, CBT_BUFFER0_BINDING_SLOT, cbtBuffer0);
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ReducePrePassCS, CBT_BUFFER1_BINDING_SLOT, cbtBuffer1);
+        // Prepare for indirect dispatches
+        prepare_indirection(cmd, targets);
+    }
+    d3d12::command_buffer::end_section(cmd);
+}
+
+void MeshUpdater::reduce(CommandBuffer cmd, const std::vector<MeshUpdateTarget>& targets)
+{
+    uint32_t numTargets = (uint32_t)targets.size();
+    d3d12::command_buffer::start_section(cmd, "Reduce");
+    {
+        // First Pass
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
+        {
+            const CBTMesh& mesh = *targets[targetIdx].mesh;
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ReducePrePassCS, CBT_BUFFER0_BINDING_SLOT, mesh.gpuCBT.bufferArray[0]);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ReducePrePassCS, CBT_BUFFER1_BINDING_SLOT, mesh.gpuCBT.bufferArray[1]);
             d3d12::command_buffer::dispatch(cmd, m_ReducePrePassCS, mesh.gpuCBT.lastLevelSize / (4 * WORKGROUP_SIZE), 1, 1);
-            d3d12::command_buffer::uav_barrier_buffer(cmd, cbtBuffer0);
+        }
+        d3d12::command_buffer::uav_barrier(cmd);
 
-            // Second Pass
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ReduceFirstPassCS, CBT_BUFFER0_BINDING_SLOT, cbtBuffer0);
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ReduceFirstPassCS, CBT_BUFFER1_BINDING_SLOT, cbtBuffer1);
+        // Second Pass
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
+        {
+            const CBTMesh& mesh = *targets[targetIdx].mesh;
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ReduceFirstPassCS, CBT_BUFFER0_BINDING_SLOT, mesh.gpuCBT.bufferArray[0]);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ReduceFirstPassCS, CBT_BUFFER1_BINDING_SLOT, mesh.gpuCBT.bufferArray[1]);
             d3d12::command_buffer::dispatch(cmd, m_ReduceFirstPassCS, 8, 1, 1);
-            d3d12::command_buffer::uav_barrier_buffer(cmd, cbtBuffer0);
+        }
+        d3d12::command_buffer::uav_barrier(cmd);
 
-            // Third Pass
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ReduceSecondPassCS, CBT_BUFFER0_BINDING_SLOT, cbtBuffer0);
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ReduceSecondPassCS, CBT_BUFFER1_BINDING_SLOT, cbtBuffer1);
+        // Third Pass
+        for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
+        {
+            const CBTMesh& mesh = *targets[targetIdx].mesh;
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ReduceSecondPassCS, CBT_BUFFER0_BINDING_SLOT, mesh.gpuCBT.bufferArray[0]);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ReduceSecondPassCS, CBT_BUFFER1_BINDING_SLOT, mesh.gpuCBT.bufferArray[1]);
             d3d12::command_buffer::dispatch(cmd, m_ReduceSecondPassCS, 1, 1, 1);
-            d3d12::command_buffer::uav_barrier_buffer(cmd, cbtBuffer0);
+        }
+        d3d12::command_buffer::uav_barrier(cmd);
+    }
+    d3d12::command_buffer::end_section(cmd);
+}
 
+void MeshUpdater::compact(CommandBuffer cmd, const CBTMesh& mesh, ConstantBuffer geometryCB, ConstantBuffer updateCB)
+{
+    // Num groups that need to be dispatched
+    uint32_t numGroups = (mesh.totalNumElements + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+
+    // The compaction reuses the dispatch arguments of the first mesh of the batch
+    GraphicsBuffer indirectBuffer = indirectBuffers[0];
+
+    // The moved neighbors are stored in the bisector data (rewritten by the resolve pass)
+    GraphicsBuffer neighborsBuffer = mesh.neighborsBuffer;
+
+    d3d12::command_buffer::start_section(cmd, "Compaction");
+    {
+        // Clear pass
+        {
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionClearCS, COMPACTION_BUFFER_BINDING_SLOT, compactionBuffer);
+            d3d12::command_buffer::dispatch(cmd, m_CompactionClearCS, COMPACTION_NUM_BUCKETS / WORKGROUP_SIZE, 1, 1);
+            d3d12::command_buffer::uav_barrier_buffer(cmd, compactionBuffer);
         }
-        d3d12::command_buffer::end_section(cmd);
 
-        // Move to the next bisector
-        mesh.currentNeighborsBufferIdx = nextNeighborsBufferIdx;
+        // Count pass
+        {
+            // CBVs
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_CompactionCountCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
 
-        // Prepare for indirect dispatches
-        prepare_indirection(cmd, mesh, geometryCB);
+            // UAVs
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionCountCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionCountCS, COMPACTION_BUFFER_BINDING_SLOT, compactionBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionCountCS, COMPACTION_REMAP_BUFFER_BINDING_SLOT, mesh.compactionRemapBuffer);
+
+            // Dispatch
+            d3d12::command_buffer::dispatch(cmd, m_CompactionCountCS, numGroups, 1, 1);
+
+            // Barrier
+            d3d12::command_buffer::uav_barrier_buffer(cmd, compactionBuffer);
+        }
+
+        // Decide if the compaction is worth it
+        {
+            // CBVs
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PrepareCompactionCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PrepareCompactionCS, UPDATE_CB_BINDING_SLOT, updateCB);
+
+            // UAVs
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareCompactionCS, CBT_BUFFER0_BINDING_SLOT, mesh.gpuCBT.bufferArray[0]);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareCompactionCS, COMPACTION_BUFFER_BINDING_SLOT, compactionBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareCompactionCS, INDIRECT_DISPATCH_BUFFER_BINDING_SLOT, indirectBuffer);
+
+            // Dispatch
+            d3d12::command_buffer::dispatch(cmd, m_PrepareCompactionCS, 1, 1, 1);
+
+            // Barrier
+            d3d12::command_buffer::uav_barrier_buffer(cmd, indirectBuffer);
+        }
+
+        // Scan pass
+        {
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionScanCS, COMPACTION_BUFFER_BINDING_SLOT, compactionBuffer);
+            d3d12::command_buffer::dispatch_indirect(cmd, m_CompactionScanCS, indirectBuffer, 3 * sizeof(uint32_t));
+            d3d12::command_buffer::uav_barrier_buffer(cmd, compactionBuffer);
+        }
+
+        // Remap pass
+        {
+            // CBVs
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_CompactionRemapCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
+
+            // UAVs
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionRemapCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionRemapCS, COMPACTION_BUFFER_BINDING_SLOT, compactionBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionRemapCS, COMPACTION_REMAP_BUFFER_BINDING_SLOT, mesh.compactionRemapBuffer);
+
+            // Dispatch
+            d3d12::command_buffer::dispatch_indirect(cmd, m_CompactionRemapCS, indirectBuffer);
+
+            // Barrier
+            d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.compactionRemapBuffer);
+        }
+
+        // Scatter pass
+        {
+            // CBVs
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_CompactionScatterCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
+
+            // UAVs
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionScatterCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionScatterCS, NEIGHBORS_BUFFER_BINDING_SLOT, neighborsBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionScatterCS, BISECTOR_DATA_BUFFER_BINDING_SLOT, mesh.updateBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionScatterCS, COMPACTION_REMAP_BUFFER_BINDING_SLOT, mesh.compactionRemapBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionScatterCS, COMPACTION_HEAP_ID_BUFFER_BINDING_SLOT, mesh.compactionHeapIDBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionScatterCS, BISECTOR_AGE_BUFFER_BINDING_SLOT, mesh.bisectorAgeBuffer);
+
+            // Dispatch
+            d3d12::command_buffer::dispatch_indirect(cmd, m_CompactionScatterCS, indirectBuffer);
+
+            // Barrier
+            d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.updateBuffer);
+            d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.compactionHeapIDBuffer);
+            d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.bisectorAgeBuffer);
+        }
+
+        // Resolve pass
+        {
+            // CBVs
+            d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_CompactionResolveCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
+
+            // UAVs
+            for (uint32_t bufferIdx = 0; bufferIdx < mesh.gpuCBT.bufferCount; ++bufferIdx)
+                d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionResolveCS, CBT_BUFFER0_BINDING_SLOT + bufferIdx, mesh.gpuCBT.bufferArray[bufferIdx]);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionResolveCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionResolveCS, NEIGHBORS_BUFFER_BINDING_SLOT, neighborsBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionResolveCS, BISECTOR_DATA_BUFFER_BINDING_SLOT, mesh.updateBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionResolveCS, COMPACTION_HEAP_ID_BUFFER_BINDING_SLOT, mesh.compactionHeapIDBuffer);
+            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_CompactionResolveCS, BISECTOR_AGE_BUFFER_BINDING_SLOT, mesh.bisectorAgeBuffer);
+
+            // Dispatch
+            d3d12::command_buffer::dispatch_indirect(cmd, m_CompactionResolveCS, indirectBuffer);
+
+            // Barrier
+            d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.heapIDBuffer);
+            d3d12::command_buffer::uav_barrier_buffer(cmd, neighborsBuffer);
+            d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.bisectorAgeBuffer);
+            d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.gpuCBT.bufferArray[1]);
+        }
+
+        // The bitfield has been rebuilt, update the tree
+        MeshUpdateTarget target;
+        target.mesh = &mesh;
+        reduce(cmd, std::vector<MeshUpdateTarget>(1, target));
     }
     d3d12::command_buffer::end_section(cmd);
 }
@@ -532,7 +1035,7 @@ void MeshUpdater::validate(CommandBuffer cmd, const CBTMesh& mesh, ConstantBuffe
         // UAVs
         d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ValidateCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
         d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ValidateCS, BISECTOR_DATA_BUFFER_BINDING_SLOT, mesh.updateBuffer);
-        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ValidateCS, NEIGHBORS_BUFFER_BINDING_SLOT, mesh.neighborsBuffers[mesh.currentNeighborsBufferIdx]);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ValidateCS, NEIGHBORS_BUFFER_BINDING_SLOT, mesh.neighborsBuffer);
         d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ValidateCS, VALIDATION_BUFFER_BINDING_SLOT, validationBuffer);
 
         // Dispatch
@@ -542,52 +1045,140 @@ void MeshUpdater::validate(CommandBuffer cmd, const CBTMesh& mesh, ConstantBuffe
         d3d12::command_buffer::uav_barrier_buffer(cmd, validationBuffer);
 
         // Copy
-        d3d12::command_buffer::copy_graphics_buffer(cmd, validationBuffer, validationBufferRB);
+        m_ValidationReadback.enqueue(cmd, validationBuffer);
     }
     d3d12::command_buffer::end_section(cmd);
 }
 
-void MeshUpdater::reset_buffers(CommandBuffer cmd, const CBTMesh& mesh)
+void MeshUpdater::derive_adjacency(CommandBuffer cmd, const CBTMesh& mesh, ConstantBuffer geometryCB)
+{
+    d3d12::command_buffer::start_section(cmd, "Derive Adjacency");
+    {
+        // Num groups that need to be dispatched
+        uint32_t numGroups = (mesh.totalNumElements + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+        uint32_t numHashGroups = (HEAP_ID_HASH_LOAD_RATIO * mesh.totalNumElements + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+
+        // Clear the heapID table
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_ClearHeapIDHashCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ClearHeapIDHashCS, HEAP_ID_HASH_BUFFER_BINDING_SLOT, mesh.heapIDHashBuffer);
+        d3d12::command_buffer::dispatch(cmd, m_ClearHeapIDHashCS, numHashGroups, 1, 1);
+        d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.heapIDHashBuffer);
+
+        // Insert every allocated bisector
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_BuildHeapIDHashCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BuildHeapIDHashCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BuildHeapIDHashCS, HEAP_ID_HASH_BUFFER_BINDING_SLOT, mesh.heapIDHashBuffer);
+        d3d12::command_buffer::dispatch(cmd, m_BuildHeapIDHashCS, numGroups, 1, 1);
+        d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.heapIDHashBuffer);
+
+        // Derive the neighbors and compare them to the stored ones
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_DeriveAdjacencyCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_DeriveAdjacencyCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_DeriveAdjacencyCS, NEIGHBORS_BUFFER_BINDING_SLOT, mesh.neighborsBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_DeriveAdjacencyCS, BASE_NEIGHBORS_BUFFER_BINDING_SLOT, mesh.baseNeighborsBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_DeriveAdjacencyCS, HEAP_ID_HASH_BUFFER_BINDING_SLOT, mesh.heapIDHashBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_DeriveAdjacencyCS, VALIDATION_BUFFER_BINDING_SLOT, validationBuffer);
+        d3d12::command_buffer::dispatch(cmd, m_DeriveAdjacencyCS, numGroups, 1, 1);
+        d3d12::command_buffer::uav_barrier_buffer(cmd, validationBuffer);
+    }
+    d3d12::command_buffer::end_section(cmd);
+}
+
+void MeshUpdater::reset_buffers(CommandBuffer cmd, const CBTMesh& mesh, ConstantBuffer geometryCB)
 {
     d3d12::command_buffer::start_section(cmd, "Reset Buffers");
-    // Reset Pass
     {
+        reset_buffers(cmd, mesh, geometryCB, memoryBuffers[0]);
+        d3d12::command_buffer::uav_barrier_buffer(cmd, memoryBuffers[0]);
+    }
+    d3d12::command_buffer::end_section(cmd);
+}
+
+void MeshUpdater::reset_buffers(CommandBuffer cmd, const CBTMesh& mesh, ConstantBuffer geometryCB, GraphicsBuffer memoryBuffer)
+{
+    // CBVs
+    d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_ResetCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
+
+    // UAVs
+    for (uint32_t bufferIdx = 0; bufferIdx < mesh.gpuCBT.bufferCount; ++bufferIdx)
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResetCS, CBT_BUFFER0_BINDING_SLOT + bufferIdx, mesh.gpuCBT.bufferArray[bufferIdx]);
+    d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResetCS, MEMORY_BUFFER_BINDING_SLOT, memoryBuffer);
+    d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResetCS, CLASSIFICATION_BUFFER_BINDING_SLOT, mesh.classificationBuffer);
+    d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResetCS, ALLOCATE_BUFFER_BINDING_SLOT, mesh.allocateBuffer);
+    d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResetCS, INDIRECT_DRAW_BUFFER_BINDING_SLOT, mesh.indirectDrawBuffer);
+    d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResetCS, SIMPLIFICATION_BUFFER_BINDING_SLOT, mesh.simplificationBuffer);
+    d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResetCS, PROPAGATE_BUFFER_BINDING_SLOT, mesh.propagateBuffer);
+
+    // Dispatch
+    d3d12::command_buffer::dispatch(cmd, m_ResetCS, 1, 1, 1);
+}
+
+void MeshUpdater::clear_unallocated_elements(CommandBuffer cmd, CBTMesh& mesh, ConstantBuffer geometryCB)
+{
+    // Only a mesh that didn't start from a snapshot needs to be cleared, once
+    if (!mesh.clearUnallocatedElements)
+        return;
+
+    d3d12::command_buffer::start_section(cmd, "Clear Unallocated Elements");
+    {
+        // CBVs
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_ClearUnallocatedElementsCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
+
         // UAVs
-        for (uint32_t bufferIdx = 0; bufferIdx < mesh.gpuCBT.bufferCount; ++bufferIdx)
-            d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResetCS, CBT_BUFFER0_BINDING_SLOT + bufferIdx, mesh.gpuCBT.bufferArray[bufferIdx]);
-        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResetCS, MEMORY_BUFFER_BINDING_SLOT, memoryBuffer);
-        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResetCS, CLASSIFICATION_BUFFER_BINDING_SLOT, mesh.classificationBuffer);
-        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResetCS, ALLOCATE_BUFFER_BINDING_SLOT, mesh.allocateBuffer);
-        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResetCS, INDIRECT_DRAW_BUFFER_BINDING_SLOT, mesh.indirectDrawBuffer);
-        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResetCS, SIMPLIFICATION_BUFFER_BINDING_SLOT, mesh.simplificationBuffer);
-        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResetCS, PROPAGATE_BUFFER_BINDING_SLOT, mesh.propagateBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ClearUnallocatedElementsCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ClearUnallocatedElementsCS, NEIGHBORS_BUFFER_BINDING_SLOT, mesh.neighborsBuffer);
 
         // Dispatch
-        d3d12::command_buffer::dispatch(cmd, m_ResetCS, 1, 1, 1);
+        d3d12::command_buffer::dispatch(cmd, m_ClearUnallocatedElementsCS, (mesh.firstBaseElement + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
 
-        // Barrier
-        d3d12::command_buffer::uav_barrier_buffer(cmd, memoryBuffer);
+        // Barriers
+        d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.heapIDBuffer);
+        d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.neighborsBuffer);
     }
     d3d12::command_buffer::end_section(cmd);
+    mesh.clearUnallocatedElements = false;
+}
+
+void MeshUpdater::reserve_batch_buffers(uint32_t numTargets)
+{
+    // The scratch buffers are only allocated the first time a batch this large is updated
+    while ((uint32_t)indirectBuffers.size() < numTargets)
+    {
+        indirectBuffers.push_back(d3d12::graphics_resources::create_graphics_buffer(m_Device, sizeof(uint32_t) * 9, sizeof(uint32_t), GraphicsBufferType::Default));
+        memoryBuffers.push_back(d3d12::graphics_resources::create_graphics_buffer(m_Device, sizeof(int32_t) * 2, sizeof(int32_t), GraphicsBufferType::Default));
+    }
 }
 
 void MeshUpdater::prepare_indirection(CommandBuffer cmd, const CBTMesh& mesh, ConstantBuffer geometryCB)
 {
-    // Num groups that need to be dispatched
-    uint32_t numGroups = (mesh.totalNumElements + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+    MeshUpdateTarget target;
+    target.mesh = &mesh;
+    target.geometryCB = geometryCB;
+    prepare_indirection(cmd, std::vector<MeshUpdateTarget>(1, target));
+}
 
+void MeshUpdater::prepare_indirection(CommandBuffer cmd, const std::vector<MeshUpdateTarget>& targets)
+{
+    uint32_t numTargets = (uint32_t)targets.size();
     d3d12::command_buffer::start_section(cmd, "Prepare Indirect Draw & Dispatch");
     // Bisector indexation
+    for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
     {
+        const MeshUpdateTarget& target = targets[targetIdx];
+        const CBTMesh& mesh = *target.mesh;
+
+        // Num groups that need to be dispatched
+        uint32_t numGroups = (mesh.totalNumElements + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+
         // CBVs
-        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_BisectorIndexationCS, GEOMETRY_CB_BINDING_SLOT, geometryCB);
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_BisectorIndexationCS, GEOMETRY_CB_BINDING_SLOT, target.geometryCB);
 
         // UAVs
         d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectorIndexationCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
         d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectorIndexationCS, INDIRECT_DRAW_BUFFER_BINDING_SLOT, mesh.indirectDrawBuffer);
         d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectorIndexationCS, BISECTOR_INDICES_BINDING_SLOT, mesh.indexedBisectorBuffer);
         d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectorIndexationCS, BISECTOR_DATA_BUFFER_BINDING_SLOT, mesh.updateBuffer);
-        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectorIndexationCS, NEIGHBORS_BUFFER_BINDING_SLOT, mesh.neighborsBuffers[mesh.currentNeighborsBufferIdx]);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectorIndexationCS, NEIGHBORS_BUFFER_BINDING_SLOT, mesh.neighborsBuffer);
         d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectorIndexationCS, VISIBLE_BISECTOR_INDICES_BINDING_SLOT, mesh.visibleIndexedBisectorBuffer);
         d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_BisectorIndexationCS, MODIFIED_BISECTOR_INDICES_BINDING_SLOT, mesh.modifiedIndexedBisectorBuffer);
 
@@ -596,42 +1187,154 @@ void MeshUpdater::prepare_indirection(CommandBuffer cmd, const CBTMesh& mesh, Co
     }
 
     // Barrier for both passes
-    d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.indirectDrawBuffer);
+    d3d12::command_buffer::uav_barrier(cmd);
 
     // Prepare bisector indirect dispatch
+    for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
     {
+        const CBTMesh& mesh = *targets[targetIdx].mesh;
+
         // UAVs
         d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareBisectorIndirectCS, INDIRECT_DRAW_BUFFER_BINDING_SLOT, mesh.indirectDrawBuffer);
         d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareBisectorIndirectCS, INDIRECT_DISPATCH_BUFFER_BINDING_SLOT, mesh.indirectDispatchBuffer);
+#if defined(WELDED_VERTICES)
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareBisectorIndirectCS, WELDED_ARGS_BUFFER_BINDING_SLOT, mesh.weldedArgsBuffer);
+#endif
 
         // Dispatch
         d3d12::command_buffer::dispatch(cmd, m_PrepareBisectorIndirectCS, 1, 1, 1);
+    }
+    d3d12::command_buffer::uav_barrier(cmd);
 
-        // Barrier
-        d3d12::command_buffer::uav_barrier_buffer(cmd, mesh.indirectDispatchBuffer);
+#if defined(WELDED_VERTICES)
+    // Assign a vertex to the corners that own one and point the others to their owner
+    for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
+    {
+        const MeshUpdateTarget& target = targets[targetIdx];
+        const CBTMesh& mesh = *target.mesh;
+        uint32_t numGroups = (mesh.totalNumElements + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+
+        // CBVs
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_WeldVerticesCS, GEOMETRY_CB_BINDING_SLOT, target.geometryCB);
+
+        // UAVs
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_WeldVerticesCS, HEAP_ID_BUFFER_BINDING_SLOT, mesh.heapIDBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_WeldVerticesCS, NEIGHBORS_BUFFER_BINDING_SLOT, mesh.neighborsBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_WeldVerticesCS, VERTEX_INDEX_BUFFER_BINDING_SLOT, mesh.vertexIndexBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_WeldVerticesCS, WELDED_VERTEX_BUFFER_BINDING_SLOT, mesh.weldedVertexBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_WeldVerticesCS, WELDED_ARGS_BUFFER_BINDING_SLOT, mesh.weldedArgsBuffer);
+
+        // Dispatch
+        d3d12::command_buffer::dispatch(cmd, m_WeldVerticesCS, numGroups, 1, 1);
+    }
+    d3d12::command_buffer::uav_barrier(cmd);
+
+    // Resolve the shared corners and write the index buffer
+    for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
+    {
+        const MeshUpdateTarget& target = targets[targetIdx];
+        const CBTMesh& mesh = *target.mesh;
+
+        // CBVs
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_ResolveWeldedVerticesCS, GEOMETRY_CB_BINDING_SLOT, target.geometryCB);
+
+        // UAVs
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResolveWeldedVerticesCS, INDIRECT_DRAW_BUFFER_BINDING_SLOT, mesh.indirectDrawBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResolveWeldedVerticesCS, BISECTOR_INDICES_BINDING_SLOT, mesh.indexedBisectorBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResolveWeldedVerticesCS, VERTEX_INDEX_BUFFER_BINDING_SLOT, mesh.vertexIndexBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_ResolveWeldedVerticesCS, WELDED_INDEX_BUFFER_BINDING_SLOT, mesh.weldedIndexBuffer);
+
+        // Dispatch
+        d3d12::command_buffer::dispatch_indirect(cmd, m_ResolveWeldedVerticesCS, mesh.indirectDispatchBuffer);
+    }
+    d3d12::command_buffer::uav_barrier(cmd);
+
+    // Prepare the indexed draw and the deformation dispatch
+    for (uint32_t targetIdx = 0; targetIdx < numTargets; ++targetIdx)
+    {
+        const MeshUpdateTarget& target = targets[targetIdx];
+        const CBTMesh& mesh = *target.mesh;
+
+        // CBVs
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmd, m_PrepareWeldedIndirectCS, GEOMETRY_CB_BINDING_SLOT, target.geometryCB);
+
+        // UAVs
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareWeldedIndirectCS, INDIRECT_DRAW_BUFFER_BINDING_SLOT, mesh.indirectDrawBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareWeldedIndirectCS, INDIRECT_DISPATCH_BUFFER_BINDING_SLOT, mesh.indirectDispatchBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmd, m_PrepareWeldedIndirectCS, WELDED_ARGS_BUFFER_BINDING_SLOT, mesh.weldedArgsBuffer);
+
+        // Dispatch
+        d3d12::command_buffer::dispatch(cmd, m_PrepareWeldedIndirectCS, 1, 1, 1);
     }
+    d3d12::command_buffer::uav_barrier(cmd);
+#endif
     d3d12::command_buffer::end_section(cmd);
 }
 
 bool MeshUpdater::check_if_valid()
 {
-    uint32_t* buffer = (uint32_t*)d3d12::graphics_resources::allocate_cpu_buffer(validationBufferRB);
-    bool valid = buffer[0] == 0;
-    d3d12::graphics_resources::release_cpu_buffer(validationBufferRB);
-    return valid;
+    // Only the latest completed validation is evaluated
+    uint32_t validation[2];
+    if (m_ValidationReadback.read(validation))
+    {
+        m_LastValidation = validation[0] == 0;
+        m_DerivedAdjacencyMismatches = validation[1];
+    }
+    return m_LastValidation;
 }
 
 // Query occupancy
 void MeshUpdater::query_occupancy(CommandBuffer cmdB, const CBTMesh& mesh)
 {
-    d3d12::command_buffer::copy_graphics_buffer(cmdB, mesh.gpuCBT.bufferArray[0], 0, occupancyBufferRB, 0, sizeof(uint32_t));
+    m_OccupancyReadback.enqueue(cmdB, mesh.gpuCBT.bufferArray[0]);
 }
 
 // Get the occupancy
-uint32_t MeshUpdater::get_occupancy()
+bool MeshUpdater::get_occupancy(uint32_t& occupancy)
+{
+    return m_OccupancyReadback.read(&occupancy);
+}
+
+// Query the convergence
+void MeshUpdater::query_convergence(CommandBuffer cmdB, const CBTMesh& mesh)
+{
+    m_ConvergenceReadback.enqueue(cmdB, mesh.classificationBuffer);
+}
+
+// Get the convergence
+bool MeshUpdater::get_convergence(uint32_t& splitRequests, uint32_t& simplifyRequests, uint32_t& underRefinedArea)
+{
+    uint32_t convergence[4];
+    if (!m_ConvergenceReadback.read(convergence))
+        return false;
+    splitRequests = convergence[0];
+    simplifyRequests = convergence[1];
+    underRefinedArea = convergence[3];
+    return true;
+}
+
+// Query the churn counters
+void MeshUpdater::query_churn(CommandBuffer cmdB, const CBTMesh& mesh)
+{
+    m_ChurnReadback.enqueue(cmdB, mesh.bisectorAgeBuffer, sizeof(uint32_t) * 2 * mesh.totalNumElements);
+}
+
+// Get the churn counters
+bool MeshUpdater::get_churn(uint32_t& splitMergeCount, uint32_t& mergeSplitCount)
+{
+    uint32_t churn[2];
+    if (!m_ChurnReadback.read(churn))
+        return false;
+    splitMergeCount = churn[0];
+    mergeSplitCount = churn[1];
+    return true;
+}
+
+// Submit the readbacks
+void MeshUpdater::submit_readbacks(CommandQueue cmdQ)
 {
-    uint32_t* buffer = (uint32_t*)d3d12::graphics_resources::allocate_cpu_buffer(occupancyBufferRB);
-    uint32_t occupancy = buffer[0];
-    d3d12::graphics_resources::release_cpu_buffer(occupancyBufferRB);
-    return occupancy;
+    m_ValidationReadback.submit(cmdQ);
+    m_OccupancyReadback.submit(cmdQ);
+    m_ConvergenceReadback.submit(cmdQ);
+    m_ChurnReadback.submit(cmdQ);
 }
\ No newline at end of file
@@ -42,6 +42,9 @@ void MoonDeformer::reload_shaders(const std::string& shaderLibrary)
     csd.uavCount = 3;
     csd.samplerCount = 1;
     csd.kernelname = "EvaluateDeformation";
+#if defined(WELDED_VERTICES)
+    csd.defines.push_back("WELDED_VERTICES");
+#endif
     compile_and_replace_compute_shader(m_Device, csd, m_EvaluateDeformationCS);
 }
 
@@ -58,8 +61,14 @@ void MoonDeformer::apply_deformation(CommandBuffer cmdB, const MoonMaterial& moo
         // SRVs
         d3d12::command_buffer::set_compute_shader_texture_srv(cmdB, m_EvaluateDeformationCS, 0, moonMat.get_elevation_texture());
         d3d12::command_buffer::set_compute_shader_texture_srv(cmdB, m_EvaluateDeformationCS, 1, moonMat.get_detail_texture());
+#if defined(WELDED_VERTICES)
+        // Every welded vertex is displaced once
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_EvaluateDeformationCS, 2, mesh.weldedVertexBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_EvaluateDeformationCS, 3, mesh.weldedArgsBuffer);
+#else
         d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_EvaluateDeformationCS, 2, mesh.indexedBisectorBuffer);
         d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_EvaluateDeformationCS, 3, mesh.indirectDrawBuffer);
+#endif
 
         // UAVs
         d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_EvaluateDeformationCS, 0, mesh.lebVertexBuffer);
@@ -70,7 +79,11 @@ void MoonDeformer::apply_deformation(CommandBuffer cmdB, const MoonMaterial& moo
         d3d12::command_buffer::set_compute_shader_sampler(cmdB, m_EvaluateDeformationCS, 0, m_LinearWrap);
 
         // Dispatch
+#if defined(WELDED_VERTICES)
+        d3d12::command_buffer::dispatch_indirect(cmdB, m_EvaluateDeformationCS, mesh.indirectDispatchBuffer, WELDED_DISPATCH_OFFSET * sizeof(uint32_t));
+#else
         d3d12::command_buffer::dispatch_indirect(cmdB, m_EvaluateDeformationCS, mesh.indirectDispatchBuffer, 3 * sizeof(uint32_t));
+#endif
 
         // Barrier
         d3d12::command_buffer::uav_barrier_buffer(cmdB, mesh.currentVertexBuffer);
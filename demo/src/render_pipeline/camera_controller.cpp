@@ -244,6 +244,9 @@ bool CameraController::process_mouse_movement(int2 mouse, uint2 windowCenter, fl
 
 void CameraController::update(double deltaTime)
 {
+    // Keep track of the previous position to evaluate the velocity
+    double3 previousPosition = m_Camera.position;
+
     if (!m_IsPlaying)
     {
         if (m_ActiveInteraction)
@@ -350,6 +353,9 @@ void CameraController::update(double deltaTime)
         }
     }
     
+    // Evaluate the velocity
+    m_Velocity = deltaTime > 0.0 ? (m_Camera.position - previousPosition) / deltaTime : double3({ 0.0, 0.0, 0.0 });
+
     // update the distances
     evaluate_distances();
 
@@ -39,7 +39,12 @@ void MoonRenderer::reload_shaders(const std::string& shaderLibrary)
         gpd.includeDirectories.push_back(shaderLibrary);
         gpd.filename = shaderLibrary + "\\" + "Visibility\\VisibilityPass.graphics";
         gpd.cbvCount = 2;
+#if defined(WELDED_VERTICES)
+        gpd.srvCount = 3;
+        gpd.defines.push_back("WELDED_VERTICES");
+#else
         gpd.srvCount = 2;
+#endif
         gpd.rtFormat[0] = TextureFormat::R16G16B16A16_UInt;
 
         // Depth
@@ -60,7 +65,12 @@ void MoonRenderer::reload_shaders(const std::string& shaderLibrary)
         csd.includeDirectories.push_back(shaderLibrary);
         csd.filename = shaderLibrary + "\\Moon\\MaterialPass.compute";
         csd.cbvCount = 4;
+#if defined(WELDED_VERTICES)
+        csd.srvCount = 8;
+        csd.defines.push_back("WELDED_VERTICES");
+#else
         csd.srvCount = 6;
+#endif
         csd.uavCount = 1;
         csd.samplerCount = 2;
         csd.kernelname = "EvaluateMaterial";
@@ -74,7 +84,12 @@ void MoonRenderer::reload_shaders(const std::string& shaderLibrary)
         gpd.filename = shaderLibrary + "\\Moon\\SolidWire.graphics";
         gpd.geometryKernelName = "geom";
         gpd.cbvCount = 4;
+#if defined(WELDED_VERTICES)
+        gpd.srvCount = 7;
+        gpd.defines.push_back("WELDED_VERTICES");
+#else
         gpd.srvCount = 6;
+#endif
         gpd.samplerCount = 2;
         gpd.depthStencilState.enableDepth = true;
         gpd.depthStencilState.depthtest = DepthTest::Less;
@@ -131,9 +146,19 @@ void MoonRenderer::render_visibility_buffer(CommandBuffer cmd, RenderTexture vis
         // SRVs
         d3d12::command_buffer::set_graphics_pipeline_buffer_srv(cmd, m_VisibilityGP, 0, targetMesh.currentVertexBuffer);
         d3d12::command_buffer::set_graphics_pipeline_buffer_srv(cmd, m_VisibilityGP, 1, targetMesh.indexedBisectorBuffer);
-
+#if defined(WELDED_VERTICES)
+        d3d12::command_buffer::set_graphics_pipeline_buffer_srv(cmd, m_VisibilityGP, 2, targetMesh.vertexIndexBuffer);
+
+        // Draw the welded geometry
+        d3d12::command_buffer::draw_indexed_indirect(cmd, m_VisibilityGP, targetMesh.weldedIndexBuffer, targetMesh.weldedArgsBuffer);
+#elif defined(BISECTOR_CLUSTERS)
+        // Draw the bisectors of the visible clusters
+        d3d12::command_buffer::set_graphics_pipeline_buffer_srv(cmd, m_VisibilityGP, 1, targetMesh.clusterDrawBuffer);
+        d3d12::command_buffer::draw_procedural_indirect(cmd, m_VisibilityGP, targetMesh.clusterArgsBuffer, CLUSTER_DRAW_ARGS_OFFSET * sizeof(uint32_t));
+#else
         // Draw the geometry
         d3d12::command_buffer::draw_procedural_indirect(cmd, m_VisibilityGP, targetMesh.indirectDrawBuffer);
+#endif
     }
     d3d12::command_buffer::end_section(cmd);
 }
@@ -162,6 +187,9 @@ void MoonRenderer::render_material(CommandBuffer cmd, RenderTexture colorBuffer,
         d3d12::command_buffer::set_compute_shader_texture_srv(cmd, m_MaterialCS, 3, moonMaterial.get_elevation_sg_texture());
         d3d12::command_buffer::set_compute_shader_texture_srv(cmd, m_MaterialCS, 4, moonMaterial.get_detail_sg_texture());
         d3d12::command_buffer::set_compute_shader_render_texture_srv(cmd, m_MaterialCS, 5, visibilityBuffer);
+#if defined(WELDED_VERTICES)
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmd, m_MaterialCS, 7, targetMesh.vertexIndexBuffer);
+#endif
 
         // UAVs
         d3d12::command_buffer::set_compute_shader_render_texture_uav(cmd, m_MaterialCS, 0, colorBuffer);
@@ -200,6 +228,9 @@ void MoonRenderer::render_solid_wire(CommandBuffer cmd, RenderTexture colorBuffe
         d3d12::command_buffer::set_graphics_pipeline_texture_srv(cmd, m_SolidWireGP, 3, moonMaterial.get_albedo_texture());
         d3d12::command_buffer::set_graphics_pipeline_texture_srv(cmd, m_SolidWireGP, 4, moonMaterial.get_elevation_sg_texture());
         d3d12::command_buffer::set_graphics_pipeline_texture_srv(cmd, m_SolidWireGP, 5, moonMaterial.get_detail_sg_texture());
+#if defined(WELDED_VERTICES)
+        d3d12::command_buffer::set_graphics_pipeline_buffer_srv(cmd, m_SolidWireGP, 6, targetMesh.vertexIndexBuffer);
+#endif
 
         // Sampler
         d3d12::command_buffer::set_graphics_pipeline_sampler(cmd, m_SolidWireGP, 0, m_LinearWrap);
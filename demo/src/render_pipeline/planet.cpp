@@ -9,6 +9,18 @@
 
 #define WORKGROUP_SIZE 64
 
+// Maximal camera rotation within an incremental classification epoch (in radians)
+#define CLASSIFICATION_ROTATION_TOLERANCE 0.01f
+
+// Relative change of the adapted triangle size per step
+#define ADAPTIVE_TRIANGLE_SIZE_STEP 0.05f
+// Number of updates between two steps, the readbacks are a few frames late and the mesh needs to converge to the new size
+#define ADAPTIVE_TRIANGLE_SIZE_SETTLE_UPDATES 8
+// Band under the limits in which the adapted triangle size is kept as is
+#define ADAPTIVE_TRIANGLE_SIZE_HYSTERESIS 0.1f
+// Maximal ratio between the adapted and the requested triangle sizes
+#define ADAPTIVE_TRIANGLE_SIZE_MAX_RATIO 16.0f
+
 // CBVs
 #define GLOBAL_CB_BINDING_SLOT CBV_SLOT(0)
 #define GEOMETRY_CB_BINDING_SLOT CBV_SLOT(1)
@@ -24,11 +36,25 @@
 
 // UAVs
 #define CURRENT_VERTEX_BUFFER_SLOT UAV_SLOT(0)
+#define LEB_POSITION_HEAP_ID_BUFFER_SLOT UAV_SLOT(1)
 
 // Counters
 #define NUM_CBV_BINDING_SLOTS 4
 #define NUM_SRV_BINDING_SLOTS 5
-#define NUM_UAV_BINDING_SLOTS 1
+#define NUM_UAV_BINDING_SLOTS 2
+
+// Bisector cluster UAVs
+#define CLUSTER_HASH_BUFFER_BINDING_SLOT UAV_SLOT(0)
+#define CLUSTER_ROOT_BUFFER_BINDING_SLOT UAV_SLOT(1)
+#define CLUSTER_ID_BUFFER_BINDING_SLOT UAV_SLOT(2)
+#define CLUSTER_SLOT_BUFFER_BINDING_SLOT UAV_SLOT(3)
+#define CLUSTER_BUFFER_BINDING_SLOT UAV_SLOT(4)
+#define CLUSTER_BOUNDS_BUFFER_BINDING_SLOT UAV_SLOT(5)
+#define CLUSTER_ELEMENT_BUFFER_BINDING_SLOT UAV_SLOT(6)
+#define CLUSTER_DRAW_BUFFER_BINDING_SLOT UAV_SLOT(7)
+#define CLUSTER_ARGS_BUFFER_BINDING_SLOT UAV_SLOT(8)
+#define INDIRECT_DISPATCH_BUFFER_BINDING_SLOT UAV_SLOT(9)
+#define NUM_CLUSTER_UAV_BINDING_SLOTS 10
 
 Planet::Planet()
 {
@@ -39,8 +65,8 @@ Planet::~Planet()
 }
 
 void Planet::initialize(GraphicsDevice device, CommandQueue cmdQ, CommandBuffer cmdB,
-                        float planetRadius, const double3& planetCenter, float toggleDistance, float triangleSize, uint32_t materialID,
-                        const CPUMesh& mesh, const CBT& cbt)
+                        float planetRadius, const double3& planetCenter, float toggleDistance, float triangleSize, float maxDisplacement, uint32_t materialID,
+                        const CPUMesh& mesh, const CBT& cbt, const CBTMeshSnapshot* snapshot)
     {
     // Keep track of the device
     m_Device = device;
@@ -49,17 +75,40 @@ void Planet::initialize(GraphicsDevice device, CommandQueue cmdQ, CommandBuffer
     m_PlanetRadius = planetRadius;
     m_PlanetCenter = planetCenter;
     m_ToggleDistance = toggleDistance;
+    m_MaxDisplacement = maxDisplacement;
     m_MaterialID = materialID;
 
     // Subdivision properties
     m_MaxSubdivisionDepth = 63;
     m_TriangleSize = triangleSize;
+    m_CompactionThreshold = 0.25f;
+    m_IncrementalClassification = false;
+    m_IncrementalLEB = true;
+    m_HorizonCulling = true;
+    m_PatchCulling = true;
+    m_SplitBudget = 0;
+    m_SimplifyBudget = 0;
+    m_PredictiveSplitBudget = 4096;
+    // An update can create one bisector every eight elements (a sixteenth starved the refinement of the demo's fast segments)
+    m_BisectionsRatio = 8;
+    m_AdaptiveTriangleSize = false;
+    m_TargetOccupancy = 0.9f;
+    m_MaxUpdateDuration = 0.0f;
+    m_AdaptedTriangleSize = triangleSize;
+    m_AdaptationUpdateIndex = 0;
+    m_SimplifyHysteresis = 0.0f;
+    m_MinBisectorAge = 0;
+    m_ChurnWindow = 8;
+    m_ClassificationEpoch = 0;
+    m_UpdateIndex = 0;
+    m_AsyncTopology = false;
 
     // Allocate the required resources
     m_GeometryCB = d3d12::graphics_resources::create_constant_buffer(device, sizeof(GeometryCB), ConstantBufferType::Mixed);
     m_PlanetCB = d3d12::graphics_resources::create_constant_buffer(device, sizeof(PlanetCB), ConstantBufferType::Mixed);
     m_UpdateCB = d3d12::graphics_resources::create_constant_buffer(device, sizeof(UpdateCB), ConstantBufferType::Mixed);
-    initialize_cbt_mesh(mesh, cbt, m_Device, cmdQ, cmdB, m_CBTMesh);
+    m_AsyncUpdateCB = d3d12::graphics_resources::create_constant_buffer(device, sizeof(UpdateCB), ConstantBufferType::Mixed);
+    initialize_cbt_mesh(mesh, cbt, m_Device, cmdQ, cmdB, mesh.totalNumElements / m_BisectionsRatio, m_CBTMesh, snapshot);
     initialize_base_mesh(mesh, m_Device, cmdQ, cmdB, m_BaseMesh);
 }
 
@@ -68,17 +117,35 @@ void Planet::release()
     release_cbt_mesh(m_CBTMesh);
     release_base_mesh(m_BaseMesh);
 
+    d3d12::graphics_resources::destroy_constant_buffer(m_AsyncUpdateCB);
     d3d12::graphics_resources::destroy_constant_buffer(m_UpdateCB);
     d3d12::graphics_resources::destroy_constant_buffer(m_PlanetCB);
     d3d12::graphics_resources::destroy_constant_buffer(m_GeometryCB);
     d3d12::compute_shader::destroy_compute_shader(m_LebEvalCS);
     d3d12::compute_shader::destroy_compute_shader(m_ClearCS);
+#if defined(BISECTOR_CLUSTERS)
+    d3d12::compute_shader::destroy_compute_shader(m_ScatterClustersCS);
+    d3d12::compute_shader::destroy_compute_shader(m_PlaceClustersCS);
+    d3d12::compute_shader::destroy_compute_shader(m_PrepareClusterIndirectCS);
+    d3d12::compute_shader::destroy_compute_shader(m_CountClustersCS);
+    d3d12::compute_shader::destroy_compute_shader(m_InsertClustersCS);
+    d3d12::compute_shader::destroy_compute_shader(m_ClearClustersCS);
+#endif
 
+    m_AsyncUpdateCB = 0;
     m_UpdateCB = 0;
     m_PlanetCB = 0;
     m_GeometryCB = 0;
     m_LebEvalCS = 0;
     m_ClearCS = 0;
+#if defined(BISECTOR_CLUSTERS)
+    m_ScatterClustersCS = 0;
+    m_PlaceClustersCS = 0;
+    m_PrepareClusterIndirectCS = 0;
+    m_CountClustersCS = 0;
+    m_InsertClustersCS = 0;
+    m_ClearClustersCS = 0;
+#endif
 }
 
 void Planet::reload_shaders(const std::string& shaderLibrary)
@@ -88,19 +155,92 @@ void Planet::reload_shaders(const std::string& shaderLibrary)
     csd.filename = shaderLibrary + "\\PlanetGeometry.compute";
     csd.cbvCount = 4;
     csd.srvCount = 5;
-    csd.uavCount = 1;
+    csd.uavCount = 2;
 
     csd.kernelname = "EvaluateLEB";
     compile_and_replace_compute_shader(m_Device, csd, m_LebEvalCS);
 
     csd.kernelname = "ClearBuffer";
     compile_and_replace_compute_shader(m_Device, csd, m_ClearCS);
+
+#if defined(BISECTOR_CLUSTERS)
+    csd.filename = shaderLibrary + "\\BisectorClusters.compute";
+    csd.srvCount = 4;
+    csd.uavCount = NUM_CLUSTER_UAV_BINDING_SLOTS;
+
+    csd.kernelname = "ClearClusters";
+    compile_and_replace_compute_shader(m_Device, csd, m_ClearClustersCS);
+
+    csd.kernelname = "InsertClusters";
+    compile_and_replace_compute_shader(m_Device, csd, m_InsertClustersCS);
+
+    csd.kernelname = "CountClusters";
+    compile_and_replace_compute_shader(m_Device, csd, m_CountClustersCS);
+
+    csd.kernelname = "PrepareClusterIndirect";
+    compile_and_replace_compute_shader(m_Device, csd, m_PrepareClusterIndirectCS);
+
+    csd.kernelname = "PlaceClusters";
+    compile_and_replace_compute_shader(m_Device, csd, m_PlaceClustersCS);
+
+    csd.kernelname = "ScatterClusters";
+    compile_and_replace_compute_shader(m_Device, csd, m_ScatterClustersCS);
+#endif
 }
 
 void Planet::render_ui(const char* planetName)
 {
     ImGui::SliderInt((std::string("Max Depth ") + planetName).c_str(), &m_MaxSubdivisionDepth, m_CBTMesh.baseDepth, 63);
     ImGui::SliderFloat((std::string("Triangle Size ") + planetName).c_str(), &m_TriangleSize, 10.0f, 200.0f);
+    ImGui::Checkbox((std::string("Adaptive Triangle Size ") + planetName).c_str(), &m_AdaptiveTriangleSize);
+    if (m_AdaptiveTriangleSize)
+    {
+        ImGui::SliderFloat((std::string("Target Occupancy ") + planetName).c_str(), &m_TargetOccupancy, 0.1f, 1.0f);
+        ImGui::InputFloat((std::string("Max Update Duration (us) ") + planetName).c_str(), &m_MaxUpdateDuration);
+        std::string adaptedSize = "Adapted Triangle Size " + std::to_string(get_triangle_size());
+        ImGui::Text(adaptedSize.c_str());
+    }
+    ImGui::SliderFloat((std::string("Compaction Threshold ") + planetName).c_str(), &m_CompactionThreshold, 0.0f, 4.0f);
+    ImGui::Checkbox((std::string("Incremental Classification ") + planetName).c_str(), &m_IncrementalClassification);
+    ImGui::Checkbox((std::string("Incremental LEB ") + planetName).c_str(), &m_IncrementalLEB);
+    ImGui::Checkbox((std::string("Horizon Culling ") + planetName).c_str(), &m_HorizonCulling);
+    ImGui::Checkbox((std::string("Patch Culling ") + planetName).c_str(), &m_PatchCulling);
+    ImGui::InputInt((std::string("Split Budget ") + planetName).c_str(), &m_SplitBudget);
+    ImGui::InputInt((std::string("Simplify Budget ") + planetName).c_str(), &m_SimplifyBudget);
+    ImGui::InputInt((std::string("Predictive Split Budget ") + planetName).c_str(), &m_PredictiveSplitBudget);
+    ImGui::SliderInt((std::string("Bisections Ratio ") + planetName).c_str(), &m_BisectionsRatio, 1, 64);
+    ImGui::SliderFloat((std::string("Simplify Hysteresis ") + planetName).c_str(), &m_SimplifyHysteresis, 0.0f, 0.5f);
+    ImGui::InputInt((std::string("Min Bisector Age ") + planetName).c_str(), &m_MinBisectorAge);
+    ImGui::InputInt((std::string("Churn Window ") + planetName).c_str(), &m_ChurnWindow);
+}
+
+float Planet::get_triangle_size() const
+{
+    // The adapted triangle size is never finer than the requested one
+    return m_AdaptiveTriangleSize ? fmaxf(m_AdaptedTriangleSize, m_TriangleSize) : m_TriangleSize;
+}
+
+void Planet::adapt_triangle_size(uint32_t occupancy, uint64_t updateDuration)
+{
+    // The measures still describe the mesh before the previous step
+    if (m_UpdateIndex - m_AdaptationUpdateIndex < ADAPTIVE_TRIANGLE_SIZE_SETTLE_UPDATES)
+        return;
+
+    // Usage of the limits (the update duration isn't limited if it is not set)
+    float occupancyRatio = occupancy / (float)m_CBTMesh.gpuCBT.numElements / fmaxf(m_TargetOccupancy, 0.01f);
+    float durationRatio = m_MaxUpdateDuration > 0.0f ? updateDuration / m_MaxUpdateDuration : 0.0f;
+    float pressure = fmaxf(occupancyRatio, durationRatio);
+
+    // Coarsen the mesh above the limits and refine it back once it is comfortably under them
+    float triangleSize = get_triangle_size();
+    if (pressure > 1.0f)
+        triangleSize *= 1.0f + ADAPTIVE_TRIANGLE_SIZE_STEP;
+    else if (pressure < 1.0f - ADAPTIVE_TRIANGLE_SIZE_HYSTERESIS)
+        triangleSize /= 1.0f + ADAPTIVE_TRIANGLE_SIZE_STEP;
+    triangleSize = fminf(fmaxf(triangleSize, m_TriangleSize), m_TriangleSize * ADAPTIVE_TRIANGLE_SIZE_MAX_RATIO);
+    if (triangleSize != get_triangle_size())
+        m_AdaptationUpdateIndex = m_UpdateIndex;
+    m_AdaptedTriangleSize = triangleSize;
 }
 
 void Planet::upload_static_constant_buffers(CommandBuffer cmd)
@@ -112,27 +252,86 @@ void Planet::upload_static_constant_buffers(CommandBuffer cmd)
     d3d12::graphics_resources::set_constant_buffer(m_PlanetCB, (const char*)&earthCB, sizeof(PlanetCB));
     d3d12::command_buffer::upload_constant_buffer(cmd, m_PlanetCB);
 
-    // This constant buffer only needs to be set once
+    // This constant buffer only needs to be set again when the neighbors update buffer is resized
+    upload_geometry_cb(cmd);
+}
+
+void Planet::upload_geometry_cb(CommandBuffer cmd)
+{
     GeometryCB geometryCB;
     geometryCB._TotalNumElements = m_CBTMesh.totalNumElements;
     geometryCB._TotalNumVertices = m_CBTMesh.totalNumElements * 3;
     geometryCB._BaseDepth = m_CBTMesh.baseDepth;
     geometryCB._MaterialID = m_MaterialID;
+    geometryCB._FirstBaseElement = m_CBTMesh.firstBaseElement;
+    geometryCB._MaxNewBisectors = m_CBTMesh.maxNewBisectors;
     d3d12::graphics_resources::set_constant_buffer(m_GeometryCB, (const char*)&geometryCB, sizeof(GeometryCB));
     d3d12::command_buffer::upload_constant_buffer(cmd, m_GeometryCB);
+    m_GeometryCBOutdated = false;
+}
+
+void Planet::resize_neighbors_update_buffer()
+{
+    // The geometry constant buffer is uploaded again before the next update
+    ::resize_neighbors_update_buffer(m_Device, m_CBTMesh, get_max_new_bisectors());
+    m_GeometryCBOutdated = true;
 }
 
-void Planet::update_constant_buffers(CommandBuffer cmd, const UpdateProperties& updateProperties)
+void Planet::update_constant_buffers(CommandBuffer cmd, const UpdateProperties& updateProperties, const std::vector<UpdateProperties>& additionalViews, const UpdateProperties* predictedView)
 {
+    // The bound on the new bisectors follows the neighbors update buffer
+    if (m_GeometryCBOutdated)
+        upload_geometry_cb(cmd);
+
     // Update constant buffer
     UpdateCB updateCB;
 
     // Camera update properties
     set_update_properties(updateProperties, updateCB);
+    set_additional_update_views(updateProperties, additionalViews, updateCB);
+    set_predicted_update_view(updateProperties, predictedView, updateCB);
 
     // Mesh properties
     updateCB._MaxSubdivisionDepth = m_MaxSubdivisionDepth;
-    updateCB._TriangleSize = m_TriangleSize;
+    updateCB._TriangleSize = get_triangle_size();
+    updateCB._CompactionThreshold = m_CompactionThreshold;
+    updateCB._IncrementalLEB = m_IncrementalLEB ? 1 : 0;
+
+    // Horizon culling properties
+    double3 planetCenterRWS = m_PlanetCenter - updateProperties.position;
+    updateCB._UpdatePlanetCenter = { (float)planetCenterRWS.x, (float)planetCenterRWS.y, (float)planetCenterRWS.z };
+    updateCB._UpdatePlanetRadius = m_PlanetRadius;
+    updateCB._MaxDisplacement = m_MaxDisplacement;
+    updateCB._HorizonCulling = m_HorizonCulling ? 1 : 0;
+    updateCB._PatchCulling = m_PatchCulling ? 1 : 0;
+
+    // Amortize the convergence over several updates (0 doesn't limit them)
+    updateCB._SplitBudget = get_split_budget();
+    updateCB._SimplifyBudget = get_simplify_budget();
+    // The early refinement of the predicted view has its own budget, within what the regular splits leave of the split budget
+    updateCB._PredictiveSplitBudget = m_PredictiveSplitBudget > 0 ? (uint32_t)m_PredictiveSplitBudget : 0;
+
+    // Split/merge hysteresis properties (index of the next update, it only advances when an update is dispatched)
+    updateCB._UpdateIndex = m_UpdateIndex + 1;
+    updateCB._MinBisectorAge = m_MinBisectorAge > 0 ? (uint32_t)m_MinBisectorAge : 0;
+    updateCB._SimplifyHysteresis = m_SimplifyHysteresis;
+    updateCB._ChurnWindow = m_ChurnWindow > 0 ? (uint32_t)m_ChurnWindow : 0;
+
+    // Incremental classification properties
+    update_classification_epoch(updateProperties);
+    // The cached areas are only measured for the update camera
+    updateCB._ClassificationEpoch = (m_IncrementalClassification && additionalViews.empty() && predictedView == nullptr) ? m_ClassificationEpoch : 0;
+    updateCB._ClassificationTravel = m_ClassificationTravel;
+
+    // The projected area of a small triangle scales with the cube of the cosine of its angle to the view axis.
+    // The widest angle is evaluated for a 21:9 aspect ratio at most.
+    float maxViewAngle = fminf(atanf(tanf(updateProperties.fov) * 2.6f), 1.4f);
+    float rotationRatio = cosf(maxViewAngle) / cosf(maxViewAngle + 2.0f * CLASSIFICATION_ROTATION_TOLERANCE);
+    updateCB._ClassificationRotationBound = rotationRatio * rotationRatio * rotationRatio;
+
+    // The frame's update is synchronous, the asynchronous one gets its own copy
+    updateCB._AsyncUpdate = 0;
+    m_UpdateCBData = updateCB;
     
     // Set
     d3d12::graphics_resources::set_constant_buffer(m_UpdateCB, (const char*)&updateCB, sizeof(UpdateCB));
@@ -141,8 +340,37 @@ void Planet::update_constant_buffers(CommandBuffer cmd, const UpdateProperties&
     d3d12::command_buffer::upload_constant_buffer(cmd, m_UpdateCB);
 }
 
+void Planet::update_classification_epoch(const UpdateProperties& updateProperties)
+{
+    // Accumulate the distance traveled by the camera, it bounds its displacement since any previous frame of the epoch
+    m_ClassificationTravel += (float)length(updateProperties.position - m_PrevCameraPosition);
+    m_PrevCameraPosition = updateProperties.position;
+
+    // Any change other than the camera position invalidates all the measured areas. The cached areas are compared to the current triangle
+    // size, so the adapted one doesn't start a new epoch at each step
+    bool newEpoch = !m_IncrementalClassification || m_ClassificationEpoch == 0
+        || dot(updateProperties.forward, m_EpochCameraForward) < cosf(CLASSIFICATION_ROTATION_TOLERANCE)
+        || updateProperties.fov != m_EpochFOV
+        || m_TriangleSize != m_EpochTriangleSize
+        || m_MaxSubdivisionDepth != m_EpochMaxSubdivisionDepth;
+    if (!newEpoch)
+        return;
+
+    // 0 is reserved for the disabled mode
+    m_ClassificationEpoch = m_ClassificationEpoch == UINT32_MAX ? 1 : m_ClassificationEpoch + 1;
+    m_ClassificationTravel = 0.0f;
+    m_EpochCameraForward = updateProperties.forward;
+    m_EpochFOV = updateProperties.fov;
+    m_EpochTriangleSize = m_TriangleSize;
+    m_EpochMaxSubdivisionDepth = m_MaxSubdivisionDepth;
+}
+
 void Planet::evaluate_leb(CommandBuffer cmdB, const Camera& camera, ConstantBuffer globalCB, GraphicsBuffer lebMatrixCache, bool clear, bool complete)
 {
+#if defined(WELDED_VERTICES)
+    // The corners of the deallocated elements are already collapsed on the first welded vertex
+    clear = false;
+#endif
     if (clear)
     {
         d3d12::command_buffer::start_section(cmdB, "Clear Buffer");
@@ -155,26 +383,165 @@ void Planet::evaluate_leb(CommandBuffer cmdB, const Camera& camera, ConstantBuff
         d3d12::command_buffer::end_section(cmdB);
     }
 
+    // Evaluate the positions of the front mesh
+    evaluate_mesh_leb(cmdB, m_CBTMesh, globalCB, m_UpdateCB, lebMatrixCache, complete);
+}
+
+void Planet::evaluate_mesh_leb(CommandBuffer cmdB, const CBTMesh& mesh, ConstantBuffer globalCB, ConstantBuffer updateCB, GraphicsBuffer lebMatrixCache, bool complete)
+{
     d3d12::command_buffer::start_section(cmdB, "Evaluate Leb");
     {
         d3d12::command_buffer::set_compute_shader_buffer_cbv(cmdB, m_LebEvalCS, 0, globalCB);
         d3d12::command_buffer::set_compute_shader_buffer_cbv(cmdB, m_LebEvalCS, 1, m_GeometryCB);
         d3d12::command_buffer::set_compute_shader_buffer_cbv(cmdB, m_LebEvalCS, 2, m_PlanetCB);
-        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmdB, m_LebEvalCS, 3, m_UpdateCB);
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmdB, m_LebEvalCS, 3, updateCB);
 
         d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_LebEvalCS, 0, m_BaseMesh.vertexBuffer);
-        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_LebEvalCS, 1, m_CBTMesh.heapIDBuffer);
-        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_LebEvalCS, 2, complete ? m_CBTMesh.indexedBisectorBuffer : m_CBTMesh.modifiedIndexedBisectorBuffer);
-        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_LebEvalCS, 3, m_CBTMesh.indirectDrawBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_LebEvalCS, 1, mesh.heapIDBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_LebEvalCS, 2, complete ? mesh.indexedBisectorBuffer : mesh.modifiedIndexedBisectorBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_LebEvalCS, 3, mesh.indirectDrawBuffer);
         d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_LebEvalCS, 4, lebMatrixCache);
 
-        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_LebEvalCS, 0, m_CBTMesh.lebVertexBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_LebEvalCS, 0, mesh.lebVertexBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_LebEvalCS, 1, mesh.lebPositionHeapIDBuffer);
+
+        d3d12::command_buffer::dispatch_indirect(cmdB, m_LebEvalCS, mesh.indirectDispatchBuffer, complete ? 0 : sizeof(uint32_t) * 6);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, mesh.lebVertexBuffer);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, mesh.lebPositionHeapIDBuffer);
+    }
+    d3d12::command_buffer::end_section(cmdB);
+}
+
+#if defined(BISECTOR_CLUSTERS)
+void Planet::build_clusters(CommandBuffer cmdB, ConstantBuffer globalCB)
+{
+    d3d12::command_buffer::start_section(cmdB, "Build Clusters");
+    {
+        // Reset the cluster table and evaluate the cluster root of every indexed bisector
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmdB, m_ClearClustersCS, GEOMETRY_CB_BINDING_SLOT, m_GeometryCB);
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_ClearClustersCS, HEAP_ID_BUFFER_BINDING_SLOT, m_AsyncTopology ? m_CBTMesh.clusterHeapIDBuffer : m_CBTMesh.heapIDBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_ClearClustersCS, INDEXED_BISECTOR_BUFFER_BINDING_SLOT, m_CBTMesh.indexedBisectorBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_ClearClustersCS, INDIRECT_DRAW_BUFFER_BINDING_SLOT, m_CBTMesh.indirectDrawBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_ClearClustersCS, CLUSTER_HASH_BUFFER_BINDING_SLOT, m_CBTMesh.clusterHashBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_ClearClustersCS, CLUSTER_ROOT_BUFFER_BINDING_SLOT, m_CBTMesh.clusterRootBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_ClearClustersCS, CLUSTER_ARGS_BUFFER_BINDING_SLOT, m_CBTMesh.clusterArgsBuffer);
+        d3d12::command_buffer::dispatch(cmdB, m_ClearClustersCS, (CLUSTER_HASH_LOAD_RATIO * m_CBTMesh.totalNumElements + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.clusterHashBuffer);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.clusterRootBuffer);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.clusterArgsBuffer);
+
+        // The first bisector of every cluster allocates it
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmdB, m_InsertClustersCS, GEOMETRY_CB_BINDING_SLOT, m_GeometryCB);
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_InsertClustersCS, INDIRECT_DRAW_BUFFER_BINDING_SLOT, m_CBTMesh.indirectDrawBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_InsertClustersCS, CLUSTER_HASH_BUFFER_BINDING_SLOT, m_CBTMesh.clusterHashBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_InsertClustersCS, CLUSTER_ROOT_BUFFER_BINDING_SLOT, m_CBTMesh.clusterRootBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_InsertClustersCS, CLUSTER_ID_BUFFER_BINDING_SLOT, m_CBTMesh.clusterIDBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_InsertClustersCS, CLUSTER_BUFFER_BINDING_SLOT, m_CBTMesh.clusterBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_InsertClustersCS, CLUSTER_ARGS_BUFFER_BINDING_SLOT, m_CBTMesh.clusterArgsBuffer);
+        d3d12::command_buffer::dispatch_indirect(cmdB, m_InsertClustersCS, m_CBTMesh.indirectDispatchBuffer);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.clusterHashBuffer);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.clusterIDBuffer);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.clusterBuffer);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.clusterArgsBuffer);
 
-        d3d12::command_buffer::dispatch_indirect(cmdB, m_LebEvalCS, m_CBTMesh.indirectDispatchBuffer, complete ? 0 : sizeof(uint32_t) * 6);
-        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.currentVertexBuffer);
+        // Count the bisectors of every cluster
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmdB, m_CountClustersCS, GEOMETRY_CB_BINDING_SLOT, m_GeometryCB);
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_CountClustersCS, INDIRECT_DRAW_BUFFER_BINDING_SLOT, m_CBTMesh.indirectDrawBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_CountClustersCS, CLUSTER_HASH_BUFFER_BINDING_SLOT, m_CBTMesh.clusterHashBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_CountClustersCS, CLUSTER_ROOT_BUFFER_BINDING_SLOT, m_CBTMesh.clusterRootBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_CountClustersCS, CLUSTER_ID_BUFFER_BINDING_SLOT, m_CBTMesh.clusterIDBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_CountClustersCS, CLUSTER_SLOT_BUFFER_BINDING_SLOT, m_CBTMesh.clusterSlotBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_CountClustersCS, CLUSTER_BUFFER_BINDING_SLOT, m_CBTMesh.clusterBuffer);
+        d3d12::command_buffer::dispatch_indirect(cmdB, m_CountClustersCS, m_CBTMesh.indirectDispatchBuffer);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.clusterSlotBuffer);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.clusterBuffer);
+
+        // Indirect dispatch for each cluster
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_PrepareClusterIndirectCS, CLUSTER_ARGS_BUFFER_BINDING_SLOT, m_CBTMesh.clusterArgsBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_PrepareClusterIndirectCS, INDIRECT_DISPATCH_BUFFER_BINDING_SLOT, m_CBTMesh.indirectDispatchBuffer);
+        d3d12::command_buffer::dispatch(cmdB, m_PrepareClusterIndirectCS, 1, 1, 1);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.indirectDispatchBuffer);
+
+        // Allocate the range of every cluster, evaluate its bounds and cull it
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmdB, m_PlaceClustersCS, GLOBAL_CB_BINDING_SLOT, globalCB);
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmdB, m_PlaceClustersCS, GEOMETRY_CB_BINDING_SLOT, m_GeometryCB);
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmdB, m_PlaceClustersCS, PLANET_CB_BINDING_SLOT, m_PlanetCB);
+        d3d12::command_buffer::set_compute_shader_buffer_cbv(cmdB, m_PlaceClustersCS, UPDATE_CB_BINDING_SLOT, m_UpdateCB);
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_PlaceClustersCS, BASE_VERTEX_BUFFER_BINDING_SLOT, m_BaseMesh.vertexBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_PlaceClustersCS, CLUSTER_ROOT_BUFFER_BINDING_SLOT, m_CBTMesh.clusterRootBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_PlaceClustersCS, CLUSTER_BUFFER_BINDING_SLOT, m_CBTMesh.clusterBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_PlaceClustersCS, CLUSTER_BOUNDS_BUFFER_BINDING_SLOT, m_CBTMesh.clusterBoundsBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_PlaceClustersCS, CLUSTER_ARGS_BUFFER_BINDING_SLOT, m_CBTMesh.clusterArgsBuffer);
+        d3d12::command_buffer::dispatch_indirect(cmdB, m_PlaceClustersCS, m_CBTMesh.indirectDispatchBuffer, CLUSTER_DISPATCH_OFFSET * sizeof(uint32_t));
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.clusterBuffer);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.clusterBoundsBuffer);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.clusterArgsBuffer);
+
+        // Group the bisectors by cluster and gather the ones of the visible clusters
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_ScatterClustersCS, INDEXED_BISECTOR_BUFFER_BINDING_SLOT, m_CBTMesh.indexedBisectorBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_ScatterClustersCS, INDIRECT_DRAW_BUFFER_BINDING_SLOT, m_CBTMesh.indirectDrawBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_ScatterClustersCS, CLUSTER_SLOT_BUFFER_BINDING_SLOT, m_CBTMesh.clusterSlotBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_ScatterClustersCS, CLUSTER_BUFFER_BINDING_SLOT, m_CBTMesh.clusterBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_ScatterClustersCS, CLUSTER_ELEMENT_BUFFER_BINDING_SLOT, m_CBTMesh.clusterElementBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_ScatterClustersCS, CLUSTER_DRAW_BUFFER_BINDING_SLOT, m_CBTMesh.clusterDrawBuffer);
+        d3d12::command_buffer::dispatch_indirect(cmdB, m_ScatterClustersCS, m_CBTMesh.indirectDispatchBuffer);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.clusterElementBuffer);
+        d3d12::command_buffer::uav_barrier_buffer(cmdB, m_CBTMesh.clusterDrawBuffer);
     }
     d3d12::command_buffer::end_section(cmdB);
 }
+#endif
+
+void Planet::prepare_async_update(CommandBuffer cmdB)
+{
+    // Make sure the back buffers exist
+    initialize_async_update_buffers(m_Device, m_CBTMesh);
+
+    // Snapshot the front topology
+    ::prepare_async_update(cmdB, m_CBTMesh);
+
+#if defined(BISECTOR_CLUSTERS)
+    // The first update starts from the topology of the synchronous ones, its heapIDs are rewritten from now on
+    if (!m_AsyncTopology)
+        d3d12::command_buffer::copy_graphics_buffer(cmdB, m_CBTMesh.heapIDBuffer, m_CBTMesh.clusterHeapIDBuffer);
+#endif
+    m_AsyncTopology = true;
+}
+
+void Planet::async_update(CommandBuffer cmdB, MeshUpdater& meshUpdater, ConstantBuffer globalCB, GraphicsBuffer lebMatrixCache, bool compact)
+{
+    // The update properties are frozen for the whole update
+    UpdateCB updateCB = m_UpdateCBData;
+    updateCB._AsyncUpdate = 1;
+    d3d12::graphics_resources::set_constant_buffer(m_AsyncUpdateCB, (const char*)&updateCB, sizeof(UpdateCB));
+    d3d12::command_buffer::upload_constant_buffer(cmdB, m_AsyncUpdateCB);
+
+    // Update the back buffers
+    CBTMesh asyncMesh = async_update_mesh(m_CBTMesh);
+    meshUpdater.update(cmdB, asyncMesh, globalCB, m_GeometryCB, m_AsyncUpdateCB, compact);
+
+    // The back positions are two updates late, they all need to be evaluated
+    evaluate_mesh_leb(cmdB, asyncMesh, globalCB, m_AsyncUpdateCB, lebMatrixCache, true);
+
+#if defined(BISECTOR_CLUSTERS)
+    // The clusters are built on the direct queue while the next update rewrites the heapIDs
+    d3d12::command_buffer::copy_graphics_buffer(cmdB, asyncMesh.heapIDBuffer, asyncMesh.clusterHeapIDBuffer);
+#endif
+
+    // The ages of the bisectors are counted in updates
+    m_UpdateIndex++;
+}
+
+void Planet::complete_async_update()
+{
+    swap_async_update_buffers(m_CBTMesh);
+}
+
+void Planet::complete_update()
+{
+    m_UpdateIndex++;
+    m_AsyncTopology = false;
+}
 
 void Planet::planet_visibility(const Camera& camera, double& distance, bool& visible, bool& updatable) const
 {
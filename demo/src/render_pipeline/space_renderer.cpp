@@ -28,6 +28,8 @@ enum class ProfilingScopes
     Moon_Update,
     Moon_Deformation,
 
+    Derive_Adjacency,
+
     Total,
     Count
 };
@@ -75,6 +77,13 @@ void SpaceRenderer::initialize(HINSTANCE hInstance, const char* projectDirectory
     // Other rendering resources
     m_GlobalCB = d3d12::graphics_resources::create_constant_buffer(m_Device, sizeof(GlobalCB), ConstantBufferType::Mixed);
 
+    // Asynchronous update resources
+    m_AsyncCmdBuffer = d3d12::command_buffer::create_command_buffer(m_Device, CommandBufferType::Compute);
+    m_AsyncGlobalCB = d3d12::graphics_resources::create_constant_buffer(m_Device, sizeof(GlobalCB), ConstantBufferType::Mixed);
+    m_AsyncFence = d3d12::fence::create_fence(m_Device);
+    m_AsyncFenceValue = 0;
+    m_AsyncUpdateInFlight = false;
+
     // Allocate the render textures
     {
         TextureDescriptor descriptor;
@@ -113,9 +122,23 @@ void SpaceRenderer::initialize(HINSTANCE hInstance, const char* projectDirectory
     m_FrameIndex = UINT32_MAX;
     m_Time = 0.0;
     m_ActiveUpdate = true;
+    m_WarmStart = true;
+    m_SaveSnapshots = false;
+    m_ExportDisplacement = true;
+    m_ExportFormat = MeshExportFormat::Count;
     m_RayTracingPath = false;
     m_EnableValidation = false;
+    m_DeriveAdjacency = false;
     m_EnableOccupancy = false;
+    m_EnableConvergence = false;
+    m_ConvergenceFrames = 0;
+    m_UnderRefinedFraction = 0.0f;
+    m_PredictiveRefinement = false;
+    m_LookaheadTime = 0.5f;
+    m_CompactionInterval = 256;
+    m_UpdateCounter = 0;
+    m_AsyncUpdate = false;
+    m_BatchedUpdate = false;
     m_DisplayUI = true;
     m_MirrorPOV = true;
 
@@ -166,6 +189,9 @@ void SpaceRenderer::initialize(HINSTANCE hInstance, const char* projectDirectory
 
 void SpaceRenderer::reload_shaders()
 {
+    // The shaders may be in use by the asynchronous update
+    complete_async_update(true);
+
     // Location of the shader library
     std::string shaderLibrary = m_ProjectDir;
     shaderLibrary += "\\shaders";
@@ -200,7 +226,7 @@ void SpaceRenderer::reload_shaders()
     // Individual components
     m_WaterSim.reload_shaders(shaderLibrary);
     m_Cubemap.reload_shaders(shaderLibrary);
-    m_MeshUpdater.reload_shaders(shaderLibrary, m_CBTType);
+    m_MeshUpdater.reload_shaders(shaderLibrary, m_CBTType, m_EarthPlanet.get_cbt_mesh().packedNeighbors);
     m_Sky.reload_shaders(shaderLibrary);
     m_MipBuilder.reload_shaders(shaderLibrary);
 }
@@ -213,38 +239,27 @@ void SpaceRenderer::initialize_geometry()
 
     // Load the planet model
     std::string planetMeshPath = m_ProjectDir + "\\models\\icosahedron.ccm";
-    CPUMesh planetCPUMesh;
-    load_cpu_mesh(planetMeshPath.c_str(), cbtNumElements, planetCPUMesh);
+    load_cpu_mesh(planetMeshPath.c_str(), cbtNumElements, m_PlanetCPUMesh);
+
+    // Start from the refined state of the last session if it was saved for this layout
+    CBTMeshSnapshot earthSnapshot, moonSnapshot;
+    bool earthWarmStart = m_WarmStart && load_cbt_mesh_snapshot(snapshot_path("earth").c_str(), earthSnapshot) && cbt_mesh_snapshot_matches(earthSnapshot, m_PlanetCPUMesh, *cbt);
+    bool moonWarmStart = m_WarmStart && load_cbt_mesh_snapshot(snapshot_path("moon").c_str(), moonSnapshot) && cbt_mesh_snapshot_matches(moonSnapshot, m_PlanetCPUMesh, *cbt);
 
     // Initialize the earth
-    m_EarthPlanet.initialize(m_Device, m_CmdQueue, m_CmdBuffer, g_EarthRadius, g_EarthCenter, g_EarthImpostorToggle, g_EarthTriangleSize, EARTH_MATERIAL, planetCPUMesh, *cbt);
+    m_EarthPlanet.initialize(m_Device, m_CmdQueue, m_CmdBuffer, g_EarthRadius, g_EarthCenter, g_EarthImpostorToggle, g_EarthTriangleSize, g_EarthMaxDisplacement, EARTH_MATERIAL, m_PlanetCPUMesh, *cbt, earthWarmStart ? &earthSnapshot : nullptr);
 
     // Initialize the moon
-    m_MoonPlanet.initialize(m_Device, m_CmdQueue, m_CmdBuffer, g_MoonRadius, g_MoonCenter, g_MoonImpostorToggle, g_MoonTriangleSize, MOON_MATERIAL, planetCPUMesh, *cbt);
+    m_MoonPlanet.initialize(m_Device, m_CmdQueue, m_CmdBuffer, g_MoonRadius, g_MoonCenter, g_MoonImpostorToggle, g_MoonTriangleSize, g_MoonMaxDisplacement, MOON_MATERIAL, m_PlanetCPUMesh, *cbt, moonWarmStart ? &moonSnapshot : nullptr);
 
     // delete the CBT instance
     delete cbt;
 
     // Create the acceleration structures
     if (m_RayTracingSupported)
-    {
-        // Earth mesh
-        const CBTMesh& earthMesh = m_EarthPlanet.get_cbt_mesh();
-        const BaseMesh& earthBaseMesh = m_EarthPlanet.get_base_mesh();
-        m_EarthBLAS = d3d12::graphics_resources::create_blas(m_Device, earthMesh.currentVertexBuffer, earthMesh.totalNumElements * 3, earthBaseMesh.indexBuffer, earthMesh.totalNumElements);
-
-        // Moon mesh
-        const CBTMesh& moonMesh = m_MoonPlanet.get_cbt_mesh();
-        const BaseMesh& moonBaseMesh = m_MoonPlanet.get_base_mesh();
-        m_MoonBLAS = d3d12::graphics_resources::create_blas(m_Device, moonMesh.currentVertexBuffer, moonMesh.totalNumElements * 3, moonBaseMesh.indexBuffer, moonMesh.totalNumElements);
-
-        // Create the tlas
-        m_TLAS = d3d12::graphics_resources::create_tlas(m_Device, 2);
-        d3d12::graphics_resources::set_tlas_instance(m_TLAS, m_EarthBLAS, 0);
-        d3d12::graphics_resources::set_tlas_instance(m_TLAS, m_MoonBLAS, 1);
-        d3d12::graphics_resources::upload_tlas_instance_data(m_TLAS);
-    }
+        create_acceleration_structures();
 }
+
 void SpaceRenderer::release_geometry()
 {
     m_EarthPlanet.release();
@@ -252,15 +267,82 @@ void SpaceRenderer::release_geometry()
 
     // Destroy the acceleration structures
     if (m_RayTracingSupported)
+        release_acceleration_structures();
+}
+
+void SpaceRenderer::create_acceleration_structures()
+{
+    // Earth mesh
+    const CBTMesh& earthMesh = m_EarthPlanet.get_cbt_mesh();
+#if defined(WELDED_VERTICES)
+    // The corner indices of the elements are laid out like a per-element index buffer
+    m_EarthBLAS = select_blas(earthMesh, m_EarthBLASArray, m_EarthBLASIndexBuffer);
+#else
+    const BaseMesh& earthBaseMesh = m_EarthPlanet.get_base_mesh();
+    m_EarthBLAS = d3d12::graphics_resources::create_blas(m_Device, earthMesh.currentVertexBuffer, earthMesh.totalNumElements * 3, earthBaseMesh.indexBuffer, earthMesh.totalNumElements);
+#endif
+
+    // Moon mesh
+    const CBTMesh& moonMesh = m_MoonPlanet.get_cbt_mesh();
+#if defined(WELDED_VERTICES)
+    m_MoonBLAS = select_blas(moonMesh, m_MoonBLASArray, m_MoonBLASIndexBuffer);
+#else
+    const BaseMesh& moonBaseMesh = m_MoonPlanet.get_base_mesh();
+    m_MoonBLAS = d3d12::graphics_resources::create_blas(m_Device, moonMesh.currentVertexBuffer, moonMesh.totalNumElements * 3, moonBaseMesh.indexBuffer, moonMesh.totalNumElements);
+#endif
+
+    // Create the tlas
+    m_TLAS = d3d12::graphics_resources::create_tlas(m_Device, 2);
+    d3d12::graphics_resources::set_tlas_instance(m_TLAS, m_EarthBLAS, 0);
+    d3d12::graphics_resources::set_tlas_instance(m_TLAS, m_MoonBLAS, 1);
+    d3d12::graphics_resources::upload_tlas_instance_data(m_TLAS);
+}
+
+void SpaceRenderer::release_acceleration_structures()
+{
+#if defined(WELDED_VERTICES)
+    for (uint32_t blasIdx = 0; blasIdx < 2; ++blasIdx)
     {
-        d3d12::graphics_resources::destroy_blas(m_EarthBLAS);
-        d3d12::graphics_resources::destroy_blas(m_MoonBLAS);
-        d3d12::graphics_resources::destroy_tlas(m_TLAS);
+        if (m_EarthBLASArray[blasIdx] != 0)
+            d3d12::graphics_resources::destroy_blas(m_EarthBLASArray[blasIdx]);
+        if (m_MoonBLASArray[blasIdx] != 0)
+            d3d12::graphics_resources::destroy_blas(m_MoonBLASArray[blasIdx]);
+        m_EarthBLASArray[blasIdx] = 0;
+        m_MoonBLASArray[blasIdx] = 0;
+        m_EarthBLASIndexBuffer[blasIdx] = 0;
+        m_MoonBLASIndexBuffer[blasIdx] = 0;
     }
+#else
+    d3d12::graphics_resources::destroy_blas(m_EarthBLAS);
+    d3d12::graphics_resources::destroy_blas(m_MoonBLAS);
+#endif
+    d3d12::graphics_resources::destroy_tlas(m_TLAS);
 }
 
+#if defined(WELDED_VERTICES)
+BottomLevelAS SpaceRenderer::select_blas(const CBTMesh& mesh, BottomLevelAS* blasArray, GraphicsBuffer* indexBufferArray)
+{
+    // Structure created with the current vertex indices
+    for (uint32_t blasIdx = 0; blasIdx < 2; ++blasIdx)
+    {
+        if (indexBufferArray[blasIdx] == mesh.vertexIndexBuffer)
+            return blasArray[blasIdx];
+    }
+
+    // The back vertex indices are allocated by the first asynchronous update, their structure is created on first use
+    uint32_t blasIdx = blasArray[0] == 0 ? 0 : 1;
+    assert_msg(blasArray[blasIdx] == 0, "The vertex indices don't match any of the bottom level structures.");
+    blasArray[blasIdx] = d3d12::graphics_resources::create_blas(m_Device, mesh.currentVertexBuffer, current_vertex_capacity(mesh), mesh.vertexIndexBuffer, mesh.totalNumElements);
+    indexBufferArray[blasIdx] = mesh.vertexIndexBuffer;
+    return blasArray[blasIdx];
+}
+#endif
+
 void SpaceRenderer::reset_cbt_type()
 {
+    // The buffers may be in use by the asynchronous update
+    complete_async_update(true);
+
     release_geometry();
     m_CBTType = m_NewCBTType;
     initialize_geometry();
@@ -268,15 +350,65 @@ void SpaceRenderer::reset_cbt_type()
     // Location of the shader library
     std::string shaderLibrary = m_ProjectDir;
     shaderLibrary += "\\shaders";
-    m_MeshUpdater.reload_shaders(shaderLibrary, m_CBTType);
+    m_MeshUpdater.reload_shaders(shaderLibrary, m_CBTType, m_EarthPlanet.get_cbt_mesh().packedNeighbors);
     m_EarthPlanet.reload_shaders(shaderLibrary);
     m_MoonPlanet.reload_shaders(shaderLibrary);
 
     prepare_rendering(m_CmdBuffer);
 }
 
+std::string SpaceRenderer::snapshot_path(const char* planetName) const
+{
+    // One snapshot per planet and CBT size
+    return m_ProjectDir + "\\models\\" + planetName + "_" + std::to_string(cbt_num_elements(m_CBTType)) + ".snapshot";
+}
+
+void SpaceRenderer::save_snapshots()
+{
+    // The buffers may be in use by the asynchronous update
+    complete_async_update(true);
+
+    CBTMeshSnapshot snapshot;
+    capture_cbt_mesh_snapshot(m_EarthPlanet.get_cbt_mesh(), m_Device, m_CmdQueue, m_CmdBuffer, snapshot);
+    save_cbt_mesh_snapshot(snapshot, snapshot_path("earth").c_str());
+    capture_cbt_mesh_snapshot(m_MoonPlanet.get_cbt_mesh(), m_Device, m_CmdQueue, m_CmdBuffer, snapshot);
+    save_cbt_mesh_snapshot(snapshot, snapshot_path("moon").c_str());
+}
+
+void SpaceRenderer::export_meshes(MeshExportFormat format)
+{
+    // The buffers may be in use by the asynchronous update
+    complete_async_update(true);
+
+    // Export both planets in their own space
+    const char* extension = format == MeshExportFormat::OBJ ? ".obj" : ".mesh";
+    std::vector<uint64_t> heapIDArray;
+    std::vector<uint3> neighborsArray;
+    std::vector<float3> displacementArray;
+    std::vector<float3>* displacements = m_ExportDisplacement ? &displacementArray : nullptr;
+    m_ExportStats = MeshExportStats();
+
+    const Planet* planets[2] = { &m_EarthPlanet, &m_MoonPlanet };
+    const char* planetNames[2] = { "earth", "moon" };
+    const float planetRadii[2] = { g_EarthRadius, g_MoonRadius };
+    for (uint32_t planetIdx = 0; planetIdx < 2; ++planetIdx)
+    {
+        readback_cbt_mesh_bisectors(planets[planetIdx]->get_cbt_mesh(), m_Device, m_CmdQueue, m_CmdBuffer, heapIDArray, neighborsArray, displacements);
+        std::string exportPath = m_ProjectDir + "\\models\\" + planetNames[planetIdx] + "_export" + extension;
+        MeshExportStats planetStats;
+        export_bisector_mesh(m_PlanetCPUMesh, heapIDArray, neighborsArray, displacements != nullptr ? displacementArray.data() : nullptr, planetRadii[planetIdx], format, exportPath.c_str(), planetStats);
+        m_ExportStats.numTriangles += planetStats.numTriangles;
+        m_ExportStats.numVertices += planetStats.numVertices;
+        m_ExportStats.fileSize += planetStats.fileSize;
+        m_ExportStats.duration += planetStats.duration;
+    }
+}
+
 void SpaceRenderer::release()
 {
+    // Make sure the asynchronous update is done
+    complete_async_update(true);
+
     // Destroy the profiling helper
     m_ProfilingHelper.release();
 
@@ -320,6 +452,11 @@ void SpaceRenderer::release()
     d3d12::graphics_resources::destroy_render_texture(m_DepthBuffer);
     d3d12::graphics_resources::destroy_constant_buffer(m_GlobalCB);
 
+    // Asynchronous update resources
+    d3d12::fence::destroy_fence(m_AsyncFence);
+    d3d12::graphics_resources::destroy_constant_buffer(m_AsyncGlobalCB);
+    d3d12::command_buffer::destroy_command_buffer(m_AsyncCmdBuffer);
+
     // Generic graphics api cleanup
     d3d12::swap_chain::destroy_swap_chain(m_SwapChain);
     d3d12::command_buffer::destroy_command_buffer(m_CmdBuffer);
@@ -354,7 +491,30 @@ void SpaceRenderer::render_ui(CommandBuffer cmd, RenderTexture rTexture)
 
             ImGui::SeparatorText("CBT");
             ImGui::Checkbox("Update CBT", &m_ActiveUpdate);
+            ImGui::Checkbox("Async Update", &m_AsyncUpdate);
+            ImGui::Checkbox("Batched Update", &m_BatchedUpdate);
             ImGui::Checkbox("Enable Validation", &m_EnableValidation);
+            if (m_EnableValidation)
+            {
+                ImGui::Checkbox("Derive Adjacency", &m_DeriveAdjacency);
+                if (m_DeriveAdjacency)
+                {
+                    std::string mismatches = "Adjacency mismatches " + std::to_string(m_MeshUpdater.get_derived_adjacency_mismatches());
+                    ImGui::Text(mismatches.c_str());
+
+                    // Memory of the neighbors against the one of the heapID table that replaces them
+                    const CBTMesh& earthMesh = m_EarthPlanet.get_cbt_mesh();
+                    const CBTMesh& moonMesh = m_MoonPlanet.get_cbt_mesh();
+                    uint64_t numElements = (uint64_t)earthMesh.totalNumElements + moonMesh.totalNumElements;
+                    uint64_t neighborsMemory = (uint64_t)neighbors_element_size(earthMesh.totalNumElements) * earthMesh.totalNumElements
+                        + (uint64_t)neighbors_element_size(moonMesh.totalNumElements) * moonMesh.totalNumElements;
+                    uint64_t hashMemory = HEAP_ID_HASH_LOAD_RATIO * sizeof(uint32_t) * numElements;
+                    std::string memory = "Neighbors " + std::to_string(neighborsMemory >> 10) + " KB / Table " + std::to_string(hashMemory >> 10) + " KB";
+                    ImGui::Text(memory.c_str());
+                    std::string duration = "Derivation " + std::to_string(m_ProfilingHelper.get_scope_last_duration((uint32_t)ProfilingScopes::Derive_Adjacency)) + "(us)";
+                    ImGui::Text(duration.c_str());
+                }
+            }
             ImGui::Checkbox("Enable Occupancy", &m_EnableOccupancy);
             if (m_EnableOccupancy)
             {
@@ -362,7 +522,60 @@ void SpaceRenderer::render_ui(CommandBuffer cmd, RenderTexture rTexture)
                 occupancy += std::to_string(m_Occupancy);
                 ImGui::Text(occupancy.c_str());
             }
+            ImGui::Checkbox("Enable Convergence", &m_EnableConvergence);
+            if (m_EnableConvergence)
+            {
+                std::string requests = "Requests " + std::to_string(m_SplitRequests) + " / " + std::to_string(m_SimplifyRequests);
+                ImGui::Text(requests.c_str());
+                std::string convergence = m_ConvergenceFrames == 0 ? "Converged" : ("Converging for " + std::to_string(m_ConvergenceFrames) + " frames");
+                ImGui::Text(convergence.c_str());
+                std::string churn = "Churn " + std::to_string(m_SplitMergeChurn) + " / " + std::to_string(m_MergeSplitChurn);
+                ImGui::Text(churn.c_str());
+                std::string underRefined = "Under-refined " + to_string_with_precision(m_UnderRefinedFraction * 100.0f, 2) + "%";
+                ImGui::Text(underRefined.c_str());
+            }
+            ImGui::InputInt("Compaction Interval", &m_CompactionInterval);
+            ImGui::Checkbox("Warm Start", &m_WarmStart);
+            if (ImGui::Button("Save Snapshots"))
+                m_SaveSnapshots = true;
+            ImGui::SameLine();
+            if (ImGui::Button("Benchmark Snapshots"))
+                benchmark_cbt_mesh_snapshots((m_ProjectDir + "\\models\\benchmark.snapshot").c_str(), m_SnapshotBenchmarks);
+            for (const SnapshotBenchmark& benchmark : m_SnapshotBenchmarks)
+            {
+                std::string timings = std::to_string(benchmark.numElements >> 10) + "K " + std::to_string(benchmark.fileSize >> 20) + "MB: "
+                    + to_string_with_precision(benchmark.compactDuration, 1) + " / " + to_string_with_precision(benchmark.saveDuration, 1) + " / "
+                    + to_string_with_precision(benchmark.loadDuration, 1) + " / " + to_string_with_precision(benchmark.expandDuration, 1) + "(ms)";
+                ImGui::Text(timings.c_str());
+            }
+            ImGui::Checkbox("Export Displacement", &m_ExportDisplacement);
+            if (ImGui::Button("Export OBJ"))
+                m_ExportFormat = MeshExportFormat::OBJ;
+            ImGui::SameLine();
+            if (ImGui::Button("Export Binary"))
+                m_ExportFormat = MeshExportFormat::Binary;
+            if (m_ExportStats.numTriangles != 0)
+            {
+                std::string exported = "Exported " + std::to_string(m_ExportStats.numTriangles) + " triangles, " + std::to_string(m_ExportStats.fileSize >> 20) + "MB in "
+                    + to_string_with_precision(m_ExportStats.duration, 1) + "(ms)";
+                ImGui::Text(exported.c_str());
+            }
             ImGui::Checkbox("Miror VP", &m_MirrorPOV);
+            ImGui::Checkbox("Predictive Refinement", &m_PredictiveRefinement);
+            ImGui::SliderFloat("Lookahead Time", &m_LookaheadTime, 0.0f, 2.0f);
+            std::string numViews = "Additional Views: " + std::to_string(m_AdditionalUpdateProperties.size());
+            ImGui::Text(numViews.c_str());
+            if (ImGui::Button("Add View") && m_AdditionalUpdateProperties.size() < MAX_ADDITIONAL_UPDATE_VIEWS)
+            {
+                // Freeze the current point of view as an additional view of the update
+                UpdateProperties view;
+                mirror_update_properties(m_CameraController.get_camera(), view);
+                view.screenSize = { m_ScreenSize.x, m_ScreenSize.y };
+                m_AdditionalUpdateProperties.push_back(view);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Clear Views"))
+                m_AdditionalUpdateProperties.clear();
             ImGui::SeparatorText("Other");
             if (m_RayTracingSupported)
                 ImGui::Checkbox("Ray Tracing Path", &m_RayTracingPath);
@@ -486,10 +699,20 @@ void SpaceRenderer::update_constant_buffers(CommandBuffer cmd)
         globalCB._ScreenSpaceShadow = m_RayTracingPath ? 1.0f : 0.0f;
         d3d12::graphics_resources::set_constant_buffer(m_GlobalCB, (const char*)&globalCB, sizeof(GlobalCB));
         d3d12::command_buffer::upload_constant_buffer(cmd, m_GlobalCB);
+        m_GlobalCBData = globalCB;
+
+        // Extrapolate the update camera along its velocity (a frozen update camera doesn't move)
+        bool predictiveRefinement = m_PredictiveRefinement && m_MirrorPOV;
+        UpdateProperties predictedView;
+        if (predictiveRefinement)
+        {
+            predict_update_properties(m_UpdateProperties, m_CameraController.get_velocity(), m_LookaheadTime, predictedView);
+            predictedView.screenSize = { m_ScreenSize.x, m_ScreenSize.y };
+        }
 
         // Update the planet constant buffers
-        m_EarthPlanet.update_constant_buffers(cmd, m_UpdateProperties);
-        m_MoonPlanet.update_constant_buffers(cmd, m_UpdateProperties);
+        m_EarthPlanet.update_constant_buffers(cmd, m_UpdateProperties, m_AdditionalUpdateProperties, predictiveRefinement ? &predictedView : nullptr);
+        m_MoonPlanet.update_constant_buffers(cmd, m_UpdateProperties, m_AdditionalUpdateProperties, predictiveRefinement ? &predictedView : nullptr);
         m_MoonMaterial.update_constant_buffers(cmd);
 
         // Update the water simulation CB
@@ -551,13 +774,15 @@ void SpaceRenderer::prepare_rendering(CommandBuffer cmd)
     m_Sky.pre_render(cmd, m_GlobalCB, g_EarthRadius, { (float)g_EarthCenter.x, (float)g_EarthCenter.y, (float)g_EarthCenter.z });
 
     // Prepare the earth's geometry
-    m_MeshUpdater.reset_buffers(cmd, m_EarthPlanet.get_cbt_mesh());
+    m_MeshUpdater.clear_unallocated_elements(cmd, m_EarthPlanet.get_cbt_mesh(), m_EarthPlanet.get_geometry_cb());
+    m_MeshUpdater.reset_buffers(cmd, m_EarthPlanet.get_cbt_mesh(), m_EarthPlanet.get_geometry_cb());
     m_MeshUpdater.prepare_indirection(cmd, m_EarthPlanet.get_cbt_mesh(), m_EarthPlanet.get_geometry_cb());
     m_EarthPlanet.evaluate_leb(cmd, camera, m_GlobalCB, m_LebMatrixCache.get_leb_matrix_buffer(), true, true);
     m_WaterDeformer.apply_deformation(cmd, m_EarthPlanet.get_cbt_mesh(), m_EarthWaterData, m_GlobalCB, m_EarthPlanet.get_geometry_cb(), m_EarthPlanet.get_planet_cb(), m_EarthPlanet.get_update_cb());
 
     // Prepare the moon's geometry
-    m_MeshUpdater.reset_buffers(cmd, m_MoonPlanet.get_cbt_mesh());
+    m_MeshUpdater.clear_unallocated_elements(cmd, m_MoonPlanet.get_cbt_mesh(), m_MoonPlanet.get_geometry_cb());
+    m_MeshUpdater.reset_buffers(cmd, m_MoonPlanet.get_cbt_mesh(), m_MoonPlanet.get_geometry_cb());
     m_MeshUpdater.prepare_indirection(cmd, m_MoonPlanet.get_cbt_mesh(), m_MoonPlanet.get_geometry_cb());
     m_MoonPlanet.evaluate_leb(cmd, camera, m_GlobalCB, m_LebMatrixCache.get_leb_matrix_buffer(), true, true);
     m_MoonDeformer.apply_deformation(cmd, m_MoonMaterial, m_GlobalCB, m_MoonPlanet.get_cbt_mesh(), m_MoonPlanet.get_geometry_cb(), m_MoonPlanet.get_planet_cb());
@@ -582,6 +807,9 @@ void SpaceRenderer::default_render_pipeline(CommandBuffer cmd, bool earthIsVisib
     {
         if (!m_ActiveWireFrame)
         {
+#if defined(BISECTOR_CLUSTERS)
+            m_EarthPlanet.build_clusters(cmd, m_GlobalCB);
+#endif
             m_EarthRenderer.render_visibility_buffer(cmd, m_VisibilityBuffer, m_DepthBuffer, m_EarthPlanet, m_GlobalCB);
             m_EarthRenderer.render_material(cmd, m_ColorTexture, m_VisibilityBuffer, m_DepthBuffer, m_EarthPlanet, m_EarthWaterData.get_sg_texture(), m_Sky, m_GlobalCB, m_EarthWaterData.get_deformation_cb());
         }
@@ -594,6 +822,9 @@ void SpaceRenderer::default_render_pipeline(CommandBuffer cmd, bool earthIsVisib
     {
         if (!m_ActiveWireFrame)
         {
+#if defined(BISECTOR_CLUSTERS)
+            m_MoonPlanet.build_clusters(cmd, m_GlobalCB);
+#endif
             m_MoonRenderer.render_visibility_buffer(cmd, m_VisibilityBuffer, m_DepthBuffer, m_MoonPlanet, m_GlobalCB);
             m_MoonRenderer.render_material(cmd, m_ColorTexture, m_VisibilityBuffer, m_DepthBuffer, m_MoonMaterial, m_MoonPlanet, m_GlobalCB);
         }
@@ -624,6 +855,20 @@ void SpaceRenderer::default_render_pipeline(CommandBuffer cmd, bool earthIsVisib
 
 void SpaceRenderer::ray_tracing_render_pipeline(CommandBuffer cmd, bool earthIsVisible, bool moonIsVisible, double earthDistance, double moonDistance)
 {
+#if defined(WELDED_VERTICES)
+    // The asynchronous updates swap the vertex indices, the instances follow the structures created with the current ones
+    BottomLevelAS earthBLAS = select_blas(m_EarthPlanet.get_cbt_mesh(), m_EarthBLASArray, m_EarthBLASIndexBuffer);
+    BottomLevelAS moonBLAS = select_blas(m_MoonPlanet.get_cbt_mesh(), m_MoonBLASArray, m_MoonBLASIndexBuffer);
+    if (earthBLAS != m_EarthBLAS || moonBLAS != m_MoonBLAS)
+    {
+        m_EarthBLAS = earthBLAS;
+        m_MoonBLAS = moonBLAS;
+        d3d12::graphics_resources::set_tlas_instance(m_TLAS, m_EarthBLAS, 0);
+        d3d12::graphics_resources::set_tlas_instance(m_TLAS, m_MoonBLAS, 1);
+        d3d12::graphics_resources::upload_tlas_instance_data(m_TLAS);
+    }
+#endif
+
     d3d12::command_buffer::start_section(cmd, "Build RTAS");
     {
         // Build the ray tracing acceleration structures
@@ -677,6 +922,15 @@ void SpaceRenderer::render_pipeline(CommandBuffer cmd)
     // Grab the camera
     const Camera& camera = m_CameraController.get_camera();
 
+    // The update runs on the compute queue and the rendering uses the latest completed topology (not supported by the ray tracing path)
+    bool asyncUpdate = m_AsyncUpdate && m_ActiveUpdate && !m_RayTracingPath;
+    complete_async_update(!asyncUpdate);
+    bool kickAsyncUpdate = asyncUpdate && !m_AsyncUpdateInFlight;
+
+    // The validation and the occupancy would read the bisectors while they are updated (the adaptive triangle size relies on the occupancy)
+    bool validate = m_EnableValidation && !asyncUpdate;
+    bool occupancy = (m_EnableOccupancy || m_EarthPlanet.adaptive_triangle_size()) && !asyncUpdate;
+
     // Reset the command buffer
     d3d12::command_buffer::reset(cmd);
 
@@ -699,6 +953,9 @@ void SpaceRenderer::render_pipeline(CommandBuffer cmd)
     bool moonIsVisible, moonIsUpdatable;
     m_MoonPlanet.planet_visibility(camera, moonDistance, moonIsVisible, moonIsUpdatable);
 
+    // The convergence is measured on the earth's update
+    bool convergence = m_EnableConvergence && m_ActiveUpdate && !asyncUpdate && (earthIsUpdatable || m_RayTracingPath);
+
     // Update the earth water simulation only if we are close enought
     if (earthIsVisible)
     {
@@ -707,22 +964,53 @@ void SpaceRenderer::render_pipeline(CommandBuffer cmd)
         m_WaterSim.evaluate(cmd, m_EarthWaterData);
     }
 
+    // Periodically compact the bisectors (the GPU skips it if the mesh isn't fragmented enough)
+    bool compact = m_CompactionInterval > 0 && (m_UpdateCounter % (uint32_t)m_CompactionInterval) == 0;
+    if (!asyncUpdate)
+        m_UpdateCounter++;
+
+    // Both bodies can be refined by the same dispatches (the earth's scope then covers the update of both)
+    bool earthUpdate = (earthIsUpdatable || m_RayTracingPath) && !asyncUpdate;
+    bool moonUpdate = moonIsUpdatable && !asyncUpdate;
+    bool batchedUpdate = m_BatchedUpdate && m_ActiveUpdate && earthUpdate && moonUpdate;
+
     // Update the earth
     m_ProfilingHelper.start_profiling(cmd, (uint32_t)ProfilingScopes::Earth_Update);
-    if (earthIsUpdatable || m_RayTracingPath)
+    if (earthUpdate)
     {
-        if (m_ActiveUpdate)
-            m_MeshUpdater.update(cmd, m_EarthPlanet.get_cbt_mesh(),m_GlobalCB, m_EarthPlanet.get_geometry_cb(), m_EarthPlanet.get_update_cb());
+        if (batchedUpdate)
+        {
+            std::vector<MeshUpdateTarget> targets(2);
+            targets[0].mesh = &m_EarthPlanet.get_cbt_mesh();
+            targets[0].geometryCB = m_EarthPlanet.get_geometry_cb();
+            targets[0].updateCB = m_EarthPlanet.get_update_cb();
+            targets[0].compact = compact;
+            targets[1].mesh = &m_MoonPlanet.get_cbt_mesh();
+            targets[1].geometryCB = m_MoonPlanet.get_geometry_cb();
+            targets[1].updateCB = m_MoonPlanet.get_update_cb();
+            targets[1].compact = compact;
+            m_MeshUpdater.update(cmd, targets, m_GlobalCB);
+            m_EarthPlanet.complete_update();
+            m_MoonPlanet.complete_update();
+        }
+        else if (m_ActiveUpdate)
+        {
+            m_MeshUpdater.update(cmd, m_EarthPlanet.get_cbt_mesh(),m_GlobalCB, m_EarthPlanet.get_geometry_cb(), m_EarthPlanet.get_update_cb(), compact);
+            m_EarthPlanet.complete_update();
+        }
         m_EarthPlanet.evaluate_leb(cmd, camera, m_GlobalCB, m_LebMatrixCache.get_leb_matrix_buffer(), m_RayTracingPath);
     }
     m_ProfilingHelper.end_profiling(cmd, (uint32_t)ProfilingScopes::Earth_Update);
 
     // Update the moon
     m_ProfilingHelper.start_profiling(cmd, (uint32_t)ProfilingScopes::Moon_Update);
-    if (moonIsUpdatable)
+    if (moonUpdate)
     {
-        if (m_ActiveUpdate)
-            m_MeshUpdater.update(cmd, m_MoonPlanet.get_cbt_mesh(), m_GlobalCB, m_MoonPlanet.get_geometry_cb(), m_MoonPlanet.get_update_cb());
+        if (m_ActiveUpdate && !batchedUpdate)
+        {
+            m_MeshUpdater.update(cmd, m_MoonPlanet.get_cbt_mesh(), m_GlobalCB, m_MoonPlanet.get_geometry_cb(), m_MoonPlanet.get_update_cb(), compact);
+            m_MoonPlanet.complete_update();
+        }
         m_MoonPlanet.evaluate_leb(cmd, camera, m_GlobalCB, m_LebMatrixCache.get_leb_matrix_buffer(), m_RayTracingPath);
     }
     m_ProfilingHelper.end_profiling(cmd, (uint32_t)ProfilingScopes::Moon_Update);
@@ -738,9 +1026,26 @@ void SpaceRenderer::render_pipeline(CommandBuffer cmd)
         m_MoonDeformer.apply_deformation(cmd, m_MoonMaterial, m_GlobalCB, m_MoonPlanet.get_cbt_mesh(), m_MoonPlanet.get_geometry_cb(), m_MoonPlanet.get_planet_cb());
     m_ProfilingHelper.end_profiling(cmd, (uint32_t)ProfilingScopes::Moon_Deformation);
 
+    // Snapshot the topology the asynchronous update starts from
+    if (kickAsyncUpdate)
+    {
+        if (earthIsUpdatable)
+            m_EarthPlanet.prepare_async_update(cmd);
+        if (moonIsUpdatable)
+            m_MoonPlanet.prepare_async_update(cmd);
+    }
+
     // Validation required?
-    if (m_EnableValidation)
+    if (validate)
     {
+        // The derived adjacency is compared to the stored one and reported through the validation readback
+        if (m_DeriveAdjacency)
+        {
+            m_ProfilingHelper.start_profiling(cmd, (uint32_t)ProfilingScopes::Derive_Adjacency);
+            m_MeshUpdater.derive_adjacency(cmd, m_EarthPlanet.get_cbt_mesh(), m_EarthPlanet.get_geometry_cb());
+            m_MeshUpdater.derive_adjacency(cmd, m_MoonPlanet.get_cbt_mesh(), m_MoonPlanet.get_geometry_cb());
+            m_ProfilingHelper.end_profiling(cmd, (uint32_t)ProfilingScopes::Derive_Adjacency);
+        }
         m_MeshUpdater.validate(cmd, m_EarthPlanet.get_cbt_mesh(), m_EarthPlanet.get_geometry_cb());
         m_MeshUpdater.validate(cmd, m_MoonPlanet.get_cbt_mesh(), m_MoonPlanet.get_geometry_cb());
     }
@@ -754,9 +1059,16 @@ void SpaceRenderer::render_pipeline(CommandBuffer cmd)
     }
 
     // Query the occupancy
-    if (m_EnableOccupancy)
+    if (occupancy)
         m_MeshUpdater.query_occupancy(cmd, m_EarthPlanet.get_cbt_mesh());
 
+    // Query the split and simplification requests and the churn of the earth
+    if (convergence)
+    {
+        m_MeshUpdater.query_convergence(cmd, m_EarthPlanet.get_cbt_mesh());
+        m_MeshUpdater.query_churn(cmd, m_EarthPlanet.get_cbt_mesh());
+    }
+
     // The the render viewport
     d3d12::command_buffer::set_render_texture(cmd, m_ColorTexture, m_DepthBuffer);
 
@@ -793,6 +1105,9 @@ void SpaceRenderer::render_pipeline(CommandBuffer cmd)
     // Execute the command buffer in the command queue
     d3d12::command_queue::execute_command_buffer(m_CmdQueue, cmd);
 
+    // The readbacks of this frame are tracked by their own fences
+    m_MeshUpdater.submit_readbacks(m_CmdQueue);
+
     // Present
     d3d12::swap_chain::present(m_SwapChain);
 
@@ -802,18 +1117,104 @@ void SpaceRenderer::render_pipeline(CommandBuffer cmd)
     // Evaluate the timing
     m_ProfilingHelper.process_scopes(m_CmdQueue);
 
-    // Validation
-    if (m_EnableValidation)
+    // Refine the snapshot on the compute queue while the next frames are rendered
+    if (kickAsyncUpdate)
+        async_update(earthIsUpdatable, moonIsUpdatable, compact);
+
+    // Validation (the readbacks are a few frames late and never wait on the queue)
+    if (validate)
         assert_msg(m_MeshUpdater.check_if_valid(), "Validation failed.");
 
-    // Grab the CBT's occupancy
-    if (m_EnableOccupancy)
-        m_Occupancy = m_MeshUpdater.get_occupancy();
+    // Grab the CBT's occupancy and adapt the earth's triangle size to it and to the update duration
+    bool newOccupancy = m_MeshUpdater.get_occupancy(m_Occupancy);
+    if (newOccupancy && m_EarthPlanet.adaptive_triangle_size() && m_ActiveUpdate && earthIsUpdatable)
+        m_EarthPlanet.adapt_triangle_size(m_Occupancy, m_ProfilingHelper.get_scope_last_duration((uint32_t)ProfilingScopes::Earth_Update));
+
+    // Count the updates during which some requests were deferred by the budgets
+    uint32_t underRefinedArea = 0;
+    if (m_MeshUpdater.get_convergence(m_SplitRequests, m_SimplifyRequests, underRefinedArea))
+    {
+        m_UnderRefinedFraction = std::min(underRefinedArea / (m_ScreenSize.x * m_ScreenSize.y), 1.0f);
+        bool converged = m_SplitRequests <= m_EarthPlanet.get_split_budget() && m_SimplifyRequests <= m_EarthPlanet.get_simplify_budget();
+        m_ConvergenceFrames = converged ? 0 : m_ConvergenceFrames + 1;
+    }
+    m_MeshUpdater.get_churn(m_SplitMergeChurn, m_MergeSplitChurn);
+
+    if (m_SaveSnapshots)
+    {
+        save_snapshots();
+        m_SaveSnapshots = false;
+    }
+
+    if (m_ExportFormat != MeshExportFormat::Count)
+    {
+        export_meshes(m_ExportFormat);
+        m_ExportFormat = MeshExportFormat::Count;
+    }
+
+    // The neighbors update buffers may be in use by the asynchronous update
+    if (m_EarthPlanet.neighbors_update_buffer_outdated() || m_MoonPlanet.neighbors_update_buffer_outdated())
+    {
+        complete_async_update(true);
+        m_EarthPlanet.resize_neighbors_update_buffer();
+        m_MoonPlanet.resize_neighbors_update_buffer();
+    }
 
     if (m_NewCBTType != m_CBTType)
         reset_cbt_type();
 }
 
+void SpaceRenderer::async_update(bool earthIsUpdatable, bool moonIsUpdatable, bool compact)
+{
+    // Nothing to update
+    if (!earthIsUpdatable && !moonIsUpdatable)
+        return;
+
+    // Reset the command buffer
+    d3d12::command_buffer::reset(m_AsyncCmdBuffer);
+
+    // The frame's constant buffer keeps changing while the update runs
+    d3d12::graphics_resources::set_constant_buffer(m_AsyncGlobalCB, (const char*)&m_GlobalCBData, sizeof(GlobalCB));
+    d3d12::command_buffer::upload_constant_buffer(m_AsyncCmdBuffer, m_AsyncGlobalCB);
+
+    // Update the planets
+    if (earthIsUpdatable)
+        m_EarthPlanet.async_update(m_AsyncCmdBuffer, m_MeshUpdater, m_AsyncGlobalCB, m_LebMatrixCache.get_leb_matrix_buffer(), compact);
+    if (moonIsUpdatable)
+        m_MoonPlanet.async_update(m_AsyncCmdBuffer, m_MeshUpdater, m_AsyncGlobalCB, m_LebMatrixCache.get_leb_matrix_buffer(), compact);
+
+    // Close and execute the command buffer on the compute queue
+    d3d12::command_buffer::close(m_AsyncCmdBuffer);
+    d3d12::command_queue::execute_command_buffer(m_CmdQueue, m_AsyncCmdBuffer);
+    d3d12::command_queue::signal(m_CmdQueue, m_AsyncFence, ++m_AsyncFenceValue, CommandBufferType::Compute);
+
+    // Keep track of what needs to be swapped
+    m_AsyncUpdateInFlight = true;
+    m_AsyncEarthUpdated = earthIsUpdatable;
+    m_AsyncMoonUpdated = moonIsUpdatable;
+    m_UpdateCounter++;
+}
+
+void SpaceRenderer::complete_async_update(bool wait)
+{
+    // No update running
+    if (!m_AsyncUpdateInFlight)
+        return;
+
+    // Wait for the update or check if it is done
+    if (wait)
+        d3d12::command_queue::flush(m_CmdQueue, CommandBufferType::Compute);
+    else if (d3d12::fence::get_value(m_AsyncFence) < m_AsyncFenceValue)
+        return;
+
+    // Expose the new topology to the rendering
+    if (m_AsyncEarthUpdated)
+        m_EarthPlanet.complete_async_update();
+    if (m_AsyncMoonUpdated)
+        m_MoonPlanet.complete_async_update();
+    m_AsyncUpdateInFlight = false;
+}
+
 void SpaceRenderer::evaluate_sun_direction()
 {
     float sinPhi = sinf(m_SunRotation);
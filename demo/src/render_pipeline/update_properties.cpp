@@ -1,5 +1,7 @@
 // Project includes
 #include "render_pipeline/update_properties.h"
+#include "math/operators.h"
+#include "tools/security.h"
 
 // Project includes
 #include <string.h>
@@ -30,3 +32,39 @@ void set_update_properties(const UpdateProperties& updateProperties, UpdateCB& u
 	updateCB._UpdateFarPlaneDistance = updateProperties.farPlane;
 	memcpy(updateCB._UpdateFrustumPlanes, updateProperties.frustum.planes, sizeof(Plane) * 6);
 }
+
+static void set_update_view(const UpdateProperties& updateProperties, const UpdateProperties& view, UpdateView& targetView)
+{
+	// Camera properties
+	double3 positionRUS = view.position - updateProperties.position;
+	targetView._ViewProjectionMatrix = view.viewProj;
+	targetView._CameraPosition = { (float)positionRUS.x, (float)positionRUS.y, (float)positionRUS.z };
+	targetView._NumPixels = view.screenSize.x * view.screenSize.y;
+	targetView._CameraForward = view.forward;
+	targetView._PaddingUV0 = 0.0f;
+	memcpy(targetView._FrustumPlanes, view.frustum.planes, sizeof(Plane) * 6);
+}
+
+void set_additional_update_views(const UpdateProperties& updateProperties, const std::vector<UpdateProperties>& additionalViews, UpdateCB& updateCB)
+{
+	assert_msg(additionalViews.size() <= MAX_ADDITIONAL_UPDATE_VIEWS, "Too many additional update views.");
+	updateCB._NumAdditionalViews = (uint32_t)additionalViews.size();
+	for (uint32_t viewIdx = 0; viewIdx < updateCB._NumAdditionalViews; ++viewIdx)
+		set_update_view(updateProperties, additionalViews[viewIdx], updateCB._AdditionalViews[viewIdx]);
+}
+
+void predict_update_properties(const UpdateProperties& updateProperties, const double3& velocity, float lookahead, UpdateProperties& predictedProperties)
+{
+	// The matrices and frustum planes are relative to the camera, only the position moves
+	predictedProperties = updateProperties;
+	predictedProperties.position = updateProperties.position + velocity * (double)lookahead;
+}
+
+void set_predicted_update_view(const UpdateProperties& updateProperties, const UpdateProperties* predictedView, UpdateCB& updateCB)
+{
+	updateCB._PredictiveRefinement = predictedView != nullptr ? 1 : 0;
+	if (predictedView != nullptr)
+		set_update_view(updateProperties, *predictedView, updateCB._PredictedView);
+	else
+		memset(&updateCB._PredictedView, 0, sizeof(UpdateView));
+}
\ No newline at end of file
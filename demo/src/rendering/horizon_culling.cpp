@@ -0,0 +1,42 @@
+// Project includes
+#include "math/operators.h"
+#include "rendering/horizon_culling.h"
+
+bool horizon_sphere_culled(const float3& planetCenter, float occluderRadius, const float3& sphereCenter, float sphereRadius)
+{
+    // The camera is inside of the occluder
+    float planetDistance2 = dot(planetCenter, planetCenter);
+    float occluderRadius2 = occluderRadius * occluderRadius;
+    if (planetDistance2 <= occluderRadius2)
+        return false;
+
+    // Every point of the sphere needs to be further than the horizon
+    float sphereDistance = length(sphereCenter);
+    float horizonDistance = sqrtf(planetDistance2 - occluderRadius2);
+    if (sphereDistance - sphereRadius < horizonDistance)
+        return false;
+
+    // The sphere needs to be inside of the cone tangent to the occluder
+    float planetDistance = sqrtf(planetDistance2);
+    float sinAlpha = occluderRadius / planetDistance;
+    float sinBeta = sphereRadius / sphereDistance;
+    if (sinBeta >= sinAlpha)
+        return false;
+    float cosAlpha = horizonDistance / planetDistance;
+    float cosBeta = sqrtf(1.0f - sinBeta * sinBeta);
+    float cosTheta = dot(sphereCenter, planetCenter) / (sphereDistance * planetDistance);
+    return cosTheta >= cosAlpha * cosBeta + sinAlpha * sinBeta;
+}
+
+bool horizon_bisector_culled(const float3& p0, const float3& p1, const float3& p2, const float3& planetCenter, float planetRadius, float maxDisplacement)
+{
+    // Bounding sphere of the flat triangle
+    float3 center = (p0 + p1 + p2) / 3.0f;
+    float radius = fmaxf(fmaxf(length(p0 - center), length(p1 - center)), length(p2 - center));
+
+    // Account for the curvature of the planet and for the displacement of the surface inside the bisector
+    radius += radius * radius / planetRadius + 2.0f * maxDisplacement;
+
+    // The occluder is the sphere below the lowest point of the surface
+    return horizon_sphere_culled(planetCenter, planetRadius - maxDisplacement, center, radius);
+}
@@ -0,0 +1,74 @@
+// Project includes
+#include "tools/mapped_file.h"
+
+// System includes
+#include <Windows.h>
+#include <string.h>
+
+bool map_file(const char* filePath, MappedFile& file)
+{
+	file = MappedFile();
+
+	// Open the file
+	HANDLE fileHandle = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	// Empty files can't be mapped
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	// Map the whole file
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* data = mappingHandle != nullptr ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (data == nullptr)
+	{
+		if (mappingHandle != nullptr)
+			CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	file.data = (const char*)data;
+	file.size = (uint64_t)fileSize.QuadPart;
+	file.fileHandle = fileHandle;
+	file.mappingHandle = mappingHandle;
+	return true;
+}
+
+void unmap_file(MappedFile& file)
+{
+	if (file.data != nullptr)
+		UnmapViewOfFile(file.data);
+	if (file.mappingHandle != nullptr)
+		CloseHandle((HANDLE)file.mappingHandle);
+	if (file.fileHandle != nullptr)
+		CloseHandle((HANDLE)file.fileHandle);
+	file = MappedFile();
+}
+
+uint64_t hash_memory(const char* data, uint64_t size)
+{
+	const uint64_t prime = 0x100000001b3ull;
+	uint64_t hash = 0xcbf29ce484222325ull;
+
+	// Full words
+	uint64_t numWords = size / sizeof(uint64_t);
+	for (uint64_t wordIdx = 0; wordIdx < numWords; ++wordIdx)
+	{
+		uint64_t word;
+		memcpy(&word, data + wordIdx * sizeof(uint64_t), sizeof(uint64_t));
+		hash = (hash ^ word) * prime;
+	}
+
+	// Remaining bytes
+	for (uint64_t byteIdx = numWords * sizeof(uint64_t); byteIdx < size; ++byteIdx)
+		hash = (hash ^ (uint8_t)data[byteIdx]) * prime;
+
+	// Include the size so that trailing zeros change the hash
+	return (hash ^ size) * prime;
+}
@@ -0,0 +1,21 @@
+// Project includes
+#include "tools/parallel_for.h"
+
+// System includes
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+void parallel_for(uint32_t count, uint32_t minRange, const std::function<void(uint32_t, uint32_t)>& function)
+{
+	uint32_t numThreads = std::max(std::min(std::thread::hardware_concurrency(), count / std::max(minRange, 1u)), 1u);
+	uint32_t rangeSize = (count + numThreads - 1) / numThreads;
+
+	// The calling thread processes the first range
+	std::vector<std::thread> threads;
+	for (uint32_t threadIdx = 1; threadIdx < numThreads; ++threadIdx)
+		threads.emplace_back(function, std::min(threadIdx * rangeSize, count), std::min((threadIdx + 1) * rangeSize, count));
+	function(0, std::min(rangeSize, count));
+	for (std::thread& thread : threads)
+		thread.join();
+}
@@ -0,0 +1,97 @@
+// Project includes
+#include "tools/readback_ring.h"
+#include "tools/security.h"
+
+// Project includes
+#include "graphics/dx12_backend.h"
+
+// System includes
+#include <string.h>
+
+ReadbackRing::ReadbackRing()
+{
+}
+
+ReadbackRing::~ReadbackRing()
+{
+}
+
+void ReadbackRing::initialize(GraphicsDevice device, uint32_t size, uint32_t depth)
+{
+	assert_msg(depth > 0, "A readback ring needs at least one slot.");
+	m_Size = size;
+	m_Depth = depth;
+	m_Buffers.resize(m_Depth);
+	m_SlotFenceValues.resize(m_Depth);
+	for (uint32_t slotIdx = 0; slotIdx < m_Depth; ++slotIdx)
+	{
+		m_Buffers[slotIdx] = d3d12::graphics_resources::create_graphics_buffer(device, m_Size, sizeof(uint32_t), GraphicsBufferType::Readback);
+		m_SlotFenceValues[slotIdx] = 0;
+	}
+	m_Fence = d3d12::fence::create_fence(device);
+	m_FenceValue = 0;
+	m_ReadIdx = 0;
+	m_NumPending = 0;
+	m_NumRecorded = 0;
+}
+
+void ReadbackRing::release()
+{
+	d3d12::fence::destroy_fence(m_Fence);
+	for (uint32_t slotIdx = 0; slotIdx < m_Depth; ++slotIdx)
+		d3d12::graphics_resources::destroy_graphics_buffer(m_Buffers[slotIdx]);
+	m_Buffers.clear();
+	m_SlotFenceValues.clear();
+}
+
+bool ReadbackRing::enqueue(CommandBuffer cmd, GraphicsBuffer buffer, uint32_t offset)
+{
+	// Every slot is still in flight, this readback is skipped
+	if (m_NumPending == m_Depth)
+		return false;
+
+	// Record the copy in the next slot, its fence value is set at submission
+	uint32_t slotIdx = (m_ReadIdx + m_NumPending) % m_Depth;
+	d3d12::command_buffer::copy_graphics_buffer(cmd, buffer, offset, m_Buffers[slotIdx], 0, m_Size);
+	m_NumPending++;
+	m_NumRecorded++;
+	return true;
+}
+
+void ReadbackRing::submit(CommandQueue cmdQ, CommandBufferType type)
+{
+	// Nothing was recorded since the last submission
+	if (m_NumRecorded == 0)
+		return;
+
+	// Tag the recorded slots with the value the queue signals once they are done
+	d3d12::command_queue::signal(cmdQ, m_Fence, ++m_FenceValue, type);
+	for (uint32_t recordIdx = m_NumPending - m_NumRecorded; recordIdx < m_NumPending; ++recordIdx)
+		m_SlotFenceValues[(m_ReadIdx + recordIdx) % m_Depth] = m_FenceValue;
+	m_NumRecorded = 0;
+}
+
+bool ReadbackRing::read(void* output)
+{
+	// Release all the completed slots, only the most recent one is read
+	uint64_t completedValue = d3d12::fence::get_value(m_Fence);
+	uint32_t numSubmitted = m_NumPending - m_NumRecorded;
+	uint32_t latestIdx = UINT32_MAX;
+	while (numSubmitted > 0 && m_SlotFenceValues[m_ReadIdx] <= completedValue)
+	{
+		latestIdx = m_ReadIdx;
+		m_ReadIdx = (m_ReadIdx + 1) % m_Depth;
+		m_NumPending--;
+		numSubmitted--;
+	}
+
+	// Nothing completed
+	if (latestIdx == UINT32_MAX)
+		return false;
+
+	// Copy the data
+	const char* data = d3d12::graphics_resources::allocate_cpu_buffer(m_Buffers[latestIdx]);
+	memcpy(output, data, m_Size);
+	d3d12::graphics_resources::release_cpu_buffer(m_Buffers[latestIdx]);
+	return true;
+}
\ No newline at end of file
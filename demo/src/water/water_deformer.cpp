@@ -65,6 +65,9 @@ void WaterDeformer::reload_shaders(const std::string& shaderLibrary)
     csd.uavCount = WATER_DEFORMATION_UAV_COUNT;
     csd.samplerCount = WATER_DEFORMATION_SAMPLER_COUNT;
     csd.kernelname = "EvaluateDeformation";
+#if defined(WELDED_VERTICES)
+    csd.defines.push_back("WELDED_VERTICES");
+#endif
     compile_and_replace_compute_shader(m_Device, csd, m_EvaluateDeformationCS);
 }
 
@@ -80,8 +83,14 @@ void WaterDeformer::apply_deformation(CommandBuffer cmdB, const CBTMesh& mesh, c
         d3d12::command_buffer::set_compute_shader_buffer_cbv(cmdB, m_EvaluateDeformationCS, DEFORMATION_CB_BINDING_SLOT, waterData.get_deformation_cb());
         // SRVs
         d3d12::command_buffer::set_compute_shader_texture_srv(cmdB, m_EvaluateDeformationCS, DISPLACEMENT_TEXTURE_BINDING_SLOT, waterData.get_displacement_texture());
+#if defined(WELDED_VERTICES)
+        // Every welded vertex is displaced once
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_EvaluateDeformationCS, INDEXED_BISECTOR_BUFFER_BINDING_SLOT, mesh.weldedVertexBuffer);
+        d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_EvaluateDeformationCS, INDIRECT_DRAW_BUFFER_BINDING_SLOT, mesh.weldedArgsBuffer);
+#else
         d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_EvaluateDeformationCS, INDEXED_BISECTOR_BUFFER_BINDING_SLOT, mesh.indexedBisectorBuffer);
         d3d12::command_buffer::set_compute_shader_buffer_srv(cmdB, m_EvaluateDeformationCS, INDIRECT_DRAW_BUFFER_BINDING_SLOT, mesh.indirectDrawBuffer);
+#endif
         // UAVs
         d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_EvaluateDeformationCS, LEB_VERTEX_BUFFER_SLOT, mesh.lebVertexBuffer);
         d3d12::command_buffer::set_compute_shader_buffer_uav(cmdB, m_EvaluateDeformationCS, CURRENT_VERTEX_BUFFER_SLOT, mesh.currentVertexBuffer);
@@ -89,7 +98,11 @@ void WaterDeformer::apply_deformation(CommandBuffer cmdB, const CBTMesh& mesh, c
         // Samplers
         d3d12::command_buffer::set_compute_shader_sampler(cmdB, m_EvaluateDeformationCS, DISPLACEMENT_SAMPLER_BINDING_SLOT, m_LinearWrap);
         // Dispatch
+#if defined(WELDED_VERTICES)
+        d3d12::command_buffer::dispatch_indirect(cmdB, m_EvaluateDeformationCS, mesh.indirectDispatchBuffer, WELDED_DISPATCH_OFFSET * sizeof(uint32_t));
+#else
         d3d12::command_buffer::dispatch_indirect(cmdB, m_EvaluateDeformationCS, mesh.indirectDispatchBuffer, 3 * sizeof(uint32_t));
+#endif
         // Barrier
         d3d12::command_buffer::uav_barrier_buffer(cmdB, mesh.currentVertexBuffer);
     }
@@ -0,0 +1,860 @@
+// Project includes
+#include "cbt/bisector.h"
+#include "math/operators.h"
+#include "mesh/bisector_bvh.h"
+#include "mesh/cpu_mesh.h"
+#include "mesh/cpu_update.h"
+#include "mesh/mesh_exporter.h"
+#include "mesh/mesh_importer.h"
+#include "mesh/mesh_snapshot.h"
+#include "rendering/horizon_culling.h"
+
+// System includes
+#include <algorithm>
+#include <math.h>
+#include <stddef.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+
+// Number of elements of the CBT the mesh is loaded for
+#define CPU_TESTS_CBT_ELEMENTS (1 << 16)
+// Radius of the planet the bisectors are evaluated on
+#define CPU_TESTS_PLANET_RADIUS 6371000.0
+// Number of uniform subdivisions of the base patches of the exported mesh
+#define CPU_TESTS_EXPORT_SUBDIVISIONS 6
+
+// Number and length of the bisection sequences used to measure the drift of the incremental LEB positions
+#define INCREMENTAL_LEB_DRIFT_SEQUENCES 64
+#define INCREMENTAL_LEB_DRIFT_STEPS 256
+// Tolerated drift on the unit sphere (under a micrometer on the earth)
+#define INCREMENTAL_LEB_MAX_DRIFT 1e-13
+
+// Number of base patches subdivided uniformly to validate the clustering
+#define CLUSTER_VALIDATION_PATCHES 16
+
+// Failed checks are reported and counted, the tests keep running
+static uint32_t g_NumFailures = 0;
+#define CHECK(condition, message) { if (!(condition)) { printf("    FAILED: %s (%s:%d)\n", message, __FILE__, __LINE__); g_NumFailures++; } }
+
+// Number of elements of the buffer the bisector data indexing is checked on
+#define BISECTOR_LAYOUT_ELEMENTS 37
+
+// Reads the "#define NAME value" lines of a shader with an integer value and the uint fields (and their size in uints) of one of its structures
+static bool parse_shader_layout(const std::string& shaderPath, const char* structureName, std::unordered_map<std::string, int64_t>& defines, std::vector<std::pair<std::string, uint32_t>>& fields)
+{
+    FILE* shaderFile = fopen(shaderPath.c_str(), "r");
+    if (shaderFile == nullptr)
+        return false;
+
+    char line[512];
+    bool inStructure = false;
+    const std::string structureLine = std::string("struct ") + structureName;
+    while (fgets(line, sizeof(line), shaderFile) != nullptr)
+    {
+        char name[128];
+        long long value;
+        if (sscanf(line, " #define %127s %lli", name, &value) == 2)
+            defines[name] = value;
+        else if (strncmp(line, structureLine.c_str(), structureLine.size()) == 0)
+            inStructure = true;
+        else if (inStructure && strstr(line, "};") != nullptr)
+            inStructure = false;
+        else if (inStructure && sscanf(line, " uint32_t %127[A-Za-z0-9_]", name) == 1)
+        {
+            uint32_t count = 1;
+            const char* bracket = strchr(line, '[');
+            if (bracket != nullptr)
+                count = (uint32_t)atoi(bracket + 1);
+            fields.push_back({ name, count });
+        }
+    }
+    fclose(shaderFile);
+    return true;
+}
+
+static void test_bisector_data_layout(const std::string& projectDir)
+{
+    // The CPU offsets of the fields, the name of the matching shader define and the matching member of the structure
+    struct FieldLayout
+    {
+        const char* define;
+        int64_t offset;
+        const char* member;
+        size_t memberOffset;
+    };
+    const FieldLayout layout[] = {
+        { "BISECTOR_DATA_SUBDIVISION_PATTERN", BISECTOR_DATA_SUBDIVISION_PATTERN, "subdivisionPattern", offsetof(BisectorData, subdivisionPattern) },
+        { "BISECTOR_DATA_INDICES", BISECTOR_DATA_INDICES, "indices", offsetof(BisectorData, indices) },
+        { "BISECTOR_DATA_PROBLEMATIC_NEIGHBOR", BISECTOR_DATA_PROBLEMATIC_NEIGHBOR, "problematicNeighbor", offsetof(BisectorData, problematicNeighbor) },
+        { "BISECTOR_DATA_STATE", BISECTOR_DATA_STATE, "bisectorState", offsetof(BisectorData, bisectorState) },
+        { "BISECTOR_DATA_FLAGS", BISECTOR_DATA_FLAGS, "flags", offsetof(BisectorData, flags) },
+        { "BISECTOR_DATA_PROPAGATION_ID", BISECTOR_DATA_PROPAGATION_ID, "propagationID", offsetof(BisectorData, propagationID) },
+    };
+
+    // The structure of arrays offsets must be the ones of the structure so that both layouts hold the same fields
+    CHECK(sizeof(BisectorData) == BISECTOR_DATA_NUM_FIELDS * sizeof(uint32_t), "CPU bisector data doesn't have BISECTOR_DATA_NUM_FIELDS fields.");
+    for (const FieldLayout& field : layout)
+        CHECK(field.memberOffset == field.offset * sizeof(uint32_t), "CPU bisector data member doesn't match its offset.");
+
+    // The shader must use the same offsets and the same structure
+    std::unordered_map<std::string, int64_t> defines;
+    std::vector<std::pair<std::string, uint32_t>> fields;
+    CHECK(parse_shader_layout(projectDir + "\\shaders\\shader_lib\\bisector.hlsl", "BisectorData", defines, fields), "Failed to read the bisector shader.");
+    CHECK(defines.count("BISECTOR_DATA_NUM_FIELDS") == 1 && defines["BISECTOR_DATA_NUM_FIELDS"] == BISECTOR_DATA_NUM_FIELDS, "Shader doesn't have the same number of bisector data fields.");
+    std::unordered_map<std::string, uint32_t> shaderOffsets;
+    uint32_t shaderSize = 0;
+    for (const auto& field : fields)
+    {
+        shaderOffsets[field.first] = shaderSize;
+        shaderSize += field.second;
+    }
+    CHECK(shaderSize == BISECTOR_DATA_NUM_FIELDS, "Shader bisector data doesn't have BISECTOR_DATA_NUM_FIELDS fields.");
+    for (const FieldLayout& field : layout)
+    {
+        CHECK(defines.count(field.define) == 1 && defines[field.define] == field.offset, "Shader bisector data offset doesn't match the CPU one.");
+        CHECK(shaderOffsets.count(field.member) == 1 && shaderOffsets[field.member] == field.offset, "Shader bisector data member doesn't match its offset.");
+    }
+
+    // The indexing of the active layout (this file is also built with BISECTOR_DATA_SOA) must address every field of every bisector once
+    std::vector<uint32_t> hits(BISECTOR_LAYOUT_ELEMENTS * BISECTOR_DATA_NUM_FIELDS, 0);
+    uint32_t numMisplaced = 0;
+    for (uint32_t bisectorID = 0; bisectorID < BISECTOR_LAYOUT_ELEMENTS; ++bisectorID)
+    {
+        for (uint32_t field = 0; field < BISECTOR_DATA_NUM_FIELDS; ++field)
+        {
+            uint32_t index = bisector_data_index(bisectorID, field, BISECTOR_LAYOUT_ELEMENTS);
+#if defined(BISECTOR_DATA_SOA)
+            numMisplaced += index != field * BISECTOR_LAYOUT_ELEMENTS + bisectorID;
+#else
+            numMisplaced += index * sizeof(uint32_t) != bisectorID * sizeof(BisectorData) + field * sizeof(uint32_t);
+#endif
+            if (index < hits.size())
+                hits[index]++;
+        }
+    }
+    CHECK(numMisplaced == 0, "Bisector data index doesn't match the layout of the shader.");
+    CHECK(std::all_of(hits.begin(), hits.end(), [](uint32_t count) { return count == 1; }), "Bisector data index doesn't cover the buffer.");
+}
+
+static void test_cpu_mesh(const CPUMesh& mesh)
+{
+    // The adjacency derived from the heapIDs must match the one of the halfedge mesh (the derived neighbors index the stored bisectors)
+    std::vector<uint3> derivedNeighborsArray;
+    derive_neighbors(mesh, mesh.heapIDArray, derivedNeighborsArray);
+    auto element_id = [&mesh](uint32_t storedIdx) { return storedIdx != INVALID_POINTER ? mesh.firstBaseElement + storedIdx : INVALID_POINTER; };
+    uint32_t numMismatches = 0;
+    for (uint32_t storedIdx = 0; storedIdx < (uint32_t)mesh.heapIDArray.size(); ++storedIdx)
+    {
+        const uint3& stored = mesh.neighborsArray[storedIdx];
+        const uint3& derived = derivedNeighborsArray[storedIdx];
+        numMismatches += stored.x != element_id(derived.x) || stored.y != element_id(derived.y) || stored.z != element_id(derived.z);
+    }
+    CHECK(numMismatches == 0, "Derived neighbors don't match the mesh adjacency.");
+
+    // The incremental evaluation of the LEB positions must not drift away from the full decoding
+    double positionsDrift = incremental_positions_drift(mesh, INCREMENTAL_LEB_DRIFT_SEQUENCES, INCREMENTAL_LEB_DRIFT_STEPS);
+    CHECK(positionsDrift < INCREMENTAL_LEB_MAX_DRIFT, "Incremental LEB positions drift away from the full decoding.");
+
+    // Uniformly subdivided patches must be grouped into full clusters that bound their bisectors
+    const uint64_t baseHeapID = 1ull << (mesh.minimalDepth - 1);
+    const uint32_t numPatches = (uint32_t)(mesh.basePoints.size() / 3);
+    const uint32_t numValidationPatches = std::min(numPatches, (uint32_t)CLUSTER_VALIDATION_PATCHES);
+    const uint32_t numSubdivisions = CLUSTER_SUBTREE_DEPTH + 1;
+    std::vector<uint64_t> uniformHeapIDArray;
+    for (uint32_t patchIdx = 0; patchIdx < numValidationPatches; ++patchIdx)
+    {
+        uint64_t patchHeapID = baseHeapID + (uint64_t)patchIdx * numPatches / numValidationPatches;
+        for (uint64_t childIdx = 0; childIdx < (1ull << numSubdivisions); ++childIdx)
+            uniformHeapIDArray.push_back((patchHeapID << numSubdivisions) + childIdx);
+    }
+    std::vector<BisectorCluster> clusters;
+    std::vector<uint32_t> clusterElements;
+    build_bisector_clusters(mesh, uniformHeapIDArray, clusters, clusterElements);
+    CHECK(validate_bisector_clusters(mesh, uniformHeapIDArray, clusters, clusterElements), "Bisector clusters don't match the bisectors.");
+    CHECK(std::all_of(clusters.begin(), clusters.end(), [](const BisectorCluster& cluster) { return cluster.numElements == CLUSTER_MAX_ELEMENTS; }), "Uniformly subdivided patches don't give full clusters.");
+}
+
+// Number of updates of the CPU update test, depth (above the base one) requested at the focus points of the refinement and angle
+// (in radians) at which it goes back to the base depth
+#define CPU_UPDATE_TEST_UPDATES 48
+#define CPU_UPDATE_TEST_FOCUS_DEPTH 16
+#define CPU_UPDATE_TEST_FOCUS_ANGLE 1.2
+// Fraction of the elements whose classification is randomized
+#define CPU_UPDATE_TEST_NOISE 0.05
+// Fraction of the converged bisectors that the predicted view requests to split
+#define CPU_UPDATE_TEST_PREDICTED 0.1
+
+static void test_cpu_update(const CPUMesh& mesh)
+{
+    // Every update refines towards a random point of the sphere (and coarsens away from it) with randomized budgets
+    std::mt19937 generator(2);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    CPUMeshState state;
+    init_cpu_mesh_state(mesh, state);
+    const uint32_t totalNumElements = (uint32_t)state.heapIDArray.size();
+    std::vector<int32_t> validityArray(totalNumElements);
+    uint32_t numMismatches = 0, numMixedDepthNeighbors = 0, numMerges = 0, maxDepth = 0;
+    for (uint32_t updateIdx = 0; updateIdx < CPU_UPDATE_TEST_UPDATES; ++updateIdx)
+    {
+        double3 focus = normalize(double3({ unit(generator) - 0.5, unit(generator) - 0.5, unit(generator) - 0.5 }));
+        for (uint32_t elementID = 0; elementID < totalNumElements; ++elementID)
+        {
+            uint64_t heapID = state.heapIDArray[elementID];
+            if (heapID == 0)
+                continue;
+            double3 positions[4];
+            decode_bisector_positions(mesh, heapID, positions);
+            double3 center = normalize(positions[0] + positions[1] + positions[2]);
+            int32_t targetDepth = (int32_t)(mesh.minimalDepth + CPU_UPDATE_TEST_FOCUS_DEPTH * (1.0 - acos(std::min(dot(center, focus), 1.0)) / CPU_UPDATE_TEST_FOCUS_ANGLE));
+            int32_t depth = (int32_t)find_msb_64(heapID);
+            validityArray[elementID] = depth < targetDepth ? BISECT_ELEMENT : (depth > targetDepth ? TOO_SMALL : UNCHANGED_ELEMENT);
+            // Part of the converged elements are only requested by the predicted view
+            if (depth == targetDepth && unit(generator) < CPU_UPDATE_TEST_PREDICTED)
+                validityArray[elementID] = PREDICTED_BISECT_ELEMENT;
+            if (unit(generator) < CPU_UPDATE_TEST_NOISE)
+                validityArray[elementID] = (int32_t)(generator() % 3) - 1;
+        }
+
+        CPUUpdateBudgets budgets;
+        budgets.splitBudget = updateIdx % 3 == 0 ? UINT32_MAX : 64 + generator() % 4096;
+        budgets.predictiveSplitBudget = updateIdx % 5 == 0 ? UINT32_MAX : generator() % 1024;
+        budgets.simplifyBudget = updateIdx % 4 == 0 ? UINT32_MAX : 64 + generator() % 4096;
+        // Bisections ratios of the planet UI
+        budgets.maxNewBisectors = totalNumElements / (1 + generator() % 64);
+        CPUUpdateStats stats;
+        update_cpu_mesh_state(mesh, validityArray, budgets, state, stats);
+        numMerges += stats.numMerges;
+
+        // The neighbors kept by the update must be the ones of the conforming mesh described by the heapIDs
+        std::vector<uint3> derivedNeighborsArray;
+        derive_neighbors(mesh, state.heapIDArray, derivedNeighborsArray);
+        for (uint32_t elementID = 0; elementID < totalNumElements; ++elementID)
+        {
+            uint64_t heapID = state.heapIDArray[elementID];
+            if (heapID == 0)
+                continue;
+            const uint3& kept = state.neighborsArray[elementID];
+            const uint3& derived = derivedNeighborsArray[elementID];
+            numMismatches += kept.x != derived.x || kept.y != derived.y || kept.z != derived.z;
+
+            // Count the neighbors that are resolved by the finer and coarser fallbacks of the derivation
+            uint32_t depth = find_msb_64(heapID);
+            maxDepth = std::max(maxDepth, depth);
+            for (uint32_t neighborID : { derived.x, derived.y, derived.z })
+                numMixedDepthNeighbors += neighborID != INVALID_POINTER && find_msb_64(state.heapIDArray[neighborID]) != depth;
+        }
+
+        // The next updates would walk broken neighbors
+        if (numMismatches != 0)
+            break;
+    }
+    CHECK(numMismatches == 0, "Neighbors kept by the update don't match the derived ones.");
+    CHECK(numMixedDepthNeighbors > 0 && maxDepth >= mesh.minimalDepth + CPU_UPDATE_TEST_FOCUS_DEPTH / 2, "Update doesn't produce a mixed depth mesh.");
+    CHECK(numMerges > 0, "Update doesn't merge any bisector.");
+}
+
+// Random cameras and bisectors of the horizon culling test, and the number of surface points sampled in every culled bisector
+#define HORIZON_TEST_CAMERAS 64
+#define HORIZON_TEST_BISECTORS 2048
+#define HORIZON_TEST_SAMPLES 64
+// Maximal displacement of the surface around the radius of the planet
+#define HORIZON_TEST_MAX_DISPLACEMENT 8000.0
+
+// Is a point hidden by a sphere (everything is relative to the camera), the segment towards the point has to cross the sphere
+static bool point_hidden(const double3& point, const double3& center, double radius)
+{
+    double t = std::min(std::max(dot(center, point) / dot(point, point), 0.0), 1.0);
+    return length(center - point * t) < radius;
+}
+
+static float3 to_float3(const double3& v)
+{
+    return { (float)v.x, (float)v.y, (float)v.z };
+}
+
+static void test_horizon_culling()
+{
+    // The surface of the planet is displaced inside [radius - displacement, radius + displacement]
+    std::mt19937 generator(5);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    auto random_direction = [&]()
+    {
+        double z = 2.0 * unit(generator) - 1.0, phi = 6.283185307179586 * unit(generator);
+        double r = sqrt(1.0 - z * z);
+        return double3({ r * cos(phi), r * sin(phi), z });
+    };
+    const double planetRadius = CPU_TESTS_PLANET_RADIUS;
+    const double maxDisplacement = HORIZON_TEST_MAX_DISPLACEMENT;
+    const double occluderRadius = planetRadius - maxDisplacement;
+
+    uint32_t numCulled = 0, numVisibleSamples = 0, numInsideCulled = 0;
+    for (uint32_t cameraIdx = 0; cameraIdx < HORIZON_TEST_CAMERAS; ++cameraIdx)
+    {
+        // Cameras from inside of the occluder up to far in space (one in four is inside of the occluder)
+        bool insideOccluder = (cameraIdx % 4) == 0;
+        double altitude = insideOccluder ? -maxDisplacement * (1.0 + unit(generator)) : -maxDisplacement + pow(10.0, 8.0 * unit(generator));
+        double3 camera = random_direction() * (planetRadius + altitude);
+        double3 planetCenter = camera * -1.0;
+
+        for (uint32_t bisectorIdx = 0; bisectorIdx < HORIZON_TEST_BISECTORS; ++bisectorIdx)
+        {
+            // Flat triangle with its corners on the planet, from a few meters to a few hundred kilometers wide. Most of them are
+            // placed around the horizon of the camera, where the bounds of the bisector matter
+            double size = pow(10.0, 0.5 + 5.0 * unit(generator));
+            double3 normal = random_direction();
+            if (!insideOccluder && bisectorIdx % 4 != 0)
+            {
+                double3 up = normalize(camera);
+                double3 side = normalize(cross(up, random_direction()));
+                double angle = acos(occluderRadius / length(camera)) + acos(occluderRadius / planetRadius) + (3.0 * unit(generator) - 1.0) * size / planetRadius;
+                normal = up * cos(angle) + side * sin(angle);
+            }
+            double3 tangent = normalize(cross(normal, random_direction()));
+            double3 bitangent = cross(normal, tangent);
+            double3 corners[3];
+            for (uint32_t cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+            {
+                double angle = 6.283185307179586 * (cornerIdx + 0.3 * unit(generator)) / 3.0;
+                corners[cornerIdx] = normalize(normal * planetRadius + (tangent * cos(angle) + bitangent * sin(angle)) * size) * planetRadius;
+            }
+
+            bool culled = horizon_bisector_culled(to_float3(corners[0] - camera), to_float3(corners[1] - camera), to_float3(corners[2] - camera),
+                to_float3(planetCenter), (float)planetRadius, (float)maxDisplacement);
+            if (!culled)
+                continue;
+            numCulled++;
+            numInsideCulled += insideOccluder;
+
+            // Every point of the displaced surface inside of the bisector must be behind the occluder
+            for (uint32_t sampleIdx = 0; sampleIdx < HORIZON_TEST_SAMPLES; ++sampleIdx)
+            {
+                double u = unit(generator), v = unit(generator);
+                if (u + v > 1.0)
+                {
+                    u = 1.0 - u;
+                    v = 1.0 - v;
+                }
+                // The corners and the edges are the hardest cases
+                if (sampleIdx < 3)
+                {
+                    u = sampleIdx == 1 ? 1.0 : 0.0;
+                    v = sampleIdx == 2 ? 1.0 : 0.0;
+                }
+                double3 direction = normalize(corners[0] * (1.0 - u - v) + corners[1] * u + corners[2] * v);
+                double height = sampleIdx % 2 == 0 ? maxDisplacement : (2.0 * unit(generator) - 1.0) * maxDisplacement;
+                numVisibleSamples += !point_hidden(direction * (planetRadius + height) - camera, planetCenter, occluderRadius);
+            }
+        }
+    }
+    CHECK(numCulled > 0, "No bisector was culled by the horizon.");
+    CHECK(numInsideCulled == 0, "Bisectors are culled when the camera is inside of the occluder.");
+    CHECK(numVisibleSamples == 0, "Horizon culled bisectors have visible points.");
+
+    // Spheres around the planet, only the ones that are fully hidden may be culled
+    uint32_t numCulledSpheres = 0, numVisibleSpheres = 0;
+    for (uint32_t sphereIdx = 0; sphereIdx < HORIZON_TEST_CAMERAS * HORIZON_TEST_BISECTORS; ++sphereIdx)
+    {
+        double3 camera = random_direction() * (planetRadius + pow(10.0, 2.0 + 6.0 * unit(generator)));
+        double3 sphereCenter = random_direction() * planetRadius * (0.9 + 0.2 * unit(generator)) - camera;
+        double sphereRadius = pow(10.0, 1.0 + 5.0 * unit(generator));
+        if (!horizon_sphere_culled(to_float3(camera * -1.0), (float)occluderRadius, to_float3(sphereCenter), (float)sphereRadius))
+            continue;
+        numCulledSpheres++;
+        bool visible = !point_hidden(sphereCenter, camera * -1.0, occluderRadius);
+        for (uint32_t sampleIdx = 0; sampleIdx < HORIZON_TEST_SAMPLES && !visible; ++sampleIdx)
+            visible = !point_hidden(sphereCenter + random_direction() * sphereRadius, camera * -1.0, occluderRadius);
+        numVisibleSpheres += visible;
+    }
+    CHECK(numCulledSpheres > 0, "No sphere was culled by the horizon.");
+    CHECK(numVisibleSpheres == 0, "Horizon culled spheres have visible points.");
+}
+
+// Triangle of a bisector on the planet, relative to the origin (laid out like the current vertex buffer)
+static void bisector_triangle(const CPUMesh& mesh, uint64_t heapID, const double3& origin, float3* triangle)
+{
+    double3 positions[4];
+    decode_bisector_positions(mesh, heapID, positions);
+    for (uint32_t cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+    {
+        double3 position = normalize(positions[cornerIdx]) * CPU_TESTS_PLANET_RADIUS - origin;
+        triangle[cornerIdx] = { (float)position.x, (float)position.y, (float)position.z };
+    }
+}
+
+// Closest hit of a ray against every allocated bisector
+static bool brute_force_intersect(const std::vector<uint64_t>& heapIDArray, const std::vector<float3>& vertices, const double3& origin, const BVHRay& ray, BVHHit& hit)
+{
+    hit = BVHHit();
+    double3 rayOrigin = ray.origin - origin;
+    float3 localOrigin = { (float)rayOrigin.x, (float)rayOrigin.y, (float)rayOrigin.z };
+    float tMax = ray.tMax;
+    for (uint32_t elementID = 0; elementID < (uint32_t)heapIDArray.size(); ++elementID)
+    {
+        if (heapIDArray[elementID] == 0)
+            continue;
+
+        const float3* triangle = &vertices[3 * elementID];
+        float3 edge0 = triangle[1] - triangle[0];
+        float3 edge1 = triangle[2] - triangle[0];
+        float3 p = cross(ray.direction, edge1);
+        float det = dot(edge0, p);
+        if (fabsf(det) < 1e-30f)
+            continue;
+        float invDet = 1.0f / det;
+        float3 s = localOrigin - triangle[0];
+        float u = dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f)
+            continue;
+        float3 q = cross(s, edge0);
+        float v = dot(ray.direction, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f)
+            continue;
+        float t = dot(edge1, q) * invDet;
+        if (t < 0.0f || t >= tMax)
+            continue;
+        tMax = t;
+        hit.t = t;
+        hit.element = elementID;
+    }
+    return hit.element != BVH_INVALID_INDEX;
+}
+
+// Compares the queries of the tree to the brute force ones for random rays cast from the origin towards the planet
+static void check_bvh_queries(const BisectorBVH& bvh, const std::vector<uint64_t>& heapIDArray, const std::vector<float3>& vertices, const double3& origin, std::mt19937& generator)
+{
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    float3 down = normalize(float3({ (float)-origin.x, (float)-origin.y, (float)-origin.z }));
+    uint32_t numMismatches = 0, numOcclusionMismatches = 0, numPacketMismatches = 0;
+    for (uint32_t packetIdx = 0; packetIdx < 64; ++packetIdx)
+    {
+        BVHRay rays[4];
+        for (uint32_t rayIdx = 0; rayIdx < 4; ++rayIdx)
+        {
+            float3 offset = { distribution(generator), distribution(generator), distribution(generator) };
+            rays[rayIdx] = { origin, normalize(down + offset * 0.6f), (float)(3.0 * CPU_TESTS_PLANET_RADIUS) };
+        }
+
+        BVHHit packetHits[4];
+        bvh.intersect_packet(rays, packetHits);
+        for (uint32_t rayIdx = 0; rayIdx < 4; ++rayIdx)
+        {
+            // Rays that hit a shared edge can report either triangle, only the distances are compared
+            BVHHit hit, reference;
+            bool hitFound = bvh.intersect(rays[rayIdx], hit);
+            bool referenceFound = brute_force_intersect(heapIDArray, vertices, origin, rays[rayIdx], reference);
+            float tolerance = 1e-4f * reference.t;
+            if (hitFound != referenceFound || (referenceFound && fabsf(hit.t - reference.t) > tolerance))
+                numMismatches++;
+            if (bvh.occluded(rays[rayIdx]) != referenceFound)
+                numOcclusionMismatches++;
+            bool packetFound = packetHits[rayIdx].element != BVH_INVALID_INDEX;
+            if (packetFound != referenceFound || (referenceFound && fabsf(packetHits[rayIdx].t - reference.t) > tolerance))
+                numPacketMismatches++;
+        }
+    }
+    CHECK(numMismatches == 0, "Closest hits don't match the brute force ones.");
+    CHECK(numOcclusionMismatches == 0, "Occlusion doesn't match the brute force hits.");
+    CHECK(numPacketMismatches == 0, "Packet hits don't match the brute force ones.");
+}
+
+static void test_bisector_bvh(const CPUMesh& mesh)
+{
+    // Random refinement of the base patches
+    std::mt19937 generator(3);
+    const uint64_t baseHeapID = 1ull << (mesh.minimalDepth - 1);
+    const uint32_t numPatches = (uint32_t)(mesh.basePoints.size() / 3);
+    std::vector<uint64_t> heapIDArray;
+    std::vector<uint64_t> stack;
+    for (uint32_t patchIdx = 0; patchIdx < numPatches; ++patchIdx)
+        stack.push_back(baseHeapID + patchIdx);
+    while (!stack.empty())
+    {
+        uint64_t heapID = stack.back();
+        stack.pop_back();
+        uint32_t depth = find_msb_64(heapID) - mesh.minimalDepth;
+        if (depth < 12 && (depth < 6 || generator() % 4 != 0))
+        {
+            stack.push_back(2 * heapID);
+            stack.push_back(2 * heapID + 1);
+        }
+        else
+            heapIDArray.push_back(heapID);
+    }
+
+    // Unallocated slots scattered between the bisectors, like on the GPU
+    heapIDArray.resize(heapIDArray.size() * 5 / 4, 0);
+    std::shuffle(heapIDArray.begin(), heapIDArray.end(), generator);
+
+    // Camera slightly above the surface
+    double3 origin = normalize(double3({ 0.3, 0.9, 0.2 })) * (CPU_TESTS_PLANET_RADIUS + 2000.0);
+    std::vector<float3> vertices(3 * heapIDArray.size());
+    for (uint32_t elementID = 0; elementID < (uint32_t)heapIDArray.size(); ++elementID)
+    {
+        if (heapIDArray[elementID] != 0)
+            bisector_triangle(mesh, heapIDArray[elementID], origin, &vertices[3 * elementID]);
+    }
+
+    BisectorBVH bvh;
+    bvh.build(heapIDArray, vertices, origin);
+    check_bvh_queries(bvh, heapIDArray, vertices, origin, generator);
+
+    // Merges free the slot of the second child, splits reuse arbitrary free slots
+    for (uint32_t updateIdx = 0; updateIdx < 4; ++updateIdx)
+    {
+        std::vector<uint32_t> freeSlots;
+        std::unordered_map<uint64_t, uint32_t> elementOfHeapID;
+        for (uint32_t elementID = 0; elementID < (uint32_t)heapIDArray.size(); ++elementID)
+        {
+            if (heapIDArray[elementID] == 0)
+                freeSlots.push_back(elementID);
+            else
+                elementOfHeapID[heapIDArray[elementID]] = elementID;
+        }
+        std::shuffle(freeSlots.begin(), freeSlots.end(), generator);
+
+        std::vector<uint32_t> modifiedElements;
+        uint32_t numMerges = 0;
+        for (const auto& bisector : elementOfHeapID)
+        {
+            uint64_t heapID = bisector.first;
+            if (numMerges == 256 || (heapID & 1) != 0 || find_msb_64(heapID) <= mesh.minimalDepth + 6)
+                continue;
+            auto sibling = elementOfHeapID.find(heapID | 1);
+            if (sibling == elementOfHeapID.end() || heapIDArray[bisector.second] != heapID || heapIDArray[sibling->second] != (heapID | 1))
+                continue;
+            heapIDArray[bisector.second] = heapID >> 1;
+            heapIDArray[sibling->second] = 0;
+            bisector_triangle(mesh, heapID >> 1, origin, &vertices[3 * bisector.second]);
+            modifiedElements.push_back(bisector.second);
+            numMerges++;
+        }
+
+        for (uint32_t freeIdx = 0; freeIdx < (uint32_t)freeSlots.size() && freeIdx < 256; ++freeIdx)
+        {
+            uint32_t freeSlot = freeSlots[freeIdx];
+            uint32_t splitSlot;
+            do
+            {
+                splitSlot = generator() % (uint32_t)heapIDArray.size();
+            } while (heapIDArray[splitSlot] == 0 || splitSlot == freeSlot);
+
+            uint64_t heapID = heapIDArray[splitSlot];
+            heapIDArray[splitSlot] = 2 * heapID;
+            heapIDArray[freeSlot] = 2 * heapID + 1;
+            bisector_triangle(mesh, 2 * heapID, origin, &vertices[3 * splitSlot]);
+            bisector_triangle(mesh, 2 * heapID + 1, origin, &vertices[3 * freeSlot]);
+            modifiedElements.push_back(splitSlot);
+            modifiedElements.push_back(freeSlot);
+        }
+
+        // Only the allocated elements are listed (like the indexed bisectors)
+        std::sort(modifiedElements.begin(), modifiedElements.end());
+        modifiedElements.erase(std::unique(modifiedElements.begin(), modifiedElements.end()), modifiedElements.end());
+        modifiedElements.erase(std::remove_if(modifiedElements.begin(), modifiedElements.end(), [&heapIDArray](uint32_t elementID) { return heapIDArray[elementID] == 0; }), modifiedElements.end());
+        bvh.refit(heapIDArray, vertices, origin, modifiedElements.data(), (uint32_t)modifiedElements.size());
+    }
+    check_bvh_queries(bvh, heapIDArray, vertices, origin, generator);
+}
+
+static void test_mesh_snapshot(const char* scratchPath)
+{
+    // Sparse allocation with a neighbor layout that isn't a multiple of the word size
+    const uint32_t numElements = 1000;
+    const uint32_t neighborsElementSize = 12;
+    std::vector<uint64_t> heapIDArray(numElements, 0);
+    std::vector<char> neighborsArray(numElements * neighborsElementSize, 7);
+    for (uint32_t elementID = 0; elementID < numElements; elementID += 3)
+        heapIDArray[elementID] = elementID + 1;
+
+    CBTMeshSnapshot snapshot;
+    snapshot.totalNumElements = numElements;
+    snapshot.neighborsElementSize = neighborsElementSize;
+    snapshot.baseMeshHash = 0x0123456789ABCDEFull;
+    snapshot.cbtBufferCount = 2;
+    snapshot.cbtBuffers[0].assign(10, 1);
+    snapshot.cbtBuffers[1].assign(5, 2);
+    compact_cbt_mesh_snapshot(heapIDArray.data(), neighborsArray.data(), snapshot);
+    CHECK(save_cbt_mesh_snapshot(snapshot, scratchPath), "Failed to write the snapshot.");
+
+    CBTMeshSnapshot loadedSnapshot;
+    CHECK(load_cbt_mesh_snapshot(scratchPath, loadedSnapshot), "Failed to read the snapshot.");
+    remove(scratchPath);
+    CHECK(loadedSnapshot.baseMeshHash == snapshot.baseMeshHash, "Base mesh hash doesn't survive the round trip.");
+    CHECK(loadedSnapshot.cbtBufferCount == 2 && loadedSnapshot.cbtBuffers[0] == snapshot.cbtBuffers[0] && loadedSnapshot.cbtBuffers[1] == snapshot.cbtBuffers[1], "CBT buffers don't survive the round trip.");
+
+    // The expansion overwrites every element
+    std::vector<uint64_t> expandedHeapIDArray(numElements, 5);
+    std::vector<char> expandedNeighborsArray(numElements * neighborsElementSize, 9);
+    expand_cbt_mesh_snapshot(loadedSnapshot, expandedHeapIDArray.data(), expandedNeighborsArray.data());
+    uint32_t numMismatches = 0;
+    for (uint32_t elementID = 0; elementID < numElements; ++elementID)
+    {
+        char expectedNeighbors = heapIDArray[elementID] != 0 ? 7 : 0;
+        numMismatches += expandedHeapIDArray[elementID] != heapIDArray[elementID];
+        for (uint32_t byteIdx = 0; byteIdx < neighborsElementSize; ++byteIdx)
+            numMismatches += expandedNeighborsArray[elementID * neighborsElementSize + byteIdx] != expectedNeighbors;
+    }
+    CHECK(numMismatches == 0, "Bisectors don't survive the round trip.");
+}
+
+static void test_mesh_export_import(const CPUMesh& mesh, const char* objPath, const char* binaryPath)
+{
+    // Uniform subdivision of the base patches, shuffled with unallocated slots
+    std::mt19937 generator(1);
+    const uint32_t numSubdivisions = CPU_TESTS_EXPORT_SUBDIVISIONS;
+    std::vector<uint64_t> bisectors;
+    for (uint64_t baseHeapID : mesh.heapIDArray)
+    {
+        for (uint64_t childIdx = 0; childIdx < (1ull << numSubdivisions); ++childIdx)
+            bisectors.push_back((baseHeapID << numSubdivisions) + childIdx);
+    }
+    std::vector<uint64_t> heapIDArray(bisectors.size() + bisectors.size() / 8, 0);
+    std::vector<uint32_t> slots(heapIDArray.size());
+    for (uint32_t slotIdx = 0; slotIdx < (uint32_t)slots.size(); ++slotIdx)
+        slots[slotIdx] = slotIdx;
+    std::shuffle(slots.begin(), slots.end(), generator);
+    for (uint32_t bisectorIdx = 0; bisectorIdx < (uint32_t)bisectors.size(); ++bisectorIdx)
+        heapIDArray[slots[bisectorIdx]] = bisectors[bisectorIdx];
+    std::vector<uint3> neighborsArray;
+    derive_neighbors(mesh, heapIDArray, neighborsArray);
+
+    // A closed conforming mesh is welded into a sphere
+    const uint32_t numTriangles = (uint32_t)bisectors.size();
+    MeshExportStats objStats, binaryStats;
+    CHECK(export_bisector_mesh(mesh, heapIDArray, neighborsArray, nullptr, CPU_TESTS_PLANET_RADIUS, MeshExportFormat::OBJ, objPath, objStats), "Failed to export the OBJ mesh.");
+    CHECK(export_bisector_mesh(mesh, heapIDArray, neighborsArray, nullptr, CPU_TESTS_PLANET_RADIUS, MeshExportFormat::Binary, binaryPath, binaryStats), "Failed to export the binary mesh.");
+    CHECK(objStats.numTriangles == numTriangles && objStats.numVertices == numTriangles / 2 + 2, "Exported OBJ mesh isn't welded.");
+    CHECK(binaryStats.numTriangles == numTriangles && binaryStats.numVertices == numTriangles / 2 + 2, "Exported binary mesh isn't welded.");
+
+    // Read back the binary blocks, the triangles are in element order
+    std::vector<double3> vertices;
+    std::vector<uint3> triangles;
+    uint64_t fileSize = 0;
+    FILE* binaryFile = fopen(binaryPath, "rb");
+    CHECK(binaryFile != nullptr, "Failed to open the binary mesh.");
+    if (binaryFile != nullptr)
+    {
+        uint32_t header[6] = {};
+        bool valid = fread(header, sizeof(uint32_t), 6, binaryFile) == 6 && header[2] == binaryStats.numVertices && header[3] == binaryStats.numTriangles;
+        for (uint32_t blockIdx = 0; valid && blockIdx < header[4]; ++blockIdx)
+        {
+            uint32_t blockCounts[2];
+            valid = fread(blockCounts, sizeof(uint32_t), 2, binaryFile) == 2;
+            size_t firstVertex = vertices.size(), firstTriangle = triangles.size();
+            vertices.resize(firstVertex + blockCounts[0]);
+            triangles.resize(firstTriangle + blockCounts[1]);
+            valid = valid && fread(vertices.data() + firstVertex, sizeof(double3), blockCounts[0], binaryFile) == blockCounts[0];
+            valid = valid && fread(triangles.data() + firstTriangle, sizeof(uint3), blockCounts[1], binaryFile) == blockCounts[1];
+        }
+        fileSize = (uint64_t)ftell(binaryFile);
+        fclose(binaryFile);
+        CHECK(valid && vertices.size() == binaryStats.numVertices && triangles.size() == binaryStats.numTriangles, "Binary mesh doesn't match its header.");
+        CHECK(fileSize == binaryStats.fileSize, "Binary mesh size doesn't match the stats.");
+    }
+
+    if (triangles.size() == numTriangles)
+    {
+        double maxError = 0.0;
+        uint32_t triangleIdx = 0;
+        for (uint32_t elementID = 0; elementID < (uint32_t)heapIDArray.size(); ++elementID)
+        {
+            if (heapIDArray[elementID] == 0)
+                continue;
+            double3 positions[4];
+            decode_bisector_positions(mesh, heapIDArray[elementID], positions);
+            const uint3& triangle = triangles[triangleIdx++];
+            const uint32_t indices[3] = { triangle.z, triangle.y, triangle.x };
+            for (uint32_t cornerIdx = 0; cornerIdx < 3; ++cornerIdx)
+                maxError = std::max(maxError, length(vertices[indices[cornerIdx]] - positions[cornerIdx] * CPU_TESTS_PLANET_RADIUS));
+        }
+        CHECK(maxError < 1e-3, "Binary mesh vertices don't match the bisectors.");
+    }
+
+    // The exported OBJ is imported back as a closed mesh
+    std::vector<float3> importedVertices;
+    std::vector<uint32_t> halfedgeVertices;
+    std::vector<uint3> halfedgeNeighbors;
+    CHECK(import_polygon_mesh(objPath, importedVertices, halfedgeVertices, halfedgeNeighbors), "Failed to import the exported mesh.");
+    CHECK(importedVertices.size() == objStats.numVertices && halfedgeVertices.size() == 3 * (size_t)numTriangles, "Imported mesh doesn't match the export.");
+    uint32_t numInvalidTwins = 0;
+    for (uint32_t halfedgeIdx = 0; halfedgeIdx < (uint32_t)halfedgeNeighbors.size(); ++halfedgeIdx)
+    {
+        const uint3& neighbors = halfedgeNeighbors[halfedgeIdx];
+        uint32_t twin = neighbors.z;
+        bool valid = twin != INVALID_POINTER && halfedgeNeighbors[twin].z == halfedgeIdx;
+        // The twin starts where the halfedge ends
+        valid = valid && halfedgeVertices[twin] == halfedgeVertices[neighbors.y];
+        numInvalidTwins += !valid;
+    }
+    CHECK(numInvalidTwins == 0, "Imported mesh isn't closed.");
+    remove(objPath);
+    remove(binaryPath);
+}
+
+// Closed pyramid (a quad and four triangles) imported from the PLY files
+static const float g_PLYTestVertices[5][3] = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.5f, 0.5f, 1.0f } };
+static const uint32_t g_PLYTestFaceOffsets[6] = { 0, 4, 7, 10, 13, 16 };
+static const uint32_t g_PLYTestFaceVertices[16] = { 0, 3, 2, 1, 0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4 };
+
+// Binary values are written in the byte order of the format (the host is little endian)
+static void write_ply_value(FILE* plyFile, bool bigEndian, const void* value, uint32_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)value;
+    for (uint32_t byteIdx = 0; byteIdx < size; ++byteIdx)
+        fputc(bytes[bigEndian ? size - 1 - byteIdx : byteIdx], plyFile);
+}
+
+// Writes the pyramid with properties that the importer skips (a vertex color and a face flag after the indices)
+static bool write_ply_pyramid(const char* plyPath, const char* format)
+{
+    FILE* plyFile = fopen(plyPath, "wb");
+    if (plyFile == nullptr)
+        return false;
+    fprintf(plyFile, "ply\nformat %s 1.0\ncomment pyramid\nelement vertex 5\nproperty float x\nproperty float y\nproperty float z\nproperty uchar red\n", format);
+    fprintf(plyFile, "element face 5\nproperty list uchar int vertex_indices\nproperty uchar flags\nend_header\n");
+    bool ascii = strcmp(format, "ascii") == 0;
+    bool bigEndian = strcmp(format, "binary_big_endian") == 0;
+    const uint8_t extra = 7;
+    for (uint32_t vertexIdx = 0; vertexIdx < 5; ++vertexIdx)
+    {
+        const float* position = g_PLYTestVertices[vertexIdx];
+        if (ascii)
+            fprintf(plyFile, "%.9g %.9g %.9g %u\n", position[0], position[1], position[2], extra);
+        else
+        {
+            for (uint32_t coordIdx = 0; coordIdx < 3; ++coordIdx)
+                write_ply_value(plyFile, bigEndian, &position[coordIdx], sizeof(float));
+            write_ply_value(plyFile, bigEndian, &extra, 1);
+        }
+    }
+    for (uint32_t faceIdx = 0; faceIdx < 5; ++faceIdx)
+    {
+        uint8_t count = (uint8_t)(g_PLYTestFaceOffsets[faceIdx + 1] - g_PLYTestFaceOffsets[faceIdx]);
+        if (ascii)
+            fprintf(plyFile, "%u", count);
+        else
+            write_ply_value(plyFile, bigEndian, &count, 1);
+        for (uint32_t vertexIdx = g_PLYTestFaceOffsets[faceIdx]; vertexIdx < g_PLYTestFaceOffsets[faceIdx + 1]; ++vertexIdx)
+        {
+            int32_t index = (int32_t)g_PLYTestFaceVertices[vertexIdx];
+            if (ascii)
+                fprintf(plyFile, " %d", index);
+            else
+                write_ply_value(plyFile, bigEndian, &index, sizeof(int32_t));
+        }
+        if (ascii)
+            fprintf(plyFile, " %u\n", extra);
+        else
+            write_ply_value(plyFile, bigEndian, &extra, 1);
+    }
+    fclose(plyFile);
+    return true;
+}
+
+static bool write_text_file(const char* filePath, const char* content)
+{
+    FILE* file = fopen(filePath, "wb");
+    if (file == nullptr)
+        return false;
+    fputs(content, file);
+    fclose(file);
+    return true;
+}
+
+static void test_ply_import(const char* plyPath)
+{
+    // The three formats give the same closed mesh, the quad keeps its four halfedges
+    for (const char* format : { "ascii", "binary_little_endian", "binary_big_endian" })
+    {
+        std::vector<float3> vertices;
+        std::vector<uint32_t> halfedgeVertices;
+        std::vector<uint3> halfedgeNeighbors;
+        bool imported = write_ply_pyramid(plyPath, format) && import_polygon_mesh(plyPath, vertices, halfedgeVertices, halfedgeNeighbors);
+        CHECK(imported, (std::string("Failed to import the ") + format + " PLY mesh.").c_str());
+        CHECK(!imported || (vertices.size() == 5 && halfedgeVertices.size() == 16), "Imported PLY mesh doesn't have the pyramid's vertices and halfedges.");
+        if (!imported || vertices.size() != 5 || halfedgeVertices.size() != 16)
+            continue;
+
+        uint32_t numMismatches = 0;
+        for (uint32_t vertexIdx = 0; vertexIdx < 5; ++vertexIdx)
+        {
+            const float* position = g_PLYTestVertices[vertexIdx];
+            numMismatches += vertices[vertexIdx].x != position[0] || vertices[vertexIdx].y != position[1] || vertices[vertexIdx].z != position[2];
+        }
+        for (uint32_t faceIdx = 0; faceIdx < 5; ++faceIdx)
+        {
+            uint32_t begin = g_PLYTestFaceOffsets[faceIdx], end = g_PLYTestFaceOffsets[faceIdx + 1];
+            for (uint32_t halfedgeIdx = begin; halfedgeIdx < end; ++halfedgeIdx)
+            {
+                const uint3& neighbors = halfedgeNeighbors[halfedgeIdx];
+                uint32_t twin = neighbors.z;
+                numMismatches += halfedgeVertices[halfedgeIdx] != g_PLYTestFaceVertices[halfedgeIdx];
+                numMismatches += neighbors.x != (halfedgeIdx == begin ? end - 1 : halfedgeIdx - 1) || neighbors.y != (halfedgeIdx + 1 == end ? begin : halfedgeIdx + 1);
+                numMismatches += twin == INVALID_POINTER || halfedgeNeighbors[twin].z != halfedgeIdx || halfedgeVertices[twin] != halfedgeVertices[neighbors.y];
+            }
+        }
+        CHECK(numMismatches == 0, "Imported PLY mesh doesn't match the written one.");
+    }
+
+    // Negative or fractional list counts and indices, and counts that overflow, are rejected
+    const char* header = "ply\nformat ascii 1.0\nelement vertex 3\nproperty float x\nproperty float y\nproperty float z\n";
+    const char* faces = "element face 1\nproperty list uchar int vertex_indices\nend_header\n0 0 0\n1 0 0\n0 1 0\n";
+    const char* overflowHeader = "ply\nformat ascii 1.0\nelement vertex 123456789012345678901234567890\nproperty float x\nproperty float y\nproperty float z\n";
+    const std::string validFile = std::string(header) + faces + "3 0 1 2\n";
+    const std::string invalidContents[] = {
+        std::string(header) + faces + "-3 0 1 2\n",
+        std::string(header) + faces + "2.5 0 1 2\n",
+        std::string(header) + faces + "3 0 -1 2\n",
+        std::string(header) + faces + "3 0 1.5 2\n",
+        std::string(overflowHeader) + faces + "3 0 1 2\n",
+    };
+    std::vector<float3> vertices;
+    std::vector<uint32_t> halfedgeVertices;
+    std::vector<uint3> halfedgeNeighbors;
+    CHECK(write_text_file(plyPath, validFile.c_str()) && import_polygon_mesh(plyPath, vertices, halfedgeVertices, halfedgeNeighbors), "Failed to import a valid PLY triangle.");
+    uint32_t numAccepted = 0;
+    for (const std::string& content : invalidContents)
+    {
+        vertices.clear();
+        halfedgeVertices.clear();
+        halfedgeNeighbors.clear();
+        numAccepted += write_text_file(plyPath, content.c_str()) && import_polygon_mesh(plyPath, vertices, halfedgeVertices, halfedgeNeighbors);
+    }
+    CHECK(numAccepted == 0, "Invalid PLY counts or indices are accepted.");
+    remove(plyPath);
+}
+
+int main(int argc, char** argv)
+{
+    // If no project directory was specified, we take the working directory as a project dir
+    std::string projectDir = argc == 2 ? argv[1] : ".";
+
+    // Load the base mesh
+    CPUMesh mesh;
+    load_cpu_mesh((projectDir + "\\models\\icosahedron.ccm").c_str(), CPU_TESTS_CBT_ELEMENTS, mesh);
+
+    // The scratch files are written in the working directory
+    printf("Bisector data layout\n");
+    test_bisector_data_layout(projectDir);
+    printf("CPU mesh\n");
+    test_cpu_mesh(mesh);
+    printf("CPU update\n");
+    test_cpu_update(mesh);
+    printf("Horizon culling\n");
+    test_horizon_culling();
+    printf("Bisector BVH\n");
+    test_bisector_bvh(mesh);
+    printf("Mesh snapshot\n");
+    test_mesh_snapshot("cpu_tests.snapshot");
+    printf("Mesh export and import\n");
+    test_mesh_export_import(mesh, "cpu_tests_export.obj", "cpu_tests_export.mesh");
+    printf("PLY import\n");
+    test_ply_import("cpu_tests_import.ply");
+
+    printf("%u failed checks\n", g_NumFailures);
+    return g_NumFailures == 0 ? 0 : 1;
+}
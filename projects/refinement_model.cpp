@@ -0,0 +1,388 @@
+// Project includes
+#include "cbt/bisector.h"
+#include "math/cubic_spline.h"
+#include "math/operators.h"
+#include "mesh/cpu_mesh.h"
+#include "mesh/cpu_update.h"
+#include "render_pipeline/constants.h"
+#include "rendering/frustum.h"
+#include "rendering/horizon_culling.h"
+#include "tools/parallel_for.h"
+
+// System includes
+#include <algorithm>
+#include <fstream>
+#include <math.h>
+#include <sstream>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Number of elements of the CBT the earth is refined in (default CBT of the demo)
+#define MODEL_CBT_ELEMENTS (1 << 17)
+// Update camera of the demo
+#define MODEL_SCREEN_WIDTH 1920
+#define MODEL_SCREEN_HEIGHT 1080
+#define MODEL_FRAME_RATE 60.0
+// Default predictive refinement properties of the demo
+#define MODEL_LOOKAHEAD_TIME 0.5
+#define MODEL_PREDICTIVE_SPLIT_BUDGET 4096
+// Finite split budget the predicted splits compete with
+#define MODEL_SPLIT_BUDGET 2048
+// Minimal number of elements classified by a thread
+#define MODEL_CLASSIFICATION_RANGE 4096
+// Default number of elements per bisector an update can create (see Planet::initialize)
+#define MODEL_BISECTIONS_RATIO 8
+// Number of views of the path the convergence from the base mesh is measured for, and maximal number of updates it can take
+#define MODEL_CONVERGENCE_VIEWS 8
+#define MODEL_MAX_CONVERGENCE_UPDATES 64
+
+// How the splits that only the predicted view requests are processed
+enum class PredictionMode
+{
+    // The predicted view isn't classified
+    None,
+    // They are converted to regular requests within their budget and share the split list with them
+    SharedList,
+    // They have their own list, processed after the regular requests within what they leave of the split budget
+    SeparateList
+};
+
+// Update camera, everything is relative to its position
+struct ModelView
+{
+    double3 position;
+    float3 forward;
+    float4x4 viewProj;
+    Frustum frustum;
+    float numPixels;
+};
+
+// Camera path in the format of the camera controller
+struct ModelPath
+{
+    float duration = 0.0f;
+    std::vector<double3> positionSpline;
+    std::vector<float4> rotationSpline;
+};
+
+// Under-refined fraction of the frames the earth is updated in
+struct ModelResult
+{
+    uint32_t numFrames = 0;
+    double meanFraction = 0.0;
+    double maxFraction = 0.0;
+    uint32_t numUnderRefinedFrames = 0;
+};
+
+// Number of updates the earth takes to converge from the base mesh for a static update camera
+struct ConvergenceResult
+{
+    uint32_t numViews = 0;
+    double meanUpdates = 0.0;
+    uint32_t maxUpdates = 0;
+    // Number of views that didn't converge within MODEL_MAX_CONVERGENCE_UPDATES updates
+    uint32_t numUnconvergedViews = 0;
+};
+
+static bool load_model_path(const std::string& pathPath, ModelPath& path)
+{
+    std::ifstream pathFile;
+    pathFile.open(pathPath);
+    if (!pathFile.is_open())
+        return false;
+
+    // Number of control points and duration
+    uint32_t numPoints;
+    pathFile >> numPoints;
+    pathFile >> path.duration;
+    path.positionSpline.resize(numPoints);
+    path.rotationSpline.resize(numPoints);
+
+    std::string line;
+    for (uint32_t ptIdx = 0; ptIdx < numPoints; ++ptIdx)
+    {
+        pathFile >> line;
+        std::istringstream iss(line);
+        double3& position = path.positionSpline[ptIdx];
+        float4& rotation = path.rotationSpline[ptIdx];
+        char s;
+        iss >> rotation.x >> s >> rotation.y >> s >> rotation.z >> s >> rotation.w >> s >> position.x >> s >> position.y >> s >> position.z;
+
+        // Sanitize the rotation like the playback
+        if (ptIdx > 0 && length(rotation + path.rotationSpline[ptIdx - 1]) < length(rotation - path.rotationSpline[ptIdx - 1]))
+            rotation = negate(rotation);
+    }
+    return numPoints >= 2;
+}
+
+// Mirrors the path playback and the automatic clipping of the camera controller
+static void evaluate_model_view(const ModelPath& path, double playTime, ModelView& view)
+{
+    view.position = evaluate_catmull_rom_spline<double3, double>(path.positionSpline, playTime / path.duration, true);
+    float4 rotation = normalize(evaluate_catmull_rom_spline<float4, float>(path.rotationSpline, (float)(playTime / path.duration), true));
+    float4x4 viewMatrix = quaternion_to_matrix(rotation);
+
+    double earthDistance = length(view.position - g_EarthCenter);
+    double moonDistance = length(view.position - g_MoonCenter);
+    double earthElevation = earthDistance - g_EarthRadius;
+    double moonElevation = moonDistance - g_MoonRadius;
+    double nearP = 0.1, farP = 200000.0;
+    if (earthElevation >= 2000.0 && moonElevation >= 5000.0)
+    {
+        nearP = std::min(earthElevation, moonElevation) / 50.0;
+        double earthFar = std::max(sqrt(earthDistance * earthDistance - g_EarthRadius * g_EarthRadius) * 2.0, 100.0);
+        double moonFar = std::max(sqrt(moonDistance * moonDistance - g_MoonRadius * g_MoonRadius) * 2.0, 100.0);
+        farP = std::min(earthFar, moonFar);
+    }
+
+    float4x4 projection = projection_matrix(g_CameraFOV, (float)nearP, (float)farP, MODEL_SCREEN_WIDTH / (float)MODEL_SCREEN_HEIGHT);
+    view.viewProj = mul(projection, viewMatrix);
+    view.forward = { viewMatrix.m[2], viewMatrix.m[6], viewMatrix.m[10] };
+    view.numPixels = (float)(MODEL_SCREEN_WIDTH * MODEL_SCREEN_HEIGHT);
+    extract_planes_from_view_projection_matrix(view.viewProj, view.frustum);
+}
+
+static bool frustum_aabb_intersect(const Frustum& frustum, const float3& aabbMin, const float3& aabbMax)
+{
+    float3 center = (aabbMax + aabbMin) * 0.5f;
+    float3 extents = (aabbMax - aabbMin) * 0.5f;
+    for (uint32_t planeIdx = 0; planeIdx < 4; ++planeIdx)
+    {
+        const Plane& plane = frustum.planes[planeIdx];
+        float3 testPoint = { center.x + (plane.normal.x > 0.0f ? extents.x : -extents.x),
+                             center.y + (plane.normal.y > 0.0f ? extents.y : -extents.y),
+                             center.z + (plane.normal.z > 0.0f ? extents.z : -extents.z) };
+        if (dot(testPoint, plane.normal) + plane.d < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+// The shaders read the matrices in column major order
+static float2 project_on_screen(const float4x4& viewProj, const float3& p)
+{
+    float4 pP = mul(transpose(viewProj), float4({ p.x, p.y, p.z, 1.0f }));
+    return { pP.x / pP.w * 0.5f + 0.5f, pP.y / pP.w * 0.5f + 0.5f };
+}
+
+// Mirrors ClassifyBisectorView (horizon culling enabled, no simplification hysteresis, unbounded depth)
+static int32_t classify_bisector_view(const double3 positions[4], uint32_t depth, const ModelView& view, float& area)
+{
+    area = 0.0f;
+
+    // Positions relative to the camera
+    float3 p[4];
+    for (uint32_t pIdx = 0; pIdx < 4; ++pIdx)
+    {
+        double3 pR = positions[pIdx] * (double)g_EarthRadius + g_EarthCenter - view.position;
+        p[pIdx] = { (float)pR.x, (float)pR.y, (float)pR.z };
+    }
+
+    // Visibility
+    float3 triNormal = normalize(cross(p[2] - p[1], p[0] - p[1]));
+    float3 viewDir = normalize(negate((p[0] + p[1] + p[2]) / 3.0f));
+    float FdotV = dot(viewDir, view.forward);
+    float VdotN = dot(viewDir, triNormal);
+    if (FdotV < 0.0f && VdotN < -1e-3f)
+        return BACK_FACE_CULLED;
+
+    double3 planetCenter = g_EarthCenter - view.position;
+    if (horizon_bisector_culled(p[0], p[1], p[2], { (float)planetCenter.x, (float)planetCenter.y, (float)planetCenter.z }, g_EarthRadius, g_EarthMaxDisplacement))
+        return HORIZON_CULLED;
+
+    float3 aabbMin = { std::min(std::min(p[0].x, p[1].x), p[2].x), std::min(std::min(p[0].y, p[1].y), p[2].y), std::min(std::min(p[0].z, p[1].z), p[2].z) };
+    float3 aabbMax = { std::max(std::max(p[0].x, p[1].x), p[2].x), std::max(std::max(p[0].y, p[1].y), p[2].y), std::max(std::max(p[0].z, p[1].z), p[2].z) };
+    if (!frustum_aabb_intersect(view.frustum, aabbMin, aabbMax))
+        return FRUSTUM_CULLED;
+
+    // Projected area, over estimated at grazing angles
+    float2 p0P = project_on_screen(view.viewProj, p[0]);
+    float2 p1P = project_on_screen(view.viewProj, p[1]);
+    float2 p2P = project_on_screen(view.viewProj, p[2]);
+    float areaOverestimation = 2.0f + (1.0f - 2.0f) * powf(VdotN, 0.2f);
+    area = 0.5f * fabsf(p0P.x * (p2P.y - p1P.y) + p1P.x * (p0P.y - p2P.y) + p2P.x * (p1P.y - p0P.y)) * view.numPixels * areaOverestimation;
+
+    if (g_EarthTriangleSize < area && depth < 63)
+        return BISECT_ELEMENT;
+    else if (g_EarthTriangleSize * 0.5f > area)
+    {
+        float2 p3P = project_on_screen(view.viewProj, p[3]);
+        float areaParent = 0.5f * fabsf(p0P.x * (p2P.y - p3P.y) + p3P.x * (p0P.y - p2P.y) + p2P.x * (p3P.y - p0P.y)) * view.numPixels * areaOverestimation;
+        return g_EarthTriangleSize >= areaParent ? TOO_SMALL : UNCHANGED_ELEMENT;
+    }
+    return UNCHANGED_ELEMENT;
+}
+
+// Mirrors ClassifyBisector and the under-refined area measurement of ClassifyElement, returns the under-refined fraction of the screen
+static double classify_elements(const CPUMesh& mesh, const CPUMeshState& state, const ModelView& view, const ModelView* predictedView, std::vector<int32_t>& validityArray)
+{
+    const uint32_t totalNumElements = (uint32_t)state.heapIDArray.size();
+    std::vector<float> underRefinedArray(totalNumElements, 0.0f);
+    parallel_for(totalNumElements, MODEL_CLASSIFICATION_RANGE, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t elementID = begin; elementID < end; ++elementID)
+        {
+            uint64_t heapID = state.heapIDArray[elementID];
+            if (heapID == 0)
+                continue;
+            double3 positions[4];
+            decode_bisector_positions(mesh, heapID, positions);
+            uint32_t depth = find_msb_64(heapID);
+
+            float area, predictedArea;
+            int32_t validity = classify_bisector_view(positions, depth, view, area);
+            if (area > g_EarthTriangleSize && depth < 63)
+                underRefinedArray[elementID] = std::min(area, view.numPixels);
+
+            if (predictedView != nullptr && validity < BISECT_ELEMENT)
+            {
+                int32_t predictedValidity = classify_bisector_view(positions, depth, *predictedView, predictedArea);
+                validity = predictedValidity == BISECT_ELEMENT ? PREDICTED_BISECT_ELEMENT : std::max(validity, predictedValidity);
+            }
+            validityArray[elementID] = validity;
+        }
+    });
+
+    double underRefinedArea = 0.0;
+    for (float area : underRefinedArray)
+        underRefinedArea += area;
+    return std::min(underRefinedArea / view.numPixels, 1.0);
+}
+
+// Plays the path at the frame rate of the demo and updates the earth once per frame while it's updatable
+static void run_model(const CPUMesh& mesh, const ModelPath& path, PredictionMode mode, const CPUUpdateBudgets& budgets, ModelResult& result)
+{
+    CPUMeshState state;
+    init_cpu_mesh_state(mesh, state);
+    std::vector<int32_t> validityArray(state.heapIDArray.size(), UNCHANGED_ELEMENT);
+
+    const uint32_t numFrames = (uint32_t)(path.duration * MODEL_FRAME_RATE);
+    ModelView view, predictedView;
+    double3 previousPosition = {};
+    for (uint32_t frameIdx = 0; frameIdx < numFrames; ++frameIdx)
+    {
+        evaluate_model_view(path, frameIdx / MODEL_FRAME_RATE, view);
+        double3 velocity = frameIdx > 0 ? (view.position - previousPosition) * MODEL_FRAME_RATE : double3({ 0.0, 0.0, 0.0 });
+        previousPosition = view.position;
+        if (length(view.position - g_EarthCenter) >= g_EarthImpostorToggle * 1.5)
+            continue;
+
+        // The predicted view only moves along the velocity
+        predictedView = view;
+        predictedView.position = view.position + velocity * MODEL_LOOKAHEAD_TIME;
+        double fraction = classify_elements(mesh, state, view, mode != PredictionMode::None ? &predictedView : nullptr, validityArray);
+
+        // The shared list turns the predicted requests within their budget into regular ones (in element order)
+        if (mode == PredictionMode::SharedList)
+        {
+            uint32_t numPredictedRequests = 0;
+            for (int32_t& validity : validityArray)
+            {
+                if (validity == PREDICTED_BISECT_ELEMENT)
+                    validity = numPredictedRequests++ < budgets.predictiveSplitBudget ? BISECT_ELEMENT : UNCHANGED_ELEMENT;
+            }
+        }
+
+        CPUUpdateStats stats;
+        update_cpu_mesh_state(mesh, validityArray, budgets, state, stats);
+
+        result.numFrames++;
+        result.meanFraction += fraction;
+        result.maxFraction = std::max(result.maxFraction, fraction);
+        result.numUnderRefinedFrames += fraction > 0.01;
+    }
+    result.meanFraction /= std::max(result.numFrames, 1u);
+}
+
+// Updates the base mesh for every view until the under-refined fraction of the screen is under 1% (without hysteresis, the topology can keep
+// flipping a few bisectors once converged)
+static void run_convergence(const CPUMesh& mesh, const std::vector<ModelView>& views, const CPUUpdateBudgets& budgets, ConvergenceResult& result)
+{
+    std::vector<int32_t> validityArray;
+    for (const ModelView& view : views)
+    {
+        CPUMeshState state;
+        init_cpu_mesh_state(mesh, state);
+        validityArray.assign(state.heapIDArray.size(), UNCHANGED_ELEMENT);
+
+        uint32_t numUpdates = 0;
+        bool converged = classify_elements(mesh, state, view, nullptr, validityArray) <= 0.01;
+        while (!converged && numUpdates < MODEL_MAX_CONVERGENCE_UPDATES)
+        {
+            CPUUpdateStats stats;
+            update_cpu_mesh_state(mesh, validityArray, budgets, state, stats);
+            numUpdates++;
+            converged = classify_elements(mesh, state, view, nullptr, validityArray) <= 0.01;
+        }
+
+        result.numViews++;
+        result.meanUpdates += numUpdates;
+        result.maxUpdates = std::max(result.maxUpdates, numUpdates);
+        result.numUnconvergedViews += converged ? 0 : 1;
+    }
+    result.meanUpdates /= std::max(result.numViews, 1u);
+}
+
+int main(int argc, char** argv)
+{
+    // Project directory and camera path (in the paths directory)
+    std::string projectDir = argc >= 2 ? argv[1] : ".";
+    std::string pathName = argc >= 3 ? argv[2] : "loop_demo.csv";
+
+    CPUMesh mesh;
+    load_cpu_mesh((projectDir + "\\models\\icosahedron.ccm").c_str(), MODEL_CBT_ELEMENTS, mesh);
+    ModelPath path;
+    if (!load_model_path(projectDir + "\\paths\\" + pathName, path))
+    {
+        printf("Can't load the path %s\n", pathName.c_str());
+        return 1;
+    }
+
+    // Under-refined fraction of the update camera with the demo's budgets, and with a finite split budget
+    const char* modeNames[] = { "none", "shared list", "separate list" };
+    printf("split budget;prediction;frames;mean under-refined;max under-refined;frames above 1%%\n");
+    for (uint32_t splitBudget : { (uint32_t)UINT32_MAX, (uint32_t)MODEL_SPLIT_BUDGET })
+    {
+        CPUUpdateBudgets budgets;
+        budgets.splitBudget = splitBudget;
+        budgets.predictiveSplitBudget = MODEL_PREDICTIVE_SPLIT_BUDGET;
+        budgets.maxNewBisectors = MODEL_CBT_ELEMENTS / MODEL_BISECTIONS_RATIO;
+        for (PredictionMode mode : { PredictionMode::None, PredictionMode::SharedList, PredictionMode::SeparateList })
+        {
+            ModelResult result;
+            run_model(mesh, path, mode, budgets, result);
+            printf("%s;%s;%u;%.3f%%;%.3f%%;%u\n", splitBudget == UINT32_MAX ? "unlimited" : std::to_string(splitBudget).c_str(), modeNames[(uint32_t)mode],
+                result.numFrames, result.meanFraction * 100.0, result.maxFraction * 100.0, result.numUnderRefinedFrames);
+        }
+    }
+
+    // Views of the path the earth is updated in, evenly spread
+    std::vector<ModelView> updatedViews;
+    const uint32_t numFrames = (uint32_t)(path.duration * MODEL_FRAME_RATE);
+    for (uint32_t frameIdx = 0; frameIdx < numFrames; ++frameIdx)
+    {
+        ModelView view;
+        evaluate_model_view(path, frameIdx / MODEL_FRAME_RATE, view);
+        if (length(view.position - g_EarthCenter) < g_EarthImpostorToggle * 1.5)
+            updatedViews.push_back(view);
+    }
+    std::vector<ModelView> convergenceViews;
+    for (uint32_t viewIdx = 0; viewIdx < MODEL_CONVERGENCE_VIEWS && !updatedViews.empty(); ++viewIdx)
+        convergenceViews.push_back(updatedViews[(viewIdx * 2 + 1) * updatedViews.size() / (MODEL_CONVERGENCE_VIEWS * 2)]);
+
+    // Convergence from the base mesh and under-refined fraction along the path (without prediction) for the bound on the new bisectors of an update
+    printf("\nbisections ratio;max new bisectors;mean updates to converge;max updates to converge;unconverged views;mean under-refined;max under-refined;frames above 1%%\n");
+    for (uint32_t bisectionsRatio : { 16u, 8u, 4u, 2u, 1u })
+    {
+        CPUUpdateBudgets budgets;
+        budgets.maxNewBisectors = MODEL_CBT_ELEMENTS / bisectionsRatio;
+        ConvergenceResult convergence;
+        run_convergence(mesh, convergenceViews, budgets, convergence);
+        ModelResult result;
+        run_model(mesh, path, PredictionMode::None, budgets, result);
+        printf("%u;%u;%.2f;%u;%u;%.3f%%;%.3f%%;%u\n", bisectionsRatio, budgets.maxNewBisectors, convergence.meanUpdates, convergence.maxUpdates, convergence.numUnconvergedViews,
+            result.meanFraction * 100.0, result.maxFraction * 100.0, result.numUnderRefinedFrames);
+    }
+    return 0;
+}
@@ -5,6 +5,7 @@
 #define INVALID_POINTER 4294967295
 
 // Possible culling state
+#define HORIZON_CULLED -4
 #define BACK_FACE_CULLED -3
 #define FRUSTUM_CULLED -2
 #define TOO_SMALL -1
@@ -12,11 +13,39 @@
 #define BISECT_ELEMENT 1
 #define SIMPLIFY_ELEMENT 2
 #define MERGED_ELEMENT 3
+// Split only requested by the predicted view
+#define PREDICTED_BISECT_ELEMENT 4
 
 // Bisector flags
 #define VISIBLE_BISECTOR 0x1
 #define MODIFIED_BISECTOR 0x2
 
+// Offsets of the bisector data fields in the structure of arrays layout
+#define BISECTOR_DATA_SUBDIVISION_PATTERN 0
+#define BISECTOR_DATA_INDICES 1
+#define BISECTOR_DATA_PROBLEMATIC_NEIGHBOR 4
+#define BISECTOR_DATA_STATE 5
+#define BISECTOR_DATA_FLAGS 6
+#define BISECTOR_DATA_PROPAGATION_ID 7
+#define BISECTOR_DATA_NUM_FIELDS 8
+
+// Packed neighbors layout, three 21 bit indices in a 64 bit word, the all ones field encodes INVALID_POINTER
+#define PACKED_NEIGHBOR_BITS 21
+#define PACKED_NEIGHBOR_MASK 0x1FFFFFuLL
+
+// Number of slots of the heapID table per element
+#define HEAP_ID_HASH_LOAD_RATIO 2
+
+// The neighbors are updated in place: each bisection records the new neighbors of its (up to four) bisectors in a side buffer
+// sized for the maximal number of new bisectors of an update (see resize_neighbors_update_buffer), which bounds the number of bisections
+#define NEIGHBORS_UPDATE_RECORDS 4
+
+// Bisectors are clustered under their ancestor CLUSTER_SUBTREE_DEPTH levels up (or their base patch)
+#define CLUSTER_SUBTREE_DEPTH 7
+#define CLUSTER_MAX_ELEMENTS (1 << CLUSTER_SUBTREE_DEPTH)
+// Number of slots of the cluster table per element
+#define CLUSTER_HASH_LOAD_RATIO 2
+
 struct BisectorData
 {
     // Subvision that should be applied to this bisector
@@ -55,4 +84,25 @@ uint HeapIDDepth(uint64_t heapID)
 }
 #endif
 
+uint64_t PackNeighbor(uint neighborID)
+{
+    return neighborID == INVALID_POINTER ? PACKED_NEIGHBOR_MASK : uint64_t(neighborID);
+}
+
+uint UnpackNeighbor(uint64_t packedNeighbors, uint slot)
+{
+    uint neighborID = uint((packedNeighbors >> (slot * PACKED_NEIGHBOR_BITS)) & PACKED_NEIGHBOR_MASK);
+    return neighborID == uint(PACKED_NEIGHBOR_MASK) ? INVALID_POINTER : neighborID;
+}
+
+uint64_t PackNeighbors(uint3 neighbors)
+{
+    return PackNeighbor(neighbors.x) | (PackNeighbor(neighbors.y) << PACKED_NEIGHBOR_BITS) | (PackNeighbor(neighbors.z) << (2 * PACKED_NEIGHBOR_BITS));
+}
+
+uint3 UnpackNeighbors(uint64_t packedNeighbors)
+{
+    return uint3(UnpackNeighbor(packedNeighbors, 0), UnpackNeighbor(packedNeighbors, 1), UnpackNeighbor(packedNeighbors, 2));
+}
+
 #endif // BISECTOR_H
\ No newline at end of file
@@ -17,6 +17,9 @@
 #define EARTH_MATERIAL 1
 #define MOON_MATERIAL 2
 
+// Slot of the welded vertex counter in the welded draw arguments (read by the deformations)
+#define WELDED_VERTEX_COUNTER 5
+
 // Included after the constants
 #if !defined(FP64_UNSUPPORTED)
     #include "shader_lib/double_math.hlsl"
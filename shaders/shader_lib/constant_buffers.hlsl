@@ -74,6 +74,10 @@ cbuffer GeometryCB : register(GEOMETRY_CB_BINDING_SLOT)
     uint32_t _TotalNumVertices;
     // Material ID
     uint32_t _MaterialID;
+    // First base bisector (the elements before it are unallocated when the mesh is created)
+    uint32_t _FirstBaseElement;
+    // Maximal number of bisectors an update can create (capacity of the neighbors update buffer)
+    uint32_t _MaxNewBisectors;
 };
 #endif
 
@@ -109,6 +113,29 @@ cbuffer DeformationCB : register(DEFORMATION_CB_BINDING_SLOT)
 #endif
 
 #if defined(UPDATE_CB_BINDING_SLOT)
+// Maximal number of views that are classified on top of the update camera
+#define MAX_ADDITIONAL_UPDATE_VIEWS 3
+
+// Additional view of the classification
+struct UpdateView
+{
+    // View projection matrix of the view (relative to its own position)
+    float4x4 _ViewProjectionMatrix;
+
+    // Position of the view relative to the update camera
+    float3 _CameraPosition;
+    // Number of pixels of the view
+    float _NumPixels;
+
+    // Camera forward vector
+    float3 _CameraForward;
+    // Padding
+    float _PaddingUV0;
+
+    // Frustum planes
+    Plane _FrustumPlanes[6];
+};
+
 cbuffer UpdateCB : register(UPDATE_CB_BINDING_SLOT)
 {
     // View projection matrix used for the update
@@ -145,6 +172,59 @@ cbuffer UpdateCB : register(UPDATE_CB_BINDING_SLOT)
 
     // Frustum planes
     Plane _FrustumPlanes[6];
+
+    // Fragmentation ratio above which the bisectors get compacted
+    float _CompactionThreshold;
+    // Epoch of the incremental classification (0 if disabled)
+    uint32_t _ClassificationEpoch;
+    // Distance traveled by the camera since the start of the classification epoch
+    float _ClassificationTravel;
+    // Bound on the projected area change caused by the camera rotation within the epoch
+    float _ClassificationRotationBound;
+
+    // Planet center relative to the update camera
+    float3 _UpdatePlanetCenter;
+    // Radius of the planet
+    float _UpdatePlanetRadius;
+
+    // Maximal displacement of the planet surface
+    float _MaxDisplacement;
+    // Is the horizon culling enabled
+    uint32_t _HorizonCulling;
+    // Are whole base patches culled before the classification
+    uint32_t _PatchCulling;
+    // Number of additional views
+    uint32_t _NumAdditionalViews;
+
+    // Views that are classified on top of the update camera
+    UpdateView _AdditionalViews[MAX_ADDITIONAL_UPDATE_VIEWS];
+
+    // Is the update running asynchronously to the rendering
+    uint32_t _AsyncUpdate;
+    // Maximal number of split and simplification requests processed by an update
+    uint32_t _SplitBudget;
+    uint32_t _SimplifyBudget;
+    // Index of the update, used to evaluate the age of the bisectors
+    uint32_t _UpdateIndex;
+
+    // Number of updates before a newly split bisector can be simplified
+    uint32_t _MinBisectorAge;
+    // Relative width of the band between the split and simplification thresholds
+    float _SimplifyHysteresis;
+    // Number of updates within which a split followed by a merge (or the opposite) is counted as churn
+    uint32_t _ChurnWindow;
+    float _PaddingUB1;
+
+    // Extrapolation of the update camera a few frames ahead
+    UpdateView _PredictedView;
+
+    // Is the predicted view classified
+    uint32_t _PredictiveRefinement;
+    // Maximal number of split requests that only come from the predicted view, they are processed after the other ones within what they leave of _SplitBudget
+    uint32_t _PredictiveSplitBudget;
+    // Are the LEB positions derived from the cached ones of a parent or child when possible
+    uint32_t _IncrementalLEB;
+    float _PaddingUB2;
 };
 #endif
 
@@ -24,4 +24,33 @@ bool FrustumAABBIntersect(in Plane frustumPlanes[6], float3 aabbMin, float3 aabb
     return true;
 }
 
+bool FrustumSphereIntersect(in Plane frustumPlanes[6], float3 center, float radius)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        Plane plane = frustumPlanes[i];
+        if (dot(center, plane.normal) + plane.d < -radius)
+            return false;
+    }
+    return true;
+}
+
+// Frustum planes of a view projection matrix, in the same order as the ones extracted on the CPU
+void ExtractFrustumPlanes(float4x4 viewProjectionMatrix, out Plane frustumPlanes[6])
+{
+    float4 planes[6];
+    planes[0] = viewProjectionMatrix[3] + viewProjectionMatrix[0];
+    planes[1] = viewProjectionMatrix[3] - viewProjectionMatrix[0];
+    planes[2] = viewProjectionMatrix[3] + viewProjectionMatrix[1];
+    planes[3] = viewProjectionMatrix[3] - viewProjectionMatrix[1];
+    planes[4] = viewProjectionMatrix[3] + viewProjectionMatrix[2];
+    planes[5] = viewProjectionMatrix[3] - viewProjectionMatrix[2];
+    for (int i = 0; i < 6; i++)
+    {
+        float invLength = 1.0 / length(planes[i].xyz);
+        frustumPlanes[i].normal = planes[i].xyz * invLength;
+        frustumPlanes[i].d = planes[i].w * invLength;
+    }
+}
+
 #endif //FRUSTUM_CULLING_H
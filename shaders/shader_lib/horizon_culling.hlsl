@@ -0,0 +1,45 @@
+#ifndef HORIZON_CULLING_H
+#define HORIZON_CULLING_H
+
+// Is a sphere fully hidden by the occluder sphere of the planet (everything is relative to the camera)
+bool HorizonSphereCulled(float3 planetCenter, float occluderRadius, float3 sphereCenter, float sphereRadius)
+{
+    // The camera is inside of the occluder
+    float planetDistance2 = dot(planetCenter, planetCenter);
+    float occluderRadius2 = occluderRadius * occluderRadius;
+    if (planetDistance2 <= occluderRadius2)
+        return false;
+
+    // Every point of the sphere needs to be further than the horizon
+    float sphereDistance = length(sphereCenter);
+    float horizonDistance = sqrt(planetDistance2 - occluderRadius2);
+    if (sphereDistance - sphereRadius < horizonDistance)
+        return false;
+
+    // The sphere needs to be inside of the cone tangent to the occluder
+    float planetDistance = sqrt(planetDistance2);
+    float sinAlpha = occluderRadius / planetDistance;
+    float sinBeta = sphereRadius / sphereDistance;
+    if (sinBeta >= sinAlpha)
+        return false;
+    float cosAlpha = horizonDistance / planetDistance;
+    float cosBeta = sqrt(1.0 - sinBeta * sinBeta);
+    float cosTheta = dot(sphereCenter, planetCenter) / (sphereDistance * planetDistance);
+    return cosTheta >= cosAlpha * cosBeta + sinAlpha * sinBeta;
+}
+
+// Is a bisector hidden behind the horizon of the planet (everything is relative to the camera)
+bool HorizonBisectorCulled(float3 p0, float3 p1, float3 p2, float3 planetCenter, float planetRadius, float maxDisplacement)
+{
+    // Bounding sphere of the flat triangle
+    float3 center = (p0 + p1 + p2) / 3.0;
+    float radius = max(max(length(p0 - center), length(p1 - center)), length(p2 - center));
+
+    // Account for the curvature of the planet and for the displacement of the surface inside the bisector
+    radius += radius * radius / planetRadius + 2.0 * maxDisplacement;
+
+    // The occluder is the sphere below the lowest point of the surface
+    return HorizonSphereCulled(planetCenter, planetRadius - maxDisplacement, center, radius);
+}
+
+#endif //HORIZON_CULLING_H
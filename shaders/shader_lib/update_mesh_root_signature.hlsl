@@ -18,7 +18,7 @@
 // Bisector buffers
 #define HEAP_ID_BUFFER_BINDING_SLOT UAV_SLOT(2)
 #define NEIGHBORS_BUFFER_BINDING_SLOT UAV_SLOT(3)
-#define NEIGHBORS_OUTPUT_BUFFER_BINDING_SLOT UAV_SLOT(4)
+#define NEIGHBORS_UPDATE_BUFFER_BINDING_SLOT UAV_SLOT(4)
 
 // Intermediate buffers
 #define BISECTOR_DATA_BUFFER_BINDING_SLOT UAV_SLOT(5)
@@ -38,9 +38,39 @@
 // Debug
 #define VALIDATION_BUFFER_BINDING_SLOT UAV_SLOT(16)
 
+// Compaction buffers
+#define COMPACTION_BUFFER_BINDING_SLOT UAV_SLOT(17)
+#define COMPACTION_REMAP_BUFFER_BINDING_SLOT UAV_SLOT(18)
+#define COMPACTION_HEAP_ID_BUFFER_BINDING_SLOT UAV_SLOT(19)
+
+// Classification cache
+#define CLASSIFICATION_CACHE_BUFFER_BINDING_SLOT UAV_SLOT(20)
+
+// Base patch culling
+#define PATCH_BOUNDS_BUFFER_BINDING_SLOT UAV_SLOT(21)
+#define PATCH_VISIBILITY_BUFFER_BINDING_SLOT UAV_SLOT(22)
+#define PATCH_CULLING_BUFFER_BINDING_SLOT UAV_SLOT(23)
+
+// Split/merge hysteresis
+#define BISECTOR_AGE_BUFFER_BINDING_SLOT UAV_SLOT(24)
+
+// Derived adjacency
+#define BASE_NEIGHBORS_BUFFER_BINDING_SLOT UAV_SLOT(25)
+#define HEAP_ID_HASH_BUFFER_BINDING_SLOT UAV_SLOT(26)
+
+// Cached LEB positions
+#define LEB_POSITION_BUFFER_BINDING_SLOT UAV_SLOT(27)
+#define LEB_POSITION_HEAP_ID_BUFFER_BINDING_SLOT UAV_SLOT(28)
+
+// Welded vertices
+#define VERTEX_INDEX_BUFFER_BINDING_SLOT UAV_SLOT(29)
+#define WELDED_VERTEX_BUFFER_BINDING_SLOT UAV_SLOT(30)
+#define WELDED_INDEX_BUFFER_BINDING_SLOT UAV_SLOT(31)
+#define WELDED_ARGS_BUFFER_BINDING_SLOT UAV_SLOT(32)
+
 // Counters
 #define NUM_SRV_BINDING_SLOTS 2
 #define NUM_CBV_BINDING_SLOTS 3
-#define NUM_UAV_BINDING_SLOTS 17
+#define NUM_UAV_BINDING_SLOTS 33
 
 #endif // UPDATE_MESH_ROOT_SIGNATURE_HLSL
\ No newline at end of file
@@ -6,11 +6,20 @@
 
 // Bisector buffers
 RWStructuredBuffer<uint64_t> _HeapIDBuffer: register(HEAP_ID_BUFFER_BINDING_SLOT);
+#if defined(PACKED_NEIGHBORS)
+RWStructuredBuffer<uint64_t> _NeighborsBuffer: register(NEIGHBORS_BUFFER_BINDING_SLOT);
+#else
 RWStructuredBuffer<uint3> _NeighborsBuffer: register(NEIGHBORS_BUFFER_BINDING_SLOT);
-RWStructuredBuffer<uint3> _NeighborsOutputBuffer: register(NEIGHBORS_OUTPUT_BUFFER_BINDING_SLOT);
+#endif
+// New neighbors written by the bisections (bisector, neighbors), scattered once every bisection is done
+RWStructuredBuffer<uint4> _NeighborsUpdateBuffer: register(NEIGHBORS_UPDATE_BUFFER_BINDING_SLOT);
 
 // Intermediate buffers
+#if defined(BISECTOR_DATA_SOA)
+RWStructuredBuffer<uint> _BisectorDataBuffer: register(BISECTOR_DATA_BUFFER_BINDING_SLOT);
+#else
 RWStructuredBuffer<BisectorData> _BisectorDataBuffer: register(BISECTOR_DATA_BUFFER_BINDING_SLOT);
+#endif
 RWStructuredBuffer<uint> _ClassificationBuffer: register(CLASSIFICATION_BUFFER_BINDING_SLOT);
 RWStructuredBuffer<uint> _SimplificationBuffer: register(SIMPLIFICATION_BUFFER_BINDING_SLOT);
 RWStructuredBuffer<int> _AllocateBuffer: register(ALLOCATE_BUFFER_BINDING_SLOT);
@@ -27,6 +36,36 @@ RWStructuredBuffer<uint> _ModifiedBisectorIndicesBuffer: register(MODIFIED_BISEC
 // Debug buffers
 RWStructuredBuffer<uint> _ValidationBuffer: register(VALIDATION_BUFFER_BINDING_SLOT);
 
+// Classification cache (last area, last distance, travel and epoch of the last classification)
+RWStructuredBuffer<float4> _ClassificationCacheBuffer: register(CLASSIFICATION_CACHE_BUFFER_BINDING_SLOT);
+
+// Base patch culling (bounding cone, visibility and bisectors of the visible patches)
+RWStructuredBuffer<float4> _PatchBoundsBuffer: register(PATCH_BOUNDS_BUFFER_BINDING_SLOT);
+RWStructuredBuffer<uint> _PatchVisibilityBuffer: register(PATCH_VISIBILITY_BUFFER_BINDING_SLOT);
+RWStructuredBuffer<uint> _PatchCullingBuffer: register(PATCH_CULLING_BUFFER_BINDING_SLOT);
+
+// Split/merge hysteresis (birth of the bisectors, compaction scratch and churn counters)
+RWStructuredBuffer<uint> _BisectorAgeBuffer: register(BISECTOR_AGE_BUFFER_BINDING_SLOT);
+
+// Derived adjacency (neighbor patches of the base patches and open addressing table from the heapIDs to the bisectors)
+RWStructuredBuffer<uint3> _BaseNeighborsBuffer: register(BASE_NEIGHBORS_BUFFER_BINDING_SLOT);
+RWStructuredBuffer<uint> _HeapIDHashBuffer: register(HEAP_ID_HASH_BUFFER_BINDING_SLOT);
+
+// Cached LEB positions (three vertices and the parent's fourth vertex per bisector, and the heapID they were evaluated for)
+RWStructuredBuffer<REAL3_DP> _LEBPositionBuffer: register(LEB_POSITION_BUFFER_BINDING_SLOT);
+RWStructuredBuffer<uint64_t> _LEBPositionHeapIDBuffer: register(LEB_POSITION_HEAP_ID_BUFFER_BINDING_SLOT);
+
+// Welded vertices (welded vertex of the corners, LEB position of the welded vertices, index buffer and its arguments)
+RWStructuredBuffer<uint> _VertexIndexBuffer: register(VERTEX_INDEX_BUFFER_BINDING_SLOT);
+RWStructuredBuffer<uint> _WeldedVertexBuffer: register(WELDED_VERTEX_BUFFER_BINDING_SLOT);
+RWStructuredBuffer<uint> _WeldedIndexBuffer: register(WELDED_INDEX_BUFFER_BINDING_SLOT);
+RWStructuredBuffer<uint> _WeldedArgsBuffer: register(WELDED_ARGS_BUFFER_BINDING_SLOT);
+
+// Compaction buffers
+RWStructuredBuffer<uint> _CompactionBuffer: register(COMPACTION_BUFFER_BINDING_SLOT);
+RWStructuredBuffer<uint> _CompactionRemapBuffer: register(COMPACTION_REMAP_BUFFER_BINDING_SLOT);
+RWStructuredBuffer<uint64_t> _CompactionHeapIDBuffer: register(COMPACTION_HEAP_ID_BUFFER_BINDING_SLOT);
+
 // Possible splits
 #define NO_SPLIT 0x00
 #define CENTER_SPLIT 0x01
@@ -39,15 +78,147 @@ RWStructuredBuffer<uint> _ValidationBuffer: register(VALIDATION_BUFFER_BINDING_S
 // Split buffer slots
 #define SPLIT_COUNTER 0
 #define SIMPLIFY_COUNTER 1
-#define CLASSIFY_COUNTER_OFFSET 2
+#define PREDICTED_SPLIT_COUNTER 2
+#define UNDER_REFINED_AREA_COUNTER 3
+#define CLASSIFY_COUNTER_OFFSET 4
+
+// Bisectors seen at a grazing angle are always re-classified
+#define CLASSIFICATION_CACHE_MIN_VDOTN 0.5
+
+// Patch culling buffer slots
+#define PATCH_CULLING_COUNTER 0
+#define PATCH_CULLING_LIST_OFFSET 1
+
+// Origin of a bisector (stored in the lowest bit of its birth)
+#define SPLIT_BIRTH 0
+#define MERGE_BIRTH 1
+
+// Churn counters (after the births and their compaction scratch)
+#define SPLIT_MERGE_CHURN_COUNTER 0
+#define MERGE_SPLIT_CHURN_COUNTER 1
+
+// Compaction buffer slots
+#define COMPACTION_SLOT_SPAN 0
+#define COMPACTION_BUCKET_OFFSET 1
+#define COMPACTION_BUCKET_BITS 16
+#define COMPACTION_NUM_BUCKETS (1 << COMPACTION_BUCKET_BITS)
+
+// Welded vertices
+#define WELDED_VERTEX_RATIO 2
+#define WELDED_MAX_VALENCE 32
+#define WELDED_OWNER_FLAG 0x80000000
+#define WELDED_DISPATCH_OFFSET 9
+
+// Bisector data accessors, they hide the layout of the bisector data buffer
+#if defined(BISECTOR_DATA_SOA)
+// Each field is stored in its own array of _TotalNumElements values
+#define BISECTOR_DATA_FIELD(FIELD, BISECTOR_ID) _BisectorDataBuffer[(FIELD) * _TotalNumElements + (BISECTOR_ID)]
+#define BISECTOR_SUBDIVISION_PATTERN(BISECTOR_ID) BISECTOR_DATA_FIELD(BISECTOR_DATA_SUBDIVISION_PATTERN, BISECTOR_ID)
+#define BISECTOR_INDEX(BISECTOR_ID, INDEX) BISECTOR_DATA_FIELD(BISECTOR_DATA_INDICES + (INDEX), BISECTOR_ID)
+#define BISECTOR_PROBLEMATIC_NEIGHBOR(BISECTOR_ID) BISECTOR_DATA_FIELD(BISECTOR_DATA_PROBLEMATIC_NEIGHBOR, BISECTOR_ID)
+#define BISECTOR_STATE(BISECTOR_ID) BISECTOR_DATA_FIELD(BISECTOR_DATA_STATE, BISECTOR_ID)
+#define BISECTOR_FLAGS(BISECTOR_ID) BISECTOR_DATA_FIELD(BISECTOR_DATA_FLAGS, BISECTOR_ID)
+#define BISECTOR_PROPAGATION_ID(BISECTOR_ID) BISECTOR_DATA_FIELD(BISECTOR_DATA_PROPAGATION_ID, BISECTOR_ID)
+#else
+#define BISECTOR_SUBDIVISION_PATTERN(BISECTOR_ID) _BisectorDataBuffer[BISECTOR_ID].subdivisionPattern
+#define BISECTOR_INDEX(BISECTOR_ID, INDEX) _BisectorDataBuffer[BISECTOR_ID].indices[INDEX]
+#define BISECTOR_PROBLEMATIC_NEIGHBOR(BISECTOR_ID) _BisectorDataBuffer[BISECTOR_ID].problematicNeighbor
+#define BISECTOR_STATE(BISECTOR_ID) _BisectorDataBuffer[BISECTOR_ID].bisectorState
+#define BISECTOR_FLAGS(BISECTOR_ID) _BisectorDataBuffer[BISECTOR_ID].flags
+#define BISECTOR_PROPAGATION_ID(BISECTOR_ID) _BisectorDataBuffer[BISECTOR_ID].propagationID
+#endif
+
+BisectorData LoadBisectorData(uint bisectorID)
+{
+#if defined(BISECTOR_DATA_SOA)
+    BisectorData bisectorData;
+    bisectorData.subdivisionPattern = BISECTOR_SUBDIVISION_PATTERN(bisectorID);
+    bisectorData.indices[0] = BISECTOR_INDEX(bisectorID, 0);
+    bisectorData.indices[1] = BISECTOR_INDEX(bisectorID, 1);
+    bisectorData.indices[2] = BISECTOR_INDEX(bisectorID, 2);
+    bisectorData.problematicNeighbor = BISECTOR_PROBLEMATIC_NEIGHBOR(bisectorID);
+    bisectorData.bisectorState = BISECTOR_STATE(bisectorID);
+    bisectorData.flags = BISECTOR_FLAGS(bisectorID);
+    bisectorData.propagationID = BISECTOR_PROPAGATION_ID(bisectorID);
+    return bisectorData;
+#else
+    return _BisectorDataBuffer[bisectorID];
+#endif
+}
+
+void StoreBisectorData(uint bisectorID, BisectorData bisectorData)
+{
+#if defined(BISECTOR_DATA_SOA)
+    BISECTOR_SUBDIVISION_PATTERN(bisectorID) = bisectorData.subdivisionPattern;
+    BISECTOR_INDEX(bisectorID, 0) = bisectorData.indices[0];
+    BISECTOR_INDEX(bisectorID, 1) = bisectorData.indices[1];
+    BISECTOR_INDEX(bisectorID, 2) = bisectorData.indices[2];
+    BISECTOR_PROBLEMATIC_NEIGHBOR(bisectorID) = bisectorData.problematicNeighbor;
+    BISECTOR_STATE(bisectorID) = bisectorData.bisectorState;
+    BISECTOR_FLAGS(bisectorID) = bisectorData.flags;
+    BISECTOR_PROPAGATION_ID(bisectorID) = bisectorData.propagationID;
+#else
+    _BisectorDataBuffer[bisectorID] = bisectorData;
+#endif
+}
+
+uint3 LoadNeighbors(uint bisectorID)
+{
+#if defined(PACKED_NEIGHBORS)
+    return UnpackNeighbors(_NeighborsBuffer[bisectorID]);
+#else
+    return _NeighborsBuffer[bisectorID];
+#endif
+}
+
+void StoreNeighbors(uint bisectorID, uint3 neighbors)
+{
+#if defined(PACKED_NEIGHBORS)
+    _NeighborsBuffer[bisectorID] = PackNeighbors(neighbors);
+#else
+    _NeighborsBuffer[bisectorID] = neighbors;
+#endif
+}
+
+// Replaces a single neighbor, the packed path goes through atomics as the propagation passes can patch different slots of the same bisector concurrently
+void SetNeighbor(uint bisectorID, uint slot, uint neighborID)
+{
+#if defined(PACKED_NEIGHBORS)
+    uint shift = slot * PACKED_NEIGHBOR_BITS;
+    InterlockedAnd(_NeighborsBuffer[bisectorID], ~(PACKED_NEIGHBOR_MASK << shift));
+    InterlockedOr(_NeighborsBuffer[bisectorID], PackNeighbor(neighborID) << shift);
+#else
+    _NeighborsBuffer[bisectorID][slot] = neighborID;
+#endif
+}
+
+void RecordNeighbors(uint recordID, uint bisectorID, uint3 neighbors)
+{
+    _NeighborsUpdateBuffer[recordID] = uint4(bisectorID, neighbors);
+}
+
+void ScatterNeighborsElement(uint dispatchID)
+{
+    // Every bisection is done, the neighbors can be written in place
+    uint recordID = NEIGHBORS_UPDATE_RECORDS * dispatchID;
+    for (uint recordIdx = 0; recordIdx < NEIGHBORS_UPDATE_RECORDS; ++recordIdx)
+    {
+        uint4 record = _NeighborsUpdateBuffer[recordID + recordIdx];
+        if (record.x != INVALID_POINTER)
+            StoreNeighbors(record.x, record.yzw);
+    }
+}
 
 void ResetBuffers()
 {
     _MemoryBuffer[0] = 0;
-    _MemoryBuffer[1] = cbt_size() - bit_count_buffer();
+    // The number of new bisectors is also bounded by the size of the neighbors update buffer
+    _MemoryBuffer[1] = min(cbt_size() - bit_count_buffer(), _MaxNewBisectors);
 
     _ClassificationBuffer[SPLIT_COUNTER] = 0;
     _ClassificationBuffer[SIMPLIFY_COUNTER] = 0;
+    _ClassificationBuffer[PREDICTED_SPLIT_COUNTER] = 0;
+    _ClassificationBuffer[UNDER_REFINED_AREA_COUNTER] = 0;
 
     _AllocateBuffer[0] = 0;
 
@@ -69,35 +240,118 @@ void ResetBuffers()
     _IndirectDrawBuffer[8] = 0;
 }
 
-void ClassifyElement(uint currentID, BisectorGeometry bis, uint totalNumElements, uint baseDepth)
+bool ClassificationCacheHit(uint currentID)
 {
-    // Evaluate the depth of the element
-    uint64_t heapID = _HeapIDBuffer[currentID];
-    uint depth = HeapIDDepth(heapID);
-    BisectorData cbisectorData = _BisectorDataBuffer[currentID];
+    // Incremental classification is disabled
+    if (_ClassificationEpoch == 0)
+        return false;
+
+    // Element was modified by the last update or its cache is from an other epoch
+    float4 cache = _ClassificationCacheBuffer[currentID];
+    if ((BISECTOR_FLAGS(currentID) & MODIFIED_BISECTOR) != 0 || asuint(cache.w) != _ClassificationEpoch)
+        return false;
+
+    // Upper bound of the camera displacement since the last classification (with a margin for the float precision)
+    float travel = (_ClassificationTravel - cache.z) + _ClassificationTravel * 1e-5;
+    float distance = cache.y;
+    if (travel >= distance)
+        return false;
+
+    // Bound of the projected area change (distance, view angle and rotation)
+    float areaBound = (distance + travel) / (distance - travel);
+    areaBound = areaBound * areaBound * (1.0 + travel / distance) * _ClassificationRotationBound;
+
+    // The element can neither be bisected nor simplified
+    return cache.x * areaBound <= _TriangleSize && cache.x >= _TriangleSize * 0.5 * areaBound;
+}
+
+void KeepElementUnchanged(uint currentID)
+{
+    // Same output as an unchanged visible element in ClassifyElement
+    BISECTOR_SUBDIVISION_PATTERN(currentID) = 0;
+    BISECTOR_PROBLEMATIC_NEIGHBOR(currentID) = INVALID_POINTER;
+    BISECTOR_STATE(currentID) = UNCHANGED_ELEMENT;
+    BISECTOR_FLAGS(currentID) = VISIBLE_BISECTOR;
+}
+
+void UpdateClassificationCache(uint currentID, BisectorGeometry bis, int validity, float area, float VdotN)
+{
+    // Only the elements that are far enough from both thresholds can be skipped later
+    bool cacheable = validity == UNCHANGED_ELEMENT && VdotN >= CLASSIFICATION_CACHE_MIN_VDOTN
+                    && area >= _TriangleSize * 0.5 && area <= _TriangleSize;
+
+    // Keep track of the measured area
+    float distance = length((bis.p[0] + bis.p[1] + bis.p[2]) / 3.0);
+    _ClassificationCacheBuffer[currentID] = float4(area, distance, _ClassificationTravel, asfloat(cacheable ? _ClassificationEpoch : 0));
+}
+
+void StampBisectorBirth(uint currentID, uint origin)
+{
+    _BisectorAgeBuffer[currentID] = (_UpdateIndex << 1) | origin;
+}
+
+uint BisectorAge(uint currentID)
+{
+    // Number of updates since the bisector was created (wraps with the update index)
+    return (_UpdateIndex - (_BisectorAgeBuffer[currentID] >> 1)) & 0x7fffffff;
+}
+
+bool RecentBirth(uint currentID, uint origin)
+{
+    return (_BisectorAgeBuffer[currentID] & 1) == origin && BisectorAge(currentID) < _ChurnWindow;
+}
+
+void RegisterChurn(uint counterIdx)
+{
+    InterlockedAdd(_BisectorAgeBuffer[2 * _TotalNumElements + counterIdx], 1);
+}
+
+uint ClassificationRequestCount(uint counterIdx)
+{
+    // Number of requests that the update processes for a given counter
+    if (counterIdx == SIMPLIFY_COUNTER)
+        return min(_ClassificationBuffer[SIMPLIFY_COUNTER], _SimplifyBudget);
+
+    // The predicted splits only get what the regular ones leave of the split budget
+    uint splitCount = min(_ClassificationBuffer[SPLIT_COUNTER], _SplitBudget);
+    if (counterIdx == PREDICTED_SPLIT_COUNTER)
+        return min(_ClassificationBuffer[PREDICTED_SPLIT_COUNTER], min(_PredictiveSplitBudget, _SplitBudget - splitCount));
+    return splitCount;
+}
+
+void RegisterClassification(uint currentID, uint64_t heapID, uint depth, int currentValidity, uint totalNumElements, uint baseDepth)
+{
+    BisectorData cbisectorData;
 
     // Reset some values
     cbisectorData.subdivisionPattern = 0;
     cbisectorData.bisectorState = UNCHANGED_ELEMENT;
     cbisectorData.problematicNeighbor = INVALID_POINTER;
     cbisectorData.flags = VISIBLE_BISECTOR;
-    
-    // Does this triangle intersect the circle?
-    int currentValidity = ClassifyBisector(bis, depth);
-    if (currentValidity > UNCHANGED_ELEMENT)
+
+    // The splits that only the predicted view requests fill the split list from its end, they are processed after the other ones.
+    // Their state stays unchanged so that they never block the path of a regular split.
+    if (currentValidity == PREDICTED_BISECT_ELEMENT)
+    {
+        uint predictedSlot;
+        InterlockedAdd(_ClassificationBuffer[PREDICTED_SPLIT_COUNTER], 1, predictedSlot);
+        _ClassificationBuffer[CLASSIFY_COUNTER_OFFSET + totalNumElements - 1 - predictedSlot] = currentID;
+    }
+    else if (currentValidity > UNCHANGED_ELEMENT)
     {
         // This element should be bisected
-        int targetSlot;
-        cbisectorData.bisectorState = BISECT_ELEMENT;
+        uint targetSlot;
         InterlockedAdd(_ClassificationBuffer[SPLIT_COUNTER], 1, targetSlot);
         _ClassificationBuffer[CLASSIFY_COUNTER_OFFSET + targetSlot] = currentID;
 
+        // Requests past the budget are deferred, they must not block the paths of the in-budget splits
+        cbisectorData.bisectorState = targetSlot < _SplitBudget ? BISECT_ELEMENT : UNCHANGED_ELEMENT;
     }
     else
         cbisectorData.flags = currentValidity >= TOO_SMALL ? VISIBLE_BISECTOR : 0;
 
-    // What's the validity of the father?
-    if (baseDepth != depth && currentValidity < UNCHANGED_ELEMENT)
+    // What's the validity of the father? (a bisector that was just split is kept for a few updates)
+    if (baseDepth != depth && currentValidity < UNCHANGED_ELEMENT && BisectorAge(currentID) >= _MinBisectorAge)
     {   
         // Mark that it requires simplification
         cbisectorData.bisectorState = SIMPLIFY_ELEMENT;
@@ -105,27 +359,122 @@ void ClassifyElement(uint currentID, BisectorGeometry bis, uint totalNumElements
         // Only register it if it has an even heapID, the odd ones will be processed by the even ones
         if (heapID % 2 == 0)
         {
-            int targetSlot;
+            uint targetSlot;
             InterlockedAdd(_ClassificationBuffer[SIMPLIFY_COUNTER], 1, targetSlot);
             _ClassificationBuffer[CLASSIFY_COUNTER_OFFSET + totalNumElements + targetSlot] = currentID;
+
+            // A deferred pair stays unchanged, which also prevents the twin diamond from merging it
+            if (targetSlot >= _SimplifyBudget)
+                cbisectorData.bisectorState = UNCHANGED_ELEMENT;
         }
     }
 
-    // Update the bisector data
-    _BisectorDataBuffer[currentID] = cbisectorData;
+    // Update the bisector data (the indices and propagation ID are always written before being read)
+    BISECTOR_SUBDIVISION_PATTERN(currentID) = cbisectorData.subdivisionPattern;
+    BISECTOR_PROBLEMATIC_NEIGHBOR(currentID) = cbisectorData.problematicNeighbor;
+    BISECTOR_STATE(currentID) = cbisectorData.bisectorState;
+    BISECTOR_FLAGS(currentID) = cbisectorData.flags;
+}
+
+void ClassifyElement(uint currentID, BisectorGeometry bis, uint totalNumElements, uint baseDepth)
+{
+    // Evaluate the depth of the element
+    uint64_t heapID = _HeapIDBuffer[currentID];
+    uint depth = HeapIDDepth(heapID);
+
+    // Does this triangle intersect the circle?
+    float area, VdotN;
+    int currentValidity = ClassifyBisector(bis, depth, area, VdotN);
+
+    // Measure the screen area covered by the bisectors that are too big for the update camera
+    if (area > _TriangleSize && depth < _MaxSubdivisionDepth)
+        InterlockedAdd(_ClassificationBuffer[UNDER_REFINED_AREA_COUNTER], (uint)min(area, _ScreenSize.x * _ScreenSize.y));
+
+    // Keep track of the result for the incremental classification
+    if (_ClassificationEpoch != 0)
+        UpdateClassificationCache(currentID, bis, currentValidity, area, VdotN);
+
+    // Flag the element and register it for the split or simplification passes
+    RegisterClassification(currentID, heapID, depth, currentValidity, totalNumElements, baseDepth);
+}
+
+bool PatchVisible(float3 center, float radius, in Plane frustumPlanes[6], float3 planetCenter)
+{
+    if (!FrustumSphereIntersect(frustumPlanes, center, radius))
+        return false;
+    return !_HorizonCulling || !HorizonSphereCulled(planetCenter, _UpdatePlanetRadius - _MaxDisplacement, center, radius);
+}
+
+void PatchCullingElement(uint patchID)
+{
+    // Reset the counter of the bisectors that need to be classified
+    if (patchID == 0)
+        _PatchCullingBuffer[PATCH_CULLING_COUNTER] = 0;
+
+    // This thread doesn't have any work to do, we're done
+    uint numPatches, stride;
+    _PatchBoundsBuffer.GetDimensions(numPatches, stride);
+    if (patchID >= numPatches)
+        return;
+
+    // Bounding sphere of the patch's cone, for every possible displacement of the surface (relative to the camera)
+    float4 cone = _PatchBoundsBuffer[patchID];
+    float3 center = _UpdatePlanetCenter + cone.xyz * _UpdatePlanetRadius;
+    float radius = sqrt(_MaxDisplacement * _MaxDisplacement + 2.0 * _UpdatePlanetRadius * (_UpdatePlanetRadius + _MaxDisplacement) * (1.0 - cone.w));
+
+    // Is the patch hidden behind the horizon or outside of the frustum?
+    bool visible = true;
+    if (_PatchCulling)
+    {
+        visible = PatchVisible(center, radius, _FrustumPlanes, _UpdatePlanetCenter);
+
+        // The patch needs to be hidden in every additional view
+        for (uint viewIdx = 0; viewIdx < _NumAdditionalViews && !visible; ++viewIdx)
+        {
+            UpdateView view = _AdditionalViews[viewIdx];
+            visible = PatchVisible(center - view._CameraPosition, radius, view._FrustumPlanes, _UpdatePlanetCenter - view._CameraPosition);
+        }
+
+        // And in the predicted view
+        if (_PredictiveRefinement && !visible)
+            visible = PatchVisible(center - _PredictedView._CameraPosition, radius, _PredictedView._FrustumPlanes, _UpdatePlanetCenter - _PredictedView._CameraPosition);
+    }
+    _PatchVisibilityBuffer[patchID] = visible ? 1 : 0;
+}
+
+void PatchCullingIndexationElement(uint currentID, uint totalNumElements, uint baseDepth)
+{
+    // Find the base patch of the bisector
+    uint64_t heapID = _HeapIDBuffer[currentID];
+    uint depth = HeapIDDepth(heapID);
+    uint patchID = uint(heapID >> (depth - baseDepth)) - (1u << (baseDepth - 1));
+
+    // The bisectors of the visible patches go through the classification
+    if (_PatchVisibilityBuffer[patchID] != 0)
+    {
+        uint targetSlot;
+        InterlockedAdd(_PatchCullingBuffer[PATCH_CULLING_COUNTER], 1, targetSlot);
+        _PatchCullingBuffer[PATCH_CULLING_LIST_OFFSET + targetSlot] = currentID;
+        return;
+    }
+
+    // The others are culled without reading their geometry
+    if (_ClassificationEpoch != 0)
+        _ClassificationCacheBuffer[currentID] = float4(0.0, 0.0, 0.0, 0.0);
+    RegisterClassification(currentID, heapID, depth, FRUSTUM_CULLED, totalNumElements, baseDepth);
 }
 
 void SplitElement(uint currentID, uint baseDepth)
 {
     // Get the neighbors information
-    uint3 cNeighbors = _NeighborsBuffer[currentID];
+    uint3 cNeighbors = LoadNeighbors(currentID);
 
     // If there is a neighbor X
     if (cNeighbors.x != INVALID_POINTER)
     {
         // This is on the path of it's neighbor X
-        uint3 xNeighbors = _NeighborsBuffer[cNeighbors.x];
-        if (xNeighbors.z == currentID && _BisectorDataBuffer[cNeighbors.x].bisectorState != UNCHANGED_ELEMENT)
+        uint3 xNeighbors = LoadNeighbors(cNeighbors.x);
+        if (xNeighbors.z == currentID && BISECTOR_STATE(cNeighbors.x) != UNCHANGED_ELEMENT)
             return;
     }
 
@@ -133,8 +482,8 @@ void SplitElement(uint currentID, uint baseDepth)
     if (cNeighbors.y != INVALID_POINTER)
     {
         // This is on the path of it's neighbor Y
-        uint3 yNeighbors = _NeighborsBuffer[cNeighbors.y];
-        if (yNeighbors.z == currentID && _BisectorDataBuffer[cNeighbors.y].bisectorState != UNCHANGED_ELEMENT)
+        uint3 yNeighbors = LoadNeighbors(cNeighbors.y);
+        if (yNeighbors.z == currentID && BISECTOR_STATE(cNeighbors.y) != UNCHANGED_ELEMENT)
             return;
     }
 
@@ -151,7 +500,7 @@ void SplitElement(uint currentID, uint baseDepth)
     // This avoid the massive over-reservation and saves a bunch of artifacts
     if (twinID == INVALID_POINTER)
         maxRequiredMemory = 1;
-    else if (_NeighborsBuffer[twinID].z == currentID)
+    else if (LoadNeighbors(twinID).z == currentID)
         maxRequiredMemory = 2;
 
     // Try to reserve
@@ -169,7 +518,7 @@ void SplitElement(uint currentID, uint baseDepth)
     // Let's actually count the memory that we will be using
     uint usedMemory = 1;
     uint prevPattern;
-    InterlockedOr(_BisectorDataBuffer[currentID].subdivisionPattern, CENTER_SPLIT, prevPattern);
+    InterlockedOr(BISECTOR_SUBDIVISION_PATTERN(currentID), CENTER_SPLIT, prevPattern);
 
     // If this is not zero, it means an other neighbor went faster than us, we restore the memory and leave.
     if (prevPattern != 0)
@@ -178,6 +527,10 @@ void SplitElement(uint currentID, uint baseDepth)
         return;
     }
 
+    // Splitting a bisector that was just merged is churn
+    if (RecentBirth(currentID, MERGE_BIRTH))
+        RegisterChurn(MERGE_SPLIT_CHURN_COUNTER);
+
     // Mark this for allocation
     uint targetLocation;
     InterlockedAdd(_AllocateBuffer[0], 1, targetLocation);
@@ -193,15 +546,14 @@ void SplitElement(uint currentID, uint baseDepth)
 
         // Grab the bisector of the neighbor
         uint64_t nHeapID = _HeapIDBuffer[twinID];
-        BisectorData nBisectorData = _BisectorDataBuffer[twinID];
         uint nDepth = HeapIDDepth(nHeapID);
-        uint3 nNeighbors = _NeighborsBuffer[twinID];
+        uint3 nNeighbors = LoadNeighbors(twinID);
 
         // If both triangles have the same depth
         if (nDepth == currentDepth)
         {
             // Raised the center split
-            InterlockedOr(_BisectorDataBuffer[twinID].subdivisionPattern, CENTER_SPLIT, prevPattern);
+            InterlockedOr(BISECTOR_SUBDIVISION_PATTERN(twinID), CENTER_SPLIT, prevPattern);
 
             // Only account for it if it was not raised before.
             if (prevPattern == 0)
@@ -220,9 +572,9 @@ void SplitElement(uint currentID, uint baseDepth)
         else
         {
             if (nNeighbors[0] == currentID)
-                InterlockedOr(_BisectorDataBuffer[twinID].subdivisionPattern, RIGHT_DOUBLE_SPLIT, prevPattern);
+                InterlockedOr(BISECTOR_SUBDIVISION_PATTERN(twinID), RIGHT_DOUBLE_SPLIT, prevPattern);
             else // if (nNeighbors[1] == currentID)
-                InterlockedOr(_BisectorDataBuffer[twinID].subdivisionPattern, LEFT_DOUBLE_SPLIT, prevPattern);
+                InterlockedOr(BISECTOR_SUBDIVISION_PATTERN(twinID), LEFT_DOUBLE_SPLIT, prevPattern);
 
             if (prevPattern != 0)
             {
@@ -242,7 +594,7 @@ void SplitElement(uint currentID, uint baseDepth)
                 // the new bisector that needs to be propagated
                 currentID = twinID;
                 currentDepth = nDepth;
-                twinID = _NeighborsBuffer[currentID].z;
+                twinID = LoadNeighbors(currentID).z;
             }
         }
     }
@@ -253,14 +605,14 @@ void SplitElement(uint currentID, uint baseDepth)
 
 void AllocateElement(uint currentID)
 {
-    // Load the bisector for this element
-    BisectorData bisectorData = _BisectorDataBuffer[currentID];
+    // Load the subdivision pattern for this element
+    uint subdivisionPattern = BISECTOR_SUBDIVISION_PATTERN(currentID);
 
     // Does this guy need to be subdivided
-    if (bisectorData.subdivisionPattern != 0)
+    if (subdivisionPattern != 0)
     {
         // How many bits do we need?
-        int numSlots = countbits(bisectorData.subdivisionPattern);
+        int numSlots = countbits(subdivisionPattern);
 
         // Request the number of bits we need using an interlock add
         uint firstBitIndex = 0;
@@ -270,11 +622,8 @@ void AllocateElement(uint currentID)
         for (uint bitId = 0; bitId < numSlots; ++bitId)
         {
             uint index = decode_bit_complement(firstBitIndex + bitId);
-            bisectorData.indices[bitId] = index;
+            BISECTOR_INDEX(currentID, bitId) = index;
         }
-
-        // Output 
-        _BisectorDataBuffer[currentID] = bisectorData;
     }
 }
 
@@ -283,8 +632,8 @@ void AllocateElement(uint currentID)
 #define SUBLING2_ID 2
 void evaluate_neighbors(uint currentID, uint bisectorID, out uint resX, out uint resY)
 {
-    BisectorData nBisectorData = _BisectorDataBuffer[bisectorID];
-    uint3 nNeighbors = _NeighborsBuffer[bisectorID];
+    BisectorData nBisectorData = LoadBisectorData(bisectorID);
+    uint3 nNeighbors = LoadNeighbors(bisectorID);
     if (nBisectorData.subdivisionPattern == 0x01)
     {
         resX = nBisectorData.indices[SUBLING0_ID];
@@ -336,11 +685,25 @@ void evaluate_neighbors(uint currentID, uint bisectorID, out uint resX, out uint
     }
 }
 
-void BisectElement(uint currentID)
+void CopyLEBPositions(uint sourceID, uint targetID)
 {
+    _LEBPositionBuffer[3 * targetID] = _LEBPositionBuffer[3 * sourceID];
+    _LEBPositionBuffer[3 * targetID + 1] = _LEBPositionBuffer[3 * sourceID + 1];
+    _LEBPositionBuffer[3 * targetID + 2] = _LEBPositionBuffer[3 * sourceID + 2];
+    _LEBPositionBuffer[3 * _TotalNumElements + targetID] = _LEBPositionBuffer[3 * _TotalNumElements + sourceID];
+    _LEBPositionHeapIDBuffer[targetID] = _LEBPositionHeapIDBuffer[sourceID];
+}
+
+void BisectElement(uint currentID, uint dispatchID)
+{
+    // Every bisection owns a range of records for the new neighbors of its bisectors
+    uint recordID = NEIGHBORS_UPDATE_RECORDS * dispatchID;
+    for (uint recordIdx = 0; recordIdx < NEIGHBORS_UPDATE_RECORDS; ++recordIdx)
+        _NeighborsUpdateBuffer[recordID + recordIdx].x = INVALID_POINTER;
+
     // If this bisector is not allocated or not subdivided, stop right away
     uint64_t baseHeapID = _HeapIDBuffer[currentID];
-    BisectorData cBisectorData = _BisectorDataBuffer[currentID];
+    BisectorData cBisectorData = LoadBisectorData(currentID);
     if (baseHeapID == 0 || cBisectorData.subdivisionPattern == NO_SPLIT)
         return;
 
@@ -348,7 +711,7 @@ void BisectElement(uint currentID)
     uint currentSubdiv = cBisectorData.subdivisionPattern;
 
     // neighbors of the parent
-    uint3 cNeighbors = _NeighborsBuffer[currentID];
+    uint3 cNeighbors = LoadNeighbors(currentID);
     uint p_n0 = cNeighbors[0];
     uint p_n1 = cNeighbors[1];
     uint p_n2 = cNeighbors[2];
@@ -358,6 +721,11 @@ void BisectElement(uint currentID)
     uint siblingID1 = cBisectorData.indices[1];
     uint siblingID2 = cBisectorData.indices[2];
 
+    // The new bisectors start from the cached positions of the parent, the LEB evaluation only adds the midpoints
+    uint numSiblings = countbits(currentSubdiv);
+    for (uint siblingIdx = 0; siblingIdx < numSiblings; ++siblingIdx)
+        CopyLEBPositions(currentID, cBisectorData.indices[siblingIdx]);
+
     // Simple subdivision (along the main axis)
     if (currentSubdiv == CENTER_SPLIT)
     {   
@@ -374,11 +742,11 @@ void BisectElement(uint currentID)
         modifiedNeighbors[0] = siblingID0;
         modifiedNeighbors[1] = resX;
         modifiedNeighbors[2] = p_n0;
-        _NeighborsOutputBuffer[currentID] = modifiedNeighbors;
+        RecordNeighbors(recordID++, currentID, modifiedNeighbors);
         modifiedNeighbors[0] = resY;
         modifiedNeighbors[1] = currentID;
         modifiedNeighbors[2] = p_n1;
-        _NeighborsOutputBuffer[siblingID0] = modifiedNeighbors;
+        RecordNeighbors(recordID++, siblingID0, modifiedNeighbors);
 
         // Keep track of the parent
         BisectorData modifiedBisector = cBisectorData;
@@ -386,11 +754,11 @@ void BisectElement(uint currentID)
 
         modifiedBisector.problematicNeighbor = INVALID_POINTER;
         modifiedBisector.flags = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
-        _BisectorDataBuffer[currentID] = modifiedBisector;
+        StoreBisectorData(currentID, modifiedBisector);
 
         modifiedBisector.problematicNeighbor = p_n1;
         modifiedBisector.flags = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
-        _BisectorDataBuffer[siblingID0] = modifiedBisector;
+        StoreBisectorData(siblingID0, modifiedBisector);
 
         // Mark this for propagation
         uint targetLocation;
@@ -416,15 +784,15 @@ void BisectElement(uint currentID)
         modifiedNeighbors[0] = siblingID1;
         modifiedNeighbors[1] = res0X;
         modifiedNeighbors[2] = siblingID0;
-        _NeighborsOutputBuffer[currentID] = modifiedNeighbors;
+        RecordNeighbors(recordID++, currentID, modifiedNeighbors);
         modifiedNeighbors[0] = res1Y;
         modifiedNeighbors[1] = currentID;
         modifiedNeighbors[2] = p_n1;
-        _NeighborsOutputBuffer[siblingID0] = modifiedNeighbors;
+        RecordNeighbors(recordID++, siblingID0, modifiedNeighbors);
         modifiedNeighbors[0] = res0Y;
         modifiedNeighbors[1] = currentID;
         modifiedNeighbors[2] = res1X;
-        _NeighborsOutputBuffer[siblingID1] = modifiedNeighbors;
+        RecordNeighbors(recordID++, siblingID1, modifiedNeighbors);
 
         // Keep track of the parent
         BisectorData modifiedBisector = cBisectorData;
@@ -433,17 +801,17 @@ void BisectElement(uint currentID)
         // Lower the element down the tree and update it's sibling
         modifiedBisector.problematicNeighbor = INVALID_POINTER;
         modifiedBisector.flags = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
-        _BisectorDataBuffer[currentID] = modifiedBisector;
+        StoreBisectorData(currentID, modifiedBisector);
 
         // Create the sibling of the current element
         modifiedBisector.problematicNeighbor = p_n1;
         modifiedBisector.flags = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
-        _BisectorDataBuffer[siblingID0] = modifiedBisector;
+        StoreBisectorData(siblingID0, modifiedBisector);
 
         // Create the sibling of the current element
         modifiedBisector.problematicNeighbor = INVALID_POINTER;
         modifiedBisector.flags = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
-        _BisectorDataBuffer[siblingID1] = modifiedBisector;
+        StoreBisectorData(siblingID1, modifiedBisector);
 
         // Mark this for propagation
         uint targetLocation;
@@ -469,15 +837,15 @@ void BisectElement(uint currentID)
         modifiedNeighbors[0] = siblingID1;
         modifiedNeighbors[1] = res1X;
         modifiedNeighbors[2] = p_n0;
-        _NeighborsOutputBuffer[currentID] = modifiedNeighbors;
+        RecordNeighbors(recordID++, currentID, modifiedNeighbors);
         modifiedNeighbors[0] = siblingID1;
         modifiedNeighbors[1] = res0X;
         modifiedNeighbors[2] = res1Y;
-        _NeighborsOutputBuffer[siblingID0] = modifiedNeighbors;
+        RecordNeighbors(recordID++, siblingID0, modifiedNeighbors);
         modifiedNeighbors[0] = res0Y;
         modifiedNeighbors[1] = siblingID0;
         modifiedNeighbors[2] = currentID;
-        _NeighborsOutputBuffer[siblingID1] = modifiedNeighbors;
+        RecordNeighbors(recordID++, siblingID1, modifiedNeighbors);
 
         // Keep track of the parent
         BisectorData modifiedBisector = cBisectorData;
@@ -486,17 +854,17 @@ void BisectElement(uint currentID)
         // Lower the element down the tree and update it's sibling
         modifiedBisector.problematicNeighbor = INVALID_POINTER;
         modifiedBisector.flags = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
-        _BisectorDataBuffer[currentID] = modifiedBisector;
+        StoreBisectorData(currentID, modifiedBisector);
 
         // Create the sibling of the current element
         modifiedBisector.problematicNeighbor = INVALID_POINTER;
         modifiedBisector.flags = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
-        _BisectorDataBuffer[siblingID0] = modifiedBisector;
+        StoreBisectorData(siblingID0, modifiedBisector);
 
         // Create the sibling of the current element
         modifiedBisector.problematicNeighbor = INVALID_POINTER;
         modifiedBisector.flags = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
-        _BisectorDataBuffer[siblingID1] = modifiedBisector;
+        StoreBisectorData(siblingID1, modifiedBisector);
     }
     else if (currentSubdiv == TRIPLE_SPLIT)
     {
@@ -521,19 +889,19 @@ void BisectElement(uint currentID)
         modifiedNeighbors[0] = siblingID1;
         modifiedNeighbors[1] = res0X;
         modifiedNeighbors[2] = siblingID2;
-        _NeighborsOutputBuffer[currentID] = modifiedNeighbors;
+        RecordNeighbors(recordID++, currentID, modifiedNeighbors);
         modifiedNeighbors[0] = siblingID2;
         modifiedNeighbors[1] = res1X;
         modifiedNeighbors[2] = res2Y;
-        _NeighborsOutputBuffer[siblingID0] = modifiedNeighbors;
+        RecordNeighbors(recordID++, siblingID0, modifiedNeighbors);
         modifiedNeighbors[0] = res0Y;
         modifiedNeighbors[1] = currentID;
         modifiedNeighbors[2] = res2X;
-        _NeighborsOutputBuffer[siblingID1] = modifiedNeighbors;
+        RecordNeighbors(recordID++, siblingID1, modifiedNeighbors);
         modifiedNeighbors[0] = res1Y;
         modifiedNeighbors[1] = siblingID0;
         modifiedNeighbors[2] = currentID;
-        _NeighborsOutputBuffer[siblingID2] = modifiedNeighbors;
+        RecordNeighbors(recordID++, siblingID2, modifiedNeighbors);
 
         // Keep track of the parent
         BisectorData modifiedBisector = cBisectorData;
@@ -542,22 +910,22 @@ void BisectElement(uint currentID)
         // Lower the element down the tree and update it's sibling
         modifiedBisector.problematicNeighbor = INVALID_POINTER;
         modifiedBisector.flags = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
-        _BisectorDataBuffer[currentID] = modifiedBisector;
+        StoreBisectorData(currentID, modifiedBisector);
 
         // Create the sibling of the current element
         modifiedBisector.problematicNeighbor = INVALID_POINTER;
         modifiedBisector.flags = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
-        _BisectorDataBuffer[siblingID0] = modifiedBisector;
+        StoreBisectorData(siblingID0, modifiedBisector);
 
         // Create the sibling of the current element
         modifiedBisector.problematicNeighbor = INVALID_POINTER;
         modifiedBisector.flags = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
-        _BisectorDataBuffer[siblingID1] = modifiedBisector;
+        StoreBisectorData(siblingID1, modifiedBisector);
 
         // Create the sibling of the current element
         modifiedBisector.problematicNeighbor = INVALID_POINTER;
         modifiedBisector.flags = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
-        _BisectorDataBuffer[siblingID2] = modifiedBisector;
+        StoreBisectorData(siblingID2, modifiedBisector);
     }
 
     // How many bits do we need to raise
@@ -566,65 +934,67 @@ void BisectElement(uint currentID)
     {
         set_bit_atomic_buffer(cBisectorData.indices[siblingIdx], true);
     }
+
+    // Keep track of the birth of the children
+    StampBisectorBirth(currentID, SPLIT_BIRTH);
+    for (uint childIdx = 0; childIdx < numSiblings; ++childIdx)
+        StampBisectorBirth(cBisectorData.indices[childIdx], SPLIT_BIRTH);
 }
 
 void PropagateBisectElement(uint currentID)
 {
     // Load the bisector data of the target triangle
-    BisectorData cBisectorData = _BisectorDataBuffer[currentID];
+    BisectorData cBisectorData = LoadBisectorData(currentID);
 
     // neighbors of the parent
     uint parentID = cBisectorData.propagationID;
     uint problematicNeighbor = cBisectorData.problematicNeighbor;
 
     // Read the neighbor that may have changed
-    BisectorData tBisectorData = _BisectorDataBuffer[problematicNeighbor];
-    uint3 tNeighbors = _NeighborsBuffer[problematicNeighbor];
+    BisectorData tBisectorData = LoadBisectorData(problematicNeighbor);
+    uint3 tNeighbors = LoadNeighbors(problematicNeighbor);
     uint targetID = problematicNeighbor;
     uint sibling1 = tBisectorData.indices[1];
 
     if (tBisectorData.subdivisionPattern == NO_SPLIT)
     {
         if (tNeighbors[0] == parentID)
-            _NeighborsBuffer[targetID][0] = currentID;
+            SetNeighbor(targetID, 0, currentID);
         if (tNeighbors[1] == parentID)
-            _NeighborsBuffer[targetID][1] = currentID;
+            SetNeighbor(targetID, 1, currentID);
         if (tNeighbors[2] == parentID)
-            _NeighborsBuffer[targetID][2] = currentID;
+            SetNeighbor(targetID, 2, currentID);
     }
     else if (tBisectorData.subdivisionPattern == CENTER_SPLIT)
     {
-        if (_NeighborsBuffer[targetID][2] == parentID)
-            _NeighborsBuffer[targetID][2] = currentID;
-        if (_NeighborsBuffer[tBisectorData.propagationID][2] == parentID)
-            _NeighborsBuffer[tBisectorData.propagationID][2] = currentID;
+        if (LoadNeighbors(targetID)[2] == parentID)
+            SetNeighbor(targetID, 2, currentID);
+        if (LoadNeighbors(tBisectorData.propagationID)[2] == parentID)
+            SetNeighbor(tBisectorData.propagationID, 2, currentID);
     }
     else if (tBisectorData.subdivisionPattern == RIGHT_DOUBLE_SPLIT)
     {
-        _NeighborsBuffer[sibling1][2] = currentID;
+        SetNeighbor(sibling1, 2, currentID);
     } 
     else if (tBisectorData.subdivisionPattern == LEFT_DOUBLE_SPLIT)
     {
-        _NeighborsBuffer[targetID][2] = currentID;
+        SetNeighbor(targetID, 2, currentID);
     }
 
     // Reset the problematic neighbor and the bisection state
-    _BisectorDataBuffer[currentID].problematicNeighbor = INVALID_POINTER;
-    _BisectorDataBuffer[currentID].bisectorState = UNCHANGED_ELEMENT;
+    BISECTOR_PROBLEMATIC_NEIGHBOR(currentID) = INVALID_POINTER;
+    BISECTOR_STATE(currentID) = UNCHANGED_ELEMENT;
 }
 
 void PrepareSimplifyElement(uint currentID)
 {
-    // Get the bisector
-    BisectorData cBisectorData = _BisectorDataBuffer[currentID];
-
     // Grab the current bisector
     uint64_t cHeapID = _HeapIDBuffer[currentID];
 
     // If this is not an even heap number it will be handeled by it's pair, the twin or the twin's pair
 
     // Neighbors of this element
-    uint3 cNeighbors = _NeighborsBuffer[currentID];
+    uint3 cNeighbors = LoadNeighbors(currentID);
 
     // Evaluate the depth of this bisector
     uint currentDepth = HeapIDDepth(cHeapID);
@@ -632,14 +1002,14 @@ void PrepareSimplifyElement(uint currentID)
     // Grab the pair neighbor (it has to exist)
     uint pairID = cNeighbors[0];
     uint64_t pHeapID = _HeapIDBuffer[pairID];
-    BisectorData pBisectorData = _BisectorDataBuffer[pairID];
-    uint3 pNeighbors = _NeighborsBuffer[pairID];
+    uint pState = BISECTOR_STATE(pairID);
+    uint3 pNeighbors = LoadNeighbors(pairID);
 
     // Evaluate the depth of the pair
     uint pairDepth = HeapIDDepth(pHeapID);
 
     // If they are not at the same depth or the pair is not to be simplified, we're done
-    if (pairDepth != currentDepth || pBisectorData.bisectorState != SIMPLIFY_ELEMENT)
+    if (pairDepth != currentDepth || pState != SIMPLIFY_ELEMENT)
         return;
 
     // We need to identify our twin pair
@@ -663,15 +1033,15 @@ void PrepareSimplifyElement(uint currentID)
         if (lowFacingDepth != currentDepth || highFacingDepth != currentDepth)
             return;
 
-        // Grab the two bisectors
-        BisectorData twinLowBisectData = _BisectorDataBuffer[twinLowID];
-        BisectorData twinHighBisectData = _BisectorDataBuffer[twinHighID];
+        // Grab the two bisector states
+        uint twinLowState = BISECTOR_STATE(twinLowID);
+        uint twinHighState = BISECTOR_STATE(twinHighID);
 
         // This element should not be doing the simplifications if:
         // - One of the four elements doesn't have the same depth
         // - One of the four elements isn't flagged for simplification
-        if (twinLowBisectData.bisectorState != SIMPLIFY_ELEMENT
-            || twinHighBisectData.bisectorState != SIMPLIFY_ELEMENT)
+        if (twinLowState != SIMPLIFY_ELEMENT
+            || twinHighState != SIMPLIFY_ELEMENT)
             return;
     }
 
@@ -686,18 +1056,21 @@ void PrepareSimplifyElement(uint currentID)
 void SimplifyElement(uint currentID)
 {
     // Grab the current bisector
-    BisectorData cBisectorData = _BisectorDataBuffer[currentID];
-    uint3 cNeighbors = _NeighborsBuffer[currentID];
+    uint3 cNeighbors = LoadNeighbors(currentID);
 
     // Grab the pair neighbor (it has to exist)
     uint pairID = cNeighbors[0];
-    BisectorData pBisectorData = _BisectorDataBuffer[pairID];
-    uint3 pNeighbors = _NeighborsBuffer[pairID];
+    uint3 pNeighbors = LoadNeighbors(pairID);
 
     // We need to indentify our twin pair
     uint twinLowID = pNeighbors[0];
     uint twinHighID = cNeighbors[1];
 
+    // Merging bisectors that were just split is churn
+    if (RecentBirth(currentID, SPLIT_BIRTH) && RecentBirth(pairID, SPLIT_BIRTH))
+        RegisterChurn(SPLIT_MERGE_CHURN_COUNTER);
+    StampBisectorBirth(currentID, MERGE_BIRTH);
+
     // Set the heap IDs
     _HeapIDBuffer[currentID] = _HeapIDBuffer[currentID] / 2;
     _HeapIDBuffer[pairID] = 0;
@@ -707,17 +1080,16 @@ void SimplifyElement(uint currentID)
     newNeighbors[0] = cNeighbors[2];
     newNeighbors[1] = pNeighbors[2];
     newNeighbors[2] = twinLowID;
-    _NeighborsBuffer[currentID] = newNeighbors;
+    StoreNeighbors(currentID, newNeighbors);
 
     // Update the bisector data
-    cBisectorData.propagationID = pairID;
-    cBisectorData.problematicNeighbor = pNeighbors[2];
-    cBisectorData.bisectorState = MERGED_ELEMENT;
-    cBisectorData.flags = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
-    _BisectorDataBuffer[currentID] = cBisectorData;
+    BISECTOR_PROPAGATION_ID(currentID) = pairID;
+    BISECTOR_PROBLEMATIC_NEIGHBOR(currentID) = pNeighbors[2];
+    BISECTOR_STATE(currentID) = MERGED_ELEMENT;
+    BISECTOR_FLAGS(currentID) = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
 
     // Mark this for propagation
-    if (cBisectorData.problematicNeighbor != INVALID_POINTER)
+    if (pNeighbors[2] != INVALID_POINTER)
     {
         // Mark this for propagation
         uint targetLocation;
@@ -726,9 +1098,8 @@ void SimplifyElement(uint currentID)
     }
 
     // Clear the pair's heap for identification
-    pBisectorData.bisectorState = MERGED_ELEMENT;
-    pBisectorData.flags = 0;
-    _BisectorDataBuffer[pairID] = pBisectorData;
+    BISECTOR_STATE(pairID) = MERGED_ELEMENT;
+    BISECTOR_FLAGS(pairID) = 0;
 
     // Don't forget to free the bit
     set_bit_atomic_buffer(pairID, false);
@@ -736,30 +1107,32 @@ void SimplifyElement(uint currentID)
     // If there was a facing pair, simplify it aswell
     if (twinLowID != INVALID_POINTER)
     {
+        // Same churn tracking for the facing pair
+        if (RecentBirth(twinLowID, SPLIT_BIRTH) && RecentBirth(twinHighID, SPLIT_BIRTH))
+            RegisterChurn(SPLIT_MERGE_CHURN_COUNTER);
+        StampBisectorBirth(twinLowID, MERGE_BIRTH);
+
         // Set the heap IDs
         _HeapIDBuffer[twinLowID] = _HeapIDBuffer[twinLowID] / 2;
         _HeapIDBuffer[twinHighID] = 0;
 
         // Read both bisectors
-        BisectorData lowFacingBst = _BisectorDataBuffer[twinLowID];
-        uint3 lfNeighbors = _NeighborsBuffer[twinLowID];
-        BisectorData highFacingBst = _BisectorDataBuffer[twinHighID];
-        uint3 hfNeighbors = _NeighborsBuffer[twinHighID];
+        uint3 lfNeighbors = LoadNeighbors(twinLowID);
+        uint3 hfNeighbors = LoadNeighbors(twinHighID);
 
         // Update the lowest ID
         newNeighbors[0] = lfNeighbors[2];
         newNeighbors[1] = hfNeighbors[2];
         newNeighbors[2] = currentID;
-        _NeighborsBuffer[twinLowID] = newNeighbors;
+        StoreNeighbors(twinLowID, newNeighbors);
 
         // Update the twin bisector data
-        lowFacingBst.propagationID = twinHighID;
-        lowFacingBst.problematicNeighbor = hfNeighbors[2];
-        lowFacingBst.bisectorState = MERGED_ELEMENT;
-        lowFacingBst.flags = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
-        _BisectorDataBuffer[twinLowID] = lowFacingBst;
+        BISECTOR_PROPAGATION_ID(twinLowID) = twinHighID;
+        BISECTOR_PROBLEMATIC_NEIGHBOR(twinLowID) = hfNeighbors[2];
+        BISECTOR_STATE(twinLowID) = MERGED_ELEMENT;
+        BISECTOR_FLAGS(twinLowID) = (VISIBLE_BISECTOR | MODIFIED_BISECTOR);
 
-        if (lowFacingBst.problematicNeighbor != INVALID_POINTER)
+        if (hfNeighbors[2] != INVALID_POINTER)
         {
             // Mark this for propagation
             uint targetLocation;
@@ -768,9 +1141,8 @@ void SimplifyElement(uint currentID)
         }
 
         // Clear the pair's heap for identification 
-        highFacingBst.bisectorState = MERGED_ELEMENT;
-        highFacingBst.flags = 0;
-        _BisectorDataBuffer[twinHighID] = highFacingBst;
+        BISECTOR_STATE(twinHighID) = MERGED_ELEMENT;
+        BISECTOR_FLAGS(twinHighID) = 0;
 
         // Don't forget to free the bit
         set_bit_atomic_buffer(twinHighID, false);
@@ -780,7 +1152,7 @@ void SimplifyElement(uint currentID)
 void PropagateElementSimplify(uint currentID)
 {
     // Load the bisector data of the target element
-    BisectorData cBisectorData = _BisectorDataBuffer[currentID];
+    BisectorData cBisectorData = LoadBisectorData(currentID);
 
     // Id of the element before the simplification
     uint deletedPair = cBisectorData.propagationID;
@@ -789,20 +1161,20 @@ void PropagateElementSimplify(uint currentID)
     uint neighborID = cBisectorData.problematicNeighbor;
 
     // Read the neighbor that may have changed
-    BisectorData nBisectorData = _BisectorDataBuffer[neighborID];
-    uint3 nNeighbors = _NeighborsBuffer[neighborID];
+    uint nState = BISECTOR_STATE(neighborID);
+    uint3 nNeighbors = LoadNeighbors(neighborID);
 
     // The neighbor has not changed, so we just need to make it point on currentID instead of the pair that was deleted
-    if (nBisectorData.bisectorState != MERGED_ELEMENT)
+    if (nState != MERGED_ELEMENT)
     {
         for (uint i = 0; i < 3; ++i)
         {
             if (nNeighbors[i] == deletedPair)
-                _NeighborsBuffer[neighborID][i] = currentID;
+                SetNeighbor(neighborID, i, currentID);
         }
     }
     // The neighbor has had a simplification, so we need to update a different neighbor based on if it went up one depth in the tree or was deleted.
-    else if (nBisectorData.bisectorState == MERGED_ELEMENT)
+    else if (nState == MERGED_ELEMENT)
     {
         // He still exist, but was simplified
         if (_HeapIDBuffer[neighborID] != 0)
@@ -810,7 +1182,7 @@ void PropagateElementSimplify(uint currentID)
             for (uint i = 0; i < 3; ++i)
             {
                 if (nNeighbors[i] == deletedPair)
-                    _NeighborsBuffer[neighborID][i] = currentID;
+                    SetNeighbor(neighborID, i, currentID);
             }
         }
         // He is gone, we need to update his pair instead of him.
@@ -819,14 +1191,14 @@ void PropagateElementSimplify(uint currentID)
             uint neighborPair = nNeighbors[1];
             for (uint i = 0; i < 3; ++i)
             {
-                if (_NeighborsBuffer[neighborPair][i] == deletedPair)
-                    _NeighborsBuffer[neighborPair][i] = currentID;
+                if (LoadNeighbors(neighborPair)[i] == deletedPair)
+                    SetNeighbor(neighborPair, i, currentID);
             }
         }
     }
 
     // Reset the problematic neighbor
-    _BisectorDataBuffer[currentID].problematicNeighbor = INVALID_POINTER;
+    BISECTOR_PROBLEMATIC_NEIGHBOR(currentID) = INVALID_POINTER;
 }
 
 void BisectorElementIndexation(uint currentID)
@@ -845,11 +1217,11 @@ void BisectorElementIndexation(uint currentID)
     // Keep track of it's global ID
     _BisectorIndicesBuffer[bisectorSlot / 3] = currentID;
 
-    // Load the bisector data of the target element
-    BisectorData cBisectorData = _BisectorDataBuffer[currentID];
+    // Load the flags of the target element
+    uint cFlags = BISECTOR_FLAGS(currentID);
     
     // Is it visible?
-    if ((cBisectorData.flags & VISIBLE_BISECTOR) == 0)
+    if ((cFlags & VISIBLE_BISECTOR) == 0)
         return;
 
     // Reserve a slot for this visible bisector
@@ -859,7 +1231,7 @@ void BisectorElementIndexation(uint currentID)
     _VisibleBisectorIndicesBuffer[bisectorSlot / 3] = currentID;
 
     // Is it visible?
-    if ((cBisectorData.flags & MODIFIED_BISECTOR) == 0)
+    if ((cFlags & MODIFIED_BISECTOR) == 0)
         return;
 
     // Reserve a slot for this visible bisector
@@ -879,7 +1251,7 @@ void ValidateBisector(uint currentID)
         return;
 
     // Load the bisector data of the target element
-    uint3 cNeighbors = _NeighborsBuffer[currentID];
+    uint3 cNeighbors = LoadNeighbors(currentID);
 
     bool failed = false;
     uint targetNeighbor = INVALID_POINTER;
@@ -890,7 +1262,7 @@ void ValidateBisector(uint currentID)
         if (neighborID != INVALID_POINTER)
         {
             bool found = false;
-            uint3 nNeighbors = _NeighborsBuffer[neighborID];
+            uint3 nNeighbors = LoadNeighbors(neighborID);
             for (uint j = 0; j < 3; ++j)
             {
                 if (nNeighbors[j] == currentID)
@@ -914,4 +1286,389 @@ void ValidateBisector(uint currentID)
     }    
 }
 
+// Slot of the edge that leaves each corner (v0 -> v1 is the next edge, v1 -> v2 the previous one and v2 -> v0 the twin)
+uint OutgoingEdgeSlot(uint corner)
+{
+    return corner == 0 ? 1 : (corner == 1 ? 0 : 2);
+}
+
+uint WeldOwnerKey(uint bisectorID, uint corner)
+{
+    // Turn around the vertex through the outgoing edges, the neighbors share them in the reverse direction
+    uint ownerKey = 3 * bisectorID + corner;
+    uint currentBisector = bisectorID;
+    uint currentCorner = corner;
+    for (uint step = 0; step < WELDED_MAX_VALENCE; ++step)
+    {
+        uint neighborID = LoadNeighbors(currentBisector)[OutgoingEdgeSlot(currentCorner)];
+        if (neighborID == INVALID_POINTER)
+            break;
+
+        // The edge that reaches the vertex in the neighbor gives its corner
+        uint3 nNeighbors = LoadNeighbors(neighborID);
+        uint incomingSlot = nNeighbors.x == currentBisector ? 0 : (nNeighbors.y == currentBisector ? 1 : 2);
+        currentBisector = neighborID;
+        currentCorner = 2 - incomingSlot;
+
+        // The fan is closed, the smallest corner key owns the vertex
+        if (currentBisector == bisectorID)
+            return ownerKey;
+        ownerKey = min(ownerKey, 3 * currentBisector + currentCorner);
+    }
+
+    // Open or too large fan, every corner of it keeps its own vertex
+    return 3 * bisectorID + corner;
+}
+
+void WeldElementVertices(uint currentID)
+{
+    // Deallocated element, collapse its corners so that the acceleration structures skip it
+    if (_HeapIDBuffer[currentID] == 0)
+    {
+        _VertexIndexBuffer[3 * currentID] = 0;
+        _VertexIndexBuffer[3 * currentID + 1] = 0;
+        _VertexIndexBuffer[3 * currentID + 2] = 0;
+        return;
+    }
+
+    // Find the owner of every corner, the fourth vertex is only used by this element
+    uint ownerKeys[3];
+    uint numOwned = 1;
+    for (uint corner = 0; corner < 3; ++corner)
+    {
+        ownerKeys[corner] = WeldOwnerKey(currentID, corner);
+        numOwned += ownerKeys[corner] == 3 * currentID + corner ? 1 : 0;
+    }
+
+    // Reserve the vertices this element owns
+    uint vertexSlot;
+    InterlockedAdd(_WeldedArgsBuffer[WELDED_VERTEX_COUNTER], numOwned, vertexSlot);
+
+    // The shared corners point to their owner until they are resolved
+    for (uint corner = 0; corner < 3; ++corner)
+    {
+        uint cornerKey = 3 * currentID + corner;
+        if (ownerKeys[corner] == cornerKey)
+        {
+            _WeldedVertexBuffer[vertexSlot] = cornerKey;
+            _VertexIndexBuffer[cornerKey] = vertexSlot++;
+        }
+        else
+            _VertexIndexBuffer[cornerKey] = WELDED_OWNER_FLAG | ownerKeys[corner];
+    }
+    _WeldedVertexBuffer[vertexSlot] = 3 * _TotalNumElements + currentID;
+    _VertexIndexBuffer[3 * _TotalNumElements + currentID] = vertexSlot;
+}
+
+void ResolveWeldedElement(uint indexedID)
+{
+    uint currentID = _BisectorIndicesBuffer[indexedID];
+    for (uint corner = 0; corner < 3; ++corner)
+    {
+        // The owners were written by the previous pass and are never flagged
+        uint vertexIndex = _VertexIndexBuffer[3 * currentID + corner];
+        if ((vertexIndex & WELDED_OWNER_FLAG) != 0)
+        {
+            vertexIndex = _VertexIndexBuffer[vertexIndex & ~WELDED_OWNER_FLAG];
+            _VertexIndexBuffer[3 * currentID + corner] = vertexIndex;
+        }
+
+        // The corners are drawn in the reverse order
+        _WeldedIndexBuffer[3 * indexedID + 2 - corner] = vertexIndex;
+    }
+}
+
+void PrepareWeldedIndirectArgs()
+{
+    // A closed mesh stays within the capacity, an open one would duplicate its border vertices
+    uint numVertices = min(_WeldedArgsBuffer[WELDED_VERTEX_COUNTER], WELDED_VERTEX_RATIO * _TotalNumElements);
+
+    // Indexed draw of every bisector
+    _WeldedArgsBuffer[0] = _IndirectDrawBuffer[0];
+    _WeldedArgsBuffer[1] = 1;
+    _WeldedArgsBuffer[2] = 0;
+    _WeldedArgsBuffer[3] = 0;
+    _WeldedArgsBuffer[4] = 0;
+
+    // Indirect dispatch for each welded vertex, kept apart as the deformers read the counter
+    _IndirectDispatchBuffer[WELDED_DISPATCH_OFFSET] = (numVertices + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+    _IndirectDispatchBuffer[WELDED_DISPATCH_OFFSET + 1] = 1;
+    _IndirectDispatchBuffer[WELDED_DISPATCH_OFFSET + 2] = 1;
+    _WeldedArgsBuffer[WELDED_VERTEX_COUNTER] = numVertices;
+}
+
+uint HeapIDHashCapacity()
+{
+    return HEAP_ID_HASH_LOAD_RATIO * _TotalNumElements;
+}
+
+uint HeapIDHashSlot(uint64_t heapID)
+{
+    return uint((heapID * 0x9E3779B97F4A7C15uLL) >> 32) % HeapIDHashCapacity();
+}
+
+void InsertHeapID(uint currentID)
+{
+    uint64_t cHeapID = _HeapIDBuffer[currentID];
+    if (cHeapID == 0)
+        return;
+
+    // Linear probing until a free slot is found, the table is never more than half full
+    uint capacity = HeapIDHashCapacity();
+    uint slot = HeapIDHashSlot(cHeapID);
+    for (uint probe = 0; probe < capacity; ++probe)
+    {
+        uint prevValue;
+        InterlockedCompareExchange(_HeapIDHashBuffer[slot], INVALID_POINTER, currentID, prevValue);
+        if (prevValue == INVALID_POINTER)
+            return;
+        slot = (slot + 1) % capacity;
+    }
+}
+
+uint LookupHeapID(uint64_t heapID)
+{
+    // The keys are not stored, the heapID of the bisector is compared instead
+    uint capacity = HeapIDHashCapacity();
+    uint slot = HeapIDHashSlot(heapID);
+    for (uint probe = 0; probe < capacity; ++probe)
+    {
+        uint bisectorID = _HeapIDHashBuffer[slot];
+        if (bisectorID == INVALID_POINTER || _HeapIDBuffer[bisectorID] == heapID)
+            return bisectorID;
+        slot = (slot + 1) % capacity;
+    }
+    return INVALID_POINTER;
+}
+
+// Same depth neighbors (0 if none) of a heapID, obtained by replaying its bisections from the base patch adjacency
+uint64_t3 SameDepthNeighbors(uint64_t heapID, uint baseDepth)
+{
+    uint64_t baseHeapID = 1uLL << (baseDepth - 1);
+    uint depth = HeapIDDepth(heapID);
+    uint64_t current = heapID >> (depth - baseDepth);
+    uint3 baseNeighbors = _BaseNeighborsBuffer[uint(current - baseHeapID)];
+    uint64_t3 neighbors;
+    neighbors.x = baseNeighbors.x != INVALID_POINTER ? baseHeapID + baseNeighbors.x : 0;
+    neighbors.y = baseNeighbors.y != INVALID_POINTER ? baseHeapID + baseNeighbors.y : 0;
+    neighbors.z = baseNeighbors.z != INVALID_POINTER ? baseHeapID + baseNeighbors.z : 0;
+
+    // The first child's twin is the parent's first neighbor, the second child's twin is the parent's second neighbor
+    for (int bitID = depth - baseDepth - 1; bitID >= 0; --bitID)
+    {
+        uint64_t3 pNeighbors = neighbors;
+        if (((heapID >> bitID) & 1) == 0)
+        {
+            neighbors.x = 2 * current + 1;
+            neighbors.y = pNeighbors.z != 0 ? 2 * pNeighbors.z + 1 : 0;
+            neighbors.z = pNeighbors.x != 0 ? 2 * pNeighbors.x + 1 : 0;
+            current = 2 * current;
+        }
+        else
+        {
+            neighbors.x = pNeighbors.z != 0 ? 2 * pNeighbors.z : 0;
+            neighbors.y = 2 * current;
+            neighbors.z = pNeighbors.y != 0 ? 2 * pNeighbors.y : 0;
+            current = 2 * current + 1;
+        }
+    }
+    return neighbors;
+}
+
+uint3 DeriveNeighbors(uint64_t heapID, uint baseDepth)
+{
+    uint64_t3 neighbors = SameDepthNeighbors(heapID, baseDepth);
+    uint3 resolved = uint3(INVALID_POINTER, INVALID_POINTER, INVALID_POINTER);
+    for (uint slot = 0; slot < 3; ++slot)
+    {
+        uint64_t neighborHeapID = neighbors[slot];
+        if (neighborHeapID == 0)
+            continue;
+
+        // Same depth neighbor, otherwise the twin can only be coarser and the other two only finer
+        resolved[slot] = LookupHeapID(neighborHeapID);
+        if (resolved[slot] != INVALID_POINTER)
+            continue;
+        if (slot == 2)
+            resolved[slot] = HeapIDDepth(neighborHeapID) > baseDepth ? LookupHeapID(neighborHeapID >> 1) : INVALID_POINTER;
+        else
+            resolved[slot] = LookupHeapID(2 * neighborHeapID + (slot == 0 ? 1 : 0));
+    }
+    return resolved;
+}
+
+void DeriveBisectorNeighbors(uint currentID, uint baseDepth)
+{
+    // Deallocated element, we don't care
+    uint64_t cHeapID = _HeapIDBuffer[currentID];
+    if (cHeapID == 0)
+        return;
+
+    // Count the bisectors for which the stored and derived adjacency disagree
+    uint3 derived = DeriveNeighbors(cHeapID, baseDepth);
+    uint3 cNeighbors = LoadNeighbors(currentID);
+    if (any(derived != cNeighbors))
+    {
+        uint prevValue;
+        InterlockedAdd(_ValidationBuffer[1], 1, prevValue);
+    }
+}
+
+// The bucket is the first bits of the position of the bisector in the bisection tree, which makes it a morton-like spatial key.
+// The elements are only sorted by bucket: inside of a bucket they keep the order in which they were counted, which isn't
+// deterministic. This is enough for the compaction, the allocated elements end up contiguous whatever the order and the
+// bisectors of a bucket share their first COMPACTION_BUCKET_BITS bisections, so they stay close to each other in memory.
+// A full sort would need a second pass over each bucket for little locality gain.
+uint CompactionBucket(uint64_t heapID)
+{
+    // Align the heapID on the most significant bit and drop it
+    uint depth = HeapIDDepth(heapID);
+    uint64_t key = (heapID << (64 - depth)) << 1;
+    return uint(key >> (64 - COMPACTION_BUCKET_BITS));
+}
+
+// Base bisectors live outside of the CBT and are never moved
+uint RemapCompactedID(uint currentID)
+{
+    if (currentID == INVALID_POINTER || currentID >= cbt_size())
+        return currentID;
+    return _CompactionRemapBuffer[currentID];
+}
+
+void CompactionCountElement(uint currentID)
+{
+    // Deallocated element or base element, we don't care
+    uint64_t cHeapID = _HeapIDBuffer[currentID];
+    if (cHeapID == 0 || currentID >= cbt_size())
+        return;
+
+    // Keep track of the highest allocated slot
+    InterlockedMax(_CompactionBuffer[COMPACTION_SLOT_SPAN], currentID + 1);
+
+    // Count the element in its bucket and keep track of its rank inside of it
+    uint rank;
+    InterlockedAdd(_CompactionBuffer[COMPACTION_BUCKET_OFFSET + CompactionBucket(cHeapID)], 1, rank);
+    _CompactionRemapBuffer[currentID] = rank;
+}
+
+void PrepareCompactionElement(uint totalNumElements, float threshold)
+{
+    // Evaluate the fragmentation of the allocated slots
+    uint numAllocated = bit_count_buffer();
+    uint slotSpan = _CompactionBuffer[COMPACTION_SLOT_SPAN];
+    bool compact = numAllocated != 0 && float(slotSpan - numAllocated) >= threshold * float(numAllocated);
+
+    // Per element dispatch
+    _IndirectDispatchBuffer[0] = compact ? (totalNumElements + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE : 0;
+    _IndirectDispatchBuffer[1] = 1;
+    _IndirectDispatchBuffer[2] = 1;
+
+    // Single group dispatch for the scan
+    _IndirectDispatchBuffer[3] = compact ? 1 : 0;
+    _IndirectDispatchBuffer[4] = 1;
+    _IndirectDispatchBuffer[5] = 1;
+}
+
+#define COMPACTION_BUCKETS_PER_LANE (COMPACTION_NUM_BUCKETS / WORKGROUP_SIZE)
+groupshared uint gs_CompactionLaneSum[WORKGROUP_SIZE];
+
+void CompactionScanBuckets(uint groupIndex)
+{
+    // Sum the buckets of this lane
+    uint firstBucket = COMPACTION_BUCKET_OFFSET + groupIndex * COMPACTION_BUCKETS_PER_LANE;
+    uint laneSum = 0;
+    for (uint bucketIdx = 0; bucketIdx < COMPACTION_BUCKETS_PER_LANE; ++bucketIdx)
+        laneSum += _CompactionBuffer[firstBucket + bucketIdx];
+    gs_CompactionLaneSum[groupIndex] = laneSum;
+    GroupMemoryBarrierWithGroupSync();
+
+    // Exclusive prefix of the previous lanes
+    uint offset = 0;
+    for (uint laneIdx = 0; laneIdx < groupIndex; ++laneIdx)
+        offset += gs_CompactionLaneSum[laneIdx];
+
+    // Replace the counts with the offsets
+    for (uint bucketIdx = 0; bucketIdx < COMPACTION_BUCKETS_PER_LANE; ++bucketIdx)
+    {
+        uint count = _CompactionBuffer[firstBucket + bucketIdx];
+        _CompactionBuffer[firstBucket + bucketIdx] = offset;
+        offset += count;
+    }
+}
+
+void CompactionRemapElement(uint currentID)
+{
+    // Deallocated element or base element, we don't care
+    uint64_t cHeapID = _HeapIDBuffer[currentID];
+    if (cHeapID == 0 || currentID >= cbt_size())
+        return;
+
+    // The new slot is the rank of the element in the sorted sequence
+    _CompactionRemapBuffer[currentID] += _CompactionBuffer[COMPACTION_BUCKET_OFFSET + CompactionBucket(cHeapID)];
+}
+
+void CompactionScatterElement(uint currentID)
+{
+    // Deallocated element, we don't care
+    uint64_t cHeapID = _HeapIDBuffer[currentID];
+    if (cHeapID == 0)
+        return;
+
+    // Move the element and patch its neighbors (the allocation indices are not used anymore and hold the moved neighbors)
+    uint targetID = RemapCompactedID(currentID);
+    uint3 cNeighbors = LoadNeighbors(currentID);
+    _CompactionHeapIDBuffer[targetID] = cHeapID;
+    BISECTOR_INDEX(targetID, 0) = RemapCompactedID(cNeighbors.x);
+    BISECTOR_INDEX(targetID, 1) = RemapCompactedID(cNeighbors.y);
+    BISECTOR_INDEX(targetID, 2) = RemapCompactedID(cNeighbors.z);
+    // The propagation ID isn't used either and holds the previous slot of the element
+    BISECTOR_PROPAGATION_ID(targetID) = currentID;
+    _BisectorAgeBuffer[_TotalNumElements + targetID] = _BisectorAgeBuffer[currentID];
+}
+
+void CompactionResolveElement(uint currentID)
+{
+    // The allocated elements are now the first ones
+    uint numAllocated = bit_count_buffer();
+
+    // Rebuild the bitfield
+    if (currentID < OCBT_BITFIELD_NUM_SLOTS)
+    {
+        uint firstBit = currentID * 64;
+        uint numBits = numAllocated > firstBit ? min(numAllocated - firstBit, 64) : 0;
+        _BitfieldBufferRW[currentID] = numBits == 64 ? ~0uLL : ((1uLL << numBits) - 1);
+    }
+
+    // Reset the bisector data, only the moved elements are flagged as modified so that their geometry gets evaluated at their new location
+    bool moved = BISECTOR_PROPAGATION_ID(currentID) != currentID;
+    uint cFlags = BISECTOR_FLAGS(currentID);
+    BisectorData cBisectorData;
+    cBisectorData.subdivisionPattern = NO_SPLIT;
+    cBisectorData.indices[0] = INVALID_POINTER;
+    cBisectorData.indices[1] = INVALID_POINTER;
+    cBisectorData.indices[2] = INVALID_POINTER;
+    cBisectorData.problematicNeighbor = INVALID_POINTER;
+    cBisectorData.bisectorState = UNCHANGED_ELEMENT;
+    cBisectorData.propagationID = INVALID_POINTER;
+
+    // Released slot, nothing of the element it held must survive
+    bool baseElement = currentID >= cbt_size();
+    if (!baseElement && currentID >= numAllocated)
+    {
+        _HeapIDBuffer[currentID] = 0;
+        StoreNeighbors(currentID, uint3(INVALID_POINTER, INVALID_POINTER, INVALID_POINTER));
+        cBisectorData.flags = 0;
+        StoreBisectorData(currentID, cBisectorData);
+        return;
+    }
+
+    // Copy back the element
+    if (!baseElement)
+        _HeapIDBuffer[currentID] = _CompactionHeapIDBuffer[currentID];
+    StoreNeighbors(currentID, uint3(BISECTOR_INDEX(currentID, 0), BISECTOR_INDEX(currentID, 1), BISECTOR_INDEX(currentID, 2)));
+    _BisectorAgeBuffer[currentID] = _BisectorAgeBuffer[_TotalNumElements + currentID];
+    cBisectorData.flags = moved ? (VISIBLE_BISECTOR | MODIFIED_BISECTOR) : cFlags;
+    StoreBisectorData(currentID, cBisectorData);
+}
+
 #endif // UPDATE_UTILITIES_H
\ No newline at end of file
@@ -0,0 +1,19 @@
+#ifndef WELDED_VERTICES_HLSL
+#define WELDED_VERTICES_HLSL
+
+#if defined(WELDED_VERTICES)
+// Maps every corner of an element to its welded vertex
+StructuredBuffer<uint> _VertexIndexBuffer: register(VERTEX_INDEX_BUFFER_BINDING_SLOT);
+
+uint CornerVertexIndex(uint elementID, uint corner)
+{
+    return _VertexIndexBuffer[3 * elementID + corner];
+}
+#else
+uint CornerVertexIndex(uint elementID, uint corner)
+{
+    return 3 * elementID + corner;
+}
+#endif
+
+#endif // WELDED_VERTICES_HLSL